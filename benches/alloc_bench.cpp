@@ -0,0 +1,48 @@
+#include <bench.h>
+#include <cstdlib>
+#include <rustly/alloc.h>
+#include <thread>
+#include <vector>
+
+using namespace rustly;
+
+// Counts `operator new` only, so that `malloc` below is the plain allocator
+RUSTLY_ALLOC_SHIM()
+
+int main()
+{
+    constexpr size_t Iters = 10'000'000;
+    static const alloc::Scope scope("bench");
+
+    bench::run("malloc + free (64B)", Iters, []()
+               { void *p = std::malloc(64); bench::black_box(p); std::free(p); });
+    bench::run("operator new + delete (64B, unscoped)", Iters, []()
+               { void *p = ::operator new(64); bench::black_box(p); ::operator delete(p); });
+    {
+        AllocScope guard(scope);
+        bench::run("operator new + delete (64B, scoped)", Iters, []()
+                   { void *p = ::operator new(64); bench::black_box(p); ::operator delete(p); });
+    }
+    bench::run("operator new + delete (64B, align 64)", Iters, []()
+               { void *p = ::operator new(64, std::align_val_t(64)); bench::black_box(p); ::operator delete(p, std::align_val_t(64)); });
+    bench::run("AllocScope enter + exit", Iters, []()
+               { AllocScope guard(scope); bench::black_box(guard); });
+
+    // Allocations freed on another thread than the one that made them
+    std::vector<void *> ptrs(Iters / 10);
+    bench::run("malloc, free on another thread", 1, [&]()
+               {
+                   for (auto &p : ptrs) { p = std::malloc(64); }
+                   std::thread([&]() { for (auto *p : ptrs) { std::free(p); } }).join(); });
+    bench::run("operator new, delete on another thread", 1, [&]()
+               {
+                   for (auto &p : ptrs) { p = ::operator new(64); }
+                   std::thread([&]() { for (auto *p : ptrs) { ::operator delete(p); } }).join(); });
+
+    bench::run("alloc::snapshot", 10'000, []()
+               { bench::black_box(alloc::snapshot()); });
+    auto stats = alloc::snapshot().scope("bench").unwrap();
+    std::printf("bench scope: %llu allocations, %lld live bytes\n", (unsigned long long)stats.allocations,
+                (long long)stats.live_bytes());
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <bench.h>
+#include <execinfo.h>
+#include <cstdlib>
+#include <rustly/backtrace.h>
+
+using namespace rustly;
+
+[[gnu::noinline]] static Backtrace capture(int depth)
+{
+    return depth == 0 ? Backtrace::force_capture() : capture(depth - 1);
+}
+
+[[gnu::noinline]] static int capture_symbols(int depth)
+{
+    if (depth > 0)
+    {
+        return capture_symbols(depth - 1);
+    }
+    void *frames[Backtrace::MaxFrames];
+    int n = ::backtrace(frames, Backtrace::MaxFrames);
+    char **symbols = ::backtrace_symbols(frames, n);
+    std::free(symbols);
+    return n;
+}
+
+int main()
+{
+    for (int depth : {4, 16, 48})
+    {
+        std::printf("-- depth %d\n", depth);
+        bench::run("Backtrace::force_capture", 100'000, [&]()
+                   { bench::black_box(capture(depth)); });
+        bench::run("Backtrace::force_capture + to_string (cached)", 10'000, [&]()
+                   { bench::black_box(capture(depth).to_string()); });
+        bench::run("backtrace + backtrace_symbols", 10'000, [&]()
+                   { bench::black_box(capture_symbols(depth)); });
+    }
+    return 0;
+}
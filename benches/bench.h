@@ -0,0 +1,261 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <rustly/histogram.h>
+#include <rustly/time.h>
+#include "perf.h"
+
+namespace rustly::bench
+{
+    /// Prevents the compiler from optimizing away the computation of `value`
+    template <class T>
+    inline void
+    black_box(T &&value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    /// Per-iteration results of one benchmark
+    struct Measurement
+    {
+        double ns;
+        CounterValues counters;
+    };
+
+    namespace detail
+    {
+        /// Saved results, as lines of `name<TAB>ns<TAB>counter...`, with `-`
+        /// for counters that were unavailable
+        class Session
+        {
+        public:
+            Session()
+            {
+                if (const char *path = std::getenv("RUSTLY_BENCH_BASELINE"))
+                {
+                    load(path);
+                }
+                if (const char *path = std::getenv("RUSTLY_BENCH_SAVE"))
+                {
+                    // Appended to, so that several bench executables can share one file
+                    mSave.open(path, std::ios::app);
+                }
+                if (!mCounters.is_available())
+                {
+                    std::fprintf(stderr, "note: hardware counters are unavailable (see perf_event_paranoid), "
+                                         "reporting wall-clock time only\n");
+                }
+            }
+
+            static Session &
+            get()
+            {
+                static Session session;
+                return session;
+            }
+
+            inline PerfCounters &
+            counters()
+            {
+                return mCounters;
+            }
+
+            Option<Measurement>
+            baseline(const std::string &name) const
+            {
+                auto it = mBaseline.find(name);
+                return it == mBaseline.end() ? Option<Measurement>() : Option<Measurement>(it->second);
+            }
+
+            void
+            save(std::string_view name, const Measurement &m)
+            {
+                if (!mSave.is_open())
+                {
+                    return;
+                }
+                mSave << name << '\t' << m.ns;
+                for (const auto &c : m.counters)
+                {
+                    mSave << '\t';
+                    if (c.is_some())
+                    {
+                        mSave << c.unwrap();
+                    }
+                    else
+                    {
+                        mSave << '-';
+                    }
+                }
+                mSave << std::endl;
+            }
+
+        private:
+            void
+            load(const char *path)
+            {
+                std::ifstream in(path);
+                if (!in)
+                {
+                    std::fprintf(stderr, "warning: couldn't read baseline '%s'\n", path);
+                    return;
+                }
+                std::string line;
+                while (std::getline(in, line))
+                {
+                    std::istringstream fields(line);
+                    std::string name, field;
+                    Measurement m{};
+                    if (!std::getline(fields, name, '\t') || !std::getline(fields, field, '\t'))
+                    {
+                        continue;
+                    }
+                    m.ns = std::strtod(field.c_str(), nullptr);
+                    for (auto &c : m.counters)
+                    {
+                        if (std::getline(fields, field, '\t') && field != "-")
+                        {
+                            c = Option<double>(std::strtod(field.c_str(), nullptr));
+                        }
+                    }
+                    mBaseline[name] = m; // Later runs of the same benchmark win
+                }
+            }
+
+            PerfCounters mCounters;
+            std::ofstream mSave;
+            std::map<std::string, Measurement, std::less<>> mBaseline;
+        };
+
+        /// Formats the change from `before` to `after` as `(+12.3%)`, or
+        /// nothing without a baseline
+        inline std::string
+        delta(Option<double> before, Option<double> after)
+        {
+            if (before.is_none() || after.is_none() || before.unwrap() == 0.0)
+            {
+                return "";
+            }
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), " (%+.1f%%)", (after.unwrap() / before.unwrap() - 1.0) * 100.0);
+            return buf;
+        }
+
+        inline void
+        report(std::string_view name, size_t iters, const Measurement &m)
+        {
+            auto base = Session::get().baseline(std::string(name));
+            auto base_counter = [&](Counter c)
+            {
+                return base.is_some() ? base.unwrap().counters[size_t(c)] : Option<double>();
+            };
+            auto base_ns = base.is_some() ? Option<double>(base.unwrap().ns) : Option<double>();
+
+            std::printf("%-48.*s %12.2f ns/iter (%zu iters)%s\n", (int)name.size(), name.data(), m.ns, iters,
+                        delta(base_ns, Option<double>(m.ns)).c_str());
+
+            std::string line;
+            for (size_t i = 0; i < CounterCount; i++)
+            {
+                if (m.counters[i].is_some())
+                {
+                    char buf[64];
+                    std::snprintf(buf, sizeof(buf), "  %s %.2f", CounterNames[i], m.counters[i].unwrap());
+                    line += buf;
+                    line += delta(base_counter(Counter(i)), m.counters[i]);
+                }
+            }
+            auto instructions = m.counters[size_t(Counter::Instructions)];
+            auto cycles = m.counters[size_t(Counter::Cycles)];
+            if (instructions.is_some() && cycles.is_some() && cycles.unwrap() > 0.0)
+            {
+                char buf[32];
+                std::snprintf(buf, sizeof(buf), "  IPC %.2f", instructions.unwrap() / cycles.unwrap());
+                line += buf;
+            }
+            if (!line.empty())
+            {
+                std::printf("%48s%s\n", "", line.c_str());
+            }
+        }
+    }
+
+    /// Runs `f` for `iters` iterations (after a short warmup) and prints the
+    /// mean time per iteration, along with instructions, cycles, IPC,
+    /// branch-misses and L1d/LLC misses per iteration where the hardware
+    /// counters are available.
+    ///
+    /// Set `RUSTLY_BENCH_SAVE=<file>` to append the results to a file, and
+    /// `RUSTLY_BENCH_BASELINE=<file>` to print the change from a saved run.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// bench::run("option/unwrap_or", 1'000'000, [&]() { bench::black_box(x.unwrap_or(0)); });
+    /// ```
+    template <class F>
+    inline Measurement
+    run(std::string_view name, size_t iters, F &&f)
+    {
+        auto &session = detail::Session::get();
+        for (size_t i = 0; i < iters / 10; i++)
+        {
+            f();
+        }
+
+        session.counters().start();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iters; i++)
+        {
+            f();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto counters = session.counters().stop();
+
+        Measurement m{std::chrono::duration<double, std::nano>(elapsed).count() / (double)iters, {}};
+        for (size_t i = 0; i < CounterCount; i++)
+        {
+            if (counters[i].is_some())
+            {
+                m.counters[i] = Option<double>(counters[i].unwrap() / (double)iters);
+            }
+        }
+
+        detail::report(name, iters, m);
+        session.save(name, m);
+        return m;
+    }
+
+    /// Times each of `iters` calls to `f(i)` individually, and prints the
+    /// median, p99 and p99.9 latency in nanoseconds.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// bench::latency("log_info", 10'000, [&](size_t i) { log_info("{}", i); });
+    /// ```
+    template <class F>
+    inline HistogramSnapshot
+    latency(std::string_view name, size_t iters, F &&f)
+    {
+        Histogram histogram(1);
+        for (size_t i = 0; i < iters; i++)
+        {
+            auto start = Instant::now();
+            f(i);
+            histogram.record(start.elapsed());
+        }
+
+        auto snap = histogram.snapshot();
+        std::printf("%-48.*s median %8llu ns   p99 %8llu ns   p99.9 %8llu ns\n", (int)name.size(), name.data(),
+                    (unsigned long long)snap.percentile(50.0).unwrap_or_default(),
+                    (unsigned long long)snap.percentile(99.0).unwrap_or_default(),
+                    (unsigned long long)snap.percentile(99.9).unwrap_or_default());
+        return snap;
+    }
+}
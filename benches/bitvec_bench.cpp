@@ -0,0 +1,86 @@
+#include <bench.h>
+#include <random>
+#include <rustly/bitvec.h>
+#include <string>
+
+using namespace rustly;
+
+// Bulk operations on 1G-bit vectors at each CPU tier, and iterating over the
+// set bits of a 64M-bit vector at several densities
+
+namespace
+{
+    BitVec
+    random_bits(size_t len, double density, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        BitVec v(len);
+        if (density >= 0.5)
+        {
+            v.fill(true);
+        }
+        // Sets (or clears) a random subset, rather than drawing every bit
+        size_t flips = static_cast<size_t>(double(len) * (density >= 0.5 ? 1 - density : density));
+        std::uniform_int_distribution<size_t> index(0, len - 1);
+        for (size_t i = 0; i < flips; i++)
+        {
+            v.set(index(rng), density < 0.5);
+        }
+        return v;
+    }
+}
+
+int main()
+{
+    constexpr size_t Bits = size_t(1) << 30;
+    std::printf("cpu tier: %.*s\n", (int)cpu::name(cpu::tier()).size(), cpu::name(cpu::tier()).data());
+
+    auto a = random_bits(Bits, 0.5, 1);
+    auto b = random_bits(Bits, 0.1, 2);
+    for (auto t : {cpu::Tier::Scalar, cpu::Tier::Sse42, cpu::Tier::Avx2, cpu::Tier::Avx512})
+    {
+        if (cpu::force_tier(t) != t)
+        {
+            continue;
+        }
+        std::string tier(cpu::name(t));
+        bench::run(tier + ": 1G bits &=", 5, [&]()
+                   { a &= b; bench::black_box(a); });
+        bench::run(tier + ": 1G bits |=", 5, [&]()
+                   { a |= b; bench::black_box(a); });
+        bench::run(tier + ": 1G bits ^=", 5, [&]()
+                   { a ^= b; bench::black_box(a); });
+        bench::run(tier + ": 1G bits and_not", 5, [&]()
+                   { a.and_not(b); bench::black_box(a); });
+        bench::run(tier + ": 1G bits count_ones", 5, [&]()
+                   { bench::black_box(a.count_ones()); });
+    }
+    cpu::force_tier(None());
+
+    constexpr size_t IterBits = size_t(1) << 26;
+    for (double density : {0.001, 0.01, 0.1, 0.5})
+    {
+        auto v = random_bits(IterBits, density, 3);
+        std::string suffix = " (" + std::to_string(v.count_ones()) + " of 64M set)";
+        bench::run("for (i : ones())" + suffix, 5, [&]()
+                   {
+                       size_t sum = 0;
+                       for (size_t i : v.ones())
+                       {
+                           sum += i;
+                       }
+                       bench::black_box(sum); });
+        bench::run("for (i < len) if (test(i))" + suffix, 5, [&]()
+                   {
+                       size_t sum = 0;
+                       for (size_t i = 0; i < v.len(); i++)
+                       {
+                           if (v.test(i))
+                           {
+                               sum += i;
+                           }
+                       }
+                       bench::black_box(sum); });
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <bench.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <rustly/cache.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace rustly;
+
+// Hit rate and throughput of `Cache` on a Zipfian workload, at 1 to 32
+// threads, against a single mutex-guarded LRU list. Each miss inserts the key,
+// as `get_or_try_insert_with` would.
+
+namespace
+{
+    constexpr size_t Keys = 100'000;
+    constexpr size_t Capacity = 10'000;
+    constexpr size_t Ops = 4'000'000;
+
+    /// A trace of `n` keys in `[0, Keys)`, where key `k` has weight
+    /// `1 / (k + 1)^s`
+    std::vector<uint32_t>
+    zipf_trace(size_t n, double s, uint64_t seed)
+    {
+        std::vector<double> cdf(Keys);
+        double sum = 0;
+        for (size_t k = 0; k < Keys; k++)
+        {
+            sum += 1.0 / std::pow(double(k + 1), s);
+            cdf[k] = sum;
+        }
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> u(0, sum);
+        std::vector<uint32_t> trace(n);
+        for (auto &key : trace)
+        {
+            key = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin());
+        }
+        // Scatter popular keys over the key space, as real keys would be
+        std::vector<uint32_t> perm(Keys);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::shuffle(perm.begin(), perm.end(), std::mt19937_64(1));
+        for (auto &key : trace)
+        {
+            key = perm[key];
+        }
+        return trace;
+    }
+
+    class LockedLru
+    {
+    public:
+        explicit LockedLru(size_t capacity) : mCapacity(capacity) {}
+
+        bool
+        get_or_insert(uint32_t key)
+        {
+            std::lock_guard lock(mMutex);
+            auto it = mIndex.find(key);
+            if (it != mIndex.end())
+            {
+                mOrder.splice(mOrder.begin(), mOrder, it->second);
+                return true;
+            }
+            if (mIndex.size() == mCapacity)
+            {
+                mIndex.erase(mOrder.back());
+                mOrder.pop_back();
+            }
+            mOrder.push_front(key);
+            mIndex.emplace(key, mOrder.begin());
+            return false;
+        }
+
+    private:
+        size_t mCapacity;
+        std::mutex mMutex;
+        std::list<uint32_t> mOrder;
+        std::unordered_map<uint32_t, std::list<uint32_t>::iterator> mIndex;
+    };
+
+    bool
+    get_or_insert(Cache<uint32_t, uint32_t> &cache, uint32_t key)
+    {
+        if (cache.get(key).is_some())
+        {
+            return true;
+        }
+        cache.insert(key, key);
+        return false;
+    }
+
+    template <class C>
+    void
+    run(const char *name, C &cache, const std::vector<std::vector<uint32_t>> &traces)
+    {
+        std::atomic<size_t> hits{0};
+        std::vector<std::thread> threads;
+        auto start = Instant::now();
+        for (const auto &trace : traces)
+        {
+            threads.emplace_back([&]()
+                                 {
+                                     size_t h = 0;
+                                     for (uint32_t key : trace)
+                                     {
+                                         h += get_or_insert(cache, key);
+                                     }
+                                     hits += h; });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        double secs = start.elapsed().as_secs_f64();
+        std::printf("%-24s %2zu threads %18s hit rate %5.1f%% %10.2f Mops/s\n", name, traces.size(), "",
+                    100.0 * double(hits) / Ops, Ops / secs / 1e6);
+    }
+
+    bool
+    get_or_insert(LockedLru &lru, uint32_t key)
+    {
+        return lru.get_or_insert(key);
+    }
+}
+
+int main()
+{
+    for (size_t threads : {1, 2, 4, 8, 16, 32})
+    {
+        std::vector<std::vector<uint32_t>> traces;
+        for (size_t t = 0; t < threads; t++)
+        {
+            traces.push_back(zipf_trace(Ops / threads, 0.99, t));
+        }
+        Cache<uint32_t, uint32_t> sieve(Capacity);
+        run("Cache (SIEVE, sharded)", sieve, traces);
+        LockedLru lru(Capacity);
+        run("LRU (one mutex)", lru, traces);
+    }
+
+    // Every 8th access is to a key from a one-off scan, which LRU admits at
+    // the front and SIEVE evicts first
+    auto trace = zipf_trace(Ops, 0.99, 42);
+    for (size_t i = 0; i < trace.size(); i += 8)
+    {
+        trace[i] = static_cast<uint32_t>(Keys + i);
+    }
+    Cache<uint32_t, uint32_t> sieve(Capacity);
+    run("Cache, with scans", sieve, {trace});
+    LockedLru lru(Capacity);
+    run("LRU, with scans", lru, {trace});
+    return 0;
+}
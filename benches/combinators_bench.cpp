@@ -0,0 +1,112 @@
+#include <bench.h>
+#include <cstdint>
+#include <random>
+#include <rustly/option.h>
+#include <rustly/result.h>
+#include <vector>
+
+using namespace rustly;
+
+// Each combinator is measured against the raw branch it replaces, over inputs
+// that are `Some`/`Ok` with probability `p`: at 50% the branch predictor is
+// defeated, at 100% the branch is free and only the abstraction's overhead
+// remains.
+
+namespace
+{
+    constexpr size_t Inputs = 4096; // Power of two, and fits in L1d
+    constexpr size_t Iters = 10'000'000;
+
+    struct Data
+    {
+        std::vector<Option<int32_t>> options;
+        std::vector<Result<int32_t, uint32_t>> results;
+        std::vector<int32_t> values;
+        std::vector<bool> present;
+    };
+
+    Data
+    generate(double p)
+    {
+        std::mt19937 rng(42);
+        std::bernoulli_distribution some(p);
+        Data data;
+        for (size_t i = 0; i < Inputs; i++)
+        {
+            auto v = static_cast<int32_t>(rng() & 0xffff);
+            bool is_some = some(rng);
+            data.options.push_back(is_some ? Option<int32_t>(v) : Option<int32_t>());
+            data.results.push_back(is_some ? Ok<int32_t, uint32_t>(v) : Err<int32_t, uint32_t>(uint32_t(v)));
+            data.values.push_back(v);
+            data.present.push_back(is_some);
+        }
+        return data;
+    }
+
+    void
+    run_all(const char *label, Data data)
+    {
+        std::printf("-- %s\n", label);
+        size_t i = 0;
+        auto next = [&]()
+        { return i++ & (Inputs - 1); };
+
+        // unwrap_or
+        bench::run("raw branch (unwrap_or)", Iters, [&]()
+                   { auto j = next(); bench::black_box(data.present[j] ? data.values[j] : 0); });
+        bench::run("Option::unwrap_or_default", Iters, [&]()
+                   { bench::black_box(data.options[next()].unwrap_or_default()); });
+        bench::run("Result::unwrap_or", Iters, [&]()
+                   { bench::black_box(data.results[next()].unwrap_or(0)); });
+
+        // map + unwrap_or
+        bench::run("raw branch (map)", Iters, [&]()
+                   { auto j = next(); bench::black_box(data.present[j] ? data.values[j] * 2 + 1 : 0); });
+        std::function<int32_t(int32_t)> f = [](int32_t x)
+        { return x * 2 + 1; };
+        bench::run("Option::map.unwrap_or_default", Iters, [&]()
+                   { bench::black_box(data.options[next()].map(f).unwrap_or_default()); });
+        bench::run("Result::map.unwrap_or", Iters, [&]()
+                   { bench::black_box(data.results[next()].map(f).unwrap_or(0)); });
+
+        // and_then chains
+        bench::run("raw branch (and_then x2)", Iters, [&]()
+                   {
+                       auto j = next();
+                       int32_t out = 0;
+                       if (data.present[j] && data.values[j] % 3 != 0)
+                       {
+                           int32_t x = data.values[j] / 3;
+                           if (x % 2 == 0)
+                           {
+                               out = x / 2;
+                           }
+                       }
+                       bench::black_box(out); });
+        std::function<Option<int32_t>(int32_t)> third = [](int32_t x)
+        { return x % 3 != 0 ? Option<int32_t>(x / 3) : Option<int32_t>(); };
+        std::function<Option<int32_t>(int32_t)> half = [](int32_t x)
+        { return x % 2 == 0 ? Option<int32_t>(x / 2) : Option<int32_t>(); };
+        bench::run("Option::and_then x2.unwrap_or_default", Iters, [&]()
+                   { bench::black_box(data.options[next()].and_then(third).and_then(half).unwrap_or_default()); });
+        std::function<Result<int32_t, uint32_t>(int32_t)> rthird = [](int32_t x)
+        { return x % 3 != 0 ? Ok<int32_t, uint32_t>(x / 3) : Err<int32_t, uint32_t>(3); };
+        std::function<Result<int32_t, uint32_t>(int32_t)> rhalf = [](int32_t x)
+        { return x % 2 == 0 ? Ok<int32_t, uint32_t>(x / 2) : Err<int32_t, uint32_t>(2); };
+        bench::run("Result::and_then x2.unwrap_or", Iters, [&]()
+                   { bench::black_box(data.results[next()].and_then(rthird).and_then(rhalf).unwrap_or(0)); });
+
+        // Conversions
+        bench::run("Option::ok_or", Iters, [&]()
+                   { bench::black_box(data.options[next()].ok_or(1u).is_ok()); });
+        bench::run("Result::ok", Iters, [&]()
+                   { bench::black_box(data.results[next()].ok().is_some()); });
+    }
+}
+
+int main()
+{
+    run_all("p(Some) = 50%", generate(0.5));
+    run_all("p(Some) = 100%", generate(1.0));
+    return 0;
+}
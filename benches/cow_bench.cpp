@@ -0,0 +1,104 @@
+#include <bench.h>
+#include <random>
+#include <rustly/cow.h>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+// Escaping a corpus in which 95% of the strings need no change: returning a
+// `Cow` only allocates for the 5% that do, while returning a `std::string`
+// allocates for every string too long for the small string buffer
+
+namespace
+{
+    bool
+    needs_escape(char c)
+    {
+        return c == '"' || c == '\\';
+    }
+
+    template <class Out>
+    void
+    escape_into(std::string_view s, Out &out)
+    {
+        for (char c : s)
+        {
+            if (needs_escape(c))
+            {
+                out.push_back('\\');
+            }
+            out.push_back(c);
+        }
+    }
+
+    std::string
+    escape_string(std::string_view s)
+    {
+        std::string out;
+        out.reserve(s.size());
+        escape_into(s, out);
+        return out;
+    }
+
+    Cow<std::string_view>
+    escape_cow(std::string_view s)
+    {
+        size_t first = 0;
+        while (first < s.size() && !needs_escape(s[first]))
+        {
+            first++;
+        }
+        if (first == s.size())
+        {
+            return s;
+        }
+        std::string out;
+        out.reserve(s.size() + 8);
+        out.append(s.substr(0, first));
+        escape_into(s.substr(first), out);
+        return out;
+    }
+}
+
+int main()
+{
+    constexpr size_t Strings = 4096;
+    constexpr size_t Iters = 1'000;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> length(16, 64);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<std::string> corpus(Strings);
+    for (auto &s : corpus)
+    {
+        s.resize(length(rng));
+        for (char &c : s)
+        {
+            c = static_cast<char>(letter(rng));
+        }
+        if (percent(rng) < 5)
+        {
+            s[s.size() / 2] = '"';
+        }
+    }
+
+    bench::run("std::string escape(corpus)", Iters, [&]()
+               {
+                   size_t total = 0;
+                   for (const auto &s : corpus)
+                   {
+                       total += escape_string(s).size();
+                   }
+                   bench::black_box(total); });
+    bench::run("Cow escape(corpus)", Iters, [&]()
+               {
+                   size_t total = 0;
+                   for (const auto &s : corpus)
+                   {
+                       total += escape_cow(s).size();
+                   }
+                   bench::black_box(total); });
+    return 0;
+}
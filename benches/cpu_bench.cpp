@@ -0,0 +1,43 @@
+#include <bench.h>
+#include <rustly/cpu.h>
+
+using namespace rustly;
+
+// The cost of calling a kernel through `cpu::Dispatch` rather than directly,
+// with the kernel kept out of line so that only the call differs
+
+namespace
+{
+    [[gnu::noinline]] uint64_t
+    add_scalar(uint64_t a, uint64_t b)
+    {
+        return a + b;
+    }
+
+    [[gnu::noinline]] RUSTLY_TARGET_AVX2 uint64_t
+    add_avx2(uint64_t a, uint64_t b)
+    {
+        return a + b;
+    }
+
+    cpu::Dispatch<uint64_t(uint64_t, uint64_t)> add{add_scalar, nullptr, add_avx2};
+}
+
+int main()
+{
+    std::printf("cpu tier: %.*s (detected %.*s)\n", (int)cpu::name(cpu::tier()).size(), cpu::name(cpu::tier()).data(),
+                (int)cpu::name(cpu::detect()).size(), cpu::name(cpu::detect()).data());
+
+    uint64_t x = 0;
+    bench::run("direct call", 100'000'000, [&]()
+               { x = add_scalar(x, 1); bench::black_box(x); });
+    auto *fn = add.get(cpu::tier());
+    bench::black_box(fn);
+    bench::run("function pointer call", 100'000'000, [&]()
+               { x = fn(x, 1); bench::black_box(x); });
+    bench::run("cpu::Dispatch call", 100'000'000, [&]()
+               { x = add(x, 1); bench::black_box(x); });
+    bench::run("cpu::detect", 10'000, []()
+               { bench::black_box(cpu::detect()); });
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <bench.h>
+#include <memory>
+#include <ostream>
+#include <rustly/dyn.h>
+#include <vector>
+
+using namespace rustly;
+
+// Storing and then displaying 10M errors of three different types, through
+// `Dyn<traits::Error>`, an up-front `std::string`, and a virtual base class
+
+namespace
+{
+    constexpr size_t Count = 10'000'000;
+
+    struct NotFound
+    {
+        uint32_t id;
+        std::string to_string() const noexcept { return "not found: " + std::to_string(id); }
+        friend std::ostream &operator<<(std::ostream &os, const NotFound &e) { return os << "not found: " << e.id; }
+    };
+
+    struct Timeout
+    {
+        uint64_t millis;
+        std::string to_string() const noexcept { return "timed out after " + std::to_string(millis) + "ms"; }
+        friend std::ostream &operator<<(std::ostream &os, const Timeout &e) { return os << "timed out after " << e.millis << "ms"; }
+    };
+
+    struct Io
+    {
+        int code;
+        const char *path;
+        std::string to_string() const noexcept { return std::string(path) + ": error " + std::to_string(code); }
+        friend std::ostream &operator<<(std::ostream &os, const Io &e) { return os << e.path << ": error " << e.code; }
+    };
+
+    /// The classic alternative: one heap-allocated subclass per error
+    struct Base
+    {
+        virtual ~Base() = default;
+        virtual void write(std::ostream &os) const = 0;
+    };
+
+    template <class E>
+    struct Derived final : Base
+    {
+        explicit Derived(E e) : error(e) {}
+        void write(std::ostream &os) const override { os << error; }
+        E error;
+    };
+
+    /// Counts the bytes written, so that formatting is measured rather than
+    /// buffering
+    class CountingBuf : public std::streambuf
+    {
+    public:
+        size_t count = 0;
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            count++;
+            return c;
+        }
+        std::streamsize xsputn(const char *, std::streamsize n) override
+        {
+            count += static_cast<size_t>(n);
+            return n;
+        }
+    };
+
+    template <class F>
+    auto
+    make(size_t i, F &&f)
+    {
+        switch (i % 3)
+        {
+        case 0:
+            return f(NotFound{static_cast<uint32_t>(i)});
+        case 1:
+            return f(Timeout{i % 5000});
+        default:
+            return f(Io{static_cast<int>(i % 133), "/var/lib/data"});
+        }
+    }
+
+    template <class T, class Make, class Write>
+    void
+    run(std::string_view name, Make &&make_one, Write &&write_one)
+    {
+        std::vector<T> errors;
+        errors.reserve(Count + Count / 10);
+        size_t i = 0;
+        bench::run(std::string(name) + " store", Count, [&]()
+                   { errors.push_back(make(i++, make_one)); });
+
+        CountingBuf buf;
+        std::ostream os(&buf);
+        i = 0;
+        bench::run(std::string(name) + " display", Count, [&]()
+                   { write_one(os, errors[i++ % errors.size()]); });
+        bench::black_box(buf.count);
+    }
+}
+
+int main()
+{
+    run<Dyn<traits::Error>>(
+        "Dyn<Error>", [](auto e)
+        { return Dyn<traits::Error>(e); },
+        [](std::ostream &os, const Dyn<traits::Error> &e)
+        { os << e; });
+    run<std::string>(
+        "std::string", [](auto e)
+        { return e.to_string(); },
+        [](std::ostream &os, const std::string &e)
+        { os << e; });
+    run<std::unique_ptr<Base>>(
+        "std::unique_ptr<Base>", [](auto e)
+        { return std::unique_ptr<Base>(std::make_unique<Derived<decltype(e)>>(e)); },
+        [](std::ostream &os, const std::unique_ptr<Base> &e)
+        { e->write(os); });
+    return 0;
+}
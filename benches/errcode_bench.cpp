@@ -0,0 +1,65 @@
+#include <bench.h>
+#include <rustly/errcode.h>
+#include <rustly/result.h>
+#include <string>
+
+using namespace rustly;
+
+// Throughput of the error path: creating an `Err`, and checking which error
+// it is, with `ErrorCode` and with a `std::string` message
+
+enum class ParseErrc : uint32_t
+{
+    Eof,
+    BadDigit,
+};
+
+RUSTLY_ERROR_DOMAIN(ParseErrc, 2, "parse", "unexpected end of input", "invalid digit")
+
+namespace
+{
+    [[gnu::noinline]] Result<int, ErrorCode>
+    parse_code(char c)
+    {
+        if (c < '0' || c > '9')
+        {
+            return Err<int, ErrorCode>(c == '\0' ? ParseErrc::Eof : ParseErrc::BadDigit);
+        }
+        return Ok<int, ErrorCode>(c - '0');
+    }
+
+    [[gnu::noinline]] Result<int, std::string>
+    parse_string(char c)
+    {
+        if (c < '0' || c > '9')
+        {
+            return Err<int, std::string>(c == '\0' ? "unexpected end of input" : "invalid digit: not a decimal number");
+        }
+        return Ok<int, std::string>(c - '0');
+    }
+}
+
+int main()
+{
+    constexpr size_t Iters = 10'000'000;
+    std::printf("sizeof(Result<int, ErrorCode>) = %zu, sizeof(Result<int, std::string>) = %zu\n",
+                sizeof(Result<int, ErrorCode>), sizeof(Result<int, std::string>));
+
+    char input = 'x';
+    bench::black_box(input);
+    size_t errors = 0;
+    bench::run("Result<int, ErrorCode> error path", Iters, [&]()
+               {
+                   auto r = parse_code(input);
+                   errors += r.is_err() && r.unwrap_err() == ParseErrc::BadDigit; });
+    bench::run("Result<int, std::string> error path", Iters, [&]()
+               {
+                   auto r = parse_string(input);
+                   errors += r.is_err() && r.unwrap_err().starts_with("invalid digit"); });
+    bench::run("ErrorCode::message", Iters, [&]()
+               { bench::black_box(ErrorCode(ParseErrc::BadDigit).message()); });
+    bench::run("ErrorCode::message (os)", Iters, [&]()
+               { bench::black_box(ErrorCode::from_errno(ENOENT).message()); });
+    bench::black_box(errors);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <bench.h>
+#include <fstream>
+#include <rustly/fs.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+// Reading 1M small config files, as 10K files read 100 times over, with
+// `fs::read_to_string` against `std::ifstream` and `std::stringstream`
+
+int main()
+{
+    constexpr size_t Files = 10'000;
+    constexpr size_t Passes = 100;
+
+    char dir[] = "/tmp/rustly_fs_bench_XXXXXX";
+    if (::mkdtemp(dir) == nullptr)
+    {
+        return 1;
+    }
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < Files; i++)
+    {
+        paths.push_back(std::string(dir) + "/" + std::to_string(i) + ".conf");
+        std::string contents;
+        for (size_t line = 0; line < 8 + i % 24; line++)
+        {
+            contents += "key_" + std::to_string(line) + " = " + std::to_string(i * line) + "\n";
+        }
+        fs::write(paths.back(), contents).unwrap();
+    }
+
+    size_t i = 0;
+    bench::run("std::ifstream + std::stringstream (small files)", Files * Passes, [&]()
+               {
+                   std::ifstream in(paths[i++ % Files]);
+                   std::stringstream ss;
+                   ss << in.rdbuf();
+                   bench::black_box(ss.str()); });
+    bench::run("fs::read_to_string (small files)", Files * Passes, [&]()
+               { bench::black_box(fs::read_to_string(paths[i++ % Files])); });
+    bench::run("fs::read (small files)", Files * Passes, [&]()
+               { bench::black_box(fs::read(paths[i++ % Files])); });
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <bench.h>
+#include <functional>
+#include <rustly/function.h>
+
+using namespace rustly;
+
+namespace
+{
+    struct Large
+    {
+        uint64_t a, b, c, d, e;
+    };
+
+    /// Constructs a callable from a capture, then calls it once
+    template <class F, class Capture>
+    void
+    construct_and_call(std::string_view name, Capture capture)
+    {
+        bench::run(name, 10'000'000, [&]()
+                   {
+                       F f = [capture](uint64_t x) { return x + capture.a; };
+                       bench::black_box(f(1)); });
+    }
+
+    /// Calls an already constructed callable
+    template <class F, class Capture>
+    void
+    call(std::string_view name, Capture capture)
+    {
+        F f = [capture](uint64_t x) { return x + capture.a; };
+        bench::black_box(f);
+        uint64_t x = 0;
+        bench::run(name, 100'000'000, [&]()
+                   { x = f(x); bench::black_box(x); });
+    }
+
+    template <class Capture>
+    void
+    run_all(std::string_view size, Capture capture)
+    {
+        std::string suffix = " (" + std::string(size) + ")";
+        construct_and_call<std::function<uint64_t(uint64_t)>>("std::function construct + call" + suffix, capture);
+#if __cpp_lib_move_only_function
+        construct_and_call<std::move_only_function<uint64_t(uint64_t)>>("std::move_only_function construct + call" + suffix, capture);
+#endif
+        construct_and_call<FnMut<uint64_t(uint64_t)>>("FnMut construct + call" + suffix, capture);
+
+        call<std::function<uint64_t(uint64_t)>>("std::function call" + suffix, capture);
+#if __cpp_lib_move_only_function
+        call<std::move_only_function<uint64_t(uint64_t)>>("std::move_only_function call" + suffix, capture);
+#endif
+        call<FnMut<uint64_t(uint64_t)>>("FnMut call" + suffix, capture);
+    }
+}
+
+int main()
+{
+    struct Small
+    {
+        uint64_t a, b;
+    };
+    run_all("16B capture", Small{1, 2});
+    run_all("40B capture", Large{1, 2, 3, 4, 5});
+    return 0;
+}
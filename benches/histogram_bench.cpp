@@ -0,0 +1,61 @@
+#include <bench.h>
+#include <rustly/histogram.h>
+#include <thread>
+#include <vector>
+
+using namespace rustly;
+
+/// Records `per_thread` values from each of `threads` threads, and prints the
+/// aggregate record throughput
+static void record_throughput(size_t threads, size_t per_thread)
+{
+    Histogram histogram;
+    std::vector<std::thread> workers;
+    auto start = Instant::now();
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&histogram, per_thread, t]()
+                             {
+            uint64_t v = t * 7919;
+            for (size_t i = 0; i < per_thread; i++)
+            {
+                v = v * 6364136223846793005ull + 1442695040888963407ull; // LCG
+                histogram.record(v >> 40);
+            } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double secs = start.elapsed().as_secs_f64();
+    std::printf("record, %2zu threads %34s %12.2f Mrecords/s\n", threads, "",
+                (double)(threads * per_thread) / secs / 1e6);
+}
+
+int main()
+{
+    Histogram single(1);
+    uint64_t v = 1;
+    bench::run("Histogram::record", 100'000'000, [&]()
+               { single.record(v++ & 0xfffff); });
+
+    for (size_t threads : {1, 4, 16, 64})
+    {
+        record_throughput(threads, 10'000'000 / threads * 4);
+    }
+
+    Histogram sharded(16);
+    for (uint64_t i = 0; i < 1'000'000; i++)
+    {
+        sharded.record(i);
+    }
+    bench::run("Histogram::snapshot (16 shards)", 1'000, [&]()
+               { bench::black_box(sharded.snapshot()); });
+
+    auto a = sharded.snapshot(), b = sharded.snapshot();
+    bench::run("HistogramSnapshot::merge", 10'000, [&]()
+               { a.merge(b); });
+    bench::run("HistogramSnapshot::percentile(99.9)", 10'000, [&]()
+               { bench::black_box(b.percentile(99.9)); });
+    return 0;
+}
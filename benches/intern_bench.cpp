@@ -0,0 +1,109 @@
+#include <bench.h>
+#include <cmath>
+#include <random>
+#include <rustly/intern.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace rustly;
+
+// Interning 50M identifier tokens drawn from a Zipfian vocabulary, against a
+// `std::unordered_map` from strings to ids, and comparing symbols against
+// comparing the strings themselves
+
+namespace
+{
+    constexpr size_t Vocabulary = 200'000;
+    constexpr size_t TraceLength = 1 << 20;
+    constexpr size_t Tokens = 50'000'000;
+
+    std::vector<std::string>
+    vocabulary()
+    {
+        std::vector<std::string> words;
+        const char *prefixes[] = {"orders.", "customer_", "line_item.", "tmp_", ""};
+        for (size_t i = 0; i < Vocabulary; i++)
+        {
+            words.push_back(prefixes[i % 5] + std::string("column_") + std::to_string(i * 2654435761u % 1'000'003));
+        }
+        return words;
+    }
+
+    std::vector<uint32_t>
+    trace()
+    {
+        std::vector<double> cdf(Vocabulary);
+        double sum = 0;
+        for (size_t k = 0; k < Vocabulary; k++)
+        {
+            sum += 1.0 / std::pow(double(k + 1), 0.9);
+            cdf[k] = sum;
+        }
+        std::mt19937_64 rng(42);
+        std::uniform_real_distribution<double> u(0, sum);
+        std::vector<uint32_t> t(TraceLength);
+        for (auto &i : t)
+        {
+            i = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin());
+        }
+        return t;
+    }
+}
+
+int main()
+{
+    auto words = vocabulary();
+    auto tokens = trace();
+
+    size_t i = 0;
+    Interner interner;
+    bench::run("Interner::intern", Tokens, [&]()
+               { bench::black_box(interner.intern(words[tokens[i++ & (TraceLength - 1)]])); });
+
+    i = 0;
+    SyncInterner sync;
+    bench::run("SyncInterner::intern", Tokens, [&]()
+               { bench::black_box(sync.intern(words[tokens[i++ & (TraceLength - 1)]])); });
+
+    i = 0;
+    std::unordered_map<std::string_view, uint32_t> map;
+    std::vector<std::string> owned;
+    owned.reserve(Vocabulary);
+    bench::run("std::unordered_map<std::string_view, uint32_t>", Tokens, [&]()
+               {
+                   std::string_view s = words[tokens[i++ & (TraceLength - 1)]];
+                   auto it = map.find(s);
+                   if (it == map.end())
+                   {
+                       it = map.emplace(owned.emplace_back(s), static_cast<uint32_t>(map.size())).first;
+                   }
+                   bench::black_box(it->second); });
+
+    i = 0;
+    bench::run("Interner::lookup", Tokens, [&]()
+               { bench::black_box(interner.lookup(words[tokens[i++ & (TraceLength - 1)]])); });
+    i = 0;
+    bench::run("SyncInterner::lookup", Tokens, [&]()
+               { bench::black_box(sync.lookup(words[tokens[i++ & (TraceLength - 1)]])); });
+
+    // Equality of neighbouring tokens, as in a join or group-by on a key
+    std::vector<Symbol> symbols;
+    std::vector<std::string> strings;
+    for (uint32_t t : tokens)
+    {
+        symbols.push_back(interner.intern(words[t]));
+        strings.push_back(words[t]);
+    }
+    i = 0;
+    bench::run("Symbol == Symbol", Tokens, [&]()
+               {
+                   size_t j = i++ & (TraceLength - 2);
+                   bench::black_box(symbols[j] == symbols[j + 1]); });
+    i = 0;
+    bench::run("std::string == std::string", Tokens, [&]()
+               {
+                   size_t j = i++ & (TraceLength - 2);
+                   bench::black_box(strings[j] == strings[j + 1]); });
+    return 0;
+}
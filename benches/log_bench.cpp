@@ -0,0 +1,51 @@
+#include <bench.h>
+#include <cstdio>
+#include <format>
+#include <rustly/log.h>
+
+using namespace rustly;
+
+int main()
+{
+    FILE *null = std::fopen("/dev/null", "w");
+    logging::set_output(null);
+    logging::set_max_level(logging::Level::Info);
+
+    // Stay well within the per-thread ring so nothing is dropped
+    constexpr size_t Iters = 2'000;
+    constexpr size_t Rounds = 50;
+    auto opt = Some(42);
+    std::string name("request");
+
+    for (size_t round = 0; round < Rounds; round++)
+    {
+        bool last = round + 1 == Rounds;
+        auto run = [&](const char *label, auto &&f)
+        {
+            if (last)
+            {
+                bench::latency(label, Iters, f);
+            }
+            else
+            {
+                for (size_t i = 0; i < Iters; i++)
+                {
+                    f(i);
+                }
+            }
+        };
+
+        run("timer overhead", [](size_t) {});
+        run("log_info (deferred)", [&](size_t i)
+            { log_info("{} {} took {} us, cached: {}", name, i, 1.5 * i, opt); });
+        run("std::format + fwrite", [&](size_t i)
+            {
+                auto m = std::format("{} {} took {} us, cached: {}\n", name, i, 1.5 * i, opt.unwrap());
+                std::fwrite(m.data(), 1, m.size(), null); });
+        logging::flush();
+    }
+
+    logging::set_output(stderr);
+    std::fclose(null);
+    return 0;
+}
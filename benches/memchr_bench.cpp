@@ -0,0 +1,73 @@
+#include <bench.h>
+#include <cstring>
+#include <random>
+#include <rustly/memchr.h>
+#include <string>
+#include <string_view>
+
+using namespace rustly;
+
+// Searching a 64MiB haystack of English-like text for bytes and substrings
+// that don't occur, so each search scans all of it, against the C library
+// and `std::string_view::find`, at each CPU tier
+
+namespace
+{
+    std::string
+    random_text(size_t len, uint64_t seed)
+    {
+        // Lowercase letters and spaces only, so that the needles below never
+        // match
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<int> letter(0, 26);
+        std::string s(len, ' ');
+        for (char &c : s)
+        {
+            int l = letter(rng);
+            c = l == 26 ? ' ' : static_cast<char>('a' + l);
+        }
+        return s;
+    }
+}
+
+int main()
+{
+    constexpr size_t Len = size_t(64) << 20;
+    std::printf("cpu tier: %.*s\n", (int)cpu::name(cpu::tier()).size(), cpu::name(cpu::tier()).data());
+
+    std::string text = random_text(Len, 1);
+    std::string_view haystack = text;
+    // Common first and last bytes, so the prefilter has candidates to reject
+    std::string_view needle = "the quick brown fox jumps over the lazy dog!";
+
+    bench::run("::memchr 64MiB", 10, [&]()
+               { bench::black_box(::memchr(haystack.data(), '!', haystack.size())); });
+    bench::run("string_view::find(char) 64MiB", 10, [&]()
+               { bench::black_box(haystack.find('!')); });
+    bench::run("::memrchr 64MiB", 10, [&]()
+               { bench::black_box(::memrchr(haystack.data(), '!', haystack.size())); });
+    bench::run("::memmem 64MiB", 10, [&]()
+               { bench::black_box(::memmem(haystack.data(), haystack.size(), needle.data(), needle.size())); });
+    bench::run("string_view::find(string_view) 64MiB", 10, [&]()
+               { bench::black_box(haystack.find(needle)); });
+
+    for (auto t : {cpu::Tier::Scalar, cpu::Tier::Sse42, cpu::Tier::Avx2, cpu::Tier::Avx512})
+    {
+        if (cpu::force_tier(t) != t)
+        {
+            continue;
+        }
+        std::string tier(cpu::name(t));
+        bench::run(tier + ": memchr 64MiB", 10, [&]()
+                   { bench::black_box(rustly::memchr('!', haystack)); });
+        bench::run(tier + ": memchr3 64MiB", 10, [&]()
+                   { bench::black_box(memchr3('!', '?', '.', haystack)); });
+        bench::run(tier + ": memrchr 64MiB", 10, [&]()
+                   { bench::black_box(rustly::memrchr('!', haystack)); });
+        Finder finder(needle);
+        bench::run(tier + ": Finder::find 64MiB", 10, [&]()
+                   { bench::black_box(finder.find(haystack)); });
+    }
+    cpu::force_tier(None());
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <bench.h>
+#include <rustly/option.h>
+#include <vector>
+
+using namespace rustly;
+
+// A memoized `Option<std::vector<double>>` updated on every iteration: in
+// place, and through the copying `cache = Some(f(cache.unwrap()))` pattern
+
+namespace
+{
+    constexpr size_t Size = 256;
+
+    std::vector<double>
+    compute()
+    {
+        return std::vector<double>(Size, 1.0);
+    }
+}
+
+int main()
+{
+    constexpr size_t Iters = 1'000'000;
+
+    Option<std::vector<double>> cache;
+    size_t i = 0;
+    bench::run("copy: cache = Some(update(cache.unwrap()))", Iters, [&]()
+               {
+                   if (cache.is_none())
+                   {
+                       cache = Some(compute());
+                   }
+                   auto v = cache.unwrap();
+                   v[i++ % Size] += 1.0;
+                   cache = Some(v); });
+
+    cache = None();
+    bench::run("in place: get_or_insert_with", Iters, [&]()
+               { cache.get_or_insert_with(compute)[i++ % Size] += 1.0; });
+
+    // Invalidated every 64 iterations, so it is recomputed
+    bench::run("in place: take_if + get_or_insert_with", Iters, [&]()
+               {
+                   cache.take_if([&](auto &) { return i % 64 == 0; });
+                   cache.get_or_insert_with(compute)[i++ % Size] += 1.0; });
+    bench::run("in place: emplace", Iters, [&]()
+               { cache.emplace(Size, 1.0); });
+    bench::black_box(cache);
+    return 0;
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <rustly/option.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rustly::bench
+{
+    /// Hardware events counted around each benchmark
+    enum class Counter : size_t
+    {
+        Instructions = 0,
+        Cycles,
+        BranchMisses,
+        L1dMisses,
+        LlcMisses,
+    };
+
+    inline constexpr size_t CounterCount = 5;
+    inline constexpr const char *CounterNames[CounterCount] = {"instructions", "cycles", "branch-misses", "L1d-misses", "LLC-misses"};
+
+    /// Counts for one measurement. Each counter is `None` when it couldn't be
+    /// opened, e.g. in containers or VMs without a virtual PMU.
+    using CounterValues = std::array<Option<double>, CounterCount>;
+
+    /// A group of hardware performance counters for the calling thread and
+    /// the threads it creates after, read through `perf_event_open(2)`.
+    class PerfCounters
+    {
+    public:
+        PerfCounters()
+        {
+            mFds.fill(-1);
+#if defined(__linux__)
+            struct Event
+            {
+                uint32_t type;
+                uint64_t config;
+            };
+            constexpr uint64_t L1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const Event events[CounterCount] = {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {PERF_TYPE_HW_CACHE, L1dReadMiss},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            };
+
+            // Cycles lead a group, so that every counter is enabled, disabled
+            // and read at once and they cover the same window. Any other
+            // counter that the PMU doesn't support is left out of the group.
+            // Counters are inherited by threads the benchmark creates, and
+            // summed with the main thread's.
+            constexpr size_t Leader = static_cast<size_t>(Counter::Cycles);
+            auto open = [&](size_t i, int group_fd)
+            {
+                perf_event_attr attr{};
+                attr.size = sizeof(attr);
+                attr.type = events[i].type;
+                attr.config = events[i].config;
+                attr.disabled = group_fd == -1 ? 1 : 0;
+                attr.inherit = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                   PERF_FORMAT_TOTAL_TIME_RUNNING;
+                mFds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+                if (mFds[i] >= 0 && ioctl(mFds[i], PERF_EVENT_IOC_ID, &mIds[i]) != 0)
+                {
+                    close(mFds[i]);
+                    mFds[i] = -1;
+                }
+            };
+            open(Leader, -1);
+            if (mFds[Leader] < 0)
+            {
+                return;
+            }
+            for (size_t i = 0; i < CounterCount; i++)
+            {
+                if (i != Leader)
+                {
+                    open(i, mFds[Leader]);
+                }
+            }
+#endif
+        }
+
+        ~PerfCounters()
+        {
+#if defined(__linux__)
+            for (int fd : mFds)
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        /// Returns `true` if any counter could be opened.
+        bool
+        is_available() const
+        {
+            for (int fd : mFds)
+            {
+                if (fd >= 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// Starts every counter, from a snapshot of their counts.
+        ///
+        /// Resetting isn't enough: counts that inherited threads added to the
+        /// group before exiting survive `PERF_EVENT_IOC_RESET`, so they're
+        /// subtracted instead.
+        void
+        start()
+        {
+#if defined(__linux__)
+            int leader = mFds[static_cast<size_t>(Counter::Cycles)];
+            if (leader >= 0)
+            {
+                ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                mStartValid = read_group(leader, mStart);
+                ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#endif
+        }
+
+        /// Stops every counter, and returns their counts scaled for any time
+        /// the kernel multiplexed the group off the PMU.
+        CounterValues
+        stop()
+        {
+            CounterValues values;
+#if defined(__linux__)
+            int leader = mFds[static_cast<size_t>(Counter::Cycles)];
+            if (leader < 0)
+            {
+                return values;
+            }
+            ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+            GroupRead end;
+            if (!mStartValid || !read_group(leader, end))
+            {
+                return values;
+            }
+            uint64_t enabled = end.enabled - mStart.enabled;
+            uint64_t running = end.running - mStart.running;
+            if (running == 0)
+            {
+                return values;
+            }
+            double scale = static_cast<double>(enabled) / static_cast<double>(running);
+            for (size_t i = 0; i < CounterCount; i++)
+            {
+                if (end.counts[i].is_some() && mStart.counts[i].is_some())
+                {
+                    uint64_t count = end.counts[i].unwrap() - mStart.counts[i].unwrap();
+                    values[i] = Option<double>(static_cast<double>(count) * scale);
+                }
+            }
+#endif
+            return values;
+        }
+
+    private:
+        /// One read of the whole group
+        struct GroupRead
+        {
+            uint64_t enabled = 0;
+            uint64_t running = 0;
+            std::array<Option<uint64_t>, CounterCount> counts;
+        };
+
+#if defined(__linux__)
+        bool
+        read_group(int leader, GroupRead &out) const
+        {
+            // nr, time enabled, time running, then a value and id per counter
+            uint64_t data[3 + 2 * CounterCount];
+            ssize_t n = read(leader, data, sizeof(data));
+            if (n < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+            {
+                return false;
+            }
+            out = GroupRead{data[1], data[2], {}};
+            for (size_t j = 0; j < data[0] && j < CounterCount; j++)
+            {
+                for (size_t i = 0; i < CounterCount; i++)
+                {
+                    if (mFds[i] >= 0 && mIds[i] == data[4 + 2 * j])
+                    {
+                        out.counts[i] = Option<uint64_t>(data[3 + 2 * j]);
+                    }
+                }
+            }
+            return true;
+        }
+#endif
+
+        std::array<int, CounterCount> mFds;
+        /// The kernel's id for each counter, to find its value in a group read
+        std::array<uint64_t, CounterCount> mIds{};
+        /// The counts when the current run started
+        GroupRead mStart;
+        bool mStartValid = false;
+    };
+}
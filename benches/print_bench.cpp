@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <rustly/print.h>
+
+// Prints N lines (100M by default) to stdout with each method, and reports
+// throughput to stderr. Run with stdout redirected, e.g. `> /dev/null`.
+template <class F>
+static void throughput(const char *name, size_t lines, F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%-24s %8.3f s %10.2f Mlines/s\n", name, secs, (double)lines / secs / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    size_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000'000;
+
+    throughput("println", lines, [&]()
+               {
+        for (size_t i = 0; i < lines; i++)
+        {
+            rustly::println("line {} of {}: {:.3f}", i, lines, 0.5 * (double)i);
+        }
+        rustly::io::flush(); });
+
+    throughput("std::cout", lines, [&]()
+               {
+        std::cout.precision(3);
+        std::cout << std::fixed;
+        for (size_t i = 0; i < lines; i++)
+        {
+            std::cout << "line " << i << " of " << lines << ": " << 0.5 * (double)i << '\n';
+        }
+        std::cout.flush(); });
+
+    throughput("printf", lines, [&]()
+               {
+        for (size_t i = 0; i < lines; i++)
+        {
+            std::printf("line %zu of %zu: %.3f\n", i, lines, 0.5 * (double)i);
+        }
+        std::fflush(stdout); });
+
+    return 0;
+}
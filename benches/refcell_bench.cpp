@@ -0,0 +1,33 @@
+#include <bench.h>
+#include <rustly/refcell.h>
+
+using namespace rustly;
+
+// The cost of a guard around each access to a counter, against accessing it
+// directly. `refcell_unchecked_bench` builds this with the checks compiled out.
+
+#ifdef RUSTLY_REFCELL_UNCHECKED
+#define MODE "unchecked"
+#else
+#define MODE "checked"
+#endif
+
+int main()
+{
+    constexpr size_t Iters = 10'000'000;
+
+    uint64_t raw = 0;
+    bench::run("raw: ++x", Iters, [&]()
+               { bench::black_box(++raw); });
+
+    RefCell<uint64_t> cell(0);
+    bench::run(MODE ": ++*cell.borrow_mut()", Iters, [&]()
+               { bench::black_box(++*cell.borrow_mut()); });
+    bench::run(MODE ": *cell.borrow()", Iters, [&]()
+               { bench::black_box(*cell.borrow()); });
+    bench::run(MODE ": ++*cell.try_borrow_mut().unwrap()", Iters, [&]()
+               { bench::black_box(++*cell.try_borrow_mut().unwrap()); });
+    bench::run(MODE ": *cell.try_borrow().unwrap()", Iters, [&]()
+               { bench::black_box(*cell.try_borrow().unwrap()); });
+    return 0;
+}
@@ -0,0 +1,2 @@
+#define RUSTLY_REFCELL_UNCHECKED
+#include "refcell_bench.cpp"
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <bench.h>
+#include <random>
+#include <rustly/sort.h>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+// Sorting 1M 64-bit integers against `std::sort` and `std::stable_sort`, for
+// random, sorted, reversed and few-unique inputs, and 100K strings by a
+// computed key
+
+namespace
+{
+    std::vector<uint64_t>
+    generate(const std::string &pattern, size_t n)
+    {
+        std::mt19937_64 rng(1);
+        std::vector<uint64_t> v(n);
+        for (auto &x : v)
+        {
+            x = pattern == "few unique" ? rng() % 16 : rng();
+        }
+        if (pattern == "sorted")
+        {
+            std::sort(v.begin(), v.end());
+        }
+        else if (pattern == "reversed")
+        {
+            std::sort(v.begin(), v.end(), std::greater<uint64_t>());
+        }
+        return v;
+    }
+}
+
+int main()
+{
+    constexpr size_t N = 1'000'000;
+    for (std::string pattern : {"random", "sorted", "reversed", "few unique"})
+    {
+        const auto input = generate(pattern, N);
+        std::vector<uint64_t> v;
+        auto suffix = " (1M u64, " + pattern + ")";
+        bench::run("std::sort" + suffix, 10, [&]()
+                   { v = input; std::sort(v.begin(), v.end()); bench::black_box(v); });
+        bench::run("sort_unstable" + suffix, 10, [&]()
+                   { v = input; sort_unstable(v); bench::black_box(v); });
+        bench::run("std::stable_sort" + suffix, 10, [&]()
+                   { v = input; std::stable_sort(v.begin(), v.end()); bench::black_box(v); });
+        bench::run("sort" + suffix, 10, [&]()
+                   { v = input; sort(v); bench::black_box(v); });
+        bench::run("std::nth_element" + suffix, 10, [&]()
+                   { v = input; std::nth_element(v.begin(), v.begin() + N / 2, v.end()); bench::black_box(v); });
+        bench::run("select_nth_unstable" + suffix, 10, [&]()
+                   { v = input; bench::black_box(select_nth_unstable(v, N / 2)); });
+    }
+
+    // Keys that are costly to compute, such as a lowercased copy
+    constexpr size_t Strings = 100'000;
+    std::vector<std::string> input;
+    std::mt19937_64 rng(2);
+    for (size_t i = 0; i < Strings; i++)
+    {
+        std::string s(16, ' ');
+        for (char &c : s)
+        {
+            c = static_cast<char>((rng() % 2 ? 'a' : 'A') + rng() % 26);
+        }
+        input.push_back(std::move(s));
+    }
+    auto lowercase = [](const std::string &s)
+    {
+        std::string l = s;
+        std::transform(l.begin(), l.end(), l.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+        return l;
+    };
+    std::vector<std::string> v;
+    bench::run("sort_by_key (100K strings, lowercased)", 10, [&]()
+               { v = input; sort_by_key(v, lowercase); bench::black_box(v); });
+    bench::run("sort_by_cached_key (100K strings, lowercased)", 10, [&]()
+               { v = input; sort_by_cached_key(v, lowercase); bench::black_box(v); });
+    return 0;
+}
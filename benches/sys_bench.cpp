@@ -0,0 +1,49 @@
+#include <bench.h>
+#include <fcntl.h>
+#include <rustly/sys.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace rustly;
+
+// The overhead of the `sys` wrappers over calling libc directly, for cheap
+// syscalls where it would show: reading a byte of /dev/zero, `fstat`, and an
+// eventfd round trip
+
+int main()
+{
+    constexpr size_t Iters = 1'000'000;
+    int zero = ::open("/dev/zero", O_RDONLY | O_CLOEXEC);
+    int efd = ::eventfd(0, EFD_CLOEXEC);
+    char c;
+    uint64_t one = 1, value;
+
+    bench::run("::read 1 byte of /dev/zero", Iters, [&]()
+               { bench::black_box(::read(zero, &c, 1)); });
+    bench::run("sys::read 1 byte of /dev/zero", Iters, [&]()
+               { bench::black_box(sys::read(zero, &c, 1)); });
+
+    bench::run("::read (EBADF)", Iters, [&]()
+               { bench::black_box(::read(-1, &c, 1)); });
+    bench::run("sys::read (EBADF)", Iters, [&]()
+               { bench::black_box(sys::read(-1, &c, 1)); });
+
+    struct stat st;
+    bench::run("::fstat", Iters, [&]()
+               { bench::black_box(::fstat(zero, &st)); bench::black_box(st); });
+    bench::run("sys::fstat", Iters, [&]()
+               { bench::black_box(sys::fstat(zero)); });
+
+    bench::run("::write + ::read eventfd", Iters, [&]()
+               {
+                   bench::black_box(::write(efd, &one, sizeof(one)));
+                   bench::black_box(::read(efd, &value, sizeof(value))); });
+    bench::run("sys::write + sys::read eventfd", Iters, [&]()
+               {
+                   bench::black_box(sys::write(efd, &one, sizeof(one)));
+                   bench::black_box(sys::read(efd, &value, sizeof(value))); });
+
+    ::close(zero);
+    ::close(efd);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <bench.h>
+#include <chrono>
+#include <cmath>
+#include <rustly/time.h>
+#include <thread>
+
+using namespace rustly;
+
+int main()
+{
+    std::printf("clock source: %s\n", Instant::clock_source() == ClockSource::Tsc ? "tsc" : "monotonic");
+
+    // Clock read cost
+    bench::run("Instant::now", 10'000'000, []()
+               { bench::black_box(Instant::now()); });
+    bench::run("CLOCK_MONOTONIC", 10'000'000, []()
+               { bench::black_box(detail::monotonic_nanos()); });
+    bench::run("std::chrono::steady_clock::now", 10'000'000, []()
+               { bench::black_box(std::chrono::steady_clock::now()); });
+    auto start = Instant::now();
+    bench::run("Instant::elapsed", 10'000'000, [&]()
+               { bench::black_box(start.elapsed()); });
+
+    if (!detail::TscClock::is_invariant())
+    {
+        std::printf("no invariant TSC, skipping calibration accuracy\n");
+        return 0;
+    }
+
+    // Calibration accuracy: drift from CLOCK_MONOTONIC over a 200ms interval,
+    // for each calibration window
+    for (uint64_t window : {1, 10, 100})
+    {
+        detail::TscClock tsc(Duration::from_millis(window));
+        uint64_t mono0 = detail::monotonic_nanos(), tsc0 = tsc.nanos();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        uint64_t mono1 = detail::monotonic_nanos(), tsc1 = tsc.nanos();
+        double ppm = ((double)(tsc1 - tsc0) - (double)(mono1 - mono0)) / (double)(mono1 - mono0) * 1e6;
+        std::printf("calibration window %4llums: %.6f GHz, drift %+9.2f ppm\n",
+                    (unsigned long long)window, tsc.hz() / 1e9, ppm);
+    }
+    return 0;
+}
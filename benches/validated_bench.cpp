@@ -0,0 +1,116 @@
+#include <array>
+#include <bench.h>
+#include <memory_resource>
+#include <random>
+#include <rustly/validated.h>
+#include <string_view>
+#include <vector>
+
+using namespace rustly;
+
+// Validating 10M records of 12 fields each, collecting every field error, at
+// several error rates: into a `std::vector` by hand, and with `combine`
+
+namespace
+{
+    constexpr size_t Records = 10'000'000;
+    constexpr size_t Fields = 12;
+    using Record = std::array<int, Fields>;
+
+    struct Row
+    {
+        int fields[Fields];
+    };
+
+    Validated<int, std::string_view>
+    field(int x)
+    {
+        if (x < 0)
+        {
+            return Invalid<int, std::string_view>("field out of range");
+        }
+        return Valid<int, std::string_view>(x);
+    }
+
+    Row
+    make_row(int a, int b, int c, int d, int e, int f, int g, int h, int i, int j, int k, int l)
+    {
+        return Row{{a, b, c, d, e, f, g, h, i, j, k, l}};
+    }
+
+    Validated<Row, std::string_view>
+    validate(const Record &r)
+    {
+        return combine(make_row, field(r[0]), field(r[1]), field(r[2]), field(r[3]), field(r[4]), field(r[5]),
+                       field(r[6]), field(r[7]), field(r[8]), field(r[9]), field(r[10]), field(r[11]));
+    }
+
+    /// The hand-written equivalent
+    bool
+    validate_by_hand(const Record &r, Row &row, std::vector<std::string_view> &errors)
+    {
+        for (size_t i = 0; i < Fields; i++)
+        {
+            if (r[i] < 0)
+            {
+                errors.push_back("field out of range");
+            }
+            row.fields[i] = r[i];
+        }
+        return errors.empty();
+    }
+
+    std::vector<Record>
+    generate(double error_rate)
+    {
+        std::mt19937 rng(42);
+        std::bernoulli_distribution invalid(error_rate);
+        std::vector<Record> records(1 << 16);
+        for (auto &r : records)
+        {
+            for (auto &f : r)
+            {
+                f = invalid(rng) ? -1 : static_cast<int>(rng() % 100);
+            }
+        }
+        return records;
+    }
+}
+
+int main()
+{
+    std::pmr::monotonic_buffer_resource arena(1 << 20);
+
+    for (double rate : {0.0, 0.01, 0.1, 0.5})
+    {
+        auto records = generate(rate);
+        auto suffix = " (" + std::to_string(static_cast<int>(rate * 100)) + "% fields invalid)";
+        size_t i = 0, failed = 0;
+
+        bench::run("std::vector by hand" + suffix, Records, [&]()
+                   {
+                       Row row;
+                       std::vector<std::string_view> errors;
+                       failed += !validate_by_hand(records[i++ % records.size()], row, errors);
+                       bench::black_box(row); });
+
+        bench::run("combine" + suffix, Records, [&]()
+                   {
+                       auto v = validate(records[i++ % records.size()]);
+                       failed += v.is_invalid();
+                       bench::black_box(v); });
+
+        // Errors that spill past the inline ones go to an arena, reset per batch
+        auto *previous = std::pmr::set_default_resource(&arena);
+        bench::run("combine, arena" + suffix, Records, [&]()
+                   {
+                       auto v = validate(records[i++ % records.size()]);
+                       failed += v.is_invalid();
+                       bench::black_box(v);
+                       if (i % 4096 == 0) { arena.release(); } });
+        std::pmr::set_default_resource(previous);
+        arena.release();
+        bench::black_box(failed);
+    }
+    return 0;
+}
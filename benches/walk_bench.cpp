@@ -0,0 +1,80 @@
+#include <atomic>
+#include <bench.h>
+#include <cstdio>
+#include <filesystem>
+#include <rustly/fs.h>
+#include <rustly/walk.h>
+#include <string>
+
+using namespace rustly;
+
+// Walking a tree of ~200K files, 3 levels of 20 directories with 25 files
+// each, with `std::filesystem::recursive_directory_iterator` against
+// `fs::WalkDir` on one thread and on one per CPU
+
+namespace
+{
+    void
+    populate(const std::string &dir, size_t depth)
+    {
+        for (size_t i = 0; i < 25; i++)
+        {
+            fs::write(dir + "/file" + std::to_string(i) + ".dat", "").unwrap();
+        }
+        if (depth == 0)
+        {
+            return;
+        }
+        for (size_t i = 0; i < 20; i++)
+        {
+            auto sub = dir + "/dir" + std::to_string(i);
+            std::filesystem::create_directory(sub);
+            populate(sub, depth - 1);
+        }
+    }
+
+    void
+    report(const char *name, size_t entries, const bench::Measurement &m)
+    {
+        std::printf("%-48s %12.2f M entries/sec\n", name, (double)entries / m.ns * 1e3);
+    }
+}
+
+int main()
+{
+    char root[] = "/tmp/rustly_walk_bench_XXXXXX";
+    if (::mkdtemp(root) == nullptr)
+    {
+        return 1;
+    }
+    populate(root, 3);
+
+    size_t entries = 0;
+    auto m = bench::run("std::filesystem::recursive_directory_iterator", 5, [&]()
+                        {
+                            entries = 0;
+                            for (const auto &entry : std::filesystem::recursive_directory_iterator(root))
+                            {
+                                bench::black_box(entry.is_directory());
+                                entries++;
+                            } });
+    report("std::filesystem", entries, m);
+
+    std::atomic<size_t> walked = 0;
+    m = bench::run("fs::WalkDir (1 thread)", 5, [&]()
+                   {
+                       walked = 0;
+                       fs::WalkDir(root).threads(1).for_each([&](Result<fs::DirEntry, fs::WalkError> entry)
+                                                             { walked.fetch_add(entry.is_ok(), std::memory_order_relaxed); }); });
+    report("fs::WalkDir (1 thread)", walked.load(), m);
+
+    m = bench::run("fs::WalkDir (a thread per CPU)", 5, [&]()
+                   {
+                       walked = 0;
+                       fs::WalkDir(root).for_each([&](Result<fs::DirEntry, fs::WalkError> entry)
+                                                  { walked.fetch_add(entry.is_ok(), std::memory_order_relaxed); }); });
+    report("fs::WalkDir (a thread per CPU)", walked.load(), m);
+
+    std::filesystem::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,726 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <rustly/option.h>
+
+namespace rustly::alloc
+{
+    /// The most scopes that can be registered, including the implicit
+    /// `(unscoped)`. Later scopes are attributed to `(unscoped)`.
+    inline constexpr size_t MaxScopes = 256;
+
+    /// The deepest `AllocScope` nesting that is tracked. Deeper scopes are
+    /// attributed to the innermost tracked one.
+    inline constexpr size_t MaxDepth = 64;
+
+    using ScopeId = uint16_t;
+
+    namespace detail
+    {
+#if defined(__GLIBC__)
+        extern "C"
+        {
+            void *__libc_malloc(size_t);
+            void *__libc_realloc(void *, size_t);
+            void *__libc_memalign(size_t, size_t);
+            void __libc_free(void *);
+        }
+
+        // glibc's own allocator, so that the `malloc` shim can sit in front of it
+        inline void *raw_malloc(size_t n) { return __libc_malloc(n); }
+        inline void *raw_realloc(void *p, size_t n) { return __libc_realloc(p, n); }
+        inline void *raw_memalign(size_t align, size_t n) { return __libc_memalign(align, n); }
+        inline void raw_free(void *p) { __libc_free(p); }
+#else
+        inline void *raw_malloc(size_t n) { return std::malloc(n); }
+        inline void *raw_realloc(void *p, size_t n) { return std::realloc(p, n); }
+        inline void *raw_memalign(size_t align, size_t n) { return std::aligned_alloc(align, (n + align - 1) & ~(align - 1)); }
+        inline void raw_free(void *p) { std::free(p); }
+#endif
+
+        /// Precedes every allocation made through the shim
+        struct Header
+        {
+            uint64_t size;   // As requested
+            uint32_t offset; // From the underlying allocation to the user's pointer
+            ScopeId scope;
+            uint16_t tracked; // Zero for allocations made re-entrantly, which aren't counted
+        };
+        static_assert(sizeof(Header) == 16);
+
+        inline constexpr size_t MinAlign = sizeof(Header);
+
+        struct Counters
+        {
+            std::atomic<uint64_t> allocations;
+            std::atomic<uint64_t> deallocations;
+            std::atomic<uint64_t> allocated_bytes;
+            std::atomic<uint64_t> freed_bytes;
+        };
+
+        /// Counters of one thread, written only by that thread. Tables are
+        /// never freed: when a thread exits its table is reused, so counts
+        /// accumulate over the life of the process.
+        struct Table
+        {
+            Counters counters[MaxScopes];
+            std::atomic<bool> in_use;
+            Table *next;
+        };
+
+        inline std::atomic<Table *> &
+        tables()
+        {
+            static std::atomic<Table *> head{nullptr};
+            return head;
+        }
+
+        /// Shared by threads with no table of their own (those exiting), so it
+        /// is updated with atomic read-modify-writes
+        inline Table &
+        shared_table()
+        {
+            static Table table{};
+            return table;
+        }
+
+        struct ThreadState
+        {
+            Table *table = nullptr;
+            ScopeId stack[MaxDepth] = {};
+            uint32_t depth = 0;
+            bool busy = false;   // Inside the allocator's own bookkeeping
+            bool exited = false; // Table released at thread exit
+        };
+
+        /// Trivially constructed and destroyed, so that it can be used from
+        /// within `malloc` without itself allocating
+        inline ThreadState &
+        state()
+        {
+            static thread_local constinit ThreadState state;
+            return state;
+        }
+
+        inline void
+        release_table(void *)
+        {
+            auto &s = state();
+            if (s.table != nullptr)
+            {
+                s.table->in_use.store(false, std::memory_order_release);
+                s.table = nullptr;
+            }
+            s.exited = true;
+        }
+
+        inline pthread_key_t
+        exit_key()
+        {
+            static const pthread_key_t key = []()
+            {
+                pthread_key_t key;
+                pthread_key_create(&key, release_table);
+                return key;
+            }();
+            return key;
+        }
+
+        inline Table *
+        acquire_table()
+        {
+            for (Table *t = tables().load(std::memory_order_acquire); t != nullptr; t = t->next)
+            {
+                bool expected = false;
+                if (!t->in_use.load(std::memory_order_relaxed) &&
+                    t->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                {
+                    return t;
+                }
+            }
+
+            void *mem = raw_memalign(alignof(Table), sizeof(Table));
+            if (mem == nullptr)
+            {
+                return nullptr;
+            }
+            std::memset(mem, 0, sizeof(Table));
+            auto *t = new (mem) Table{};
+            t->in_use.store(true, std::memory_order_relaxed);
+            t->next = tables().load(std::memory_order_relaxed);
+            while (!tables().compare_exchange_weak(t->next, t, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            return t;
+        }
+
+        /// Returns this thread's table, or `nullptr` if it should use the
+        /// shared one
+        inline Table *
+        thread_table(ThreadState &s)
+        {
+            if (s.table != nullptr) [[likely]]
+            {
+                return s.table;
+            }
+            if (s.exited)
+            {
+                return nullptr;
+            }
+            s.busy = true; // Registering for thread exit may allocate
+            s.table = acquire_table();
+            if (s.table != nullptr)
+            {
+                pthread_setspecific(exit_key(), s.table);
+            }
+            s.busy = false;
+            return s.table;
+        }
+
+        inline void
+        add(Table *t, std::atomic<uint64_t> Counters::*counter, ScopeId scope, uint64_t n)
+        {
+            if (t != nullptr) [[likely]]
+            {
+                // Single writer, so a plain load and store suffices
+                auto &c = t->counters[scope].*counter;
+                c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+            else
+            {
+                (shared_table().counters[scope].*counter).fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+
+        inline ScopeId
+        current_scope(const ThreadState &s)
+        {
+            return s.depth == 0 ? 0 : s.stack[std::min<size_t>(s.depth, MaxDepth) - 1];
+        }
+
+        inline Header *
+        header(void *p)
+        {
+            return static_cast<Header *>(p) - 1;
+        }
+
+        inline void
+        record_allocation(ThreadState &s, Header *h)
+        {
+            Table *t = thread_table(s);
+            add(t, &Counters::allocations, h->scope, 1);
+            add(t, &Counters::allocated_bytes, h->scope, h->size);
+        }
+
+        /// Allocates `n` bytes aligned to `align` (a power of two), attributed
+        /// to the current scope. Returns `nullptr` on failure.
+        inline void *
+        allocate(size_t n, size_t align = MinAlign)
+        {
+            align = std::max(align, MinAlign);
+            if (n > SIZE_MAX - align)
+            {
+                return nullptr;
+            }
+            void *raw = align == MinAlign ? raw_malloc(n + align) : raw_memalign(align, n + align);
+            if (raw == nullptr)
+            {
+                return nullptr;
+            }
+
+            void *p = static_cast<std::byte *>(raw) + align;
+            auto &s = state();
+            auto *h = header(p);
+            h->size = n;
+            h->offset = static_cast<uint32_t>(align);
+            h->scope = current_scope(s);
+            h->tracked = !s.busy;
+            if (h->tracked)
+            {
+                record_allocation(s, h);
+            }
+            return p;
+        }
+
+        /// Frees memory from `allocate`, crediting the scope it was allocated in.
+        inline void
+        deallocate(void *p)
+        {
+            if (p == nullptr)
+            {
+                return;
+            }
+            auto *h = header(p);
+            if (h->tracked)
+            {
+                auto &s = state();
+                Table *t = s.busy ? nullptr : thread_table(s);
+                add(t, &Counters::deallocations, h->scope, 1);
+                add(t, &Counters::freed_bytes, h->scope, h->size);
+            }
+            raw_free(static_cast<std::byte *>(p) - h->offset);
+        }
+
+        inline size_t
+        usable_size(void *p)
+        {
+            return p == nullptr ? 0 : header(p)->size;
+        }
+
+        /// Resizes memory from `allocate`, as `realloc` does. The new size is
+        /// attributed to the current scope.
+        inline void *
+        reallocate(void *p, size_t n)
+        {
+            if (p == nullptr)
+            {
+                return allocate(n);
+            }
+            if (n == 0)
+            {
+                deallocate(p);
+                return nullptr;
+            }
+
+            auto *h = header(p);
+            if (h->offset != MinAlign)
+            {
+                // Over-aligned, so the underlying allocator can't resize it in place
+                void *q = allocate(n, h->offset);
+                if (q != nullptr)
+                {
+                    std::memcpy(q, p, std::min<size_t>(n, h->size));
+                    deallocate(p);
+                }
+                return q;
+            }
+
+            Header old = *h;
+            if (n > SIZE_MAX - MinAlign)
+            {
+                return nullptr;
+            }
+            void *raw = raw_realloc(h, n + MinAlign);
+            if (raw == nullptr)
+            {
+                return nullptr;
+            }
+
+            auto &s = state();
+            h = static_cast<Header *>(raw);
+            h->size = n;
+            h->scope = current_scope(s);
+            h->tracked = !s.busy;
+            if (old.tracked || h->tracked)
+            {
+                // Within the allocator's own bookkeeping, as in `deallocate`
+                Table *t = s.busy ? nullptr : thread_table(s);
+                if (old.tracked)
+                {
+                    add(t, &Counters::deallocations, old.scope, 1);
+                    add(t, &Counters::freed_bytes, old.scope, old.size);
+                }
+                if (h->tracked)
+                {
+                    record_allocation(s, h);
+                }
+            }
+            return h + 1;
+        }
+
+        inline void *
+        allocate_or_throw(size_t n, size_t align = MinAlign)
+        {
+            void *p = allocate(n, align);
+            if (p == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            return p;
+        }
+
+        inline std::atomic<bool> &
+        installed()
+        {
+            static std::atomic<bool> installed{false};
+            return installed;
+        }
+
+        class Registry
+        {
+        public:
+            static Registry &
+            get()
+            {
+                static Registry registry;
+                return registry;
+            }
+
+            ScopeId
+            id(std::string_view name)
+            {
+                // Names are kept for good, so aren't counted against any scope
+                auto &s = state();
+                bool busy = std::exchange(s.busy, true);
+                ScopeId id = find_or_insert(name);
+                s.busy = busy;
+                return id;
+            }
+
+            /// Names are never changed once registered, so may be read without
+            /// the lock
+            std::string_view
+            name(ScopeId id) const
+            {
+                return mNames[id];
+            }
+
+            size_t
+            count() const
+            {
+                return mCount.load(std::memory_order_acquire);
+            }
+
+        private:
+            Registry() : mCount(1)
+            {
+                mNames[0] = "(unscoped)";
+            }
+
+            ScopeId
+            find_or_insert(std::string_view name)
+            {
+                std::lock_guard<std::mutex> guard(mLock);
+                for (size_t i = 0; i < mCount.load(std::memory_order_relaxed); i++)
+                {
+                    if (mNames[i] == name)
+                    {
+                        return static_cast<ScopeId>(i);
+                    }
+                }
+                size_t i = mCount.load(std::memory_order_relaxed);
+                if (i == MaxScopes)
+                {
+                    return 0;
+                }
+                mNames[i] = std::string(name);
+                mCount.store(i + 1, std::memory_order_release);
+                return static_cast<ScopeId>(i);
+            }
+
+            std::mutex mLock;
+            std::string mNames[MaxScopes];
+            std::atomic<size_t> mCount;
+        };
+    }
+
+    /// A registered name that allocations can be attributed to. Registering
+    /// takes a lock, so scopes entered often should be registered once.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// static const alloc::Scope parser("parser");
+    /// AllocScope guard(parser);
+    /// ```
+    class Scope
+    {
+    public:
+        explicit Scope(std::string_view name) : mId(detail::Registry::get().id(name)) {}
+
+        inline ScopeId
+        id() const
+        {
+            return mId;
+        }
+
+        inline std::string_view
+        name() const
+        {
+            return detail::Registry::get().name(mId);
+        }
+
+    private:
+        ScopeId mId;
+    };
+
+    /// Counts for one scope, summed over every thread
+    struct ScopeStats
+    {
+        std::string_view name;
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t allocated_bytes = 0;
+        uint64_t freed_bytes = 0;
+
+        /// Bytes allocated in this scope and not yet freed, wherever they
+        /// were freed. Counts are read without stopping other threads, so this
+        /// can be briefly negative.
+        inline int64_t
+        live_bytes() const
+        {
+            return static_cast<int64_t>(allocated_bytes - freed_bytes);
+        }
+    };
+
+    /// A point-in-time copy of the counts of every scope.
+    class AllocSnapshot
+    {
+    public:
+        /// Every registered scope, in order of registration, starting with
+        /// `(unscoped)`.
+        const std::vector<ScopeStats> &
+        scopes() const
+        {
+            return mScopes;
+        }
+
+        /// Returns the counts of the scope called `name`, or `None` if no such
+        /// scope was registered.
+        Option<ScopeStats>
+        scope(std::string_view name) const
+        {
+            for (const auto &s : mScopes)
+            {
+                if (s.name == name)
+                {
+                    return Option<ScopeStats>(s);
+                }
+            }
+            return Option<ScopeStats>();
+        }
+
+        /// Returns the counts of all scopes together.
+        ScopeStats
+        total() const
+        {
+            ScopeStats total{"(total)"};
+            for (const auto &s : mScopes)
+            {
+                total.allocations += s.allocations;
+                total.deallocations += s.deallocations;
+                total.allocated_bytes += s.allocated_bytes;
+                total.freed_bytes += s.freed_bytes;
+            }
+            return total;
+        }
+
+    private:
+        friend AllocSnapshot snapshot();
+
+        std::vector<ScopeStats> mScopes;
+    };
+
+    /// Returns `true` if the allocation shim is compiled into the program, so
+    /// that allocations are being counted.
+    inline bool
+    is_installed()
+    {
+        return detail::installed().load(std::memory_order_relaxed);
+    }
+
+    /// Sums the counts of every thread. The snapshot's own allocations aren't
+    /// counted.
+    inline AllocSnapshot
+    snapshot()
+    {
+        auto &state = detail::state();
+        bool busy = std::exchange(state.busy, true);
+
+        auto &registry = detail::Registry::get();
+        AllocSnapshot snap;
+        snap.mScopes.resize(registry.count());
+
+        auto sum = [&](const detail::Table &t)
+        {
+            for (size_t i = 0; i < snap.mScopes.size(); i++)
+            {
+                const auto &c = t.counters[i];
+                snap.mScopes[i].allocations += c.allocations.load(std::memory_order_relaxed);
+                snap.mScopes[i].deallocations += c.deallocations.load(std::memory_order_relaxed);
+                snap.mScopes[i].allocated_bytes += c.allocated_bytes.load(std::memory_order_relaxed);
+                snap.mScopes[i].freed_bytes += c.freed_bytes.load(std::memory_order_relaxed);
+            }
+        };
+        for (auto *t = detail::tables().load(std::memory_order_acquire); t != nullptr; t = t->next)
+        {
+            sum(*t);
+        }
+        sum(detail::shared_table());
+
+        for (size_t i = 0; i < snap.mScopes.size(); i++)
+        {
+            snap.mScopes[i].name = registry.name(static_cast<ScopeId>(i));
+        }
+        state.busy = busy;
+        return snap;
+    }
+}
+
+namespace rustly
+{
+    /// Attributes the calling thread's allocations to a scope until it is
+    /// destroyed. Scopes nest, and frees are credited to the scope that made
+    /// the allocation, on whichever thread they happen.
+    ///
+    /// Counting requires the allocation shim: expand `RUSTLY_ALLOC_SHIM()` (and
+    /// optionally `RUSTLY_ALLOC_SHIM_MALLOC()`) in exactly one source file.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// {
+    ///     AllocScope guard("parser");
+    ///     auto ast = parse(input);
+    /// }
+    /// auto parser = alloc::snapshot().scope("parser").unwrap();
+    /// std::cout << parser.live_bytes() << std::endl;
+    /// ```
+    class AllocScope
+    {
+    public:
+        explicit AllocScope(const alloc::Scope &scope)
+        {
+            auto &s = alloc::detail::state();
+            if (s.depth < alloc::MaxDepth)
+            {
+                s.stack[s.depth] = scope.id();
+            }
+            s.depth++;
+        }
+
+        explicit AllocScope(std::string_view name) : AllocScope(alloc::Scope(name)) {}
+
+        ~AllocScope()
+        {
+            alloc::detail::state().depth--;
+        }
+
+        AllocScope(const AllocScope &) = delete;
+        AllocScope &operator=(const AllocScope &) = delete;
+    };
+}
+
+/// Replaces the global `operator new` and `operator delete` with versions that
+/// count allocations per `AllocScope`. Expand in exactly one source file.
+#define RUSTLY_ALLOC_SHIM()                                                                                          \
+    [[maybe_unused]] static const bool rustly_alloc_shim_installed_ =                                                 \
+        (::rustly::alloc::detail::installed().store(true), true);                                                     \
+    void *operator new(std::size_t n) { return ::rustly::alloc::detail::allocate_or_throw(n); }                       \
+    void *operator new[](std::size_t n) { return ::rustly::alloc::detail::allocate_or_throw(n); }                     \
+    void *operator new(std::size_t n, std::align_val_t a)                                                             \
+    {                                                                                                                 \
+        return ::rustly::alloc::detail::allocate_or_throw(n, static_cast<std::size_t>(a));                            \
+    }                                                                                                                 \
+    void *operator new[](std::size_t n, std::align_val_t a)                                                           \
+    {                                                                                                                 \
+        return ::rustly::alloc::detail::allocate_or_throw(n, static_cast<std::size_t>(a));                            \
+    }                                                                                                                 \
+    void *operator new(std::size_t n, const std::nothrow_t &) noexcept                                                \
+    {                                                                                                                 \
+        return ::rustly::alloc::detail::allocate(n);                                                                  \
+    }                                                                                                                 \
+    void *operator new[](std::size_t n, const std::nothrow_t &) noexcept                                              \
+    {                                                                                                                 \
+        return ::rustly::alloc::detail::allocate(n);                                                                  \
+    }                                                                                                                 \
+    void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept                            \
+    {                                                                                                                 \
+        return ::rustly::alloc::detail::allocate(n, static_cast<std::size_t>(a));                                     \
+    }                                                                                                                 \
+    void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept                          \
+    {                                                                                                                 \
+        return ::rustly::alloc::detail::allocate(n, static_cast<std::size_t>(a));                                     \
+    }                                                                                                                 \
+    void operator delete(void *p) noexcept { ::rustly::alloc::detail::deallocate(p); }                                \
+    void operator delete[](void *p) noexcept { ::rustly::alloc::detail::deallocate(p); }                              \
+    void operator delete(void *p, std::size_t) noexcept { ::rustly::alloc::detail::deallocate(p); }                   \
+    void operator delete[](void *p, std::size_t) noexcept { ::rustly::alloc::detail::deallocate(p); }                 \
+    void operator delete(void *p, std::align_val_t) noexcept { ::rustly::alloc::detail::deallocate(p); }              \
+    void operator delete[](void *p, std::align_val_t) noexcept { ::rustly::alloc::detail::deallocate(p); }            \
+    void operator delete(void *p, std::size_t, std::align_val_t) noexcept { ::rustly::alloc::detail::deallocate(p); } \
+    void operator delete[](void *p, std::size_t, std::align_val_t) noexcept                                           \
+    {                                                                                                                 \
+        ::rustly::alloc::detail::deallocate(p);                                                                       \
+    }                                                                                                                 \
+    void operator delete(void *p, const std::nothrow_t &) noexcept { ::rustly::alloc::detail::deallocate(p); }        \
+    void operator delete[](void *p, const std::nothrow_t &) noexcept { ::rustly::alloc::detail::deallocate(p); }      \
+    void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept                                  \
+    {                                                                                                                 \
+        ::rustly::alloc::detail::deallocate(p);                                                                       \
+    }                                                                                                                 \
+    void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept                                \
+    {                                                                                                                 \
+        ::rustly::alloc::detail::deallocate(p);                                                                       \
+    }
+
+#if defined(__GLIBC__)
+/// Replaces `malloc` and friends with versions that count allocations per
+/// `AllocScope`, in front of glibc's allocator. Expand in exactly one source
+/// file, alongside `RUSTLY_ALLOC_SHIM()`.
+#define RUSTLY_ALLOC_SHIM_MALLOC()                                                                  \
+    extern "C"                                                                                       \
+    {                                                                                                \
+        void *malloc(std::size_t n) noexcept { return ::rustly::alloc::detail::allocate(n); }        \
+        void free(void *p) noexcept { ::rustly::alloc::detail::deallocate(p); }                      \
+        void *calloc(std::size_t count, std::size_t n) noexcept                                      \
+        {                                                                                            \
+            if (n != 0 && count > SIZE_MAX / n)                                                      \
+            {                                                                                        \
+                errno = ENOMEM;                                                                      \
+                return nullptr;                                                                      \
+            }                                                                                        \
+            void *p = ::rustly::alloc::detail::allocate(count * n);                                  \
+            return p != nullptr ? std::memset(p, 0, count * n) : nullptr;                            \
+        }                                                                                            \
+        void *realloc(void *p, std::size_t n) noexcept                                               \
+        {                                                                                            \
+            return ::rustly::alloc::detail::reallocate(p, n);                                        \
+        }                                                                                            \
+        void *memalign(std::size_t a, std::size_t n) noexcept                                        \
+        {                                                                                            \
+            return ::rustly::alloc::detail::allocate(n, a);                                          \
+        }                                                                                            \
+        void *aligned_alloc(std::size_t a, std::size_t n) noexcept                                   \
+        {                                                                                            \
+            return ::rustly::alloc::detail::allocate(n, a);                                          \
+        }                                                                                            \
+        void *valloc(std::size_t n) noexcept { return ::rustly::alloc::detail::allocate(n, 4096); }  \
+        void *pvalloc(std::size_t n) noexcept                                                        \
+        {                                                                                            \
+            return ::rustly::alloc::detail::allocate((n + 4095) & ~std::size_t(4095), 4096);         \
+        }                                                                                            \
+        int posix_memalign(void **out, std::size_t a, std::size_t n) noexcept                        \
+        {                                                                                            \
+            if (a < sizeof(void *) || (a & (a - 1)) != 0)                                            \
+            {                                                                                        \
+                return EINVAL;                                                                       \
+            }                                                                                        \
+            void *p = ::rustly::alloc::detail::allocate(n, a);                                       \
+            if (p == nullptr)                                                                        \
+            {                                                                                        \
+                return ENOMEM;                                                                       \
+            }                                                                                        \
+            *out = p;                                                                                \
+            return 0;                                                                                \
+        }                                                                                            \
+        std::size_t malloc_usable_size(void *p) noexcept                                             \
+        {                                                                                            \
+            return ::rustly::alloc::detail::usable_size(p);                                          \
+        }                                                                                            \
+    }
+#endif
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unwind.h>
+#include <rustly/panic.h>
+
+namespace rustly
+{
+    /// The current status of a `Backtrace`, indicating whether it was captured or
+    /// whether it is empty for some other reason.
+    enum class BacktraceStatus
+    {
+        /// Capturing a backtrace is not supported, likely because it's not
+        /// implemented for the current platform.
+        Unsupported,
+        /// Capturing a backtrace has been disabled through the `RUST_BACKTRACE`
+        /// environment variable.
+        Disabled,
+        /// A backtrace has been captured and the `Backtrace` should print
+        /// reasonable information when rendered.
+        Captured,
+    };
+
+    /// A captured OS thread stack backtrace.
+    ///
+    /// Capturing only records raw return addresses into a fixed-size inline
+    /// buffer, so it never allocates. Symbol names are resolved when the
+    /// backtrace is rendered, and each address is resolved at most once per
+    /// process.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// class ParseError
+    /// {
+    /// public:
+    ///     ParseError() : mBacktrace(Backtrace::capture()) {}
+    ///     const std::string to_string() noexcept { return "parse error\n" + mBacktrace.to_string(); }
+    ///
+    /// private:
+    ///     Backtrace mBacktrace;
+    /// };
+    /// ```
+    class Backtrace
+    {
+    public:
+        /// Maximum number of frames retained by a single capture
+        static constexpr size_t MaxFrames = 64;
+
+        /// Returns `true` if backtraces were enabled with the `RUST_BACKTRACE`
+        /// environment variable.
+        ///
+        /// The environment is only read on the first call.
+        static bool
+        enabled()
+        {
+            static const bool enabled = []()
+            {
+                const char *var = std::getenv("RUST_BACKTRACE");
+                return var != nullptr && std::strcmp(var, "0") != 0;
+            }();
+            return enabled;
+        }
+
+        /// Captures a stack backtrace of the current thread, if enabled by
+        /// the `RUST_BACKTRACE` environment variable.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto bt = Backtrace::capture();
+        /// if (bt.status() == BacktraceStatus::Captured)
+        /// {
+        ///     std::cerr << bt;
+        /// }
+        /// ```
+        [[gnu::noinline]] static Backtrace
+        capture()
+        {
+            return enabled() ? Backtrace::trace(2) : Backtrace::disabled();
+        }
+
+        /// Forcibly captures a stack backtrace of the current thread, regardless
+        /// of environment configuration.
+        [[gnu::noinline]] static Backtrace
+        force_capture()
+        {
+            return Backtrace::trace(2);
+        }
+
+        /// Returns a backtrace with no frames, and a `Disabled` status.
+        static Backtrace
+        disabled()
+        {
+            return Backtrace(BacktraceStatus::Disabled);
+        }
+
+        /// Returns the status of this backtrace.
+        inline BacktraceStatus
+        status() const
+        {
+            return mStatus;
+        }
+
+        /// Returns the raw return addresses of the captured frames, innermost
+        /// frame first.
+        inline std::span<void *const>
+        frames() const
+        {
+            return std::span<void *const>(mFrames.data(), mLen);
+        }
+
+        /// Symbolizes and renders the backtrace, one frame per line.
+        const std::string
+        to_string() const noexcept
+        {
+            std::ostringstream oss;
+            oss << *this;
+            return oss.str();
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &out, const Backtrace &rhs)
+        {
+            switch (rhs.mStatus)
+            {
+            case BacktraceStatus::Unsupported:
+                return out << "unsupported backtrace\n";
+            case BacktraceStatus::Disabled:
+                return out << "disabled backtrace\n";
+            case BacktraceStatus::Captured:
+                break;
+            }
+
+            // Wide enough for any `size_t`, so never truncated
+            char index[24];
+            for (size_t i = 0; i < rhs.mLen; i++)
+            {
+                std::snprintf(index, sizeof(index), "%4zu: ", i);
+                out << index << symbolize(rhs.mFrames[i]);
+            }
+            return out;
+        }
+
+    private:
+        explicit Backtrace(BacktraceStatus status) : mLen(0), mStatus(status) {}
+
+        [[gnu::noinline]] static Backtrace
+        trace(size_t skip)
+        {
+            struct State
+            {
+                Backtrace *bt;
+                size_t skip;
+            };
+
+            Backtrace bt(BacktraceStatus::Captured);
+            State state{&bt, skip};
+            auto callback = [](_Unwind_Context *ctx, void *arg) -> _Unwind_Reason_Code
+            {
+                auto *s = static_cast<State *>(arg);
+                uintptr_t ip = _Unwind_GetIP(ctx);
+                if (ip == 0)
+                {
+                    return _URC_END_OF_STACK;
+                }
+                if (s->skip > 0)
+                {
+                    s->skip--;
+                    return _URC_NO_REASON;
+                }
+                s->bt->mFrames[s->bt->mLen++] = reinterpret_cast<void *>(ip);
+                return s->bt->mLen < MaxFrames ? _URC_NO_REASON : _URC_END_OF_STACK;
+            };
+            if (_Unwind_Backtrace(callback, &state) != _URC_END_OF_STACK && bt.mLen == 0)
+            {
+                bt.mStatus = BacktraceStatus::Unsupported;
+            }
+            return bt;
+        }
+
+        /// Appends the panicking thread's backtrace to a panic's message, or
+        /// a note on enabling it
+        [[gnu::noinline]] static void
+        panic_hook(std::string &message)
+        {
+            if (enabled())
+            {
+                // Skips this frame, so that the innermost is the panic's
+                message += "stack backtrace:\n" + trace(2).to_string();
+            }
+            else
+            {
+                message += "note: run with `RUST_BACKTRACE=1` environment variable to display a backtrace\n";
+            }
+        }
+
+        static inline const bool PanicHookRegistered = (detail::panic_hooks.backtrace = &panic_hook, true);
+
+        /// Resolves a return address to a rendered frame, caching the result
+        /// so each address is only ever resolved once.
+        static const std::string &
+        symbolize(void *ip)
+        {
+            static std::mutex lock;
+            static std::unordered_map<void *, std::string> cache;
+
+            std::lock_guard<std::mutex> guard(lock);
+            auto [it, inserted] = cache.try_emplace(ip);
+            if (!inserted)
+            {
+                return it->second;
+            }
+
+            // Return addresses point past the call, so look up the call itself
+            auto *pc = static_cast<char *>(ip) - 1;
+            Dl_info info{};
+            bool resolved = dladdr(pc, &info) != 0;
+            std::string frame;
+            if (resolved && info.dli_sname != nullptr)
+            {
+                int status = 0;
+                char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                frame = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+                std::free(demangled);
+            }
+            else
+            {
+                frame = "<unknown>";
+            }
+
+            frame += "\n             at ";
+            frame += resolved && info.dli_fname != nullptr ? info.dli_fname : "<unknown>";
+            // Module-relative offsets can be resolved offline with `addr2line`
+            if (resolved && info.dli_fbase != nullptr)
+            {
+                char location[24];
+                std::snprintf(location, sizeof(location), "+0x%zx",
+                              static_cast<size_t>(pc - static_cast<char *>(info.dli_fbase)));
+                frame += location;
+            }
+            frame += "\n";
+
+            it->second = std::move(frame);
+            return it->second;
+        }
+
+        std::array<void *, MaxFrames> mFrames;
+        size_t mLen;
+        BacktraceStatus mStatus;
+    };
+}
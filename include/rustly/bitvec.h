@@ -0,0 +1,567 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <vector>
+#include <rustly/cpu.h>
+#include <rustly/option.h>
+#include <rustly/panic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace rustly
+{
+    namespace detail::bits
+    {
+        /// The bulk operations, for each width of vector that the kernels
+        /// below are instantiated for
+        struct And
+        {
+            static uint64_t
+            scalar(uint64_t a, uint64_t b)
+            {
+                return a & b;
+            }
+
+#if defined(__x86_64__) || defined(__i386__)
+            RUSTLY_TARGET_AVX2 static __m256i
+            avx2(__m256i a, __m256i b)
+            {
+                return _mm256_and_si256(a, b);
+            }
+
+            RUSTLY_TARGET_AVX512 static __m512i
+            avx512(__m512i a, __m512i b)
+            {
+                return _mm512_and_si512(a, b);
+            }
+#endif
+        };
+
+        struct Or
+        {
+            static uint64_t
+            scalar(uint64_t a, uint64_t b)
+            {
+                return a | b;
+            }
+
+#if defined(__x86_64__) || defined(__i386__)
+            RUSTLY_TARGET_AVX2 static __m256i
+            avx2(__m256i a, __m256i b)
+            {
+                return _mm256_or_si256(a, b);
+            }
+
+            RUSTLY_TARGET_AVX512 static __m512i
+            avx512(__m512i a, __m512i b)
+            {
+                return _mm512_or_si512(a, b);
+            }
+#endif
+        };
+
+        struct Xor
+        {
+            static uint64_t
+            scalar(uint64_t a, uint64_t b)
+            {
+                return a ^ b;
+            }
+
+#if defined(__x86_64__) || defined(__i386__)
+            RUSTLY_TARGET_AVX2 static __m256i
+            avx2(__m256i a, __m256i b)
+            {
+                return _mm256_xor_si256(a, b);
+            }
+
+            RUSTLY_TARGET_AVX512 static __m512i
+            avx512(__m512i a, __m512i b)
+            {
+                return _mm512_xor_si512(a, b);
+            }
+#endif
+        };
+
+        struct AndNot
+        {
+            static uint64_t
+            scalar(uint64_t a, uint64_t b)
+            {
+                return a & ~b;
+            }
+
+#if defined(__x86_64__) || defined(__i386__)
+            RUSTLY_TARGET_AVX2 static __m256i
+            avx2(__m256i a, __m256i b)
+            {
+                return _mm256_andnot_si256(b, a);
+            }
+
+            RUSTLY_TARGET_AVX512 static __m512i
+            avx512(__m512i a, __m512i b)
+            {
+                // `a & ~b` as a truth table over (a, b, b), since GCC 12's
+                // `_mm512_andnot_si512` warns of an uninitialized operand
+                return _mm512_ternarylogic_epi64(a, b, b, 0x30);
+            }
+#endif
+        };
+
+        /// `dst[i] = Op(dst[i], src[i])` for `n` words, a word at a time
+        template <class Op>
+        inline void
+        apply_scalar(uint64_t *dst, const uint64_t *src, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                dst[i] = Op::scalar(dst[i], src[i]);
+            }
+        }
+
+        inline uint64_t
+        count_scalar(const uint64_t *p, size_t n)
+        {
+            uint64_t count = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                count += static_cast<uint64_t>(std::popcount(p[i]));
+            }
+            return count;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        RUSTLY_TARGET_SSE42 inline uint64_t
+        count_sse42(const uint64_t *p, size_t n)
+        {
+            // Compiled to POPCNT for this tier, where the scalar one isn't
+            uint64_t count = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                count += static_cast<uint64_t>(__builtin_popcountll(p[i]));
+            }
+            return count;
+        }
+
+        template <class Op>
+        RUSTLY_TARGET_AVX2 inline void
+        apply_avx2(uint64_t *dst, const uint64_t *src, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), Op::avx2(a, b));
+            }
+            apply_scalar<Op>(dst + i, src + i, n - i);
+        }
+
+        template <class Op>
+        RUSTLY_TARGET_AVX512 inline void
+        apply_avx512(uint64_t *dst, const uint64_t *src, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m512i a = _mm512_loadu_si512(dst + i);
+                __m512i b = _mm512_loadu_si512(src + i);
+                _mm512_storeu_si512(dst + i, Op::avx512(a, b));
+            }
+            apply_scalar<Op>(dst + i, src + i, n - i);
+        }
+
+        /// Counts with a nibble lookup table in each byte lane, and sums the
+        /// bytes with `vpsadbw` (Mula's algorithm)
+        RUSTLY_TARGET_AVX2 inline uint64_t
+        count_avx2(const uint64_t *p, size_t n)
+        {
+            const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                   0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low = _mm256_set1_epi8(0x0f);
+            __m256i total = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+                __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+                total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+            }
+            uint64_t count = static_cast<uint64_t>(_mm256_extract_epi64(total, 0)) +
+                             static_cast<uint64_t>(_mm256_extract_epi64(total, 1)) +
+                             static_cast<uint64_t>(_mm256_extract_epi64(total, 2)) +
+                             static_cast<uint64_t>(_mm256_extract_epi64(total, 3));
+            for (; i < n; i++)
+            {
+                count += static_cast<uint64_t>(__builtin_popcountll(p[i]));
+            }
+            return count;
+        }
+
+        RUSTLY_TARGET_AVX512 inline uint64_t
+        count_avx512(const uint64_t *p, size_t n)
+        {
+            // Loaded whole rather than broadcast, and reduced through memory
+            // below, as GCC 12's broadcast and reduce intrinsics warn of
+            // uninitialized operands
+            alignas(64) static constexpr uint8_t Table[64] = {
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+            const __m512i table = _mm512_loadu_si512(Table);
+            const __m512i low = _mm512_set1_epi8(0x0f);
+            __m512i total = _mm512_setzero_si512();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m512i v = _mm512_loadu_si512(p + i);
+                __m512i lo = _mm512_shuffle_epi8(table, _mm512_and_si512(v, low));
+                __m512i hi = _mm512_shuffle_epi8(table, _mm512_and_si512(_mm512_srli_epi16(v, 4), low));
+                total = _mm512_add_epi64(total, _mm512_sad_epu8(_mm512_add_epi8(lo, hi), _mm512_setzero_si512()));
+            }
+            alignas(64) uint64_t lanes[8];
+            _mm512_store_si512(lanes, total);
+            uint64_t count = 0;
+            for (uint64_t lane : lanes)
+            {
+                count += lane;
+            }
+            for (; i < n; i++)
+            {
+                count += static_cast<uint64_t>(__builtin_popcountll(p[i]));
+            }
+            return count;
+        }
+
+        using Op = cpu::Dispatch<void(uint64_t *, const uint64_t *, size_t)>;
+
+        inline Op and_words{apply_scalar<And>, nullptr, apply_avx2<And>, apply_avx512<And>};
+        inline Op or_words{apply_scalar<Or>, nullptr, apply_avx2<Or>, apply_avx512<Or>};
+        inline Op xor_words{apply_scalar<Xor>, nullptr, apply_avx2<Xor>, apply_avx512<Xor>};
+        inline Op and_not_words{apply_scalar<AndNot>, nullptr, apply_avx2<AndNot>, apply_avx512<AndNot>};
+        inline cpu::Dispatch<uint64_t(const uint64_t *, size_t)> count_words{count_scalar, count_sse42, count_avx2,
+                                                                              count_avx512};
+#else
+        using Op = cpu::Dispatch<void(uint64_t *, const uint64_t *, size_t)>;
+
+        inline Op and_words{apply_scalar<And>};
+        inline Op or_words{apply_scalar<Or>};
+        inline Op xor_words{apply_scalar<Xor>};
+        inline Op and_not_words{apply_scalar<AndNot>};
+        inline cpu::Dispatch<uint64_t(const uint64_t *, size_t)> count_words{count_scalar};
+#endif
+    }
+
+    /// A growable vector of bits, packed 64 to a word, for large bitmaps.
+    ///
+    /// Bulk operations between vectors of the same length run through
+    /// `cpu::Dispatch`, with AVX2 and AVX-512 kernels. Bits past the end of
+    /// the last word are always zero.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// BitVec rows(1'000);
+    /// rows.set(3, true);
+    /// rows.set(700, true);
+    ///
+    /// BitVec visible(1'000, true);
+    /// rows &= visible;
+    /// assert(rows.count_ones() == 2);
+    /// assert(rows.find_next_set(4) == Some<size_t>(700));
+    /// for (size_t i : rows.ones())
+    /// {
+    ///     emit(i);
+    /// }
+    /// ```
+    ///
+    /// ## Panics
+    /// Bulk operations panic if the lengths differ; `set` panics if out of
+    /// range.
+    class BitVec
+    {
+    public:
+        static constexpr size_t WordBits = 64;
+
+        BitVec() = default;
+
+        /// Creates `len` bits, all `value`.
+        explicit BitVec(size_t len, bool value = false) : mWords(words_for(len), value ? ~uint64_t(0) : 0), mLen(len)
+        {
+            clear_tail();
+        }
+
+        size_t
+        len() const noexcept
+        {
+            return mLen;
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return mLen == 0;
+        }
+
+        /// Returns bit `i`, or `None` if out of range.
+        Option<bool>
+        get(size_t i) const noexcept
+        {
+            return i < mLen ? Option<bool>(test(i)) : Option<bool>();
+        }
+
+        /// Returns bit `i`, which must be in range.
+        bool
+        test(size_t i) const noexcept
+        {
+            return (mWords[i / WordBits] >> (i % WordBits)) & 1;
+        }
+
+        /// Sets bit `i`.
+        ///
+        /// ## Panics
+        /// Panics if `i` is out of range.
+        void
+        set(size_t i, bool value)
+        {
+            if (i >= mLen) [[unlikely]]
+            {
+                panic("bit index {} out of range for length {}", i, mLen);
+            }
+            uint64_t mask = uint64_t(1) << (i % WordBits);
+            mWords[i / WordBits] = value ? mWords[i / WordBits] | mask : mWords[i / WordBits] & ~mask;
+        }
+
+        /// Appends a bit.
+        void
+        push(bool value)
+        {
+            if (mLen % WordBits == 0)
+            {
+                mWords.push_back(0);
+            }
+            mWords.back() |= uint64_t(value) << (mLen % WordBits);
+            mLen++;
+        }
+
+        /// Sets every bit to `value`.
+        void
+        fill(bool value) noexcept
+        {
+            std::fill(mWords.begin(), mWords.end(), value ? ~uint64_t(0) : 0);
+            clear_tail();
+        }
+
+        /// Returns the number of set bits.
+        uint64_t
+        count_ones() const
+        {
+            return detail::bits::count_words(mWords.data(), mWords.size());
+        }
+
+        uint64_t
+        count_zeros() const
+        {
+            return mLen - count_ones();
+        }
+
+        /// Returns the index of the first set bit, if any.
+        Option<size_t>
+        find_first_set() const noexcept
+        {
+            return find_next_set(0);
+        }
+
+        /// Returns the index of the first set bit at or after `from`, if any.
+        Option<size_t>
+        find_next_set(size_t from) const noexcept
+        {
+            if (from >= mLen)
+            {
+                return Option<size_t>();
+            }
+            size_t w = from / WordBits;
+            uint64_t bits = mWords[w] & (~uint64_t(0) << (from % WordBits));
+            while (bits == 0)
+            {
+                if (++w == mWords.size())
+                {
+                    return Option<size_t>();
+                }
+                bits = mWords[w];
+            }
+            return Option<size_t>(w * WordBits + static_cast<size_t>(std::countr_zero(bits)));
+        }
+
+        /// An iterator over the indices of set bits, in order, finding each
+        /// with a count of trailing zeros.
+        class OnesIter
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = size_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const size_t *;
+            using reference = size_t;
+
+            OnesIter() = default;
+
+            size_t
+            operator*() const noexcept
+            {
+                return mWord * WordBits + static_cast<size_t>(std::countr_zero(mBits));
+            }
+
+            OnesIter &
+            operator++() noexcept
+            {
+                mBits &= mBits - 1;
+                skip_zeros();
+                return *this;
+            }
+
+            OnesIter
+            operator++(int) noexcept
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool
+            operator==(const OnesIter &rhs) const noexcept
+            {
+                return mWord == rhs.mWord && mBits == rhs.mBits;
+            }
+
+        private:
+            friend class BitVec;
+
+            OnesIter(const uint64_t *words, size_t word, size_t count) noexcept
+                : mWords(words), mWord(word), mCount(count), mBits(word < count ? words[word] : 0)
+            {
+                skip_zeros();
+            }
+
+            void
+            skip_zeros() noexcept
+            {
+                while (mBits == 0 && mWord < mCount)
+                {
+                    if (++mWord < mCount)
+                    {
+                        mBits = mWords[mWord];
+                    }
+                }
+            }
+
+            const uint64_t *mWords = nullptr;
+            size_t mWord = 0;
+            size_t mCount = 0;
+            uint64_t mBits = 0;
+        };
+
+        struct Ones
+        {
+            OnesIter mBegin;
+            OnesIter mEnd;
+
+            OnesIter begin() const noexcept { return mBegin; }
+            OnesIter end() const noexcept { return mEnd; }
+        };
+
+        /// Returns the indices of set bits, in order.
+        Ones
+        ones() const noexcept
+        {
+            return Ones{OnesIter(mWords.data(), 0, mWords.size()), OnesIter(mWords.data(), mWords.size(), mWords.size())};
+        }
+
+        /// Keeps the bits also set in `rhs`.
+        BitVec &
+        operator&=(const BitVec &rhs)
+        {
+            return bulk(detail::bits::and_words, rhs);
+        }
+
+        /// Sets the bits set in `rhs`.
+        BitVec &
+        operator|=(const BitVec &rhs)
+        {
+            return bulk(detail::bits::or_words, rhs);
+        }
+
+        /// Flips the bits set in `rhs`.
+        BitVec &
+        operator^=(const BitVec &rhs)
+        {
+            return bulk(detail::bits::xor_words, rhs);
+        }
+
+        /// Clears the bits set in `rhs`.
+        BitVec &
+        and_not(const BitVec &rhs)
+        {
+            return bulk(detail::bits::and_not_words, rhs);
+        }
+
+        friend BitVec operator&(BitVec lhs, const BitVec &rhs) { return std::move(lhs &= rhs); }
+        friend BitVec operator|(BitVec lhs, const BitVec &rhs) { return std::move(lhs |= rhs); }
+        friend BitVec operator^(BitVec lhs, const BitVec &rhs) { return std::move(lhs ^= rhs); }
+
+        bool operator==(const BitVec &rhs) const = default;
+
+        /// Returns the underlying words, least significant bit first.
+        const std::vector<uint64_t> &
+        words() const noexcept
+        {
+            return mWords;
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const BitVec &rhs)
+        {
+            for (size_t i = 0; i < rhs.mLen; i++)
+            {
+                os << (rhs.test(i) ? '1' : '0');
+            }
+            return os;
+        }
+
+    private:
+        static size_t
+        words_for(size_t len) noexcept
+        {
+            return (len + WordBits - 1) / WordBits;
+        }
+
+        void
+        clear_tail() noexcept
+        {
+            if (mLen % WordBits != 0)
+            {
+                mWords.back() &= (uint64_t(1) << (mLen % WordBits)) - 1;
+            }
+        }
+
+        BitVec &
+        bulk(detail::bits::Op &op, const BitVec &rhs)
+        {
+            if (mLen != rhs.mLen) [[unlikely]]
+            {
+                panic("bit vectors of different lengths: {} and {}", mLen, rhs.mLen);
+            }
+            op(mWords.data(), rhs.mWords.data(), mWords.size());
+            return *this;
+        }
+
+        std::vector<uint64_t> mWords;
+        size_t mLen = 0;
+    };
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <rustly/option.h>
+#include <rustly/result.h>
+#include <rustly/time.h>
+
+namespace rustly
+{
+    /// A bounded, concurrent map for memoizing expensive lookups, which evicts
+    /// with the SIEVE policy.
+    ///
+    /// Keys are spread over shards by hash, each with its own lock and an
+    /// even share of the capacity. A hit only sets the entry's visited bit,
+    /// under a shared lock, so concurrent readers don't contend on a
+    /// recency list as they would with LRU. To evict, a hand sweeps from the
+    /// oldest entry towards the newest, clearing visited bits, and evicts the
+    /// first unvisited entry. Entries that are inserted and never hit again,
+    /// as in a scan, are evicted before older entries that are, which makes
+    /// it scan-resistant.
+    ///
+    /// Values are returned by copy, since another thread may evict an entry
+    /// as soon as its shard is unlocked; store a `std::shared_ptr` to avoid
+    /// copying large values.
+    ///
+    /// `get_or_try_insert_with` can also remember an `Err` for a while, so
+    /// that failing lookups aren't retried on every call.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Cache<std::string, Address, ResolveError> hosts(10'000, Some(Duration::from_secs(5)));
+    ///
+    /// Result<Address, ResolveError> r = hosts.get_or_try_insert_with(name, [&]() { return resolve(name); });
+    /// assert(hosts.get(name).is_some() == r.is_ok());
+    /// ```
+    template <class K, class V, class E = Unit, class Hash = std::hash<K>>
+    class Cache
+    {
+    public:
+        /// Creates a cache of at most `capacity` entries, which doesn't cache
+        /// errors.
+        explicit Cache(size_t capacity, size_t shards = default_shards()) : Cache(capacity, Option<Duration>(), shards)
+        {
+        }
+
+        /// Creates a cache of at most `capacity` entries, which caches errors
+        /// returned by `get_or_try_insert_with` for `error_ttl`, if set.
+        Cache(size_t capacity, Option<Duration> error_ttl, size_t shards = default_shards())
+            : mShardCount(std::clamp<size_t>(shards, 1, std::max<size_t>(capacity, 1))),
+              mShards(new Shard[mShardCount]),
+              mErrorTtl(error_ttl)
+        {
+            for (size_t i = 0; i < mShardCount; i++)
+            {
+                // The first shards take the remainder
+                mShards[i].reset(capacity / mShardCount + (i < capacity % mShardCount ? 1 : 0));
+            }
+        }
+
+        Cache(const Cache &) = delete;
+        Cache &operator=(const Cache &) = delete;
+
+        /// Returns a copy of the value for `key`, if cached.
+        Option<V>
+        get(const K &key) const
+        {
+            const Shard &shard = shard_for(key);
+            std::shared_lock lock(shard.mutex);
+            auto it = shard.index.find(key);
+            if (it == shard.index.end() || shard.nodes[it->second].value.index() != 0)
+            {
+                return Option<V>();
+            }
+            shard.visited[it->second].store(true, std::memory_order_relaxed);
+            return Option<V>(std::get<0>(shard.nodes[it->second].value));
+        }
+
+        /// Returns `true` if a value is cached for `key`, without counting as
+        /// a hit.
+        bool
+        contains(const K &key) const
+        {
+            const Shard &shard = shard_for(key);
+            std::shared_lock lock(shard.mutex);
+            auto it = shard.index.find(key);
+            return it != shard.index.end() && shard.nodes[it->second].value.index() == 0;
+        }
+
+        /// Caches `value` for `key`. Returns the entry it pushed out: the old
+        /// value for `key`, or else the entry evicted to make room, if any.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// Cache<int, std::string> cache(1, 1);
+        /// assert(cache.insert(1, "a").is_none());
+        /// auto evicted = cache.insert(2, "b");
+        /// assert(evicted == Some(std::pair<int, std::string>(1, "a")));
+        /// ```
+        Option<std::pair<K, V>>
+        insert(K key, V value)
+        {
+            Shard &shard = shard_for(key);
+            std::unique_lock lock(shard.mutex);
+            return shard.put(std::move(key), Slot(std::in_place_index<0>, std::move(value)));
+        }
+
+        /// Removes the value for `key`, returning it if it was cached.
+        Option<V>
+        remove(const K &key)
+        {
+            Shard &shard = shard_for(key);
+            std::unique_lock lock(shard.mutex);
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+            {
+                return Option<V>();
+            }
+            uint32_t i = it->second;
+            shard.index.erase(it);
+            shard.unlink(i);
+            auto node = std::move(shard.nodes[i]);
+            shard.free.push_back(i);
+            return node.value.index() == 0 ? Option<V>(std::move(std::get<0>(node.value))) : Option<V>();
+        }
+
+        /// Returns the cached value for `key`, or calls `f` to look it up,
+        /// caching `Ok` values. With an error TTL set, an `Err` is cached too,
+        /// and returned until it expires instead of calling `f` again.
+        ///
+        /// `f` is called without any lock held, so threads that miss on the
+        /// same key at once each call it, and the last result wins.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// Cache<std::string, Schema, FetchError> schemas(1'000, Some(Duration::from_secs(30)));
+        /// auto schema = schemas.get_or_try_insert_with(url, [&]() { return fetch(url); });
+        /// ```
+        template <class F>
+            requires std::convertible_to<std::invoke_result_t<F &>, Result<V, E>>
+        Result<V, E>
+        get_or_try_insert_with(const K &key, F &&f)
+        {
+            Shard &shard = shard_for(key);
+            {
+                std::shared_lock lock(shard.mutex);
+                auto it = shard.index.find(key);
+                if (it != shard.index.end())
+                {
+                    const Node &node = shard.nodes[it->second];
+                    if (node.value.index() == 0)
+                    {
+                        shard.visited[it->second].store(true, std::memory_order_relaxed);
+                        return Result<V, E>(std::in_place_index<0>, std::get<0>(node.value));
+                    }
+                    const auto &negative = std::get<1>(node.value);
+                    if (Instant::now() < negative.expires)
+                    {
+                        shard.visited[it->second].store(true, std::memory_order_relaxed);
+                        return Result<V, E>(std::in_place_index<1>, negative.error);
+                    }
+                }
+            }
+
+            Result<V, E> result = f();
+            if (result.is_ok())
+            {
+                Slot slot(std::in_place_index<0>, result.ok().unwrap());
+                std::unique_lock lock(shard.mutex);
+                shard.put(key, std::move(slot));
+            }
+            else if (mErrorTtl.is_some())
+            {
+                Slot slot(std::in_place_index<1>, Negative{result.err().unwrap(), Instant::now() + mErrorTtl.unwrap()});
+                std::unique_lock lock(shard.mutex);
+                shard.put(key, std::move(slot));
+            }
+            return result;
+        }
+
+        /// Returns the number of entries, including cached errors. Entries
+        /// may be inserted or evicted concurrently.
+        size_t
+        size() const
+        {
+            size_t n = 0;
+            for (size_t i = 0; i < mShardCount; i++)
+            {
+                std::shared_lock lock(mShards[i].mutex);
+                n += mShards[i].index.size();
+            }
+            return n;
+        }
+
+        size_t
+        capacity() const noexcept
+        {
+            size_t n = 0;
+            for (size_t i = 0; i < mShardCount; i++)
+            {
+                n += mShards[i].capacity;
+            }
+            return n;
+        }
+
+        /// Removes every entry.
+        void
+        clear()
+        {
+            for (size_t i = 0; i < mShardCount; i++)
+            {
+                std::unique_lock lock(mShards[i].mutex);
+                mShards[i].reset(mShards[i].capacity);
+            }
+        }
+
+    private:
+        static constexpr uint32_t Nil = UINT32_MAX;
+
+        /// A cached error, and when it stops being returned
+        struct Negative
+        {
+            E error;
+            Instant expires;
+        };
+
+        using Slot = std::variant<V, Negative>;
+
+        /// An entry in a shard's list, from the newest (head) to the oldest
+        /// (tail)
+        struct Node
+        {
+            K key;
+            Slot value;
+            /// Towards the head
+            uint32_t newer;
+            /// Towards the tail
+            uint32_t older;
+        };
+
+        struct alignas(64) Shard
+        {
+            void
+            reset(size_t cap)
+            {
+                capacity = cap;
+                index.clear();
+                index.reserve(cap);
+                nodes.clear();
+                nodes.reserve(cap);
+                free.clear();
+                visited.reset(new std::atomic<bool>[std::max<size_t>(cap, 1)]);
+                head = tail = hand = Nil;
+            }
+
+            Option<std::pair<K, V>>
+            put(K key, Slot value)
+            {
+                if (auto it = index.find(key); it != index.end())
+                {
+                    Node &node = nodes[it->second];
+                    auto old = std::exchange(node.value, std::move(value));
+                    visited[it->second].store(true, std::memory_order_relaxed);
+                    if (old.index() != 0)
+                    {
+                        return Option<std::pair<K, V>>();
+                    }
+                    return Option<std::pair<K, V>>(std::pair<K, V>(std::move(key), std::move(std::get<0>(old))));
+                }
+                if (capacity == 0)
+                {
+                    return value.index() == 0 ? Option<std::pair<K, V>>(std::pair<K, V>(std::move(key), std::move(std::get<0>(value))))
+                                              : Option<std::pair<K, V>>();
+                }
+
+                Option<std::pair<K, V>> evicted;
+                uint32_t i;
+                if (index.size() == capacity)
+                {
+                    i = evict();
+                    Node &victim = nodes[i];
+                    index.erase(victim.key);
+                    if (victim.value.index() == 0)
+                    {
+                        evicted = Option<std::pair<K, V>>(std::pair<K, V>(std::move(victim.key), std::move(std::get<0>(victim.value))));
+                    }
+                    victim.key = key;
+                    victim.value = std::move(value);
+                }
+                else if (!free.empty())
+                {
+                    i = free.back();
+                    free.pop_back();
+                    nodes[i].key = key;
+                    nodes[i].value = std::move(value);
+                }
+                else
+                {
+                    i = static_cast<uint32_t>(nodes.size());
+                    nodes.push_back(Node{key, std::move(value), Nil, Nil});
+                }
+                visited[i].store(false, std::memory_order_relaxed);
+                push_head(i);
+                index.emplace(std::move(key), i);
+                return evicted;
+            }
+
+            /// Moves the hand to the next unvisited entry, clearing visited
+            /// bits on the way, and unlinks it
+            uint32_t
+            evict()
+            {
+                uint32_t i = hand != Nil ? hand : tail;
+                while (visited[i].load(std::memory_order_relaxed))
+                {
+                    visited[i].store(false, std::memory_order_relaxed);
+                    i = nodes[i].newer != Nil ? nodes[i].newer : tail;
+                }
+                hand = nodes[i].newer;
+                unlink(i);
+                return i;
+            }
+
+            void
+            push_head(uint32_t i)
+            {
+                nodes[i].newer = Nil;
+                nodes[i].older = head;
+                if (head != Nil)
+                {
+                    nodes[head].newer = i;
+                }
+                head = i;
+                if (tail == Nil)
+                {
+                    tail = i;
+                }
+            }
+
+            void
+            unlink(uint32_t i)
+            {
+                Node &node = nodes[i];
+                if (hand == i)
+                {
+                    hand = node.newer;
+                }
+                (node.newer != Nil ? nodes[node.newer].older : head) = node.older;
+                (node.older != Nil ? nodes[node.older].newer : tail) = node.newer;
+            }
+
+            mutable std::shared_mutex mutex;
+            std::unordered_map<K, uint32_t, Hash> index;
+            std::vector<Node> nodes;
+            /// Slots in `nodes` that were removed
+            std::vector<uint32_t> free;
+            /// Set by hits under a shared lock, so kept apart from `nodes`
+            std::unique_ptr<std::atomic<bool>[]> visited;
+            uint32_t head = Nil;
+            uint32_t tail = Nil;
+            uint32_t hand = Nil;
+            size_t capacity = 0;
+        };
+
+        static size_t
+        default_shards()
+        {
+            return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 16);
+        }
+
+        Shard &
+        shard_for(const K &key) const
+        {
+            // Mixed, since `std::hash` is often the identity, and the index
+            // uses the low bits
+            uint64_t h = static_cast<uint64_t>(Hash{}(key)) * 0x9e3779b97f4a7c15ull;
+            return mShards[(h >> 32) % mShardCount];
+        }
+
+        size_t mShardCount;
+        std::unique_ptr<Shard[]> mShards;
+        Option<Duration> mErrorTtl;
+    };
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace rustly
+{
+    /// The result of comparing two values, like Rust's `std::cmp::Ordering`:
+    /// `Ordering::Less`, `Ordering::Equal` or `Ordering::Greater`.
+    ///
+    /// It converts from `std::strong_ordering` and `std::weak_ordering`, so a
+    /// comparator for `sort_by` can return `a <=> b` as well.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// assert(cmp(1, 2) == Ordering::Less);
+    /// assert(cmp(1, 2).reverse() == Ordering::Greater);
+    ///
+    /// // By age, then by name
+    /// Ordering o = cmp(a.age, b.age).then_with([&]() { return cmp(a.name, b.name); });
+    /// ```
+    class Ordering
+    {
+    public:
+        static const Ordering Less;
+        static const Ordering Equal;
+        static const Ordering Greater;
+
+        constexpr Ordering(std::strong_ordering o) noexcept : mValue(o < 0 ? -1 : o > 0 ? 1 : 0) {}
+        constexpr Ordering(std::weak_ordering o) noexcept : mValue(o < 0 ? -1 : o > 0 ? 1 : 0) {}
+
+        constexpr bool operator==(const Ordering &) const = default;
+
+        constexpr bool
+        is_eq() const noexcept
+        {
+            return mValue == 0;
+        }
+
+        constexpr bool
+        is_ne() const noexcept
+        {
+            return mValue != 0;
+        }
+
+        constexpr bool
+        is_lt() const noexcept
+        {
+            return mValue < 0;
+        }
+
+        constexpr bool
+        is_gt() const noexcept
+        {
+            return mValue > 0;
+        }
+
+        constexpr bool
+        is_le() const noexcept
+        {
+            return mValue <= 0;
+        }
+
+        constexpr bool
+        is_ge() const noexcept
+        {
+            return mValue >= 0;
+        }
+
+        /// Swaps `Less` and `Greater`, e.g. to sort in descending order.
+        constexpr Ordering
+        reverse() const noexcept
+        {
+            return Ordering(static_cast<int8_t>(-mValue));
+        }
+
+        /// Returns this ordering, or `other` if this is `Equal`, to compare by
+        /// several keys in turn.
+        constexpr Ordering
+        then(Ordering other) const noexcept
+        {
+            return mValue != 0 ? *this : other;
+        }
+
+        /// Returns this ordering, or else the result of `f`, which is only
+        /// called if this is `Equal`.
+        template <class F>
+            requires std::convertible_to<std::invoke_result_t<F &>, Ordering>
+        constexpr Ordering
+        then_with(F &&f) const
+        {
+            return mValue != 0 ? *this : Ordering(f());
+        }
+
+        constexpr operator std::strong_ordering() const noexcept
+        {
+            return mValue < 0 ? std::strong_ordering::less : mValue > 0 ? std::strong_ordering::greater : std::strong_ordering::equal;
+        }
+
+        std::string
+        to_string() const
+        {
+            return mValue < 0 ? "Less" : mValue > 0 ? "Greater" : "Equal";
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const Ordering &o)
+        {
+            return os << o.to_string();
+        }
+
+    private:
+        explicit constexpr Ordering(int8_t value) noexcept : mValue(value) {}
+
+        int8_t mValue;
+    };
+
+    inline constexpr Ordering Ordering::Less = Ordering(int8_t(-1));
+    inline constexpr Ordering Ordering::Equal = Ordering(int8_t(0));
+    inline constexpr Ordering Ordering::Greater = Ordering(int8_t(1));
+
+    /// Compares `a` and `b` with `<=>`, or with `<` for types without it.
+    /// Unordered floating-point values compare `Equal`, as with `std::sort`.
+    template <class T>
+        requires std::three_way_comparable<T> || requires(const T &x) { { x < x } -> std::convertible_to<bool>; }
+    constexpr Ordering
+    cmp(const T &a, const T &b)
+    {
+        if constexpr (std::three_way_comparable<T, std::weak_ordering>)
+        {
+            return Ordering(std::weak_ordering(a <=> b));
+        }
+        else
+        {
+            return a < b ? Ordering::Less : b < a ? Ordering::Greater : Ordering::Equal;
+        }
+    }
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace rustly
+{
+    /// Maps a borrowed view type to the type that owns the same data, like
+    /// Rust's `ToOwned`. Specialize it, with an `Owned` type constructible from
+    /// the view and convertible back to it, to use other views with `Cow`.
+    template <class B>
+    struct ToOwned;
+
+    template <class CharT, class Traits>
+    struct ToOwned<std::basic_string_view<CharT, Traits>>
+    {
+        using Owned = std::basic_string<CharT, Traits>;
+    };
+
+    template <class T>
+    struct ToOwned<std::span<const T>>
+    {
+        using Owned = std::vector<T>;
+
+        static Owned
+        to_owned(std::span<const T> b)
+        {
+            return Owned(b.begin(), b.end());
+        }
+    };
+
+    namespace detail
+    {
+        template <class B>
+        inline typename ToOwned<B>::Owned
+        to_owned(B b)
+        {
+            if constexpr (requires { ToOwned<B>::to_owned(b); })
+            {
+                return ToOwned<B>::to_owned(b);
+            }
+            else
+            {
+                return typename ToOwned<B>::Owned(b);
+            }
+        }
+    }
+
+    /// A clone-on-write value: either a borrowed view `B`, or the owned data
+    /// it views, like Rust's `Cow`. A pass that usually returns its input
+    /// unchanged can return it borrowed, and only allocate when it changes
+    /// something.
+    ///
+    /// A `Cow` is constructed borrowed from a view, or from an lvalue of the
+    /// owned type, and owned from an rvalue of the owned type. A borrowed
+    /// `Cow` must not outlive what it borrows.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Cow<std::string_view>
+    /// escape(std::string_view s)
+    /// {
+    ///     if (s.find('"') == std::string_view::npos)
+    ///     {
+    ///         return s; // No allocation
+    ///     }
+    ///     std::string out;
+    ///     // ...
+    ///     return out;
+    /// }
+    ///
+    /// assert(escape("plain").is_borrowed());
+    /// assert(escape("\"quoted\"").is_owned());
+    /// ```
+    template <class B>
+    class Cow
+    {
+    public:
+        using Borrowed = B;
+        using Owned = typename ToOwned<B>::Owned;
+
+        /// Borrows `b`, or anything that converts to a `B`, such as an lvalue
+        /// of the owned type. Never borrows an rvalue of the owned type,
+        /// which would dangle.
+        template <class U>
+            requires(std::convertible_to<U, B> &&
+                     (std::is_lvalue_reference_v<U> || !std::same_as<std::remove_cvref_t<U>, Owned>) &&
+                     !std::same_as<std::remove_cvref_t<U>, Cow>)
+        Cow(U &&b) noexcept(std::is_nothrow_convertible_v<U, B>) : mValue(std::in_place_index<0>, B(std::forward<U>(b)))
+        {
+        }
+
+        /// Takes ownership of `o`, without copying it.
+        Cow(Owned &&o) noexcept : mValue(std::in_place_index<1>, std::move(o)) {}
+
+        /// Copies `o`, a `const` rvalue that can't be moved from or borrowed.
+        Cow(const Owned &&o) : mValue(std::in_place_index<1>, o) {}
+
+        [[nodiscard]] bool
+        is_borrowed() const noexcept
+        {
+            return mValue.index() == 0;
+        }
+
+        [[nodiscard]] bool
+        is_owned() const noexcept
+        {
+            return mValue.index() == 1;
+        }
+
+        /// Returns a view of the data, borrowed or owned.
+        B
+        as_ref() const noexcept
+        {
+            return is_borrowed() ? std::get<0>(mValue) : B(std::get<1>(mValue));
+        }
+
+        /// Returns a mutable reference to the owned data, first copying the
+        /// borrowed data if it isn't owned yet.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// Cow<std::string_view> c = std::string_view("abc");
+        /// c.to_mut().push_back('d'); // Copies
+        /// c.to_mut().push_back('e'); // Doesn't
+        /// assert(c == "abcde");
+        /// ```
+        Owned &
+        to_mut()
+        {
+            if (is_borrowed())
+            {
+                mValue.template emplace<1>(detail::to_owned<B>(std::get<0>(mValue)));
+            }
+            return std::get<1>(mValue);
+        }
+
+        /// Returns the owned data, moving it out if already owned, or copying
+        /// the borrowed data if not.
+        Owned
+        into_owned() &&
+        {
+            if (is_owned())
+            {
+                return std::move(std::get<1>(mValue));
+            }
+            return detail::to_owned<B>(std::get<0>(mValue));
+        }
+
+        /// Copies the data into a new owned value.
+        Owned
+        into_owned() const &
+        {
+            return detail::to_owned<B>(as_ref());
+        }
+
+        size_t
+        size() const noexcept
+        {
+            return as_ref().size();
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        bool
+        operator==(const Cow &rhs) const
+        {
+            return view_equal(as_ref(), rhs.as_ref());
+        }
+
+        template <class U>
+            requires(std::convertible_to<const U &, B> && !std::same_as<U, Cow>)
+        bool
+        operator==(const U &rhs) const
+        {
+            return view_equal(as_ref(), B(rhs));
+        }
+
+        std::string
+        to_string() const noexcept
+            requires std::convertible_to<B, std::string_view>
+        {
+            return std::string(as_ref());
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const Cow &rhs)
+            requires std::convertible_to<B, std::string_view>
+        {
+            return os << rhs.as_ref();
+        }
+
+    private:
+        static bool
+        view_equal(B a, B b)
+        {
+            if constexpr (std::equality_comparable<B>)
+            {
+                return a == b;
+            }
+            else
+            {
+                return std::equal(a.begin(), a.end(), b.begin(), b.end());
+            }
+        }
+
+        std::variant<B, Owned> mValue;
+    };
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <rustly/option.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/// Compiles a function for a higher tier than the rest of the program, for use
+/// as a `cpu::Dispatch` implementation. It must only be called through a
+/// dispatcher, or after checking `cpu::has()`.
+#if defined(__x86_64__) || defined(__i386__)
+#define RUSTLY_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define RUSTLY_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt")))
+#define RUSTLY_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,bmi,bmi2,popcnt")))
+#else
+#define RUSTLY_TARGET_SSE42
+#define RUSTLY_TARGET_AVX2
+#define RUSTLY_TARGET_AVX512
+#endif
+
+namespace rustly::cpu
+{
+    /// A level of SIMD support. Each tier implies the ones below it.
+    enum class Tier : uint8_t
+    {
+        Scalar = 0,
+        /// SSE4.2 and POPCNT
+        Sse42,
+        /// AVX2, BMI1 and BMI2
+        Avx2,
+        /// AVX-512 F, BW, DQ and VL
+        Avx512,
+    };
+
+    inline constexpr size_t Tiers = 4;
+
+    inline constexpr std::string_view
+    name(Tier tier)
+    {
+        constexpr std::string_view names[Tiers] = {"scalar", "sse4.2", "avx2", "avx512"};
+        return names[static_cast<size_t>(tier)];
+    }
+
+    inline std::ostream &
+    operator<<(std::ostream &os, Tier tier)
+    {
+        return os << name(tier);
+    }
+
+    /// Parses a tier from its name, as printed.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// assert(cpu::parse_tier("avx2") == Some(cpu::Tier::Avx2));
+    /// assert(cpu::parse_tier("neon") == None());
+    /// ```
+    inline Option<Tier>
+    parse_tier(std::string_view s)
+    {
+        for (size_t i = 0; i < Tiers; i++)
+        {
+            if (s == name(static_cast<Tier>(i)))
+            {
+                return Option<Tier>(static_cast<Tier>(i));
+            }
+        }
+        return Option<Tier>();
+    }
+
+    /// Queries the CPU (and, for AVX, the OS's saved register state) for the
+    /// highest tier it supports. Prefer the cached `cpu::supported()`.
+    inline Tier
+    detect()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            return Tier::Scalar;
+        }
+        bool sse42 = (ecx & bit_SSE4_2) && (ecx & bit_POPCNT);
+        if (!sse42)
+        {
+            return Tier::Scalar;
+        }
+
+        // AVX state must be enabled by the OS, as well as supported by the CPU
+        bool avx_os = false, avx512_os = false;
+        if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX))
+        {
+            uint32_t xcr0_lo, xcr0_hi;
+            __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+            avx_os = (xcr0_lo & 0x06) == 0x06;    // XMM, YMM
+            avx512_os = (xcr0_lo & 0xe6) == 0xe6; // and opmask, ZMM
+        }
+        if (!avx_os || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        {
+            return Tier::Sse42;
+        }
+
+        bool avx2 = (ebx & bit_AVX2) && (ebx & bit_BMI) && (ebx & bit_BMI2);
+        if (!avx2)
+        {
+            return Tier::Sse42;
+        }
+        bool avx512 = avx512_os && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (ebx & bit_AVX512DQ) &&
+                      (ebx & bit_AVX512VL);
+        return avx512 ? Tier::Avx512 : Tier::Avx2;
+#else
+        return Tier::Scalar;
+#endif
+    }
+
+    namespace detail
+    {
+        inline constexpr uint8_t NotForced = 0xff;
+
+        inline std::atomic<uint8_t> &
+        forced_tier()
+        {
+            static std::atomic<uint8_t> forced{NotForced};
+            return forced;
+        }
+
+        /// Bumped whenever the effective tier changes, so that dispatchers
+        /// know to reselect
+        inline std::atomic<uint32_t> &
+        generation()
+        {
+            static std::atomic<uint32_t> generation{1};
+            return generation;
+        }
+    }
+
+    /// Returns the highest tier supported by this CPU, detected once.
+    ///
+    /// Setting `RUSTLY_CPU_TIER` to a tier name caps it, e.g.
+    /// `RUSTLY_CPU_TIER=sse4.2` to test the SSE4.2 paths on an AVX-512 machine.
+    /// Tiers above what the CPU supports are ignored.
+    inline Tier
+    supported()
+    {
+        static const Tier tier = []()
+        {
+            Tier tier = detect();
+            const char *var = std::getenv("RUSTLY_CPU_TIER");
+            if (var != nullptr)
+            {
+                auto cap = parse_tier(var);
+                if (cap.is_some() && cap.unwrap() < tier)
+                {
+                    tier = cap.unwrap();
+                }
+            }
+            return tier;
+        }();
+        return tier;
+    }
+
+    /// Returns the tier that dispatched kernels are selected for: the
+    /// supported tier, unless forced lower by `cpu::force_tier()`.
+    inline Tier
+    tier()
+    {
+        uint8_t forced = detail::forced_tier().load(std::memory_order_relaxed);
+        return forced == detail::NotForced ? supported() : static_cast<Tier>(forced);
+    }
+
+    /// Returns `true` if code compiled for `t` can run here.
+    inline bool
+    has(Tier t)
+    {
+        return t <= tier();
+    }
+
+    /// Forces dispatched kernels down to `t`, or restores the supported tier if
+    /// `None`, and returns the tier now in effect. A test hook, so that every
+    /// path can be exercised on one machine.
+    ///
+    /// `t` is capped at `cpu::supported()`, since higher tiers can't run.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// for (auto t : {cpu::Tier::Scalar, cpu::Tier::Sse42, cpu::Tier::Avx2, cpu::Tier::Avx512})
+    /// {
+    ///     if (cpu::force_tier(t) == t)
+    ///     {
+    ///         check_kernel();
+    ///     }
+    /// }
+    /// cpu::force_tier(None());
+    /// ```
+    inline Tier
+    force_tier(Option<Tier> t)
+    {
+        uint8_t forced = t.is_some() && t.unwrap() < supported() ? static_cast<uint8_t>(t.unwrap()) : detail::NotForced;
+        detail::forced_tier().store(forced, std::memory_order_relaxed);
+        detail::generation().fetch_add(1, std::memory_order_release);
+        return tier();
+    }
+
+    template <class F>
+    class Dispatch;
+
+    /// A kernel with an implementation per tier, called through a cached
+    /// function pointer to the best one for `cpu::tier()`.
+    ///
+    /// Implementations may be left `nullptr`, in which case the next tier down
+    /// is used; the scalar one is required. Selection happens on first call,
+    /// and again after `cpu::force_tier()`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// size_t count_scalar(const uint8_t *p, size_t n);
+    /// RUSTLY_TARGET_AVX2 size_t count_avx2(const uint8_t *p, size_t n);
+    ///
+    /// inline cpu::Dispatch<size_t(const uint8_t *, size_t)> count{count_scalar, nullptr, count_avx2};
+    ///
+    /// size_t n = count(data, len);
+    /// ```
+    template <class R, class... Args>
+    class Dispatch<R(Args...)>
+    {
+    public:
+        using Fn = R (*)(Args...);
+
+        constexpr Dispatch(Fn scalar, Fn sse42 = nullptr, Fn avx2 = nullptr, Fn avx512 = nullptr)
+            : mImpls{scalar, sse42, avx2, avx512}, mFn(scalar), mGeneration(0)
+        {
+        }
+
+        Dispatch(const Dispatch &) = delete;
+        Dispatch &operator=(const Dispatch &) = delete;
+
+        inline R
+        operator()(Args... args)
+        {
+            if (mGeneration.load(std::memory_order_acquire) != detail::generation().load(std::memory_order_relaxed))
+                [[unlikely]]
+            {
+                select();
+            }
+            return mFn.load(std::memory_order_relaxed)(std::forward<Args>(args)...);
+        }
+
+        /// Returns the tier of the implementation that would be called.
+        Tier
+        selected() const
+        {
+            return best(tier());
+        }
+
+        /// Returns the implementation for tier `t`, falling back to lower tiers.
+        Fn
+        get(Tier t) const
+        {
+            return mImpls[static_cast<size_t>(best(t))];
+        }
+
+    private:
+        Tier
+        best(Tier t) const
+        {
+            size_t i = static_cast<size_t>(t);
+            while (i > 0 && mImpls[i] == nullptr)
+            {
+                i--;
+            }
+            return static_cast<Tier>(i);
+        }
+
+        void
+        select()
+        {
+            // Racing selections store the same values, and the generation last,
+            // so a reader that sees it also sees the matching function
+            uint32_t generation = detail::generation().load(std::memory_order_acquire);
+            mFn.store(get(tier()), std::memory_order_relaxed);
+            mGeneration.store(generation, std::memory_order_release);
+        }
+
+        Fn mImpls[Tiers];
+        std::atomic<Fn> mFn;
+        std::atomic<uint32_t> mGeneration;
+    };
+}
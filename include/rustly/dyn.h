@@ -0,0 +1,398 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <rustly/display.h>
+#include <rustly/error.h>
+#include <rustly/panic.h>
+
+namespace rustly
+{
+    /// Tags naming a concept for `Dyn` and `DynRef`, since a concept can't be
+    /// passed as a template argument itself.
+    namespace traits
+    {
+        /// Any `Display` type
+        struct Display
+        {
+            template <class T>
+            static constexpr bool implemented_by = rustly::Display<T>;
+        };
+
+        /// Any `Error` type
+        struct Error
+        {
+            template <class T>
+            static constexpr bool implemented_by = rustly::Error<T>;
+        };
+    }
+
+    /// Bytes of a value stored inline by a `Dyn` by default, without
+    /// allocating. Enough for a `std::string`.
+    inline constexpr size_t DefaultDynSize = 4 * sizeof(void *);
+
+    namespace detail
+    {
+        /// The operations of a `Display` or `Error` value, on a pointer to it.
+        /// All traits share them, so that references convert freely.
+        struct DynOps
+        {
+            void (*write)(const void *value, std::ostream &os);
+            std::string (*to_string)(const void *value);
+        };
+
+        template <class T>
+        inline void
+        dyn_write(const void *value, std::ostream &os)
+        {
+            const T &t = *static_cast<const T *>(value);
+            if constexpr (ToStream<T>)
+            {
+                os << t;
+            }
+            else
+            {
+                os << std::to_string(t);
+            }
+        }
+
+        template <class T>
+        inline std::string
+        dyn_to_string(const void *value)
+        {
+            const T &t = *static_cast<const T *>(value);
+            if constexpr (ToString<T>)
+            {
+                return std::to_string(t);
+            }
+            else
+            {
+                std::ostringstream oss;
+                oss << t;
+                return oss.str();
+            }
+        }
+
+        template <class T>
+        inline constexpr bool IsDynRef = false;
+
+        template <class T>
+        inline constexpr DynOps DynOpsFor = {&dyn_write<T>, &dyn_to_string<T>};
+
+        /// The single table for one stored type, at one inline size
+        struct DynVTable
+        {
+            DynOps ops;
+            /// Stored behind a pointer, rather than inline
+            bool boxed;
+            void (*copy)(void *dst, const void *src);
+            /// Moves the value from `src` into `dst`, and destroys `src`.
+            /// `nullptr` when the bytes can simply be copied.
+            void (*relocate)(void *dst, void *src) noexcept;
+            /// `nullptr` when there is nothing to destroy
+            void (*destroy)(void *storage) noexcept;
+        };
+    }
+
+    template <class Trait>
+    class DynRef;
+
+    namespace detail
+    {
+        template <class Trait>
+        inline constexpr bool IsDynRef<DynRef<Trait>> = true;
+    }
+
+    /// An owned value of any type implementing `Trait`, whose type has been
+    /// erased, like Rust's `Box<dyn Trait>`. `Trait` is one of the tags in
+    /// `rustly::traits`.
+    ///
+    /// Values up to `InlineSize` bytes are stored inline; larger ones are
+    /// heap-allocated. Every stored type has a single static table of
+    /// operations, so a `Dyn` is one pointer larger than its inline storage.
+    /// Copying copies the value.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::vector<Dyn<traits::Error>> errors;
+    /// errors.push_back(std::string("not found"));
+    /// errors.push_back(ParseError{17}); // any `Error` type
+    /// for (const auto &e : errors)
+    /// {
+    ///     std::cout << e << std::endl;
+    /// }
+    /// ```
+    ///
+    /// ## Panics
+    /// Panics if used after being moved from.
+    template <class Trait, size_t InlineSize = DefaultDynSize>
+    class Dyn
+    {
+        static_assert(InlineSize >= sizeof(void *), "the inline size must hold at least a pointer");
+
+        template <class T>
+        static constexpr bool Inline = sizeof(T) <= InlineSize && alignof(T) <= alignof(void *) &&
+                                       std::is_nothrow_move_constructible_v<T>;
+
+    public:
+        template <class V>
+            requires(!std::same_as<std::remove_cvref_t<V>, Dyn> && !detail::IsDynRef<std::remove_cvref_t<V>> &&
+                     Trait::template implemented_by<std::decay_t<V>> && std::copy_constructible<std::decay_t<V>>)
+        Dyn(V &&value)
+        {
+            using T = std::decay_t<V>;
+            if constexpr (Inline<T>)
+            {
+                ::new (static_cast<void *>(mStorage)) T(std::forward<V>(value));
+            }
+            else
+            {
+                *reinterpret_cast<T **>(mStorage) = new T(std::forward<V>(value));
+            }
+            mVTable = &VTable<T>;
+        }
+
+        Dyn(const Dyn &other) : mVTable(nullptr)
+        {
+            if (other.mVTable != nullptr)
+            {
+                other.mVTable->copy(mStorage, other.mStorage);
+                mVTable = other.mVTable;
+            }
+        }
+
+        Dyn(Dyn &&other) noexcept : mVTable(nullptr)
+        {
+            take(other);
+        }
+
+        Dyn &
+        operator=(const Dyn &other)
+        {
+            if (this != &other)
+            {
+                Dyn copy(other);
+                reset();
+                take(copy);
+            }
+            return *this;
+        }
+
+        Dyn &
+        operator=(Dyn &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~Dyn()
+        {
+            reset();
+        }
+
+        /// Borrows the value, without copying it.
+        DynRef<Trait>
+        as_ref() const
+        {
+            return DynRef<Trait>(value(), &vtable().ops);
+        }
+
+        /// Converts the value to a string, through its own `to_string()` or
+        /// `operator<<`.
+        std::string
+        to_string() const noexcept
+        {
+            return vtable().ops.to_string(value());
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const Dyn &rhs)
+        {
+            rhs.vtable().ops.write(rhs.value(), os);
+            return os;
+        }
+
+    private:
+        template <class T>
+        static T *
+        get(void *storage)
+        {
+            if constexpr (Inline<T>)
+            {
+                return std::launder(reinterpret_cast<T *>(storage));
+            }
+            else
+            {
+                return *reinterpret_cast<T **>(storage);
+            }
+        }
+
+        template <class T>
+        static void
+        copy(void *dst, const void *src)
+        {
+            const T &from = *get<T>(const_cast<void *>(src));
+            if constexpr (Inline<T>)
+            {
+                ::new (dst) T(from);
+            }
+            else
+            {
+                *reinterpret_cast<T **>(dst) = new T(from);
+            }
+        }
+
+        template <class T>
+        static void
+        relocate(void *dst, void *src) noexcept
+        {
+            ::new (dst) T(std::move(*get<T>(src)));
+            get<T>(src)->~T();
+        }
+
+        template <class T>
+        static void
+        destroy(void *storage) noexcept
+        {
+            if constexpr (Inline<T>)
+            {
+                get<T>(storage)->~T();
+            }
+            else
+            {
+                delete get<T>(storage);
+            }
+        }
+
+        template <class T>
+        static constexpr detail::DynVTable VTable = {
+            detail::DynOpsFor<T>,
+            !Inline<T>,
+            &copy<T>,
+            Inline<T> && !std::is_trivially_copyable_v<T> ? &relocate<T> : nullptr,
+            !Inline<T> || !std::is_trivially_destructible_v<T> ? &destroy<T> : nullptr,
+        };
+
+        const detail::DynVTable &
+        vtable() const
+        {
+            if (mVTable == nullptr) [[unlikely]]
+            {
+                panic("used a moved-from `Dyn`");
+            }
+            return *mVTable;
+        }
+
+        const void *
+        value() const
+        {
+            return vtable().boxed ? *reinterpret_cast<void *const *>(mStorage) : static_cast<const void *>(mStorage);
+        }
+
+        void
+        reset() noexcept
+        {
+            if (mVTable != nullptr && mVTable->destroy != nullptr)
+            {
+                mVTable->destroy(mStorage);
+            }
+            mVTable = nullptr;
+        }
+
+        void
+        take(Dyn &other) noexcept
+        {
+            if (other.mVTable == nullptr)
+            {
+                return;
+            }
+            if (other.mVTable->relocate != nullptr)
+            {
+                other.mVTable->relocate(mStorage, other.mStorage);
+            }
+            else
+            {
+                std::memcpy(mStorage, other.mStorage, InlineSize);
+            }
+            mVTable = std::exchange(other.mVTable, nullptr);
+        }
+
+        const detail::DynVTable *mVTable;
+        alignas(void *) std::byte mStorage[InlineSize];
+    };
+
+    /// A borrowed reference to a value of any type implementing `Trait`, like
+    /// Rust's `&dyn Trait`. Two pointers in size, and never allocates; the
+    /// value must outlive it.
+    ///
+    /// An `Error` reference converts to a `Display` one.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// void
+    /// report(DynRef<traits::Error> e)
+    /// {
+    ///     std::cerr << "error: " << e << std::endl;
+    /// }
+    ///
+    /// report(ParseError{17});
+    /// report(std::string("not found"));
+    /// ```
+    template <class Trait>
+    class DynRef
+    {
+    public:
+        template <class V>
+            requires(!detail::IsDynRef<V> && Trait::template implemented_by<V>)
+        DynRef(const V &value) noexcept : mValue(&value), mOps(&detail::DynOpsFor<V>)
+        {
+        }
+
+        template <class Other>
+            requires(std::same_as<Trait, traits::Display> && !std::same_as<Other, traits::Display>)
+        DynRef(DynRef<Other> other) noexcept : mValue(other.mValue), mOps(other.mOps)
+        {
+        }
+
+        template <size_t N>
+        DynRef(const Dyn<Trait, N> &value) : DynRef(value.as_ref())
+        {
+        }
+
+        std::string
+        to_string() const noexcept
+        {
+            return mOps->to_string(mValue);
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, DynRef rhs)
+        {
+            rhs.mOps->write(rhs.mValue, os);
+            return os;
+        }
+
+    private:
+        template <class, size_t>
+        friend class Dyn;
+
+        template <class>
+        friend class DynRef;
+
+        DynRef(const void *value, const detail::DynOps *ops) noexcept : mValue(value), mOps(ops) {}
+
+        const void *mValue;
+        const detail::DynOps *mOps;
+    };
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <rustly/error.h>
+#include <rustly/option.h>
+#include <rustly/panic.h>
+
+/// Registers the enum `Enum` as error domain `Id` (1 to 255), named `Name`,
+/// with one message per code, starting from 0. Use at global scope.
+///
+/// ## Examples
+/// ```cpp
+/// enum class ParseErrc : uint32_t { Eof, BadDigit };
+/// RUSTLY_ERROR_DOMAIN(ParseErrc, 2, "parse", "unexpected end of input", "invalid digit")
+/// ```
+#define RUSTLY_ERROR_DOMAIN(Enum, Id, Name, ...)                                                 \
+    RUSTLY_ERROR_DOMAIN_WITH_CATEGORY(Enum, Id, Name, nullptr, __VA_ARGS__)
+
+/// Registers an error domain like `RUSTLY_ERROR_DOMAIN`, whose codes are also
+/// the values of the `std::error_category` returned by `Category`, so that
+/// `ErrorCode::from` converts `std::error_code`s of that category.
+///
+/// ## Examples
+/// ```cpp
+/// const std::error_category &db_category() noexcept;
+/// RUSTLY_ERROR_DOMAIN_WITH_CATEGORY(DbErrc, 4, "db", &db_category, "", "database is locked")
+/// ```
+#define RUSTLY_ERROR_DOMAIN_WITH_CATEGORY(Enum, Id, Name, Category, ...)                         \
+    template <>                                                                                  \
+    struct rustly::ErrorDomainOf<Enum>                                                           \
+    {                                                                                            \
+        static constexpr std::string_view messages[] = {__VA_ARGS__};                            \
+        static constexpr rustly::ErrorDomain domain{Id, Name, messages, nullptr, Category};      \
+    };
+
+namespace rustly
+{
+    /// A set of error codes, with their messages in a static table. Domain 0
+    /// is the OS's `errno` values; others are registered by the enum types
+    /// that use them, with `RUSTLY_ERROR_DOMAIN`.
+    struct ErrorDomain
+    {
+        uint8_t id;
+        std::string_view name;
+        /// Indexed by code
+        std::span<const std::string_view> messages;
+        /// Describes codes instead of `messages`, when set
+        std::string_view (*describe)(uint32_t code) = nullptr;
+        /// The `std::error_category` whose values are this domain's codes,
+        /// when set
+        const std::error_category &(*category)() noexcept = nullptr;
+    };
+
+    /// Specialized for each enum type that is an error domain, with a
+    /// `static constexpr ErrorDomain domain`; see `RUSTLY_ERROR_DOMAIN`.
+    template <class E>
+    struct ErrorDomainOf;
+
+    template <class E>
+    concept ErrorEnum = std::is_enum_v<E> && requires {
+        {
+            ErrorDomainOf<E>::domain
+        } -> std::convertible_to<const ErrorDomain &>;
+    };
+
+    namespace detail
+    {
+        inline std::string_view
+        describe_errno(uint32_t code)
+        {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 32))
+            // Static, untranslated, and thread-safe
+            const char *s = strerrordesc_np(static_cast<int>(code));
+            return s != nullptr ? std::string_view(s) : std::string_view("unknown error");
+#else
+            return std::strerror(static_cast<int>(code));
+#endif
+        }
+
+        inline constexpr ErrorDomain OsDomain{0, "os", {}, &describe_errno, &std::system_category};
+
+        inline constexpr size_t MaxDomains = 256;
+
+        inline std::atomic<const ErrorDomain *> &
+        domain_slot(uint8_t id)
+        {
+            static constinit std::atomic<const ErrorDomain *> domains[MaxDomains] = {&OsDomain};
+            return domains[id];
+        }
+
+        inline bool
+        register_domain(const ErrorDomain &domain)
+        {
+            if (domain.id == 0)
+            {
+                panic("error domain 0 is reserved for the OS, so can't be used for `{}`", domain.name);
+            }
+            const ErrorDomain *expected = nullptr;
+            if (!domain_slot(domain.id).compare_exchange_strong(expected, &domain) && expected != &domain)
+            {
+                panic("error domain {} registered twice, for `{}` and `{}`", domain.id, expected->name, domain.name);
+            }
+            return true;
+        }
+
+        /// Registers `E`'s domain before `main`, as soon as any `ErrorCode` is
+        /// made from one
+        template <ErrorEnum E>
+        inline const bool Registered = register_domain(ErrorDomainOf<E>::domain);
+    }
+
+    /// A 32-bit error: an 8-bit domain and a 24-bit code within it, whose
+    /// message is looked up in the domain's static table only when displayed.
+    /// Cheap to create, copy and compare, so a `Result<T, ErrorCode>` is
+    /// barely larger than `T`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// enum class ParseErrc : uint32_t { Eof, BadDigit };
+    /// RUSTLY_ERROR_DOMAIN(ParseErrc, 2, "parse", "unexpected end of input", "invalid digit")
+    ///
+    /// Result<int, ErrorCode> r = Err<int, ErrorCode>(ParseErrc::BadDigit);
+    /// assert(r.unwrap_err() == ParseErrc::BadDigit);
+    /// assert(r.unwrap_err().message() == "invalid digit");
+    /// assert(ErrorCode::from_errno(ENOENT).message() == "No such file or directory");
+    /// ```
+    class ErrorCode
+    {
+    public:
+        static constexpr uint32_t CodeBits = 24;
+        static constexpr uint32_t CodeMask = (uint32_t(1) << CodeBits) - 1;
+
+        /// ## Panics
+        /// Panics if `e`, negative or otherwise, doesn't fit in `CodeBits`.
+        template <ErrorEnum E>
+        constexpr ErrorCode(E e) noexcept
+            : mBits(uint32_t(ErrorDomainOf<E>::domain.id) << CodeBits | static_cast<uint32_t>(e))
+        {
+            (void)detail::Registered<E>;
+            if (static_cast<uint32_t>(e) > CodeMask)
+            {
+                panic("error code {} of domain `{}` doesn't fit in {} bits",
+                      static_cast<std::underlying_type_t<E>>(e), ErrorDomainOf<E>::domain.name, CodeBits);
+            }
+        }
+
+        /// The OS error `errno`.
+        ///
+        /// ## Panics
+        /// Panics if `errno_` is negative or doesn't fit in `CodeBits`.
+        static ErrorCode
+        from_errno(int errno_) noexcept
+        {
+            if (errno_ < 0 || static_cast<uint32_t>(errno_) > CodeMask)
+            {
+                panic("errno {} doesn't fit in {} bits", errno_, CodeBits);
+            }
+            return from_raw(static_cast<uint32_t>(errno_));
+        }
+
+        /// The OS error in `errno` now.
+        static ErrorCode
+        last_os_error() noexcept
+        {
+            return from_errno(errno);
+        }
+
+        /// Converts a `std::error_code` from the system or generic categories,
+        /// or from a domain's own category. Returns `None` for any other, or
+        /// for a value that doesn't fit in `CodeBits`.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto e = ErrorCode::from(std::make_error_code(std::errc::permission_denied));
+        /// assert(e == Some(ErrorCode::from_errno(EACCES)));
+        /// ```
+        static Option<ErrorCode>
+        from(const std::error_code &ec) noexcept
+        {
+            if (ec.value() < 0 || static_cast<uint32_t>(ec.value()) > CodeMask)
+            {
+                return Option<ErrorCode>();
+            }
+            if (ec.category() == std::system_category() || ec.category() == std::generic_category())
+            {
+                return Option<ErrorCode>(from_errno(ec.value()));
+            }
+            for (size_t id = 1; id < detail::MaxDomains; id++)
+            {
+                const auto *domain = detail::domain_slot(static_cast<uint8_t>(id)).load(std::memory_order_acquire);
+                if (domain != nullptr && domain->category != nullptr && domain->category() == ec.category())
+                {
+                    uint32_t code = static_cast<uint32_t>(ec.value());
+                    return Option<ErrorCode>(from_raw(uint32_t(id) << CodeBits | code));
+                }
+            }
+            return Option<ErrorCode>();
+        }
+
+        /// Reconstructs an error from `raw()`.
+        static constexpr ErrorCode
+        from_raw(uint32_t bits) noexcept
+        {
+            return ErrorCode(bits);
+        }
+
+        constexpr uint32_t
+        raw() const noexcept
+        {
+            return mBits;
+        }
+
+        constexpr uint8_t
+        domain_id() const noexcept
+        {
+            return static_cast<uint8_t>(mBits >> CodeBits);
+        }
+
+        constexpr uint32_t
+        code() const noexcept
+        {
+            return mBits & CodeMask;
+        }
+
+        /// Returns the registered domain, if any.
+        const ErrorDomain *
+        domain() const noexcept
+        {
+            return detail::domain_slot(domain_id()).load(std::memory_order_acquire);
+        }
+
+        /// Returns the `errno` value, if this is an OS error.
+        Option<int>
+        raw_os_error() const noexcept
+        {
+            return domain_id() == 0 ? Option<int>(static_cast<int>(code())) : Option<int>();
+        }
+
+        /// Returns `true` if this is an error from `E`'s domain.
+        template <ErrorEnum E>
+        constexpr bool
+        is() const noexcept
+        {
+            return domain_id() == ErrorDomainOf<E>::domain.id;
+        }
+
+        /// Returns the error as an `E`, if it's from `E`'s domain.
+        template <ErrorEnum E>
+        Option<E>
+        as() const noexcept
+        {
+            return is<E>() ? Option<E>(static_cast<E>(code())) : Option<E>();
+        }
+
+        /// Translates errors from `From`'s domain with `f`, e.g. into the
+        /// domain of a higher layer, and leaves any others unchanged.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// ErrorCode e = StorageErrc::Corrupt;
+        /// e = e.map<StorageErrc>([](StorageErrc s) { return s == StorageErrc::Corrupt ? ApiErrc::Internal : ApiErrc::Unavailable; });
+        /// assert(e == ApiErrc::Internal);
+        /// ```
+        template <ErrorEnum From, class F>
+            requires std::convertible_to<std::invoke_result_t<F, From>, ErrorCode>
+        ErrorCode
+        map(F &&f) const
+        {
+            return is<From>() ? ErrorCode(f(static_cast<From>(code()))) : *this;
+        }
+
+        /// Returns the domain's static message for this code, without
+        /// allocating.
+        std::string_view
+        message() const noexcept
+        {
+            const auto *d = domain();
+            if (d == nullptr)
+            {
+                return "unknown error";
+            }
+            if (d->describe != nullptr)
+            {
+                return d->describe(code());
+            }
+            return code() < d->messages.size() ? d->messages[code()] : std::string_view("unknown error");
+        }
+
+        /// Returns the message, and the domain and code, e.g.
+        /// `No such file or directory (os error 2)`.
+        std::string
+        to_string() const noexcept
+        {
+            const auto *d = domain();
+            std::string out(message());
+            out += " (";
+            out += d != nullptr ? d->name : std::string_view("unknown");
+            out += " error ";
+            out += std::to_string(code());
+            out += ')';
+            return out;
+        }
+
+        constexpr bool operator==(const ErrorCode &rhs) const noexcept = default;
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const ErrorCode &rhs)
+        {
+            return os << rhs.to_string();
+        }
+
+    private:
+        explicit constexpr ErrorCode(uint32_t bits) noexcept : mBits(bits) {}
+
+        uint32_t mBits;
+    };
+}
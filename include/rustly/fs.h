@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <rustly/result.h>
+#include <rustly/sys.h>
+
+namespace rustly::fs
+{
+    /// An error from a filesystem operation: the OS error, and the path it
+    /// was operating on. The path is only copied when the error is made, so
+    /// the successful path doesn't pay for it.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto r = fs::read_to_string("/nonexistent");
+    /// assert(r.unwrap_err().kind() == sys::Errno(ENOENT));
+    /// std::cout << r.unwrap_err(); // "/nonexistent: No such file or directory (os error 2)"
+    /// ```
+    class IoError
+    {
+    public:
+        IoError(sys::Errno errno_, std::string_view path) : mErrno(errno_), mPath(std::make_shared<const std::string>(path)) {}
+
+        /// The OS error.
+        sys::Errno
+        kind() const noexcept
+        {
+            return mErrno;
+        }
+
+        /// The path of the file that the operation failed on.
+        std::string_view
+        path() const noexcept
+        {
+            return *mPath;
+        }
+
+        /// Returns the path and the OS error, e.g. `a.txt: Permission denied
+        /// (os error 13)`.
+        std::string
+        to_string() const noexcept
+        {
+            return std::string(path()) + ": " + mErrno.to_string();
+        }
+
+        bool
+        operator==(const IoError &rhs) const noexcept
+        {
+            return mErrno == rhs.mErrno && path() == rhs.path();
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const IoError &rhs)
+        {
+            return os << rhs.to_string();
+        }
+
+    private:
+        sys::Errno mErrno;
+        /// Shared, so that copying an error doesn't copy the path
+        std::shared_ptr<const std::string> mPath;
+    };
+
+    namespace detail
+    {
+        /// A NUL-terminated path, borrowed from any of the usual path types
+        /// without copying it.
+        class CPath
+        {
+        public:
+            CPath(const char *path) noexcept : mPath(path) {}
+            CPath(const std::string &path) noexcept : mPath(path.c_str()) {}
+            CPath(const std::filesystem::path &path) noexcept : mPath(path.c_str()) {}
+
+            const char *
+            c_str() const noexcept
+            {
+                return mPath;
+            }
+
+        private:
+            const char *mPath;
+        };
+
+        /// The buffer to start with for files that don't report their size,
+        /// such as those in procfs, which is doubled as they fill it
+        inline constexpr size_t ProbeSize = 4096;
+
+        /// Resizes `buf` without zeroing the bytes that will be read over,
+        /// where the standard library allows it
+        inline void
+        resize_for_read(std::string &buf, size_t n)
+        {
+#if defined(__cpp_lib_string_resize_and_overwrite)
+            buf.resize_and_overwrite(n, [](char *, size_t len) { return len; });
+#else
+            buf.resize(n);
+#endif
+        }
+
+        inline void
+        resize_for_read(std::vector<uint8_t> &buf, size_t n)
+        {
+            buf.resize(n);
+        }
+
+        /// Reads all of `path` into `buf`: an `open`, an `fstat`, and `read`s
+        /// until one returns 0, as any may be short. For a regular file, the
+        /// buffer is one byte larger than the file, so it's usually filled
+        /// by the first read, and a second reads nothing into the spare byte
+        /// to confirm the end, making five syscalls with `close`. If the
+        /// buffer fills, the file grew, and it's doubled like the buffer for
+        /// a file whose size is unknown.
+        template <class Buf>
+        inline Result<Buf, IoError>
+        read_all(CPath path)
+        {
+            auto fail = [&](sys::Errno e) { return Err<Buf, IoError>(IoError(e, path.c_str())); };
+
+            auto opened = sys::open(path.c_str(), O_RDONLY);
+            if (opened.is_err()) [[unlikely]]
+            {
+                return fail(opened.err().unwrap());
+            }
+            sys::Fd fd = std::move(opened).unwrap();
+
+            auto status = sys::fstat(fd.raw());
+            if (status.is_err()) [[unlikely]]
+            {
+                return fail(status.err().unwrap());
+            }
+            struct stat st = status.unwrap();
+            size_t hint = S_ISREG(st.st_mode) ? static_cast<size_t>(st.st_size) : 0;
+
+            Buf buf;
+            size_t len = 0;
+            size_t capacity = hint > 0 ? hint + 1 : ProbeSize;
+            resize_for_read(buf, capacity);
+            while (true)
+            {
+                auto n = sys::read(fd.raw(), buf.data() + len, capacity - len);
+                if (n.is_err()) [[unlikely]]
+                {
+                    return fail(n.err().unwrap());
+                }
+                if (n.unwrap() == 0)
+                {
+                    break;
+                }
+                len += n.unwrap();
+                if (len == capacity)
+                {
+                    capacity *= 2;
+                    resize_for_read(buf, capacity);
+                }
+            }
+            buf.resize(len);
+            return Ok<Buf, IoError>(std::move(buf));
+        }
+    }
+
+    /// Reads the whole file at `path`, with as few syscalls as possible: for
+    /// a regular file, an `open`, an `fstat`, a `read` into a buffer of just
+    /// over its size, another that finds the end, and a `close`. Files that
+    /// don't report a size, such as those in procfs, are read into a buffer
+    /// that doubles as it fills.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::vector<uint8_t> bytes = fs::read("image.png").unwrap();
+    /// ```
+    inline Result<std::vector<uint8_t>, IoError>
+    read(detail::CPath path)
+    {
+        return detail::read_all<std::vector<uint8_t>>(path);
+    }
+
+    /// Reads the whole file at `path` into a string, like `read()`. The
+    /// contents are the file's bytes, which aren't checked to be UTF-8.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::string hostname = fs::read_to_string("/etc/hostname").unwrap();
+    /// auto missing = fs::read_to_string("/nonexistent");
+    /// assert(missing.unwrap_err().kind() == sys::Errno(ENOENT));
+    /// ```
+    inline Result<std::string, IoError>
+    read_to_string(detail::CPath path)
+    {
+        return detail::read_all<std::string>(path);
+    }
+
+    /// Writes `data` to the file at `path`, creating it if needed and
+    /// truncating it if not, with a single `write` unless it's short.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// fs::write("out.txt", "hello").unwrap();
+    /// ```
+    inline Result<Unit, IoError>
+    write(detail::CPath path, std::span<const uint8_t> data)
+    {
+        auto fail = [&](sys::Errno e) { return Err<Unit, IoError>(IoError(e, path.c_str())); };
+
+        auto opened = sys::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (opened.is_err()) [[unlikely]]
+        {
+            return fail(opened.err().unwrap());
+        }
+        sys::Fd fd = std::move(opened).unwrap();
+        while (!data.empty())
+        {
+            auto n = sys::write(fd.raw(), data.data(), data.size());
+            if (n.is_err()) [[unlikely]]
+            {
+                return fail(n.err().unwrap());
+            }
+            data = data.subspan(n.unwrap());
+        }
+        // Reports errors that are only found when closing, such as on NFS
+        auto closed = std::move(fd).close();
+        if (closed.is_err()) [[unlikely]]
+        {
+            return fail(closed.err().unwrap());
+        }
+        return Ok<IoError>();
+    }
+
+    inline Result<Unit, IoError>
+    write(detail::CPath path, std::string_view data)
+    {
+        return write(path, std::span(reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+    }
+}
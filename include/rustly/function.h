@@ -0,0 +1,353 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <rustly/panic.h>
+
+namespace rustly
+{
+    /// Bytes of captures stored inline by default, without allocating. With
+    /// the table pointer, a callable is then four pointers in size.
+    inline constexpr size_t DefaultInlineSize = 3 * sizeof(void *);
+
+    namespace detail
+    {
+        enum class FnKind
+        {
+            Once,
+            Mut,
+            Const,
+        };
+
+        /// The single table of operations for one stored target type
+        template <class R, class... Args>
+        struct FnVTable
+        {
+            R (*call)(void *storage, Args &&...args);
+            /// Moves the target from `src` into `dst`, and destroys `src`.
+            /// `nullptr` when the bytes can simply be copied.
+            void (*relocate)(void *dst, void *src) noexcept;
+            /// `nullptr` when there is nothing to destroy
+            void (*destroy)(void *storage) noexcept;
+        };
+
+        /// Targets are stored inline when they fit, and can be moved without
+        /// throwing; otherwise on the heap, behind a pointer
+        template <class F, size_t N>
+        inline constexpr bool FnInline = sizeof(F) <= N && alignof(F) <= alignof(void *) &&
+                                         std::is_nothrow_move_constructible_v<F>;
+
+        /// `std::invoke_r`, from C++23
+        template <class R, class F, class... Args>
+        inline R
+        invoke_r(F &&f, Args &&...args)
+        {
+            if constexpr (std::is_void_v<R>)
+            {
+                std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+            }
+            else
+            {
+                return std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+            }
+        }
+
+        template <FnKind K, class F>
+        using FnTarget = std::conditional_t<K == FnKind::Const, const F &, std::conditional_t<K == FnKind::Once, F &&, F &>>;
+
+        template <FnKind K, size_t N, class R, class... Args>
+        class FnStorage
+        {
+            static_assert(N >= sizeof(void *), "the inline size must hold at least a pointer");
+
+        public:
+            FnStorage() noexcept : mVTable(nullptr) {}
+
+            template <class T, class F>
+            explicit FnStorage(std::in_place_type_t<T>, F &&f)
+            {
+                if constexpr (FnInline<T, N>)
+                {
+                    ::new (static_cast<void *>(mStorage)) T(std::forward<F>(f));
+                }
+                else
+                {
+                    *reinterpret_cast<T **>(mStorage) = new T(std::forward<F>(f));
+                }
+                mVTable = &VTable<T>;
+            }
+
+            FnStorage(FnStorage &&other) noexcept : mVTable(nullptr)
+            {
+                take(other);
+            }
+
+            FnStorage &
+            operator=(FnStorage &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    take(other);
+                }
+                return *this;
+            }
+
+            FnStorage(const FnStorage &) = delete;
+            FnStorage &operator=(const FnStorage &) = delete;
+
+            ~FnStorage()
+            {
+                reset();
+            }
+
+            /// Returns `true` if a target is stored.
+            explicit operator bool() const noexcept
+            {
+                return mVTable != nullptr;
+            }
+
+        protected:
+            inline R
+            invoke(const char *type, Args &&...args) const
+            {
+                if (mVTable == nullptr) [[unlikely]]
+                {
+                    panic("called an empty `{}`", type);
+                }
+                if constexpr (K == FnKind::Once)
+                {
+                    // Consumed by the call, which destroys the target even if it throws
+                    const auto *vtable = std::exchange(mVTable, nullptr);
+                    return vtable->call(mStorage, std::forward<Args>(args)...);
+                }
+                else
+                {
+                    return mVTable->call(mStorage, std::forward<Args>(args)...);
+                }
+            }
+
+        private:
+            template <class T>
+            static T &
+            target(void *storage)
+            {
+                if constexpr (FnInline<T, N>)
+                {
+                    return *std::launder(reinterpret_cast<T *>(storage));
+                }
+                else
+                {
+                    return **reinterpret_cast<T **>(storage);
+                }
+            }
+
+            template <class T>
+            static void
+            destroy(void *storage) noexcept
+            {
+                if constexpr (FnInline<T, N>)
+                {
+                    target<T>(storage).~T();
+                }
+                else
+                {
+                    delete &target<T>(storage);
+                }
+            }
+
+            template <class T>
+            static R
+            call(void *storage, Args &&...args)
+            {
+                if constexpr (K == FnKind::Once)
+                {
+                    struct Consume
+                    {
+                        void *storage;
+                        ~Consume() { destroy<T>(storage); }
+                    } consume{storage};
+                    return invoke_r<R>(static_cast<FnTarget<K, T>>(target<T>(storage)), std::forward<Args>(args)...);
+                }
+                else
+                {
+                    return invoke_r<R>(static_cast<FnTarget<K, T>>(target<T>(storage)), std::forward<Args>(args)...);
+                }
+            }
+
+            template <class T>
+            static void
+            relocate(void *dst, void *src) noexcept
+            {
+                ::new (dst) T(std::move(target<T>(src)));
+                target<T>(src).~T();
+            }
+
+            template <class T>
+            static constexpr FnVTable<R, Args...> VTable = {
+                &call<T>,
+                FnInline<T, N> && !std::is_trivially_copyable_v<T> ? &relocate<T> : nullptr,
+                !FnInline<T, N> || !std::is_trivially_destructible_v<T> ? &destroy<T> : nullptr,
+            };
+
+            void
+            reset() noexcept
+            {
+                if (mVTable != nullptr && mVTable->destroy != nullptr)
+                {
+                    mVTable->destroy(mStorage);
+                }
+                mVTable = nullptr;
+            }
+
+            void
+            take(FnStorage &other) noexcept
+            {
+                if (other.mVTable == nullptr)
+                {
+                    return;
+                }
+                if (other.mVTable->relocate != nullptr)
+                {
+                    other.mVTable->relocate(mStorage, other.mStorage);
+                }
+                else
+                {
+                    std::memcpy(mStorage, other.mStorage, N);
+                }
+                mVTable = std::exchange(other.mVTable, nullptr);
+            }
+
+            mutable const FnVTable<R, Args...> *mVTable;
+            alignas(void *) mutable std::byte mStorage[N];
+        };
+
+        template <class F, class Self>
+        concept NotSelf = !std::same_as<std::remove_cvref_t<F>, Self>;
+    }
+
+    template <class Sig, size_t InlineSize = DefaultInlineSize>
+    class FnOnce;
+
+    template <class Sig, size_t InlineSize = DefaultInlineSize>
+    class FnMut;
+
+    template <class Sig, size_t InlineSize = DefaultInlineSize>
+    class Fn;
+
+    /// A move-only callable that can be called once, consuming it, like Rust's
+    /// `FnOnce`.
+    ///
+    /// Captures up to `InlineSize` bytes are stored inline; larger ones are
+    /// heap-allocated. Moving is a copy of the bytes, unless the captures
+    /// themselves need a move constructor.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto data = std::make_unique<int>(5);
+    /// FnOnce<int()> f = [data = std::move(data)]() { return *data; };
+    /// assert(std::move(f)() == 5);
+    /// assert(!f);
+    /// ```
+    ///
+    /// ## Panics
+    /// Panics if called when empty.
+    template <class R, class... Args, size_t InlineSize>
+    class FnOnce<R(Args...), InlineSize> : public detail::FnStorage<detail::FnKind::Once, InlineSize, R, Args...>
+    {
+        using Base = detail::FnStorage<detail::FnKind::Once, InlineSize, R, Args...>;
+
+    public:
+        FnOnce() noexcept = default;
+        FnOnce(std::nullptr_t) noexcept {}
+
+        template <detail::NotSelf<FnOnce> F>
+            requires std::is_invocable_r_v<R, std::decay_t<F> &&, Args...>
+        FnOnce(F &&f) : Base(std::in_place_type<std::decay_t<F>>, std::forward<F>(f))
+        {
+        }
+
+        inline R
+        operator()(Args... args) &&
+        {
+            return this->invoke("FnOnce", std::forward<Args>(args)...);
+        }
+    };
+
+    /// A move-only callable that may mutate its captures, like Rust's `FnMut`.
+    ///
+    /// Captures up to `InlineSize` bytes are stored inline; larger ones are
+    /// heap-allocated.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// FnMut<int()> counter = [n = 0]() mutable { return ++n; };
+    /// assert(counter() == 1);
+    /// assert(counter() == 2);
+    /// ```
+    ///
+    /// ## Panics
+    /// Panics if called when empty.
+    template <class R, class... Args, size_t InlineSize>
+    class FnMut<R(Args...), InlineSize> : public detail::FnStorage<detail::FnKind::Mut, InlineSize, R, Args...>
+    {
+        using Base = detail::FnStorage<detail::FnKind::Mut, InlineSize, R, Args...>;
+
+    public:
+        FnMut() noexcept = default;
+        FnMut(std::nullptr_t) noexcept {}
+
+        template <detail::NotSelf<FnMut> F>
+            requires std::is_invocable_r_v<R, std::decay_t<F> &, Args...>
+        FnMut(F &&f) : Base(std::in_place_type<std::decay_t<F>>, std::forward<F>(f))
+        {
+        }
+
+        inline R
+        operator()(Args... args)
+        {
+            return this->invoke("FnMut", std::forward<Args>(args)...);
+        }
+    };
+
+    /// A move-only callable that doesn't mutate its captures, so can be called
+    /// through a `const` reference, like Rust's `Fn`.
+    ///
+    /// Captures up to `InlineSize` bytes are stored inline; larger ones are
+    /// heap-allocated.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Fn<int(int)> add = [k = 2](int x) { return x + k; };
+    /// assert(add(3) == 5);
+    /// ```
+    ///
+    /// ## Panics
+    /// Panics if called when empty.
+    template <class R, class... Args, size_t InlineSize>
+    class Fn<R(Args...), InlineSize> : public detail::FnStorage<detail::FnKind::Const, InlineSize, R, Args...>
+    {
+        using Base = detail::FnStorage<detail::FnKind::Const, InlineSize, R, Args...>;
+
+    public:
+        Fn() noexcept = default;
+        Fn(std::nullptr_t) noexcept {}
+
+        template <detail::NotSelf<Fn> F>
+            requires std::is_invocable_r_v<R, const std::decay_t<F> &, Args...>
+        Fn(F &&f) : Base(std::in_place_type<std::decay_t<F>>, std::forward<F>(f))
+        {
+        }
+
+        inline R
+        operator()(Args... args) const
+        {
+            return this->invoke("Fn", std::forward<Args>(args)...);
+        }
+    };
+}
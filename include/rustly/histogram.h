@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <rustly/option.h>
+#include <rustly/time.h>
+
+namespace rustly
+{
+    namespace detail
+    {
+        /// Log-linear bucketing: values below `2^SubBucketBits` get a bucket
+        /// each, and every power-of-two range above is split into
+        /// `2^(SubBucketBits - 1)` equal buckets, for a relative error of at
+        /// most `2^-(SubBucketBits - 1)`.
+        struct HistogramLayout
+        {
+            static constexpr unsigned SubBucketBits = 8;
+            static constexpr size_t HalfBucket = size_t(1) << (SubBucketBits - 1);
+            static constexpr size_t Buckets = (64 - SubBucketBits + 2) * HalfBucket;
+
+            static constexpr size_t
+            index(uint64_t v)
+            {
+                if (v < (uint64_t(1) << SubBucketBits))
+                {
+                    return static_cast<size_t>(v);
+                }
+                unsigned e = std::bit_width(v) - SubBucketBits;
+                return e * HalfBucket + static_cast<size_t>(v >> e);
+            }
+
+            static constexpr uint64_t
+            lowest(size_t i)
+            {
+                if (i < (size_t(1) << SubBucketBits))
+                {
+                    return i;
+                }
+                size_t e = i / HalfBucket - 1;
+                return static_cast<uint64_t>(i - e * HalfBucket) << e;
+            }
+
+            static constexpr uint64_t
+            highest(size_t i)
+            {
+                return i + 1 < Buckets ? lowest(i + 1) - 1 : UINT64_MAX;
+            }
+        };
+    }
+
+    /// A point-in-time copy of a `Histogram`'s counts. Snapshots of
+    /// different histograms can be merged.
+    class HistogramSnapshot
+    {
+    public:
+        HistogramSnapshot() : mCounts(detail::HistogramLayout::Buckets, 0), mTotal(0) {}
+
+        /// Returns the number of recorded values.
+        inline uint64_t
+        count() const
+        {
+            return mTotal;
+        }
+
+        inline bool
+        is_empty() const
+        {
+            return mTotal == 0;
+        }
+
+        /// Returns the value at percentile `p` (between `0.0` and `100.0`), or
+        /// `None` if nothing was recorded.
+        ///
+        /// The result is the highest value equivalent to the true percentile,
+        /// within the histogram's precision.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// Histogram h;
+        /// assert(h.snapshot().percentile(99.0) == None());
+        ///
+        /// for (uint64_t v = 1; v <= 100; v++)
+        /// {
+        ///     h.record(v);
+        /// }
+        /// assert(h.snapshot().percentile(50.0) == Some<uint64_t>(50));
+        /// ```
+        Option<uint64_t>
+        percentile(double p) const
+        {
+            if (is_empty())
+            {
+                return Option<uint64_t>();
+            }
+            auto rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(mTotal)));
+            rank = std::max<uint64_t>(rank, 1);
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < mCounts.size(); i++)
+            {
+                seen += mCounts[i];
+                if (seen >= rank)
+                {
+                    return Option<uint64_t>(detail::HistogramLayout::highest(i));
+                }
+            }
+            return Option<uint64_t>(); // Unreachable
+        }
+
+        /// Returns the lowest recorded value, within the histogram's precision.
+        Option<uint64_t>
+        min() const
+        {
+            auto it = std::find_if(mCounts.begin(), mCounts.end(), [](uint64_t c)
+                                   { return c > 0; });
+            return it == mCounts.end() ? Option<uint64_t>()
+                                       : Option<uint64_t>(detail::HistogramLayout::lowest(it - mCounts.begin()));
+        }
+
+        /// Returns the highest recorded value, within the histogram's precision.
+        Option<uint64_t>
+        max() const
+        {
+            auto it = std::find_if(mCounts.rbegin(), mCounts.rend(), [](uint64_t c)
+                                   { return c > 0; });
+            return it == mCounts.rend() ? Option<uint64_t>()
+                                        : Option<uint64_t>(detail::HistogramLayout::highest(mCounts.rend() - it - 1));
+        }
+
+        /// Returns the mean of the recorded values, within the histogram's
+        /// precision.
+        Option<double>
+        mean() const
+        {
+            if (is_empty())
+            {
+                return Option<double>();
+            }
+            double sum = 0.0;
+            for (size_t i = 0; i < mCounts.size(); i++)
+            {
+                if (mCounts[i] > 0)
+                {
+                    double mid = (static_cast<double>(detail::HistogramLayout::lowest(i)) +
+                                  static_cast<double>(detail::HistogramLayout::highest(i))) /
+                                 2.0;
+                    sum += mid * static_cast<double>(mCounts[i]);
+                }
+            }
+            return Option<double>(sum / static_cast<double>(mTotal));
+        }
+
+        /// Adds the counts of `other` to this snapshot.
+        void
+        merge(const HistogramSnapshot &other)
+        {
+            for (size_t i = 0; i < mCounts.size(); i++)
+            {
+                mCounts[i] += other.mCounts[i];
+            }
+            mTotal += other.mTotal;
+        }
+
+    private:
+        friend class Histogram;
+
+        std::vector<uint64_t> mCounts;
+        uint64_t mTotal;
+    };
+
+    /// A concurrent, fixed-size latency histogram in the style of
+    /// HdrHistogram.
+    ///
+    /// Each thread records into one of a fixed number of shards with a single
+    /// relaxed atomic increment. Reading it takes a `HistogramSnapshot`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Histogram latency;
+    /// {
+    ///     ScopedTimer timer(latency);
+    ///     handle(request);
+    /// }
+    /// auto p99 = latency.snapshot().percentile(99.0);
+    /// ```
+    class Histogram
+    {
+    public:
+        /// Creates a histogram with `shards` shards, each taking
+        /// `Histogram::ShardBytes` bytes.
+        explicit Histogram(size_t shards = default_shards())
+            : mShards(std::max<size_t>(shards, 1)),
+              mCounts(new std::atomic<uint64_t>[mShards * detail::HistogramLayout::Buckets])
+        {
+            reset();
+        }
+
+        static constexpr size_t ShardBytes = detail::HistogramLayout::Buckets * sizeof(uint64_t);
+
+        /// Records a single value.
+        inline void
+        record(uint64_t v)
+        {
+            shard()[detail::HistogramLayout::index(v)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Records `n` occurrences of a value.
+        inline void
+        record_n(uint64_t v, uint64_t n)
+        {
+            shard()[detail::HistogramLayout::index(v)].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// Records a duration, in nanoseconds.
+        inline void
+        record(Duration d)
+        {
+            record(d.as_nanos());
+        }
+
+        /// Sums the counts of every shard.
+        HistogramSnapshot
+        snapshot() const
+        {
+            HistogramSnapshot snap;
+            for (size_t s = 0; s < mShards; s++)
+            {
+                const auto *counts = &mCounts[s * detail::HistogramLayout::Buckets];
+                for (size_t i = 0; i < detail::HistogramLayout::Buckets; i++)
+                {
+                    uint64_t c = counts[i].load(std::memory_order_relaxed);
+                    snap.mCounts[i] += c;
+                    snap.mTotal += c;
+                }
+            }
+            return snap;
+        }
+
+        /// Clears all counts. Values recorded concurrently may be lost.
+        void
+        reset()
+        {
+            for (size_t i = 0; i < mShards * detail::HistogramLayout::Buckets; i++)
+            {
+                mCounts[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        static size_t
+        default_shards()
+        {
+            return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 16);
+        }
+
+        inline std::atomic<uint64_t> *
+        shard()
+        {
+            // Threads are spread over shards round-robin, in order of first use
+            static std::atomic<size_t> next{0};
+            static thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+            return &mCounts[(slot % mShards) * detail::HistogramLayout::Buckets];
+        }
+
+        size_t mShards;
+        std::unique_ptr<std::atomic<uint64_t>[]> mCounts;
+    };
+}
@@ -0,0 +1,653 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <rustly/option.h>
+#include <rustly/panic.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace rustly
+{
+    /// A handle to a string interned by an `Interner`: 32 bits, compared and
+    /// hashed as an integer. Symbols are numbered from 0 in the order their
+    /// strings were first interned.
+    class Symbol
+    {
+    public:
+        explicit constexpr Symbol(uint32_t id) noexcept : mId(id) {}
+
+        constexpr uint32_t
+        as_u32() const noexcept
+        {
+            return mId;
+        }
+
+        constexpr bool operator==(const Symbol &) const noexcept = default;
+        constexpr auto operator<=>(const Symbol &) const noexcept = default;
+
+        friend std::ostream &
+        operator<<(std::ostream &os, Symbol rhs)
+        {
+            return os << "Symbol(" << rhs.mId << ")";
+        }
+
+    private:
+        uint32_t mId;
+    };
+
+    namespace detail
+    {
+        /// Copies strings into large blocks, where they never move, so that
+        /// views of them stay valid until the arena is destroyed
+        class StringArena
+        {
+        public:
+            static constexpr size_t BlockSize = 64 * 1024;
+
+            StringArena() = default;
+
+            /// Leaves `other` empty, rather than still pointing into the block
+            /// it gave up
+            StringArena(StringArena &&other) noexcept
+                : mBlocks(std::move(other.mBlocks)), mNext(std::exchange(other.mNext, nullptr)),
+                  mRemaining(std::exchange(other.mRemaining, 0))
+            {
+            }
+
+            StringArena &
+            operator=(StringArena &&other) noexcept
+            {
+                mBlocks = std::move(other.mBlocks);
+                other.mBlocks.clear();
+                mNext = std::exchange(other.mNext, nullptr);
+                mRemaining = std::exchange(other.mRemaining, 0);
+                return *this;
+            }
+
+            std::string_view
+            store(std::string_view s)
+            {
+                if (s.empty())
+                {
+                    // Nothing to copy, and a fresh arena has nowhere to copy it
+                    return std::string_view();
+                }
+                if (s.size() > mRemaining)
+                {
+                    if (s.size() > BlockSize / 4)
+                    {
+                        // Large strings get a block of their own, so the current
+                        // block's tail isn't wasted
+                        auto &block = mBlocks.emplace_back(new char[s.size()]);
+                        std::memcpy(block.get(), s.data(), s.size());
+                        return std::string_view(block.get(), s.size());
+                    }
+                    mNext = mBlocks.emplace_back(new char[BlockSize]).get();
+                    mRemaining = BlockSize;
+                }
+                char *p = mNext;
+                std::memcpy(p, s.data(), s.size());
+                mNext += s.size();
+                mRemaining -= s.size();
+                return std::string_view(p, s.size());
+            }
+
+        private:
+            std::vector<std::unique_ptr<char[]>> mBlocks;
+            char *mNext = nullptr;
+            size_t mRemaining = 0;
+        };
+
+        inline uint64_t
+        intern_hash(std::string_view s) noexcept
+        {
+            // Mixed, so that the top bits used for tags are as good as the low
+            // bits used for positions
+            return static_cast<uint64_t>(std::hash<std::string_view>{}(s)) * 0x9e3779b97f4a7c15ull;
+        }
+
+        /// A group of control bytes in a `SwissTable`-style index, probed at
+        /// once: 16 with SSE2, or 8 in a word otherwise. A control byte is
+        /// `Empty`, or the top 7 bits of a full slot's hash.
+        struct CtrlGroup
+        {
+            static constexpr uint8_t Empty = 0x80;
+
+#if defined(__SSE2__)
+            static constexpr size_t Width = 16;
+
+            explicit CtrlGroup(const uint8_t *ctrl) noexcept
+                : mCtrl(_mm_load_si128(reinterpret_cast<const __m128i *>(ctrl)))
+            {
+            }
+
+            /// A bit per control byte equal to `tag`
+            uint32_t
+            match(uint8_t tag) const noexcept
+            {
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(mCtrl, _mm_set1_epi8(static_cast<char>(tag)))));
+            }
+
+            /// A bit per empty control byte
+            uint32_t
+            match_empty() const noexcept
+            {
+                return static_cast<uint32_t>(_mm_movemask_epi8(mCtrl));
+            }
+
+            static size_t
+            index(uint32_t bit) noexcept
+            {
+                return static_cast<size_t>(std::countr_zero(bit));
+            }
+
+            static uint32_t
+            next(uint32_t bits) noexcept
+            {
+                return bits & (bits - 1);
+            }
+
+            __m128i mCtrl;
+#else
+            static constexpr size_t Width = 8;
+            static constexpr uint64_t Lsbs = 0x0101010101010101ull;
+            static constexpr uint64_t Msbs = 0x8080808080808080ull;
+
+            explicit CtrlGroup(const uint8_t *ctrl) noexcept
+            {
+                std::memcpy(&mCtrl, ctrl, sizeof(mCtrl));
+            }
+
+            /// The high bit of each byte equal to `tag`, possibly with false
+            /// positives, which the caller rules out by comparing keys
+            uint64_t
+            match(uint8_t tag) const noexcept
+            {
+                uint64_t x = mCtrl ^ (Lsbs * tag);
+                return (x - Lsbs) & ~x & Msbs;
+            }
+
+            uint64_t
+            match_empty() const noexcept
+            {
+                return mCtrl & Msbs;
+            }
+
+            static size_t
+            index(uint64_t bit) noexcept
+            {
+                return static_cast<size_t>(std::countr_zero(bit)) / 8;
+            }
+
+            static uint64_t
+            next(uint64_t bits) noexcept
+            {
+                return bits & (bits - 1);
+            }
+
+            uint64_t mCtrl;
+#endif
+        };
+    }
+
+    /// Maps strings to 32-bit `Symbol`s and back, storing each distinct string
+    /// once, like the interners in Rust compilers. Comparing and hashing
+    /// symbols is then as cheap as for integers. Not thread-safe; see
+    /// `SyncInterner`.
+    ///
+    /// Strings are copied into an arena, and indexed by a SwissTable: a probe
+    /// compares a group of 7-bit hash tags at once, so `intern` and `lookup`
+    /// usually compare a single string.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Interner names;
+    /// Symbol a = names.intern("user_id");
+    /// assert(names.intern("user_id") == a);
+    /// assert(names.resolve(a) == "user_id");
+    /// assert(names.lookup("missing") == None());
+    /// ```
+    class Interner
+    {
+    public:
+        Interner() = default;
+
+        Interner(const Interner &) = delete;
+        Interner &operator=(const Interner &) = delete;
+
+        /// Leaves `other` empty, and usable.
+        Interner(Interner &&other) noexcept
+            : mArena(std::move(other.mArena)), mStrings(std::move(other.mStrings)), mCtrl(std::move(other.mCtrl)),
+              mSlots(std::move(other.mSlots)), mCapacity(std::exchange(other.mCapacity, 0))
+        {
+            other.mStrings.clear();
+        }
+
+        Interner &
+        operator=(Interner &&other) noexcept
+        {
+            mArena = std::move(other.mArena);
+            mStrings = std::move(other.mStrings);
+            other.mStrings.clear();
+            mCtrl = std::move(other.mCtrl);
+            mSlots = std::move(other.mSlots);
+            mCapacity = std::exchange(other.mCapacity, 0);
+            return *this;
+        }
+
+        /// Returns the symbol for `s`, interning it if it's new.
+        ///
+        /// ## Panics
+        /// Panics if there are already 2^32 - 1 symbols.
+        Symbol
+        intern(std::string_view s)
+        {
+            uint64_t hash = detail::intern_hash(s);
+            size_t empty = 0;
+            if (auto found = find(s, hash, &empty); found != NotFound)
+            {
+                return Symbol(found);
+            }
+            if (mStrings.size() >= MaxSymbols) [[unlikely]]
+            {
+                panic("interned more than {} strings", MaxSymbols);
+            }
+            auto id = static_cast<uint32_t>(mStrings.size());
+            mStrings.push_back(mArena.store(s));
+            if (mStrings.size() * 8 > mCapacity * 7)
+            {
+                grow();
+            }
+            else
+            {
+                // The probe that missed ended at the slot to use
+                mCtrl[empty] = tag(hash);
+                mSlots[empty] = id;
+            }
+            return Symbol(id);
+        }
+
+        /// Returns the symbol for `s`, if it has been interned, without
+        /// interning it.
+        Option<Symbol>
+        lookup(std::string_view s) const
+        {
+            auto found = find(s, detail::intern_hash(s), nullptr);
+            return found != NotFound ? Option<Symbol>(Symbol(found)) : Option<Symbol>();
+        }
+
+        /// Returns the string for `sym`.
+        ///
+        /// ## Panics
+        /// Panics if `sym` wasn't returned by this interner.
+        std::string_view
+        resolve(Symbol sym) const
+        {
+            if (sym.as_u32() >= mStrings.size()) [[unlikely]]
+            {
+                panic("{} is not from this interner, of {} symbols", sym.as_u32(), mStrings.size());
+            }
+            return mStrings[sym.as_u32()];
+        }
+
+        /// Returns the number of distinct strings interned.
+        size_t
+        size() const noexcept
+        {
+            return mStrings.size();
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return mStrings.empty();
+        }
+
+    private:
+        using Group = detail::CtrlGroup;
+
+        static constexpr uint32_t NotFound = UINT32_MAX;
+        static constexpr size_t MaxSymbols = NotFound;
+
+        static uint8_t
+        tag(uint64_t hash) noexcept
+        {
+            return static_cast<uint8_t>(hash >> 57);
+        }
+
+        /// Probes group by group, starting from the one chosen by the low bits
+        /// of the hash, with triangular steps that visit every group. On a
+        /// miss, sets `empty` to the first empty slot, where the string
+        /// belongs.
+        uint32_t
+        find(std::string_view s, uint64_t hash, size_t *empty) const noexcept
+        {
+            if (mCapacity == 0)
+            {
+                return NotFound;
+            }
+            size_t groups = mCapacity / Group::Width;
+            size_t g = hash & (groups - 1);
+            for (size_t step = 1;; step++)
+            {
+                Group group(&mCtrl[g * Group::Width]);
+                for (auto bits = group.match(tag(hash)); bits != 0; bits = Group::next(bits))
+                {
+                    uint32_t id = mSlots[g * Group::Width + Group::index(bits)];
+                    if (mStrings[id] == s)
+                    {
+                        return id;
+                    }
+                }
+                if (auto bits = group.match_empty(); bits != 0)
+                {
+                    if (empty != nullptr)
+                    {
+                        *empty = g * Group::Width + Group::index(bits);
+                    }
+                    return NotFound;
+                }
+                g = (g + step) & (groups - 1);
+            }
+        }
+
+        /// Places `id` in the first empty slot of its probe sequence, for
+        /// rehashing. Nothing is ever removed, so that's where `find` stops.
+        void
+        insert(uint32_t id, uint64_t hash) noexcept
+        {
+            size_t groups = mCapacity / Group::Width;
+            size_t g = hash & (groups - 1);
+            for (size_t step = 1;; step++)
+            {
+                Group group(&mCtrl[g * Group::Width]);
+                if (auto empty = group.match_empty(); empty != 0)
+                {
+                    size_t i = g * Group::Width + Group::index(empty);
+                    mCtrl[i] = tag(hash);
+                    mSlots[i] = id;
+                    return;
+                }
+                g = (g + step) & (groups - 1);
+            }
+        }
+
+        void
+        grow()
+        {
+            mCapacity = mCapacity == 0 ? 4 * Group::Width : mCapacity * 2;
+            mCtrl.reset(new (std::align_val_t(Group::Width)) uint8_t[mCapacity]);
+            std::memset(mCtrl.get(), Group::Empty, mCapacity);
+            mSlots.reset(new uint32_t[mCapacity]);
+            for (uint32_t id = 0; id < mStrings.size(); id++)
+            {
+                insert(id, detail::intern_hash(mStrings[id]));
+            }
+        }
+
+        struct AlignedDelete
+        {
+            void
+            operator()(uint8_t *p) const noexcept
+            {
+                ::operator delete[](p, std::align_val_t(Group::Width));
+            }
+        };
+
+        detail::StringArena mArena;
+        /// Indexed by symbol
+        std::vector<std::string_view> mStrings;
+        /// A control byte per slot, in groups of `Group::Width`
+        std::unique_ptr<uint8_t[], AlignedDelete> mCtrl;
+        std::unique_ptr<uint32_t[]> mSlots;
+        size_t mCapacity = 0;
+    };
+
+    /// A thread-safe `Interner`, whose `lookup` and `resolve` never lock.
+    ///
+    /// Interning a new string takes a lock. Readers probe an index of atomic
+    /// slots, published with release stores, and strings sit in segments
+    /// that never move. When the index grows, the old one is kept until the
+    /// interner is destroyed, since a reader may still be probing it; they
+    /// total less than the current one.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// SyncInterner names;
+    /// std::thread writer([&]() { names.intern("user_id"); });
+    /// writer.join();
+    /// assert(names.lookup("user_id").is_some());
+    /// ```
+    class SyncInterner
+    {
+    public:
+        SyncInterner()
+        {
+            auto table = new_table(64);
+            mTable.store(table.get(), std::memory_order_relaxed);
+            mTables.push_back(std::move(table));
+        }
+
+        SyncInterner(const SyncInterner &) = delete;
+        SyncInterner &operator=(const SyncInterner &) = delete;
+
+        ~SyncInterner()
+        {
+            for (auto &segment : mSegments)
+            {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+
+        /// Returns the symbol for `s`, interning it if it's new. Only locks
+        /// when it's new.
+        ///
+        /// ## Panics
+        /// Panics if there are already 2^32 - 1 symbols.
+        Symbol
+        intern(std::string_view s)
+        {
+            uint64_t hash = detail::intern_hash(s);
+            if (auto found = find(s, hash); found != NotFound)
+            {
+                return Symbol(found);
+            }
+
+            std::lock_guard lock(mMutex);
+            // Another thread may have interned it since
+            if (auto found = find(s, hash); found != NotFound)
+            {
+                return Symbol(found);
+            }
+            uint32_t id = mSize.load(std::memory_order_relaxed);
+            if (id >= MaxSymbols) [[unlikely]]
+            {
+                panic("interned more than {} strings", MaxSymbols);
+            }
+            Table *table = mTable.load(std::memory_order_relaxed);
+            if ((size_t(id) + 1) * 4 > (table->mask + 1) * 3)
+            {
+                table = grow(table);
+            }
+            std::string_view *segment = segment_for(id, true);
+            segment[offset(id)] = mArena.store(s);
+            // The string must be visible before the slot that leads to it
+            mSize.store(id + 1, std::memory_order_release);
+            insert(table, id, hash);
+            return Symbol(id);
+        }
+
+        /// Returns the symbol for `s`, if it has been interned, without
+        /// interning it or locking.
+        Option<Symbol>
+        lookup(std::string_view s) const
+        {
+            auto found = find(s, detail::intern_hash(s));
+            return found != NotFound ? Option<Symbol>(Symbol(found)) : Option<Symbol>();
+        }
+
+        /// Returns the string for `sym`, without locking.
+        ///
+        /// ## Panics
+        /// Panics if `sym` wasn't returned by this interner.
+        std::string_view
+        resolve(Symbol sym) const
+        {
+            uint32_t size = mSize.load(std::memory_order_acquire);
+            if (sym.as_u32() >= size) [[unlikely]]
+            {
+                panic("{} is not from this interner, of {} symbols", sym.as_u32(), size);
+            }
+            return string(sym.as_u32());
+        }
+
+        /// Returns the number of distinct strings interned so far.
+        size_t
+        size() const noexcept
+        {
+            return mSize.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr uint32_t NotFound = UINT32_MAX;
+        static constexpr size_t MaxSymbols = NotFound;
+
+        /// Segment `k` holds `FirstSegment << k` strings
+        static constexpr size_t FirstSegmentBits = 6;
+        static constexpr size_t Segments = 32 - FirstSegmentBits + 1;
+
+        /// An open-addressing index of `(hash >> 32) << 32 | (symbol + 1)`
+        /// slots, 0 when empty, probed linearly
+        struct Table
+        {
+            size_t mask;
+            std::unique_ptr<std::atomic<uint64_t>[]> slots;
+        };
+
+        static std::unique_ptr<Table>
+        new_table(size_t capacity)
+        {
+            return std::make_unique<Table>(Table{capacity - 1, std::make_unique<std::atomic<uint64_t>[]>(capacity)});
+        }
+
+        static size_t
+        segment(uint32_t id) noexcept
+        {
+            return std::bit_width((uint64_t(id) >> FirstSegmentBits) + 1) - 1;
+        }
+
+        static size_t
+        offset(uint32_t id) noexcept
+        {
+            return uint64_t(id) + (uint64_t(1) << FirstSegmentBits) - (uint64_t(1) << (segment(id) + FirstSegmentBits));
+        }
+
+        std::string_view *
+        segment_for(uint32_t id, bool allocate)
+        {
+            auto &slot = mSegments[segment(id)];
+            std::string_view *segment = slot.load(std::memory_order_acquire);
+            if (segment == nullptr && allocate)
+            {
+                segment = new std::string_view[size_t(1) << (this->segment(id) + FirstSegmentBits)];
+                slot.store(segment, std::memory_order_release);
+            }
+            return segment;
+        }
+
+        std::string_view
+        string(uint32_t id) const noexcept
+        {
+            return mSegments[segment(id)].load(std::memory_order_acquire)[offset(id)];
+        }
+
+        uint32_t
+        find(std::string_view s, uint64_t hash) const noexcept
+        {
+            const Table *table = mTable.load(std::memory_order_acquire);
+            uint64_t high = hash & 0xffffffff00000000ull;
+            for (size_t i = hash & table->mask;; i = (i + 1) & table->mask)
+            {
+                uint64_t slot = table->slots[i].load(std::memory_order_acquire);
+                if (slot == 0)
+                {
+                    return NotFound;
+                }
+                if ((slot & 0xffffffff00000000ull) == high)
+                {
+                    auto id = static_cast<uint32_t>(slot - 1);
+                    if (string(id) == s)
+                    {
+                        return id;
+                    }
+                }
+            }
+        }
+
+        static void
+        insert(Table *table, uint32_t id, uint64_t hash) noexcept
+        {
+            uint64_t slot = (hash & 0xffffffff00000000ull) | (uint64_t(id) + 1);
+            for (size_t i = hash & table->mask;; i = (i + 1) & table->mask)
+            {
+                if (table->slots[i].load(std::memory_order_relaxed) == 0)
+                {
+                    table->slots[i].store(slot, std::memory_order_release);
+                    return;
+                }
+            }
+        }
+
+        /// Builds a table twice the size, and publishes it; called with the
+        /// lock held
+        Table *
+        grow(Table *old)
+        {
+            auto bigger = new_table((old->mask + 1) * 2);
+            for (size_t i = 0; i <= old->mask; i++)
+            {
+                uint64_t slot = old->slots[i].load(std::memory_order_relaxed);
+                if (slot != 0)
+                {
+                    auto id = static_cast<uint32_t>(slot - 1);
+                    insert(bigger.get(), id, detail::intern_hash(string(id)));
+                }
+            }
+            Table *table = bigger.get();
+            mTable.store(table, std::memory_order_release);
+            mTables.push_back(std::move(bigger));
+            return table;
+        }
+
+        std::mutex mMutex;
+        detail::StringArena mArena;
+        std::atomic<std::string_view *> mSegments[Segments] = {};
+        std::atomic<uint32_t> mSize{0};
+        std::atomic<Table *> mTable;
+        /// Every table ever published, as readers may still be probing old
+        /// ones
+        std::vector<std::unique_ptr<Table>> mTables;
+    };
+}
+
+template <>
+struct std::hash<rustly::Symbol>
+{
+    size_t
+    operator()(rustly::Symbol sym) const noexcept
+    {
+        return std::hash<uint32_t>{}(sym.as_u32());
+    }
+};
@@ -0,0 +1,672 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <source_location>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <rustly/display.h>
+#include <rustly/option.h>
+#include <rustly/panic.h>
+#include <rustly/result.h>
+
+namespace rustly::logging
+{
+    /// An enum representing the available verbosity levels of the logger.
+    enum class Level : uint8_t
+    {
+        Off = 0,
+        Error,
+        Warn,
+        Info,
+        Debug,
+        Trace,
+    };
+
+    namespace detail
+    {
+        inline std::atomic<Level> &
+        max_level()
+        {
+            // Mirrors `env_logger`, which only enables errors by default
+            static std::atomic<Level> level = []()
+            {
+                const char *var = std::getenv("RUST_LOG");
+                std::string_view v = var != nullptr ? var : "error";
+                for (auto [name, l] : {std::pair{"off", Level::Off}, {"error", Level::Error}, {"warn", Level::Warn},
+                                       {"info", Level::Info}, {"debug", Level::Debug}, {"trace", Level::Trace}})
+                {
+                    if (v == name)
+                    {
+                        return l;
+                    }
+                }
+                return Level::Error;
+            }();
+            return level;
+        }
+
+        inline std::atomic<FILE *> &
+        output()
+        {
+            static std::atomic<FILE *> out{stderr};
+            return out;
+        }
+
+        /// Appends the formatted message for a record's arguments to `out`
+        using Decoder = void (*)(std::string &out, std::string_view fmt, const std::byte *args);
+
+        /// Header of every record in a thread's ring buffer. Arguments follow
+        /// immediately after, in their raw encoded form.
+        struct Header
+        {
+            uint32_t size; // Including this header, always a multiple of 8
+            bool padding;  // Marks unused space at the end of the ring
+            Level level;
+            Decoder decode;
+            const char *fmt;
+            size_t fmt_len;
+            std::source_location loc;
+            int64_t timestamp;
+        };
+
+        // Padding at the end of the ring is at least 8 bytes, and only has these
+        static_assert(offsetof(Header, padding) + sizeof(bool) <= 8);
+
+        /// Single-producer, single-consumer ring buffer of records, owned by
+        /// one logging thread and drained by the background thread.
+        class Ring
+        {
+        public:
+            static constexpr size_t Capacity = 256 * 1024;
+
+            Ring() : mBuffer(new std::byte[Capacity]), mHead(0), mCachedTail(0), mTail(0), mDropped(0), mRetired(false) {}
+
+            /// Reserves `size` contiguous bytes, or returns `nullptr` if the
+            /// consumer has fallen too far behind.
+            std::byte *
+            reserve(size_t size)
+            {
+                size_t head = mHead.load(std::memory_order_relaxed);
+                size_t pos = head & (Capacity - 1);
+                size_t pad = (pos + size > Capacity) ? Capacity - pos : 0;
+                if (head + pad + size - mCachedTail > Capacity)
+                {
+                    mCachedTail = mTail.load(std::memory_order_acquire);
+                    if (head + pad + size - mCachedTail > Capacity)
+                    {
+                        mDropped.fetch_add(1, std::memory_order_relaxed);
+                        return nullptr;
+                    }
+                }
+                if (pad > 0)
+                {
+                    // As little as 8 bytes may be left, too few for a whole
+                    // `Header`, so only its leading fields are written
+                    auto size = static_cast<uint32_t>(pad);
+                    bool padding = true;
+                    std::memcpy(mBuffer.get() + pos + offsetof(Header, size), &size, sizeof(size));
+                    std::memcpy(mBuffer.get() + pos + offsetof(Header, padding), &padding, sizeof(padding));
+                    mHead.store(head + pad, std::memory_order_release);
+                    pos = 0;
+                }
+                return mBuffer.get() + pos;
+            }
+
+            void
+            commit(size_t size)
+            {
+                mHead.store(mHead.load(std::memory_order_relaxed) + size, std::memory_order_release);
+            }
+
+            /// Calls `f` for each committed record, then releases them.
+            /// Returns the number of records consumed.
+            template <class F>
+            size_t
+            consume(F &&f)
+            {
+                size_t tail = mTail.load(std::memory_order_relaxed);
+                size_t head = mHead.load(std::memory_order_acquire);
+                size_t count = 0;
+                while (tail != head)
+                {
+                    const std::byte *record = mBuffer.get() + (tail & (Capacity - 1));
+                    uint32_t size;
+                    bool padding;
+                    std::memcpy(&size, record + offsetof(Header, size), sizeof(size));
+                    std::memcpy(&padding, record + offsetof(Header, padding), sizeof(padding));
+                    if (!padding)
+                    {
+                        const auto *h = reinterpret_cast<const Header *>(record);
+                        f(*h, reinterpret_cast<const std::byte *>(h + 1));
+                        count++;
+                    }
+                    tail += size;
+                }
+                mTail.store(tail, std::memory_order_release);
+                return count;
+            }
+
+            size_t
+            take_dropped()
+            {
+                return mDropped.exchange(0, std::memory_order_relaxed);
+            }
+
+            void
+            retire()
+            {
+                mRetired.store(true, std::memory_order_release);
+            }
+
+            /// Returns `true` once the owning thread has exited and every record
+            /// it logged has been consumed.
+            bool
+            is_exhausted() const
+            {
+                return mRetired.load(std::memory_order_acquire) &&
+                       mTail.load(std::memory_order_relaxed) == mHead.load(std::memory_order_relaxed);
+            }
+
+        private:
+            std::unique_ptr<std::byte[]> mBuffer;
+            alignas(64) std::atomic<size_t> mHead;
+            size_t mCachedTail;
+            alignas(64) std::atomic<size_t> mTail;
+            std::atomic<size_t> mDropped;
+            std::atomic<bool> mRetired;
+        };
+
+        /// Owns every thread's ring, and the background thread that formats
+        /// and writes their records.
+        class Logger
+        {
+        public:
+            static Logger &
+            instance()
+            {
+                static Logger logger;
+                return logger;
+            }
+
+            std::shared_ptr<Ring>
+            attach()
+            {
+                auto ring = std::make_shared<Ring>();
+                std::lock_guard<std::mutex> guard(mRegistryLock);
+                mRings.push_back(ring);
+                return ring;
+            }
+
+            /// Formats and writes every pending record
+            void
+            flush()
+            {
+                std::lock_guard<std::mutex> guard(mDrainLock);
+                drain();
+            }
+
+            /// Writes out pending records before a panic aborts, if there's a
+            /// logger running. It never blocks on the drain lock, since the
+            /// panic may have come from within a drain on this very thread;
+            /// if another thread holds it for too long, the records are lost.
+            static void
+            flush_on_panic()
+            {
+                Logger *logger = live().load(std::memory_order_acquire);
+                if (logger == nullptr || std::this_thread::get_id() == logger->mThread.get_id())
+                {
+                    return;
+                }
+                std::unique_lock<std::mutex> guard(logger->mDrainLock, std::try_to_lock);
+                for (int attempt = 0; !guard.owns_lock() && attempt < 100; attempt++)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    guard.try_lock();
+                }
+                if (guard.owns_lock())
+                {
+                    logger->drain();
+                    std::fflush(output().load(std::memory_order_relaxed));
+                }
+            }
+
+        private:
+            Logger() : mStop(false), mThread([this]()
+                                             { run(); })
+            {
+                live().store(this, std::memory_order_release);
+            }
+
+            ~Logger()
+            {
+                live().store(nullptr, std::memory_order_release);
+                mStop.store(true, std::memory_order_relaxed);
+                mThread.join();
+                flush();
+            }
+
+            static std::atomic<Logger *> &
+            live()
+            {
+                static std::atomic<Logger *> logger{nullptr};
+                return logger;
+            }
+
+            void
+            run()
+            {
+                while (!mStop.load(std::memory_order_relaxed))
+                {
+                    size_t count;
+                    {
+                        std::lock_guard<std::mutex> guard(mDrainLock);
+                        count = drain();
+                    }
+                    if (count == 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+            }
+
+            size_t
+            drain()
+            {
+                std::vector<std::shared_ptr<Ring>> rings;
+                {
+                    std::lock_guard<std::mutex> guard(mRegistryLock);
+                    rings = mRings;
+                }
+
+                size_t count = 0;
+                for (auto &ring : rings)
+                {
+                    count += ring->consume([this](const Header &h, const std::byte *args)
+                                           { write(h, args); });
+                    if (size_t dropped = ring->take_dropped(); dropped > 0)
+                    {
+                        mBuffer += std::format("[rustly::logging] dropped {} messages, logging thread fell behind\n", dropped);
+                    }
+                }
+
+                if (!mBuffer.empty())
+                {
+                    std::fwrite(mBuffer.data(), 1, mBuffer.size(), output().load(std::memory_order_relaxed));
+                    mBuffer.clear();
+                }
+
+                // Rings of exited threads can go once they're drained
+                std::lock_guard<std::mutex> guard(mRegistryLock);
+                std::erase_if(mRings, [](const auto &ring)
+                              { return ring->is_exhausted(); });
+                return count;
+            }
+
+            void
+            write(const Header &h, const std::byte *args)
+            {
+                static constexpr const char *Names[] = {"OFF", "ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+
+                time_t secs = static_cast<time_t>(h.timestamp / 1'000'000'000);
+                std::tm tm{};
+                gmtime_r(&secs, &tm);
+                char time[32];
+                std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &tm);
+
+                std::format_to(std::back_inserter(mBuffer), "[{}.{:06}Z {:<5} {}:{}] ",
+                               time, (h.timestamp % 1'000'000'000) / 1'000, Names[static_cast<size_t>(h.level)],
+                               h.loc.file_name(), h.loc.line());
+                h.decode(mBuffer, std::string_view(h.fmt, h.fmt_len), args);
+                mBuffer += '\n';
+            }
+
+            std::mutex mRegistryLock;
+            std::vector<std::shared_ptr<Ring>> mRings;
+            std::mutex mDrainLock;
+            std::string mBuffer;
+            std::atomic<bool> mStop;
+            std::thread mThread;
+        };
+
+        /// Writes out logged messages before a panic aborts
+        inline const bool PanicFlushRegistered = rustly::detail::panic_hooks.add_flush(&Logger::flush_on_panic);
+
+        /// Registers the calling thread's ring on first use, and retires it
+        /// when the thread exits.
+        class RingHandle
+        {
+        public:
+            RingHandle() : mRing(Logger::instance().attach()) {}
+            ~RingHandle() { mRing->retire(); }
+
+            Ring &
+            get()
+            {
+                return *mRing;
+            }
+
+        private:
+            std::shared_ptr<Ring> mRing;
+        };
+
+        inline Ring &
+        thread_ring()
+        {
+            static thread_local RingHandle handle;
+            return handle.get();
+        }
+
+        // Argument encoding
+        //
+        // Scalars and strings (and `Option`/`Result`s of them) are copied into
+        // the record as raw bytes and only formatted by the background thread.
+        // Any other `Display` type is eagerly rendered to a string.
+
+        template <class T>
+        struct Codec;
+
+        template <class T>
+        concept Scalar = std::is_arithmetic_v<T> || std::same_as<T, const void *> ||
+                         std::same_as<T, void *> || std::same_as<T, std::nullptr_t>;
+
+        template <class T>
+        concept Stringly = std::same_as<T, const char *> || std::same_as<T, char *> ||
+                           std::same_as<T, std::string> || std::same_as<T, std::string_view>;
+
+        template <class T>
+        struct IsDeferred : std::bool_constant<Scalar<T> || Stringly<T>>
+        {
+        };
+
+        template <class T>
+        struct IsDeferred<Option<T>> : IsDeferred<T>
+        {
+        };
+
+        template <class T, class E>
+        struct IsDeferred<Result<T, E>> : std::bool_constant<IsDeferred<T>::value && IsDeferred<E>::value>
+        {
+        };
+
+        template <class T>
+        concept Deferred = IsDeferred<T>::value;
+
+        template <class T>
+        concept Loggable = Deferred<T> || Display<T>;
+
+        template <class T>
+            requires Scalar<T>
+        struct Codec<T>
+        {
+            using Decoded = T;
+
+            static size_t size(const T &) { return sizeof(T); }
+
+            static void
+            encode(std::byte *&p, const T &t)
+            {
+                std::memcpy(p, &t, sizeof(T));
+                p += sizeof(T);
+            }
+
+            static T
+            decode(const std::byte *&p)
+            {
+                T t;
+                std::memcpy(&t, p, sizeof(T));
+                p += sizeof(T);
+                return t;
+            }
+        };
+
+        template <class T>
+            requires Stringly<T>
+        struct Codec<T>
+        {
+            using Decoded = std::string_view;
+
+            static size_t size(std::string_view s) { return sizeof(size_t) + s.size(); }
+
+            static void
+            encode(std::byte *&p, std::string_view s)
+            {
+                size_t len = s.size();
+                std::memcpy(p, &len, sizeof(len));
+                std::memcpy(p + sizeof(len), s.data(), len);
+                p += sizeof(len) + len;
+            }
+
+            static std::string_view
+            decode(const std::byte *&p)
+            {
+                size_t len;
+                std::memcpy(&len, p, sizeof(len));
+                std::string_view s(reinterpret_cast<const char *>(p + sizeof(len)), len);
+                p += sizeof(len) + len;
+                return s;
+            }
+        };
+
+        template <class T>
+            requires Deferred<T>
+        struct Codec<Option<T>>
+        {
+            using Decoded = std::string;
+
+            static size_t
+            size(const Option<T> &o)
+            {
+                return 1 + (o.is_some() ? Codec<T>::size(o.unwrap()) : 0);
+            }
+
+            static void
+            encode(std::byte *&p, const Option<T> &o)
+            {
+                *p++ = static_cast<std::byte>(o.is_some());
+                if (o.is_some())
+                {
+                    Codec<T>::encode(p, o.unwrap());
+                }
+            }
+
+            static std::string
+            decode(const std::byte *&p)
+            {
+                return (*p++ != std::byte{0}) ? std::format("Some({})", Codec<T>::decode(p)) : std::string("None");
+            }
+        };
+
+        template <class T, class E>
+            requires(Deferred<T> && Deferred<E>)
+        struct Codec<Result<T, E>>
+        {
+            using Decoded = std::string;
+
+            static size_t
+            size(const Result<T, E> &r)
+            {
+                return 1 + (r.is_ok() ? Codec<T>::size(r.ok().unwrap()) : Codec<E>::size(r.err().unwrap()));
+            }
+
+            static void
+            encode(std::byte *&p, const Result<T, E> &r)
+            {
+                *p++ = static_cast<std::byte>(r.is_ok());
+                if (r.is_ok())
+                {
+                    Codec<T>::encode(p, r.ok().unwrap());
+                }
+                else
+                {
+                    Codec<E>::encode(p, r.err().unwrap());
+                }
+            }
+
+            static std::string
+            decode(const std::byte *&p)
+            {
+                return (*p++ != std::byte{0}) ? std::format("Ok({})", Codec<T>::decode(p))
+                                              : std::format("Err({})", Codec<E>::decode(p));
+            }
+        };
+
+        /// The type an argument is encoded as: itself when it can be deferred,
+        /// otherwise its eagerly rendered string
+        template <class T>
+        using Encoded = std::conditional_t<Deferred<std::decay_t<T>>, std::decay_t<T>, std::string>;
+
+        /// The type an argument is formatted as, once decoded
+        template <class T>
+        using Decoded = typename Codec<Encoded<T>>::Decoded;
+
+        template <class T>
+        inline decltype(auto)
+        prepare(const T &t)
+        {
+            if constexpr (Scalar<std::decay_t<T>> || std::is_array_v<T>)
+            {
+                return std::decay_t<T>(t);
+            }
+            else if constexpr (Deferred<T>)
+            {
+                return static_cast<const T &>(t);
+            }
+            else if constexpr (ToStream<T>)
+            {
+                std::ostringstream oss;
+                oss << t;
+                return oss.str();
+            }
+            else
+            {
+                return std::to_string(t);
+            }
+        }
+
+        template <class... Encoded>
+        inline void
+        decode(std::string &out, std::string_view fmt, [[maybe_unused]] const std::byte *args)
+        {
+            // Braced initialization guarantees left-to-right decoding
+            std::tuple<typename Codec<Encoded>::Decoded...> decoded{Codec<Encoded>::decode(args)...};
+            std::apply([&](auto &...a)
+                       { std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(a...)); },
+                       decoded);
+        }
+
+        template <class... Args>
+        inline void
+        record(Level level, const std::source_location loc, std::string_view fmt, const Args &...args)
+        {
+            auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+
+            // Non-deferred arguments are rendered here, before sizing the record
+            std::tuple<decltype(prepare(args))...> prepared{prepare(args)...};
+            size_t size = std::apply([](const auto &...p)
+                                     { return (sizeof(Header) + ... + Codec<Encoded<Args>>::size(p)); },
+                                     prepared);
+            size = (size + 7) & ~size_t(7);
+
+            Ring &ring = thread_ring();
+            std::byte *p = ring.reserve(size);
+            if (p == nullptr)
+            {
+                return;
+            }
+            new (p) Header{static_cast<uint32_t>(size), false, level, &decode<Encoded<Args>...>,
+                           fmt.data(), fmt.size(), loc, timestamp};
+            std::byte *cursor = p + sizeof(Header);
+            std::apply([&](const auto &...p)
+                       { (Codec<Encoded<Args>>::encode(cursor, p), ...); },
+                       prepared);
+            ring.commit(size);
+        }
+
+        template <class... Args>
+            requires(Loggable<std::decay_t<Args>> && ...)
+        inline void
+        log(Level level, const std::source_location loc,
+            const std::format_string<Decoded<Args>...> &fmt, const Args &...args)
+        {
+            record(level, loc, std::string_view(fmt.get().data(), fmt.get().size()), args...);
+        }
+    }
+
+    /// Returns the current maximum log level. Initialized from the `RUST_LOG`
+    /// environment variable (`off`, `error`, `warn`, `info`, `debug` or `trace`),
+    /// defaulting to `error`.
+    inline Level
+    max_level()
+    {
+        return detail::max_level().load(std::memory_order_relaxed);
+    }
+
+    /// Sets the maximum log level. Messages above it are discarded without
+    /// evaluating their arguments.
+    inline void
+    set_max_level(Level level)
+    {
+        detail::max_level().store(level, std::memory_order_relaxed);
+    }
+
+    /// Returns `true` if a message at `level` would be logged.
+    inline bool
+    enabled(Level level)
+    {
+        return level != Level::Off && level <= max_level();
+    }
+
+    /// Redirects formatted log output, `stderr` by default.
+    inline void
+    set_output(FILE *out)
+    {
+        detail::output().store(out, std::memory_order_relaxed);
+    }
+
+    /// Blocks until every message logged so far has been formatted and written.
+    inline void
+    flush()
+    {
+        detail::Logger::instance().flush();
+        std::fflush(detail::output().load(std::memory_order_relaxed));
+    }
+}
+
+#define __log_impl(level, ...)                                                                    \
+    (::rustly::logging::enabled(level)                                                                \
+         ? ::rustly::logging::detail::log(level, std::source_location::current(), __VA_ARGS__) \
+         : void())
+
+/// @brief Logs a message at the error level.
+///
+/// Only the format string and raw arguments are recorded by the calling thread;
+/// formatting happens on a background thread. Format strings are checked at
+/// compile time.
+#define log_error(...) __log_impl(::rustly::logging::Level::Error, __VA_ARGS__)
+/// @brief Logs a message at the warn level.
+#define log_warn(...) __log_impl(::rustly::logging::Level::Warn, __VA_ARGS__)
+/// @brief Logs a message at the info level.
+#define log_info(...) __log_impl(::rustly::logging::Level::Info, __VA_ARGS__)
+/// @brief Logs a message at the debug level.
+#define log_debug(...) __log_impl(::rustly::logging::Level::Debug, __VA_ARGS__)
+/// @brief Logs a message at the trace level.
+#define log_trace(...) __log_impl(::rustly::logging::Level::Trace, __VA_ARGS__)
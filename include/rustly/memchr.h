@@ -0,0 +1,767 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <rustly/cpu.h>
+#include <rustly/option.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace rustly
+{
+    namespace detail::search
+    {
+        /// Returned by kernels that found nothing
+        inline constexpr size_t NotFound = SIZE_MAX;
+
+        /// Searches `n` bytes for any of `N` bytes, returning the first index
+        /// or `NotFound`
+        using ForwardFn = size_t (*)(const uint8_t *p, size_t n, uint8_t a, uint8_t b, uint8_t c);
+        /// Searches `n` bytes for `a`, returning the last index or `NotFound`
+        using ReverseFn = size_t (*)(const uint8_t *p, size_t n, uint8_t a);
+
+        inline constexpr uint64_t Lsbs = 0x0101010101010101ull;
+        inline constexpr uint64_t Msbs = 0x8080808080808080ull;
+
+        /// The high bit of each zero byte of `x`; exact up to the lowest one
+        inline uint64_t
+        zero_bytes(uint64_t x) noexcept
+        {
+            return (x - Lsbs) & ~x & Msbs;
+        }
+
+        template <int N>
+        inline bool
+        matches(uint8_t x, uint8_t a, uint8_t b, uint8_t c) noexcept
+        {
+            return x == a || (N >= 2 && x == b) || (N >= 3 && x == c);
+        }
+
+        /// A word at a time, on little-endian targets
+        template <int N>
+        inline size_t
+        forward_scalar(const uint8_t *p, size_t n, uint8_t a, uint8_t b, uint8_t c)
+        {
+            size_t i = 0;
+            if constexpr (std::endian::native == std::endian::little)
+            {
+                for (; i + 8 <= n; i += 8)
+                {
+                    uint64_t w;
+                    std::memcpy(&w, p + i, 8);
+                    uint64_t z = zero_bytes(w ^ (Lsbs * a));
+                    if constexpr (N >= 2)
+                    {
+                        z |= zero_bytes(w ^ (Lsbs * b));
+                    }
+                    if constexpr (N >= 3)
+                    {
+                        z |= zero_bytes(w ^ (Lsbs * c));
+                    }
+                    if (z != 0)
+                    {
+                        return i + static_cast<size_t>(std::countr_zero(z)) / 8;
+                    }
+                }
+            }
+            for (; i < n; i++)
+            {
+                if (matches<N>(p[i], a, b, c))
+                {
+                    return i;
+                }
+            }
+            return NotFound;
+        }
+
+        /// The high bit of each zero byte of `x`, exactly, for finding the last
+        inline uint64_t
+        zero_bytes_exact(uint64_t x) noexcept
+        {
+            constexpr uint64_t Lows = ~Msbs;
+            return ~(((x & Lows) + Lows) | x | Lows);
+        }
+
+        inline size_t
+        reverse_scalar(const uint8_t *p, size_t n, uint8_t a)
+        {
+            if constexpr (std::endian::native == std::endian::little)
+            {
+                for (; n >= 8; n -= 8)
+                {
+                    uint64_t w;
+                    std::memcpy(&w, p + n - 8, 8);
+                    if (uint64_t z = zero_bytes_exact(w ^ (Lsbs * a)); z != 0)
+                    {
+                        return n - 8 + static_cast<size_t>(63 - std::countl_zero(z)) / 8;
+                    }
+                }
+            }
+            while (n > 0)
+            {
+                if (p[--n] == a)
+                {
+                    return n;
+                }
+            }
+            return NotFound;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        /// SSE2 is baseline on x86-64, but it's the SSE4.2 tier's kernel so
+        /// that the scalar one can be tested
+        template <int N>
+        RUSTLY_TARGET_SSE42 inline size_t
+        forward_sse42(const uint8_t *p, size_t n, uint8_t a, uint8_t b, uint8_t c)
+        {
+            const __m128i va = _mm_set1_epi8(static_cast<char>(a));
+            const __m128i vb = _mm_set1_epi8(static_cast<char>(b));
+            const __m128i vc = _mm_set1_epi8(static_cast<char>(c));
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                __m128i eq = _mm_cmpeq_epi8(v, va);
+                if constexpr (N >= 2)
+                {
+                    eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, vb));
+                }
+                if constexpr (N >= 3)
+                {
+                    eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, vc));
+                }
+                if (int mask = _mm_movemask_epi8(eq); mask != 0)
+                {
+                    return i + static_cast<size_t>(std::countr_zero(static_cast<uint32_t>(mask)));
+                }
+            }
+            size_t rest = forward_scalar<N>(p + i, n - i, a, b, c);
+            return rest == NotFound ? NotFound : i + rest;
+        }
+
+        template <int N>
+        RUSTLY_TARGET_AVX2 inline size_t
+        forward_avx2(const uint8_t *p, size_t n, uint8_t a, uint8_t b, uint8_t c)
+        {
+            const __m256i va = _mm256_set1_epi8(static_cast<char>(a));
+            const __m256i vb = _mm256_set1_epi8(static_cast<char>(b));
+            const __m256i vc = _mm256_set1_epi8(static_cast<char>(c));
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                __m256i eq = _mm256_cmpeq_epi8(v, va);
+                if constexpr (N >= 2)
+                {
+                    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(v, vb));
+                }
+                if constexpr (N >= 3)
+                {
+                    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(v, vc));
+                }
+                if (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq)); mask != 0)
+                {
+                    return i + static_cast<size_t>(std::countr_zero(mask));
+                }
+            }
+            size_t rest = forward_sse42<N>(p + i, n - i, a, b, c);
+            return rest == NotFound ? NotFound : i + rest;
+        }
+
+        /// Masked loads cover the tail, without reading past the end
+        template <int N>
+        RUSTLY_TARGET_AVX512 inline size_t
+        forward_avx512(const uint8_t *p, size_t n, uint8_t a, uint8_t b, uint8_t c)
+        {
+            const __m512i va = _mm512_set1_epi8(static_cast<char>(a));
+            const __m512i vb = _mm512_set1_epi8(static_cast<char>(b));
+            const __m512i vc = _mm512_set1_epi8(static_cast<char>(c));
+            for (size_t i = 0; i < n; i += 64)
+            {
+                __mmask64 live = n - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+                __m512i v = _mm512_maskz_loadu_epi8(live, p + i);
+                __mmask64 eq = _mm512_cmpeq_epi8_mask(v, va);
+                if constexpr (N >= 2)
+                {
+                    eq |= _mm512_cmpeq_epi8_mask(v, vb);
+                }
+                if constexpr (N >= 3)
+                {
+                    eq |= _mm512_cmpeq_epi8_mask(v, vc);
+                }
+                if (eq &= live; eq != 0)
+                {
+                    return i + static_cast<size_t>(std::countr_zero(static_cast<uint64_t>(eq)));
+                }
+            }
+            return NotFound;
+        }
+
+        RUSTLY_TARGET_SSE42 inline size_t
+        reverse_sse42(const uint8_t *p, size_t n, uint8_t a)
+        {
+            const __m128i va = _mm_set1_epi8(static_cast<char>(a));
+            for (; n >= 16; n -= 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + n - 16));
+                if (int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, va)); mask != 0)
+                {
+                    return n - 16 + 31 - static_cast<size_t>(std::countl_zero(static_cast<uint32_t>(mask)));
+                }
+            }
+            return reverse_scalar(p, n, a);
+        }
+
+        RUSTLY_TARGET_AVX2 inline size_t
+        reverse_avx2(const uint8_t *p, size_t n, uint8_t a)
+        {
+            const __m256i va = _mm256_set1_epi8(static_cast<char>(a));
+            for (; n >= 32; n -= 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + n - 32));
+                if (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, va))); mask != 0)
+                {
+                    return n - 32 + 31 - static_cast<size_t>(std::countl_zero(mask));
+                }
+            }
+            return reverse_sse42(p, n, a);
+        }
+
+        template <int N>
+        inline cpu::Dispatch<size_t(const uint8_t *, size_t, uint8_t, uint8_t, uint8_t)> forward{
+            forward_scalar<N>, forward_sse42<N>, forward_avx2<N>, forward_avx512<N>};
+        inline cpu::Dispatch<size_t(const uint8_t *, size_t, uint8_t)> reverse{reverse_scalar, reverse_sse42, reverse_avx2};
+#else
+        template <int N>
+        inline cpu::Dispatch<size_t(const uint8_t *, size_t, uint8_t, uint8_t, uint8_t)> forward{forward_scalar<N>};
+        inline cpu::Dispatch<size_t(const uint8_t *, size_t, uint8_t)> reverse{reverse_scalar};
+#endif
+
+        inline const uint8_t *
+        bytes(std::string_view s) noexcept
+        {
+            return reinterpret_cast<const uint8_t *>(s.data());
+        }
+
+        template <int N>
+        inline Option<size_t>
+        find_bytes(std::string_view haystack, char a, char b, char c)
+        {
+            size_t i = forward<N>(bytes(haystack), haystack.size(), static_cast<uint8_t>(a), static_cast<uint8_t>(b),
+                                  static_cast<uint8_t>(c));
+            return i == NotFound ? Option<size_t>() : Option<size_t>(i);
+        }
+    }
+
+    /// Returns the index of the first `needle` byte in `haystack`, if any,
+    /// like `memchr(3)`. Uses AVX2 or AVX-512 where available.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// assert(memchr(',', "a,b,c") == Some<size_t>(1));
+    /// assert(memchr(';', "a,b,c") == None());
+    /// ```
+    inline Option<size_t>
+    memchr(char needle, std::string_view haystack)
+    {
+        return detail::search::find_bytes<1>(haystack, needle, needle, needle);
+    }
+
+    /// Returns the index of the first byte in `haystack` that is either
+    /// `n1` or `n2`, if any.
+    inline Option<size_t>
+    memchr2(char n1, char n2, std::string_view haystack)
+    {
+        return detail::search::find_bytes<2>(haystack, n1, n2, n2);
+    }
+
+    /// Returns the index of the first byte in `haystack` that is `n1`, `n2`
+    /// or `n3`, if any.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// // The end of a CSV field
+    /// assert(memchr3(',', '"', '\n', "abc\"d") == Some<size_t>(3));
+    /// ```
+    inline Option<size_t>
+    memchr3(char n1, char n2, char n3, std::string_view haystack)
+    {
+        return detail::search::find_bytes<3>(haystack, n1, n2, n3);
+    }
+
+    /// Returns the index of the last `needle` byte in `haystack`, if any.
+    inline Option<size_t>
+    memrchr(char needle, std::string_view haystack)
+    {
+        size_t i = detail::search::reverse(detail::search::bytes(haystack), haystack.size(), static_cast<uint8_t>(needle));
+        return i == detail::search::NotFound ? Option<size_t>() : Option<size_t>(i);
+    }
+
+    namespace detail::search
+    {
+        /// Returned by a prefilter that stopped early, since its candidates
+        /// kept failing to match
+        inline constexpr size_t GaveUp = SIZE_MAX - 1;
+
+        /// Finds candidates for an `m`-byte needle (`m >= 2`) where both its
+        /// first and last bytes match, and verifies them. Gives up, setting
+        /// `resume`, if too many candidates fail.
+        using PrefilterFn = size_t (*)(const uint8_t *h, size_t n, const uint8_t *needle, size_t m, size_t *resume);
+
+        /// Allows a failed candidate per 8 bytes scanned, plus some slack
+        inline bool
+        too_many_failures(size_t failures, size_t scanned) noexcept
+        {
+            return failures > 32 + scanned / 8;
+        }
+
+        inline size_t
+        prefilter_tail(const uint8_t *h, size_t n, const uint8_t *needle, size_t m, size_t i)
+        {
+            for (; i + m <= n; i++)
+            {
+                if (h[i] == needle[0] && h[i + m - 1] == needle[m - 1] && std::memcmp(h + i + 1, needle + 1, m - 2) == 0)
+                {
+                    return i;
+                }
+            }
+            return NotFound;
+        }
+
+        /// Without SIMD, the Two-Way search is used from the start
+        inline size_t
+        prefilter_scalar(const uint8_t *, size_t, const uint8_t *, size_t, size_t *resume)
+        {
+            *resume = 0;
+            return GaveUp;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        RUSTLY_TARGET_SSE42 inline size_t
+        prefilter_sse42(const uint8_t *h, size_t n, const uint8_t *needle, size_t m, size_t *resume)
+        {
+            const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+            const __m128i last = _mm_set1_epi8(static_cast<char>(needle[m - 1]));
+            size_t failures = 0;
+            size_t i = 0;
+            for (; i + m - 1 + 16 <= n; i += 16)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i + m - 1));
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    size_t k = i + static_cast<size_t>(std::countr_zero(mask));
+                    if (std::memcmp(h + k + 1, needle + 1, m - 2) == 0)
+                    {
+                        return k;
+                    }
+                    failures++;
+                }
+                if (too_many_failures(failures, i)) [[unlikely]]
+                {
+                    *resume = i + 16;
+                    return GaveUp;
+                }
+            }
+            return prefilter_tail(h, n, needle, m, i);
+        }
+
+        RUSTLY_TARGET_AVX2 inline size_t
+        prefilter_avx2(const uint8_t *h, size_t n, const uint8_t *needle, size_t m, size_t *resume)
+        {
+            const __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+            const __m256i last = _mm256_set1_epi8(static_cast<char>(needle[m - 1]));
+            size_t failures = 0;
+            size_t i = 0;
+            for (; i + m - 1 + 32 <= n; i += 32)
+            {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i + m - 1));
+                auto mask = static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    size_t k = i + static_cast<size_t>(std::countr_zero(mask));
+                    if (std::memcmp(h + k + 1, needle + 1, m - 2) == 0)
+                    {
+                        return k;
+                    }
+                    failures++;
+                }
+                if (too_many_failures(failures, i)) [[unlikely]]
+                {
+                    *resume = i + 32;
+                    return GaveUp;
+                }
+            }
+            return prefilter_tail(h, n, needle, m, i);
+        }
+
+        inline cpu::Dispatch<size_t(const uint8_t *, size_t, const uint8_t *, size_t, size_t *)> prefilter{
+            prefilter_scalar, prefilter_sse42, prefilter_avx2};
+#else
+        inline cpu::Dispatch<size_t(const uint8_t *, size_t, const uint8_t *, size_t, size_t *)> prefilter{prefilter_scalar};
+#endif
+    }
+
+    /// A substring searcher for one needle, which can be reused across
+    /// haystacks, like Rust's `memchr::memmem::Finder`. The needle must
+    /// outlive it.
+    ///
+    /// A SIMD prefilter finds positions where the needle's first and last
+    /// bytes both match, and compares the rest. If too many of those
+    /// candidates fail, as for needles of common bytes, it switches to the
+    /// Two-Way algorithm, which is linear in the worst case and uses constant
+    /// space.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Finder finder("ERROR");
+    /// for (std::string_view line : lines)
+    /// {
+    ///     if (finder.find(line).is_some())
+    ///     {
+    ///         report(line);
+    ///     }
+    /// }
+    /// ```
+    class Finder
+    {
+    public:
+        explicit Finder(std::string_view needle) noexcept : mNeedle(needle)
+        {
+            // Critical factorization: the later of the maximal suffixes under
+            // either byte order
+            size_t m = needle.size();
+            size_t p, q;
+            ptrdiff_t i = max_suffix(false, p), j = max_suffix(true, q);
+            mEll = i > j ? i : j;
+            mPeriod = i > j ? p : q;
+            mPeriodic = mEll + 1 + static_cast<ptrdiff_t>(mPeriod) <= static_cast<ptrdiff_t>(m) &&
+                        std::memcmp(needle.data(), needle.data() + mPeriod, static_cast<size_t>(mEll + 1)) == 0;
+            if (!mPeriodic)
+            {
+                mPeriod = std::max<size_t>(static_cast<size_t>(mEll + 1), m - static_cast<size_t>(mEll) - 1) + 1;
+            }
+        }
+
+        std::string_view
+        needle() const noexcept
+        {
+            return mNeedle;
+        }
+
+        /// Returns the index of the first occurrence of the needle in
+        /// `haystack`, if any. An empty needle is found at 0.
+        Option<size_t>
+        find(std::string_view haystack) const
+        {
+            size_t m = mNeedle.size(), n = haystack.size();
+            if (m == 0)
+            {
+                return Option<size_t>(0);
+            }
+            if (m > n)
+            {
+                return Option<size_t>();
+            }
+            if (m == 1)
+            {
+                return memchr(mNeedle[0], haystack);
+            }
+            size_t resume = 0;
+            size_t i = detail::search::prefilter(detail::search::bytes(haystack), n, detail::search::bytes(mNeedle), m, &resume);
+            if (i == detail::search::NotFound)
+            {
+                return Option<size_t>();
+            }
+            if (i != detail::search::GaveUp)
+            {
+                return Option<size_t>(i);
+            }
+            return two_way(haystack, resume);
+        }
+
+    private:
+        /// The start of the maximal suffix of the needle, minus one, under the
+        /// usual byte order or its reverse, and that suffix's period
+        ptrdiff_t
+        max_suffix(bool reversed, size_t &period) const noexcept
+        {
+            const auto *x = detail::search::bytes(mNeedle);
+            ptrdiff_t m = static_cast<ptrdiff_t>(mNeedle.size());
+            ptrdiff_t ms = -1, j = 0, k = 1, p = 1;
+            while (j + k < m)
+            {
+                uint8_t a = x[j + k], b = x[ms + k];
+                if (reversed ? a > b : a < b)
+                {
+                    j += k;
+                    k = 1;
+                    p = j - ms;
+                }
+                else if (a == b)
+                {
+                    if (k != p)
+                    {
+                        k++;
+                    }
+                    else
+                    {
+                        j += p;
+                        k = 1;
+                    }
+                }
+                else
+                {
+                    ms = j;
+                    j = ms + 1;
+                    k = p = 1;
+                }
+            }
+            period = static_cast<size_t>(p);
+            return ms;
+        }
+
+        /// Crochemore and Perrin's Two-Way search, from `from`
+        Option<size_t>
+        two_way(std::string_view haystack, size_t from) const noexcept
+        {
+            const auto *x = detail::search::bytes(mNeedle);
+            const auto *y = detail::search::bytes(haystack);
+            ptrdiff_t m = static_cast<ptrdiff_t>(mNeedle.size()), n = static_cast<ptrdiff_t>(haystack.size());
+            ptrdiff_t per = static_cast<ptrdiff_t>(mPeriod);
+            ptrdiff_t memory = -1;
+            for (ptrdiff_t j = static_cast<ptrdiff_t>(from); j <= n - m;)
+            {
+                // Match the right half, left to right
+                ptrdiff_t i = std::max(mEll, memory) + 1;
+                while (i < m && x[i] == y[i + j])
+                {
+                    i++;
+                }
+                if (i < m)
+                {
+                    j += i - mEll;
+                    memory = -1;
+                    continue;
+                }
+                // Then the left half, right to left
+                ptrdiff_t floor = mPeriodic ? memory : -1;
+                i = mEll;
+                while (i > floor && x[i] == y[i + j])
+                {
+                    i--;
+                }
+                if (i <= floor)
+                {
+                    return Option<size_t>(static_cast<size_t>(j));
+                }
+                j += per;
+                if (mPeriodic)
+                {
+                    memory = m - per - 1;
+                }
+            }
+            return Option<size_t>();
+        }
+
+        std::string_view mNeedle;
+        /// The critical position, minus one
+        ptrdiff_t mEll;
+        size_t mPeriod;
+        /// The left half is a suffix of the right half's period, so matched
+        /// prefixes can be remembered across shifts
+        bool mPeriodic;
+    };
+
+    /// Returns the index of the first occurrence of `needle` in `haystack`,
+    /// if any, like `memmem(3)`. Prefer a `Finder` to search for the same
+    /// needle repeatedly.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// assert(memmem("GET /index.html HTTP/1.1", "HTTP/") == Some<size_t>(16));
+    /// ```
+    inline Option<size_t>
+    memmem(std::string_view haystack, std::string_view needle)
+    {
+        return Finder(needle).find(haystack);
+    }
+
+    namespace detail::search
+    {
+        template <class Search>
+        class MatchIter
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = size_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const size_t *;
+            using reference = size_t;
+
+            MatchIter() = default;
+
+            MatchIter(Search search, std::string_view haystack, size_t from) : mSearch(std::move(search)), mHaystack(haystack)
+            {
+                seek(from);
+            }
+
+            size_t
+            operator*() const noexcept
+            {
+                return mPos;
+            }
+
+            MatchIter &
+            operator++()
+            {
+                seek(mPos + mSearch.width());
+                return *this;
+            }
+
+            MatchIter
+            operator++(int)
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool
+            operator==(const MatchIter &rhs) const noexcept
+            {
+                return mPos == rhs.mPos;
+            }
+
+        private:
+            void
+            seek(size_t from)
+            {
+                if (from > mHaystack.size())
+                {
+                    mPos = NotFound;
+                    return;
+                }
+                auto found = mSearch(mHaystack.substr(from));
+                mPos = found.is_some() ? from + found.unwrap() : NotFound;
+            }
+
+            /// Held by value, so that the iterator outlives its range, and
+            /// small: a few bytes, or a `Finder`
+            Search mSearch{};
+            std::string_view mHaystack;
+            size_t mPos = NotFound;
+        };
+
+        /// The match positions of a search, as a range
+        template <class Search>
+        class Matches
+        {
+        public:
+            Matches(Search search, std::string_view haystack) : mSearch(std::move(search)), mHaystack(haystack) {}
+
+            MatchIter<Search>
+            begin() const
+            {
+                return MatchIter<Search>(mSearch, mHaystack, 0);
+            }
+
+            MatchIter<Search>
+            end() const noexcept
+            {
+                return MatchIter<Search>();
+            }
+
+        private:
+            Search mSearch;
+            std::string_view mHaystack;
+        };
+
+        template <int N>
+        struct ByteSearch
+        {
+            char a, b, c;
+
+            Option<size_t>
+            operator()(std::string_view haystack) const
+            {
+                return find_bytes<N>(haystack, a, b, c);
+            }
+
+            size_t
+            width() const noexcept
+            {
+                return 1;
+            }
+        };
+
+        struct SubstringSearch
+        {
+            Finder finder{std::string_view()};
+
+            Option<size_t>
+            operator()(std::string_view haystack) const
+            {
+                return finder.find(haystack);
+            }
+
+            /// An empty needle matches at every position
+            size_t
+            width() const noexcept
+            {
+                return std::max<size_t>(finder.needle().size(), 1);
+            }
+        };
+    }
+
+    /// Returns the indices of every `needle` byte in `haystack`, in order.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// for (size_t i : memchr_iter('\n', buffer))
+    /// {
+    ///     lines.push_back(i);
+    /// }
+    /// ```
+    inline detail::search::Matches<detail::search::ByteSearch<1>>
+    memchr_iter(char needle, std::string_view haystack)
+    {
+        return {{needle, needle, needle}, haystack};
+    }
+
+    inline detail::search::Matches<detail::search::ByteSearch<2>>
+    memchr2_iter(char n1, char n2, std::string_view haystack)
+    {
+        return {{n1, n2, n2}, haystack};
+    }
+
+    inline detail::search::Matches<detail::search::ByteSearch<3>>
+    memchr3_iter(char n1, char n2, char n3, std::string_view haystack)
+    {
+        return {{n1, n2, n3}, haystack};
+    }
+
+    /// Returns the indices of the non-overlapping occurrences of `needle` in
+    /// `haystack`, in order.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::vector<size_t> v(memmem_iter("abcabc", "bc").begin(), memmem_iter("abcabc", "bc").end());
+    /// assert(v == std::vector<size_t>({1, 4}));
+    /// ```
+    inline detail::search::Matches<detail::search::SubstringSearch>
+    memmem_iter(std::string_view haystack, std::string_view needle)
+    {
+        return {{Finder(needle)}, haystack};
+    }
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <compare>
+#include <concepts>
 #include <functional>
 #include <optional>
 #include <rustly/panic.h>
@@ -11,27 +13,27 @@ namespace rustly
     class Result; // forward declare
 
     template <class T>
-    class Option : private std::optional<T>
+    class Option
     {
     public:
-        Option() : std::optional<T>() {}
-        Option(T t) : std::optional<T>(t) {}
+        Option() : mValue() {}
+        Option(T t) : mValue(std::move(t)) {}
 
         Option([[maybe_unused]] const Option<std::monostate>
                    &other) // None copy constructor
-            : std::optional<T>()
+            : mValue()
         {
         }
 
         Option([[maybe_unused]] Option<std::monostate> &&other) noexcept // None move constructor
-            : std::optional<T>()
+            : mValue()
         {
         }
 
         Option &
         operator=([[maybe_unused]] Option<std::monostate> other) noexcept // None assignment constructor
         {
-            this->reset();
+            mValue.reset();
             return *this;
         }
 
@@ -51,7 +53,7 @@ namespace rustly
                 return false;
             }
             // None types are equal even if types aren't
-            return (is_none() && rhs.is_none()) || (this->value() == rhs.unwrap());
+            return (is_none() && rhs.is_none()) || (mValue.value() == rhs.unwrap());
         }
 
         template <class U>
@@ -61,19 +63,38 @@ namespace rustly
             return (is_none() && rhs.is_none()) || false; // Not value-comparable so not equal
         }
 
+        /// `None` orders before any `Some`, and `Some`s by their values, as in
+        /// Rust, so options can be sorted or used as sort keys.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// assert(Option<int>() < Some(-1));
+        /// assert(Some(1) < Some(2));
+        /// ```
+        friend auto
+        operator<=>(const Option &lhs, const Option &rhs)
+            requires std::three_way_comparable<T>
+        {
+            if (lhs.mValue.has_value() && rhs.mValue.has_value())
+            {
+                return std::compare_three_way_result_t<T>(*lhs.mValue <=> *rhs.mValue);
+            }
+            return std::compare_three_way_result_t<T>(lhs.mValue.has_value() <=> rhs.mValue.has_value());
+        }
+
         /// @brief Returns `true` if the option is a `Some` value.
         [[nodiscard("if you intended to assert that this has a value, consider "
                     "`.unwrap()` instead")]] inline bool
         is_some() const
         {
             // Can't be some if this contains the monostate
-            return !std::is_same<T, std::monostate>::value && this->has_value();
+            return !std::is_same<T, std::monostate>::value && mValue.has_value();
         }
 
         bool
         is_some_and(const std::function<bool(T)> &f) const
         {
-            return is_some() && f(this->value());
+            return is_some() && f(mValue.value());
         }
 
         /// @brief Returns `true` if the option is a `None` value.
@@ -100,11 +121,23 @@ namespace rustly
         /// y.expect("Not a number"); // panics with `Not a number`
         /// ```
         inline T
-        expect(const std::string &msg, const std::source_location _loc = std::source_location::current()) const
+        expect(const std::string &msg, const std::source_location _loc = std::source_location::current()) const &
+        {
+            if (is_some())
+            {
+                return mValue.value();
+            }
+            __panic_impl(_loc, "{}", msg);
+        }
+
+        /// Moves the contained `Some` value out of a temporary option, e.g. a
+        /// function's return value, rather than copying it.
+        inline T
+        expect(const std::string &msg, const std::source_location _loc = std::source_location::current()) &&
         {
             if (is_some())
             {
-                return this->value();
+                return std::move(mValue.value());
             }
             __panic_impl(_loc, "{}", msg);
         }
@@ -126,11 +159,23 @@ namespace rustly
         /// assert(y.unwrap() == 71); // fails
         /// ```
         inline T
-        unwrap(const std::source_location _loc = std::source_location::current()) const
+        unwrap(const std::source_location _loc = std::source_location::current()) const &
         {
             if (is_some())
             {
-                return this->value();
+                return mValue.value();
+            }
+            __panic_impl(_loc, "called `Option::unwrap()` on a `None` value");
+        }
+
+        /// Moves the contained `Some` value out of a temporary option, e.g. a
+        /// function's return value, rather than copying it.
+        inline T
+        unwrap(const std::source_location _loc = std::source_location::current()) &&
+        {
+            if (is_some())
+            {
+                return std::move(mValue.value());
             }
             __panic_impl(_loc, "called `Option::unwrap()` on a `None` value");
         }
@@ -145,7 +190,7 @@ namespace rustly
         inline T
         unwrap_or(T def) const
         {
-            return (is_some() ? this->value() : def);
+            return (is_some() ? mValue.value() : def);
         }
 
         template <class U>
@@ -162,7 +207,7 @@ namespace rustly
         inline T
         unwrap_or_else(const std::function<T()> &f) const
         {
-            return (is_some() ? this->value() : f());
+            return (is_some() ? mValue.value() : f());
         }
 
         template <class U>
@@ -182,7 +227,7 @@ namespace rustly
         unwrap_or_default() const
             requires std::default_initializable<T>
         {
-            return (is_some() ? this->value() : T{});
+            return (is_some() ? mValue.value() : T{});
         }
 
         /// Maps an `Option<T>` to `Option<U>` by applying a function to a contained
@@ -201,7 +246,7 @@ namespace rustly
         inline Option<U>
         map(const std::function<U(T)> &f) const
         {
-            return (is_none() ? Option<U>() : Option<U>(f(this->value())));
+            return (is_none() ? Option<U>() : Option<U>(f(mValue.value())));
         }
 
         template <class R, class U>
@@ -222,7 +267,7 @@ namespace rustly
         inline U
         map_or(U def, const std::function<U(T)> &f) const
         {
-            return (is_none() ? def : f(this->value()));
+            return (is_none() ? def : f(mValue.value()));
         }
 
         template <class R, class U>
@@ -248,7 +293,7 @@ namespace rustly
         map_or_else(const std::function<U()> &def,
                     const std::function<U(T)> &f) const
         {
-            return (is_none() ? def() : f(this->value()));
+            return (is_none() ? def() : f(mValue.value()));
         }
 
         template <class R, class U>
@@ -274,7 +319,7 @@ namespace rustly
         inline Result<T, E>
         ok_or(E err)
         {
-            return (is_none() ? Result<T, E>(err) : Result<T, E>(this->value()));
+            return (is_none() ? Result<T, E>(std::in_place_index<1>, err) : Result<T, E>(std::in_place_index<0>, mValue.value()));
         }
 
         /// Transforms the `Option<T>` into a `Result<T, E>`, mapping `Some(v)` to
@@ -292,8 +337,8 @@ namespace rustly
         inline Result<T, E>
         ok_or_else(const std::function<E()> &err)
         {
-            return (is_none() ? Result<T, E>(err())
-                              : Result<T, E>(this->value()));
+            return (is_none() ? Result<T, E>(std::in_place_index<1>, err())
+                              : Result<T, E>(std::in_place_index<0>, mValue.value()));
         }
 
         /// Returns `None` if the option is `None`, otherwise returns `optb`.
@@ -350,7 +395,7 @@ namespace rustly
         inline Option<U>
         and_then(const std::function<Option<U>(T)> &f) const
         {
-            return (is_none() ? Option<U>() : f(this->value()));
+            return (is_none() ? Option<U>() : f(mValue.value()));
         }
 
         template <class R, class U>
@@ -380,9 +425,9 @@ namespace rustly
         inline Option<R>
         filter(const std::function<bool(R)> &predicate) const
         {
-            if (is_some() && predicate((R)this->value()))
+            if (is_some() && predicate((R)mValue.value()))
             {
-                return Option<R>((R)this->value());
+                return Option<R>((R)mValue.value());
             }
             else
             {
@@ -547,6 +592,155 @@ namespace rustly
 
         template <class U>
         inline Option<U> xor_b(Option<U> optb) const;
+
+        /// Inserts `value` into the option, dropping any previous value, and
+        /// returns a reference to it.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto opt = None<uint32_t>();
+        /// auto &val = opt.insert(1);
+        /// val = 3;
+        /// assert(opt.unwrap() == 3);
+        /// ```
+        inline T &
+        insert(T value)
+        {
+            return mValue.emplace(std::move(value));
+        }
+
+        /// Constructs a new value in place from `args`, dropping any previous
+        /// value, and returns a reference to it. Nothing is copied or moved.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// Option<std::vector<double>> opt;
+        /// opt.emplace(1024, 0.0);
+        /// assert(opt.unwrap().size() == 1024);
+        /// ```
+        template <class... Args>
+            requires std::constructible_from<T, Args...>
+        inline T &
+        emplace(Args &&...args)
+        {
+            return mValue.emplace(std::forward<Args>(args)...);
+        }
+
+        /// Inserts `value` if the option is `None`, then returns a reference
+        /// to the contained value.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto x = None<uint32_t>();
+        /// assert(x.get_or_insert(5) == 5);
+        /// x.get_or_insert(7) += 1;
+        /// assert(x == Some(6));
+        /// ```
+        inline T &
+        get_or_insert(T value)
+        {
+            if (is_none())
+            {
+                return mValue.emplace(std::move(value));
+            }
+            return *mValue;
+        }
+
+        /// Inserts a value computed from `f` if the option is `None`, then
+        /// returns a reference to the contained value. `f` is only called
+        /// when needed.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// Option<std::vector<double>> cache;
+        /// cache.get_or_insert_with([]() { return expensive(); }).push_back(1.0);
+        /// ```
+        template <class F>
+            requires std::convertible_to<std::invoke_result_t<F>, T>
+        inline T &
+        get_or_insert_with(F &&f)
+        {
+            if (is_none())
+            {
+                return mValue.emplace(std::invoke(std::forward<F>(f)));
+            }
+            return *mValue;
+        }
+
+        /// Inserts the default value if the option is `None`, then returns a
+        /// reference to the contained value.
+        inline T &
+        get_or_insert_default()
+            requires std::default_initializable<T>
+        {
+            if (is_none())
+            {
+                return mValue.emplace();
+            }
+            return *mValue;
+        }
+
+        /// Takes the value out of the option, leaving a `None` in its place.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto x = Some(2);
+        /// auto y = x.take();
+        /// assert(x == None());
+        /// assert(y == Some(2));
+        /// ```
+        inline Option<T>
+        take()
+        {
+            Option<T> out(std::move(*this));
+            mValue.reset();
+            return out;
+        }
+
+        /// Takes the value out of the option, but only if `predicate` returns
+        /// `true` for it. The predicate may modify the value through its
+        /// reference.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto x = Some(42);
+        /// assert(x.take_if([](int &v) { return v % 2 == 0; }) == Some(42));
+        /// assert(x == None());
+        /// ```
+        template <class P>
+            requires std::predicate<P, T &>
+        inline Option<T>
+        take_if(P &&predicate)
+        {
+            if (is_some() && std::invoke(std::forward<P>(predicate), *mValue))
+            {
+                return take();
+            }
+            return Option<T>();
+        }
+
+        /// Replaces the value with `value`, and returns the old value, if any.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// auto x = Some(2);
+        /// assert(x.replace(5) == Some(2));
+        /// assert(x == Some(5));
+        /// ```
+        inline Option<T>
+        replace(T value)
+        {
+            Option<T> out = take();
+            mValue.emplace(std::move(value));
+            return out;
+        }
+
+    private:
+        // A member rather than a base, so that `std` isn't an associated
+        // namespace of every `Option`: `std::optional`'s comparison templates
+        // would otherwise be candidates for comparing two `Option`s, and
+        // their constraints recurse into themselves (LWG 3746)
+        std::optional<T> mValue;
     };
 
     /// Returns the contained `Some` value or the provided default `def`.
@@ -1,21 +1,70 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <format>
 #include <source_location>
+#include <string>
+
+namespace rustly::detail
+{
+    /// Run by a panic before it aborts, when set. They're registered before
+    /// `main` by the headers that provide them, so that this header, and the
+    /// `Option` and `Result` that use it, need nothing beyond the standard
+    /// library.
+    struct PanicHooks
+    {
+        /// How many `flush` hooks can be registered
+        static constexpr size_t MaxFlushes = 4;
+
+        /// Write out buffered output, which would otherwise be lost, in the
+        /// order they were added; added by print.h and log.h
+        void (*flushes[MaxFlushes])() = {};
+        size_t flush_count = 0;
+        /// Appends a backtrace, or a note on enabling one, to the message;
+        /// set by backtrace.h
+        void (*backtrace)(std::string &message) = nullptr;
+
+        /// Adds a `flush` hook, returning `false` if they're all taken.
+        /// Hooks are added before `main`, so this isn't thread-safe.
+        bool
+        add_flush(void (*hook)())
+        {
+            if (flush_count == MaxFlushes)
+            {
+                return false;
+            }
+            flushes[flush_count++] = hook;
+            return true;
+        }
+    };
+
+    inline constinit PanicHooks panic_hooks;
+}
 
 namespace
 {
     template <class... Args>
-    [[noreturn]] static inline void __panic_impl(
+    [[noreturn, gnu::cold]] static inline void __panic_impl(
         const std::source_location loc = std::source_location::current(),
         const std::format_string<Args...> &fmt = "explicit panic",
         Args &&...args) noexcept
     {
         auto m = std::format("panicked at {}:{}\n{}\n", loc.file_name(), loc.line(), std::format(fmt, std::forward<Args>(args)...));
+        const auto &hooks = rustly::detail::panic_hooks;
+        if (hooks.backtrace != nullptr)
+        {
+            hooks.backtrace(m);
+        }
+        for (size_t i = 0; i < hooks.flush_count; i++)
+        {
+            hooks.flushes[i]();
+        }
         std::fputs(m.c_str(), stderr);
         std::abort();
     }
 }
 
 /// @brief Allows a program to terminate immediately and provide feedback to the caller of the program.
-#define panic(...) __panic_impl(std::source_location::current(), ##__VA_ARGS__)
\ No newline at end of file
+#define panic(...) __panic_impl(std::source_location::current(), ##__VA_ARGS__)
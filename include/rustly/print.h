@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cerrno>
+#include <concepts>
+#include <format>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unistd.h>
+#include <rustly/display.h>
+#include <rustly/panic.h>
+
+namespace rustly
+{
+    namespace detail
+    {
+        /// Satisfied by types with an enabled `std::formatter` specialization
+        template <class T>
+        concept Formattable = std::semiregular<std::formatter<T, char>>;
+
+        /// Formats a `Display` type that has no `std::formatter`, through its
+        /// `operator<<` or `to_string()`
+        template <class T>
+        class Displayed
+        {
+        public:
+            explicit Displayed(const T &value) : mValue(value) {}
+
+            std::string
+            to_string() const
+            {
+                if constexpr (ToStream<T>)
+                {
+                    std::ostringstream oss;
+                    oss << mValue;
+                    return oss.str();
+                }
+                else
+                {
+                    return std::to_string(mValue);
+                }
+            }
+
+        private:
+            const T &mValue;
+        };
+
+        /// The type an argument is formatted as
+        template <class T>
+        using FmtArg = std::conditional_t<Formattable<T>, T, Displayed<T>>;
+
+        template <class T>
+        inline decltype(auto)
+        fmt_arg(const T &t)
+        {
+            if constexpr (Formattable<T>)
+            {
+                return t;
+            }
+            else
+            {
+                return Displayed<T>(t);
+            }
+        }
+
+        template <class Out, class... Args>
+        inline void
+        vformat_into(Out &out, std::string_view fmt, const Args &...args)
+        {
+            std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(args...));
+        }
+
+        /// A per-thread output buffer for a standard stream, written straight
+        /// to its file descriptor in large chunks.
+        class StdBuffer
+        {
+        public:
+            static constexpr size_t Capacity = 64 * 1024;
+
+            /// `unbuffered` streams, and any attached to a terminal, are
+            /// written after every call
+            StdBuffer(int fd, bool unbuffered) : mFd(fd), mUnbuffered(unbuffered || isatty(fd))
+            {
+                mBuffer.reserve(Capacity);
+            }
+
+            ~StdBuffer()
+            {
+                flush();
+            }
+
+            inline std::string &
+            get()
+            {
+                return mBuffer;
+            }
+
+            inline void
+            commit()
+            {
+                if (mUnbuffered || mBuffer.size() >= Capacity)
+                {
+                    flush();
+                }
+            }
+
+            void
+            flush()
+            {
+                const char *data = mBuffer.data();
+                size_t remaining = mBuffer.size();
+                while (remaining > 0)
+                {
+                    ssize_t n = ::write(mFd, data, remaining);
+                    if (n < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if (n <= 0)
+                    {
+                        break; // Like Rust's `print!`, output errors are not recoverable
+                    }
+                    data += n;
+                    remaining -= static_cast<size_t>(n);
+                }
+                mBuffer.clear();
+            }
+
+        private:
+            int mFd;
+            bool mUnbuffered;
+            std::string mBuffer;
+        };
+
+        inline StdBuffer &
+        std_buffer(int fd)
+        {
+            // Like Rust, `stderr` is unbuffered
+            static thread_local StdBuffer out(STDOUT_FILENO, false);
+            static thread_local StdBuffer err(STDERR_FILENO, true);
+            return fd == STDERR_FILENO ? err : out;
+        }
+    }
+
+    /// A format string, checked at compile time against `Args`. Arguments that
+    /// are `Display` but have no `std::formatter` are formatted as strings.
+    template <class... Args>
+    using FormatString = std::format_string<detail::FmtArg<Args>...>;
+
+    namespace detail
+    {
+        inline void
+        print_line(int fd, bool newline)
+        {
+            auto &buffer = std_buffer(fd);
+            if (newline)
+            {
+                buffer.get().push_back('\n');
+            }
+            buffer.commit();
+        }
+
+        template <class... Args>
+        inline void
+        print_to(int fd, bool newline, std::string_view fmt, const Args &...args)
+        {
+            vformat_into(std_buffer(fd).get(), fmt, fmt_arg(args)...);
+            print_line(fd, newline);
+        }
+    }
+
+    namespace io
+    {
+        /// Writes any output buffered by the calling thread's `print` and
+        /// `println` calls.
+        inline void
+        flush()
+        {
+            detail::std_buffer(STDOUT_FILENO).flush();
+        }
+    }
+
+    namespace detail
+    {
+        /// Flushes the panicking thread's output before a panic aborts
+        inline const bool PanicFlushRegistered = panic_hooks.add_flush(&io::flush);
+    }
+
+    /// Prints to the standard output.
+    ///
+    /// Output is buffered per thread and written directly to the file
+    /// descriptor in large chunks (or per call, when attached to a terminal).
+    /// Use `io::flush()` to write it out early; a `panic` flushes the
+    /// panicking thread's output, but not other threads'.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// rustly::print("{} + {} = ", 1, 2);
+    /// ```
+    template <class... Args>
+    inline void
+    print(const FormatString<Args...> &fmt, const Args &...args)
+    {
+        detail::print_to(STDOUT_FILENO, false, fmt.get(), args...);
+    }
+
+    /// Prints a newline to the standard output.
+    inline void
+    println()
+    {
+        detail::print_line(STDOUT_FILENO, true);
+    }
+
+    /// Prints to the standard output, with a newline.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// rustly::println("hello {}", "world!");
+    /// ```
+    template <class... Args>
+    inline void
+    println(const FormatString<Args...> &fmt, const Args &...args)
+    {
+        detail::print_to(STDOUT_FILENO, true, fmt.get(), args...);
+    }
+
+    /// Prints to the standard error. Standard error is never buffered.
+    template <class... Args>
+    inline void
+    eprint(const FormatString<Args...> &fmt, const Args &...args)
+    {
+        detail::print_to(STDERR_FILENO, false, fmt.get(), args...);
+    }
+
+    /// Prints a newline to the standard error.
+    inline void
+    eprintln()
+    {
+        detail::print_line(STDERR_FILENO, true);
+    }
+
+    /// Prints to the standard error, with a newline.
+    template <class... Args>
+    inline void
+    eprintln(const FormatString<Args...> &fmt, const Args &...args)
+    {
+        detail::print_to(STDERR_FILENO, true, fmt.get(), args...);
+    }
+
+    /// Creates a `std::string` using interpolation of runtime expressions.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// assert(rustly::format("test") == "test");
+    /// assert(rustly::format("hello {}", "world!") == "hello world!");
+    /// assert(rustly::format("x = {}, y = {}", 10, 30) == "x = 10, y = 30");
+    /// ```
+    template <class... Args>
+    inline std::string
+    format(const FormatString<Args...> &fmt, const Args &...args)
+    {
+        std::string out;
+        detail::vformat_into(out, fmt.get(), detail::fmt_arg(args)...);
+        return out;
+    }
+
+    /// Writes formatted data into a buffer, such as a `std::string` or
+    /// `std::vector<char>`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::string out;
+    /// rustly::write(out, "test");
+    /// rustly::write(out, " {}", 17);
+    /// assert(out == "test 17");
+    /// ```
+    template <class Out, class... Args>
+    inline void
+    write(Out &out, const FormatString<Args...> &fmt, const Args &...args)
+    {
+        detail::vformat_into(out, fmt.get(), detail::fmt_arg(args)...);
+    }
+
+    /// Writes formatted data into a buffer, with a newline appended.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::string out;
+    /// rustly::writeln(out, "test");
+    /// rustly::writeln(out, "{} {}", "formatted", "arguments");
+    /// assert(out == "test\nformatted arguments\n");
+    /// ```
+    template <class Out, class... Args>
+    inline void
+    writeln(Out &out, const FormatString<Args...> &fmt, const Args &...args)
+    {
+        detail::vformat_into(out, fmt.get(), detail::fmt_arg(args)...);
+        out.push_back('\n');
+    }
+}
+
+template <class T>
+struct std::formatter<rustly::detail::Displayed<T>, char> : std::formatter<std::string_view, char>
+{
+    auto
+    format(const rustly::detail::Displayed<T> &value, std::format_context &ctx) const
+    {
+        auto s = value.to_string();
+        return std::formatter<std::string_view, char>::format(s, ctx);
+    }
+};
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <rustly/panic.h>
+#include <rustly/result.h>
+
+// Define `RUSTLY_REFCELL_UNCHECKED` to compile out `RefCell`'s borrow
+// tracking: borrows always succeed, and a `RefCell<T>` is the size of a `T`.
+// It must be defined the same way in every translation unit of a program.
+
+namespace rustly
+{
+    /// The error when a `RefCell` can't be borrowed, because it's mutably
+    /// borrowed.
+    struct BorrowError
+    {
+        constexpr bool operator==(const BorrowError &) const = default;
+
+        std::string
+        to_string() const noexcept
+        {
+            return "already mutably borrowed";
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const BorrowError &)
+        {
+            return os << "already mutably borrowed";
+        }
+    };
+
+    /// The error when a `RefCell` can't be mutably borrowed, because it's
+    /// borrowed.
+    struct BorrowMutError
+    {
+        constexpr bool operator==(const BorrowMutError &) const = default;
+
+        std::string
+        to_string() const noexcept
+        {
+            return "already borrowed";
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const BorrowMutError &)
+        {
+            return os << "already borrowed";
+        }
+    };
+
+    namespace detail
+    {
+        /// A `RefCell`'s borrow state, in one word: the number of shared
+        /// borrows when positive, or -1 while mutably borrowed
+        class BorrowFlag
+        {
+        public:
+#ifndef RUSTLY_REFCELL_UNCHECKED
+            inline bool
+            acquire_shared() noexcept
+            {
+                if (mState < 0) [[unlikely]]
+                {
+                    return false;
+                }
+                mState++;
+                return true;
+            }
+
+            inline bool
+            acquire_unique() noexcept
+            {
+                if (mState != 0) [[unlikely]]
+                {
+                    return false;
+                }
+                mState = -1;
+                return true;
+            }
+
+            inline void
+            release_shared() noexcept
+            {
+                mState--;
+            }
+
+            inline void
+            release_unique() noexcept
+            {
+                mState = 0;
+            }
+
+        private:
+            intptr_t mState = 0;
+#else
+            constexpr bool acquire_shared() noexcept { return true; }
+            constexpr bool acquire_unique() noexcept { return true; }
+            constexpr void release_shared() noexcept {}
+            constexpr void release_unique() noexcept {}
+#endif
+        };
+    }
+
+    template <class T>
+    class RefCell;
+
+    /// A shared borrow of a `RefCell`'s value, released when destroyed.
+    /// Copying it adds another shared borrow.
+    template <class T>
+    class Ref
+    {
+    public:
+        Ref(const Ref &other) noexcept : mValue(other.mValue), mFlag(other.mFlag)
+        {
+            if (mFlag != nullptr)
+            {
+                mFlag->acquire_shared();
+            }
+        }
+
+        Ref(Ref &&other) noexcept : mValue(other.mValue), mFlag(std::exchange(other.mFlag, nullptr)) {}
+
+        Ref &operator=(const Ref &) = delete;
+        Ref &operator=(Ref &&) = delete;
+
+        ~Ref()
+        {
+            if (mFlag != nullptr)
+            {
+                mFlag->release_shared();
+            }
+        }
+
+        const T &
+        operator*() const noexcept
+        {
+            return *mValue;
+        }
+
+        const T *
+        operator->() const noexcept
+        {
+            return mValue;
+        }
+
+        const T &
+        get() const noexcept
+        {
+            return *mValue;
+        }
+
+    private:
+        friend class RefCell<T>;
+
+        Ref(const T *value, detail::BorrowFlag *flag) noexcept : mValue(value), mFlag(flag) {}
+
+        const T *mValue;
+        detail::BorrowFlag *mFlag;
+    };
+
+    /// A mutable borrow of a `RefCell`'s value, released when destroyed.
+    template <class T>
+    class RefMut
+    {
+    public:
+        RefMut(RefMut &&other) noexcept : mValue(other.mValue), mFlag(std::exchange(other.mFlag, nullptr)) {}
+
+        RefMut(const RefMut &) = delete;
+        RefMut &operator=(const RefMut &) = delete;
+        RefMut &operator=(RefMut &&) = delete;
+
+        ~RefMut()
+        {
+            if (mFlag != nullptr)
+            {
+                mFlag->release_unique();
+            }
+        }
+
+        T &
+        operator*() const noexcept
+        {
+            return *mValue;
+        }
+
+        T *
+        operator->() const noexcept
+        {
+            return mValue;
+        }
+
+        T &
+        get() const noexcept
+        {
+            return *mValue;
+        }
+
+    private:
+        friend class RefCell<T>;
+
+        RefMut(T *value, detail::BorrowFlag *flag) noexcept : mValue(value), mFlag(flag) {}
+
+        T *mValue;
+        detail::BorrowFlag *mFlag;
+    };
+
+    /// A mutable value behind a `const` reference, whose borrows are checked
+    /// at runtime rather than compile time, like Rust's `RefCell`. Any number
+    /// of `Ref`s, or a single `RefMut`, may be alive at once. Not thread-safe.
+    ///
+    /// The borrow state is a single word beside the value. With
+    /// `RUSTLY_REFCELL_UNCHECKED` defined it's removed, and borrowing is as
+    /// cheap as taking a reference.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// const RefCell<std::vector<int>> cell(std::vector<int>{1, 2});
+    /// cell.borrow_mut()->push_back(3);
+    /// {
+    ///     auto a = cell.borrow();
+    ///     auto b = cell.borrow(); // Any number of shared borrows
+    ///     assert(a->size() == 3);
+    ///     assert(cell.try_borrow_mut().is_err());
+    /// }
+    /// assert(cell.try_borrow_mut().is_ok());
+    /// ```
+    ///
+    /// ## Panics
+    /// `borrow()` panics while mutably borrowed, and `borrow_mut()` panics
+    /// while borrowed at all.
+    template <class T>
+    class RefCell
+    {
+    public:
+        RefCell() = default;
+
+        template <class... Args>
+            requires std::is_constructible_v<T, Args...>
+        explicit RefCell(Args &&...args) : mValue(std::forward<Args>(args)...)
+        {
+        }
+
+        RefCell(const RefCell &) = delete;
+        RefCell &operator=(const RefCell &) = delete;
+
+        /// Borrows the value.
+        ///
+        /// ## Panics
+        /// Panics if the value is mutably borrowed.
+        Ref<T>
+        borrow() const
+        {
+            if (!mFlag.acquire_shared()) [[unlikely]]
+            {
+                panic("already mutably borrowed: BorrowError");
+            }
+            return Ref<T>(&mValue, &mFlag);
+        }
+
+        /// Mutably borrows the value.
+        ///
+        /// ## Panics
+        /// Panics if the value is borrowed.
+        RefMut<T>
+        borrow_mut() const
+        {
+            if (!mFlag.acquire_unique()) [[unlikely]]
+            {
+                panic("already borrowed: BorrowMutError");
+            }
+            return RefMut<T>(&mValue, &mFlag);
+        }
+
+        /// Borrows the value, or returns `Err` if it's mutably borrowed.
+        Result<Ref<T>, BorrowError>
+        try_borrow() const
+        {
+            if (!mFlag.acquire_shared())
+            {
+                return Err<Ref<T>, BorrowError>(BorrowError{});
+            }
+            return Ok<Ref<T>, BorrowError>(Ref<T>(&mValue, &mFlag));
+        }
+
+        /// Mutably borrows the value, or returns `Err` if it's borrowed.
+        Result<RefMut<T>, BorrowMutError>
+        try_borrow_mut() const
+        {
+            if (!mFlag.acquire_unique())
+            {
+                return Err<RefMut<T>, BorrowMutError>(BorrowMutError{});
+            }
+            return Ok<RefMut<T>, BorrowMutError>(RefMut<T>(&mValue, &mFlag));
+        }
+
+        /// Returns the value, without any check: a non-`const` reference to the
+        /// cell already guarantees that nothing borrows it.
+        T &
+        get_mut() noexcept
+        {
+            return mValue;
+        }
+
+        /// Replaces the value, returning the old one.
+        ///
+        /// ## Panics
+        /// Panics if the value is borrowed.
+        T
+        replace(T value) const
+        {
+            return std::exchange(*borrow_mut(), std::move(value));
+        }
+
+        /// Moves the value out, leaving a default-constructed one.
+        ///
+        /// ## Panics
+        /// Panics if the value is borrowed.
+        T
+        take() const
+            requires std::is_default_constructible_v<T>
+        {
+            return replace(T());
+        }
+
+        T
+        into_inner() &&
+        {
+            return std::move(mValue);
+        }
+
+    private:
+        mutable T mValue;
+        [[no_unique_address]] mutable detail::BorrowFlag mFlag;
+    };
+}
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <compare>
 #include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
 #include <variant>
 #include <rustly/display.h>
 #include <rustly/panic.h>
@@ -11,17 +15,222 @@ namespace rustly
     template <class T>
     class Option; // forward declare
 
+    /// The type of an `Ok` value that carries nothing, like Rust's `()`, for
+    /// operations that only succeed or fail. Construct one with `Ok<E>()`.
+    struct Unit
+    {
+        constexpr auto operator<=>(const Unit &) const = default;
+
+        std::string
+        to_string() const noexcept
+        {
+            return "()";
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const Unit &)
+        {
+            return os << "()";
+        }
+    };
+
+    namespace detail
+    {
+        /// How a `Result` stores its `Ok` value: as itself, or as a pointer for
+        /// a reference
+        template <class T>
+        using ResultStorage =
+            std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>;
+    }
+
+    /// Specialized for an error type `E` whose values can be stored in values
+    /// of `T` that are never `Ok` values (a niche), so that a `Result<T, E>`
+    /// is the size of a `T`, as Rust does for e.g. `Option<&T>`. Requires
+    /// `static bool is_err(T raw)`, `static T encode(E e)` and
+    /// `static E decode(T raw)`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// // File descriptors are never negative
+    /// template <>
+    /// struct rustly::ResultNiche<int, Errno>
+    /// {
+    ///     static bool is_err(int raw) { return raw < 0; }
+    ///     static int encode(Errno e) { return -e.code(); }
+    ///     static Errno decode(int raw) { return Errno(-raw); }
+    /// };
+    /// static_assert(sizeof(Result<int, Errno>) == sizeof(int));
+    /// ```
+    template <class T, class E>
+    struct ResultNiche;
+
+    template <class T, class E>
+    concept NichePacked = !std::is_reference_v<T> && requires(const T &raw, const E &e) {
+        { ResultNiche<T, E>::is_err(raw) } -> std::same_as<bool>;
+        { ResultNiche<T, E>::encode(e) } -> std::same_as<T>;
+        { ResultNiche<T, E>::decode(raw) } -> std::same_as<E>;
+    };
+
+    namespace detail
+    {
+        /// A `Result`'s representation: a variant of the `Ok` and `Err`
+        /// values
+        template <class T, class E>
+        class ResultRepr : private std::variant<ResultStorage<T>, E>
+        {
+            using Variant = std::variant<ResultStorage<T>, E>;
+
+        public:
+            explicit ResultRepr(Variant v) : Variant(std::move(v)) {}
+
+            template <size_t I, class... Args>
+            explicit ResultRepr(std::in_place_index_t<I> tag, Args &&...args) : Variant(tag, std::forward<Args>(args)...)
+            {
+            }
+
+            size_t
+            index() const noexcept
+            {
+                return Variant::index();
+            }
+
+            const ResultStorage<T> &
+            ok_storage() const
+            {
+                return std::get<0>(*this);
+            }
+
+            ResultStorage<T> &
+            ok_storage()
+            {
+                return std::get<0>(*this);
+            }
+
+            const E &
+            err_value() const
+            {
+                return std::get<1>(*this);
+            }
+
+            E &
+            err_value()
+            {
+                return std::get<1>(*this);
+            }
+        };
+
+        /// A niche-packed `Result`'s representation: a single `T`, where the
+        /// `Err` is encoded
+        template <class T, class E>
+            requires NichePacked<T, E>
+        class ResultRepr<T, E>
+        {
+            using Niche = ResultNiche<T, E>;
+
+        public:
+            explicit ResultRepr(std::variant<T, E> v)
+                : mRaw(v.index() == 0 ? checked(std::move(std::get<0>(v))) : Niche::encode(std::get<1>(v)))
+            {
+            }
+
+            template <class... Args>
+            explicit ResultRepr(std::in_place_index_t<0>, Args &&...args) : mRaw(checked(T(std::forward<Args>(args)...)))
+            {
+            }
+
+            template <class... Args>
+            explicit ResultRepr(std::in_place_index_t<1>, Args &&...args) : mRaw(Niche::encode(E(std::forward<Args>(args)...)))
+            {
+            }
+
+            size_t
+            index() const noexcept
+            {
+                return Niche::is_err(mRaw) ? 1 : 0;
+            }
+
+            const T &
+            ok_storage() const noexcept
+            {
+                return mRaw;
+            }
+
+            T &
+            ok_storage() noexcept
+            {
+                return mRaw;
+            }
+
+            E
+            err_value() const
+            {
+                return Niche::decode(mRaw);
+            }
+
+        private:
+            static T
+            checked(T ok)
+            {
+                if (Niche::is_err(ok)) [[unlikely]]
+                {
+                    panic("`Ok` value is in the niche of its `Err` type, so would read as an `Err`");
+                }
+                return ok;
+            }
+
+            T mRaw;
+        };
+    }
+
+    /// `T` may be a reference, e.g. `Result<Row &, E>` for a lookup into a
+    /// container, which is stored as a pointer and never copies the referent.
+    ///
+    /// Where `E` has a `ResultNiche` in `T`, the `Err` is stored in `T`'s
+    /// unused values, and the result is only as large as `T`.
     template <class T, class E>
-    class Result : private std::variant<T, E> // C++23 std::expected
+    class Result : private detail::ResultRepr<T, E> // C++23 std::expected
     {
+        using Repr = detail::ResultRepr<T, E>;
+
     public:
-        [[nodiscard("this `Result` may be an `Err` variant, which should be handled")]] Result(std::variant<T, E> v)
-            : std::variant<T, E>{v} {}
+        [[nodiscard("this `Result` may be an `Err` variant, which should be handled")]] Result(
+            std::variant<detail::ResultStorage<T>, E> v)
+            : Repr(std::move(v))
+        {
+        }
+
+        /// Constructs the `Ok` (`0`) or `Err` (`1`) value in place, from `args`.
+        template <size_t I, class... Args>
+        [[nodiscard("this `Result` may be an `Err` variant, which should be handled")]] explicit Result(
+            std::in_place_index_t<I> tag, Args &&...args)
+            : Repr(tag, std::forward<Args>(args)...)
+        {
+        }
 
         bool operator==(const Result<T, E> &rhs) const
         {
-            return (is_ok() && rhs.is_ok() && (std::get<0>(*this) == std::get<0>(rhs))) ||
-                   (is_err() && rhs.is_err() && (std::get<1>(*this) == std::get<1>(rhs)));
+            return (is_ok() && rhs.is_ok() && (ok_ref() == rhs.ok_ref())) ||
+                   (is_err() && rhs.is_err() && (this->err_value() == rhs.err_value()));
+        }
+
+        /// Any `Ok` orders before any `Err`, then `Ok`s by their values and
+        /// `Err`s by their errors, as in Rust, so results can be sorted or used
+        /// as sort keys.
+        auto
+        operator<=>(const Result<T, E> &rhs) const
+            requires std::three_way_comparable<std::remove_cvref_t<T>> && std::three_way_comparable<E>
+        {
+            using Category = std::common_comparison_category_t<std::compare_three_way_result_t<std::remove_cvref_t<T>>,
+                                                               std::compare_three_way_result_t<E>>;
+            if (this->index() != rhs.index())
+            {
+                return Category(this->index() <=> rhs.index());
+            }
+            if (is_ok())
+            {
+                return Category(ok_ref() <=> rhs.ok_ref());
+            }
+            return Category(this->err_value() <=> rhs.err_value());
         }
 
         /// Returns `true` if the result is `Ok`.
@@ -56,7 +265,7 @@ namespace rustly
         [[nodiscard]] inline bool
         is_ok_and(const std::function<bool(T)> &f) const
         {
-            return is_ok() && f(std::get<0>(*this));
+            return is_ok() && f(ok_ref());
         }
 
         /// Returns `true` if the result is `Err`.
@@ -91,7 +300,7 @@ namespace rustly
         [[nodiscard]] inline bool
         is_err_and(const std::function<bool(E)> &f) const
         {
-            return is_err() && f(std::get<1>(*this));
+            return is_err() && f(this->err_value());
         }
 
         /// Converts from `Result<T, E>` to `Option<T>`.
@@ -106,9 +315,13 @@ namespace rustly
         /// auto y = Err<uint32_t, const char *>("Nothing here");
         /// assert(y.ok() == None());
         /// ```
+        ///
+        /// Not available for a `Result<T &, E>`, since an `Option` can't hold a
+        /// reference.
         inline Option<T> ok() const
+            requires(!std::is_reference_v<T>)
         {
-            return (is_ok() ? Option<T>(std::get<0>(*this)) : Option<T>());
+            return (is_ok() ? Option<T>(ok_ref()) : Option<T>());
         }
 
         /// Converts from `Result<T, E>` to `Option<E>`.
@@ -125,7 +338,7 @@ namespace rustly
         /// ```
         inline Option<E> err() const
         {
-            return (is_err() ? Option<E>(std::get<1>(*this)) : Option<E>());
+            return (is_err() ? Option<E>(this->err_value()) : Option<E>());
         }
 
         /// Maps a `Result<T, E>` to `Result<U, E>` by applying a function to a
@@ -146,7 +359,8 @@ namespace rustly
         template <class U>
         inline Result<U, E> map(const std::function<U(T)> &f) const
         {
-            return (is_ok() ? Result<U, E>(f(std::get<0>(*this))) : Result<U, E>(std::get<1>(*this)));
+            return (is_ok() ? Result<U, E>(std::in_place_index<0>, f(ok_ref()))
+                            : Result<U, E>(std::in_place_index<1>, this->err_value()));
         }
 
         /// Returns the provided default (if `Err`), or
@@ -169,7 +383,7 @@ namespace rustly
         template <class U>
         inline U map_or(U def, const std::function<U(T)> &f) const
         {
-            return (is_ok() ? f(std::get<0>(*this)) : def);
+            return (is_ok() ? f(ok_ref()) : def);
         }
 
         /// Maps a `Result<T, E>` to `U` by applying fallback function `default` to
@@ -194,7 +408,7 @@ namespace rustly
         template <class U>
         inline U map_or_else(const std::function<U(E)> &d, const std::function<U(T)> &f) const
         {
-            return (is_ok() ? f(std::get<0>(*this)) : d(std::get<1>(*this)));
+            return (is_ok() ? f(ok_ref()) : d(this->err_value()));
         }
 
         /// Maps a `Result<T, E>` to `Result<T, F>` by applying a function to a
@@ -218,11 +432,11 @@ namespace rustly
         {
             if (is_ok())
             {
-                return Result<T, F>(std::variant<T, F>{std::in_place_index<0>, std::get<0>(*this)});
+                return Result<T, F>(std::in_place_index<0>, ok_ref());
             }
             else
             {
-                return Result<T, F>(std::variant<T, F>{std::in_place_index<1>, op(std::get<1>(*this))});
+                return Result<T, F>(std::in_place_index<1>, op(this->err_value()));
             }
         }
 
@@ -240,14 +454,26 @@ namespace rustly
         /// auto x = Err<int, const char *>("emergency failure");
         /// x.expect("Testing expect"); // panics with `Testing expect: emergency failure`
         /// ```
-        inline T expect(const std::string &msg, const std::source_location _loc = std::source_location::current()) const
+        inline T expect(const std::string &msg, const std::source_location _loc = std::source_location::current()) const &
             requires ToString<E>
         {
             if (is_ok())
             {
-                return std::get<0>(*this);
+                return ok_ref();
             }
-            __panic_impl(_loc, "{}: {}", msg, std::to_string(std::get<1>(*this)));
+            __panic_impl(_loc, "{}: {}", msg, std::to_string(this->err_value()));
+        }
+
+        /// Moves the contained `Ok` value out of a temporary result, e.g. a
+        /// function's return value, rather than copying it.
+        inline T expect(const std::string &msg, const std::source_location _loc = std::source_location::current()) &&
+            requires ToString<E>
+        {
+            if (is_ok())
+            {
+                return ok_take();
+            }
+            __panic_impl(_loc, "{}: {}", msg, std::to_string(this->err_value()));
         }
 
         /// Returns the contained `Ok` value.
@@ -267,14 +493,26 @@ namespace rustly
         /// auto y = Err<int, const char *>("emergency failure");
         /// y.unwrap(); // panics with `emergency failure`
         /// ```
-        inline T unwrap(const std::source_location _loc = std::source_location::current()) const
+        inline T unwrap(const std::source_location _loc = std::source_location::current()) const &
             requires ToString<E>
         {
             if (is_ok())
             {
-                return std::get<0>(*this);
+                return ok_ref();
+            }
+            __panic_impl(_loc, "called `Result::unwrap()` on an `Err` value: {}", std::to_string(this->err_value()));
+        }
+
+        /// Moves the contained `Ok` value out of a temporary result, e.g. a
+        /// function's return value, rather than copying it.
+        inline T unwrap(const std::source_location _loc = std::source_location::current()) &&
+            requires ToString<E>
+        {
+            if (is_ok())
+            {
+                return ok_take();
             }
-            __panic_impl(_loc, "called `Result::unwrap()` on an `Err` value: {}", std::to_string(std::get<1>(*this)));
+            __panic_impl(_loc, "called `Result::unwrap()` on an `Err` value: {}", std::to_string(this->err_value()));
         }
 
         /// Returns the contained `Ok` value or a provided default.
@@ -293,7 +531,7 @@ namespace rustly
         /// ```
         inline T unwrap_or(T def) const
         {
-            return (is_ok() ? std::get<0>(*this) : def);
+            return (is_ok() ? ok_ref() : def);
         }
 
         /// Returns the contained `Ok` value or computes it from a closure.
@@ -310,7 +548,7 @@ namespace rustly
         /// ```
         inline T unwrap_or_else(const std::function<T(E)> &op) const
         {
-            return (is_ok() ? std::get<0>(*this) : op(std::get<1>(*this)));
+            return (is_ok() ? ok_ref() : op(this->err_value()));
         }
 
         /// Returns the contained `Ok` value or a default
@@ -326,10 +564,13 @@ namespace rustly
         /// auto y = Err<int, const char *>("an error");
         /// assert(y.unwrap_or_default() == 0);
         /// ```
+        ///
+        /// Not available for a `Result<T &, E>`, which has no default to
+        /// refer to.
         inline T unwrap_or_default() const
-            requires std::default_initializable<T>
+            requires(!std::is_reference_v<T> && std::default_initializable<T>)
         {
-            return (is_ok() ? std::get<0>(*this) : T{});
+            return (is_ok() ? ok_ref() : T{});
         }
 
         /// Returns the contained `Err` value.
@@ -348,9 +589,9 @@ namespace rustly
         {
             if (is_err())
             {
-                return std::get<1>(*this);
+                return this->err_value();
             }
-            __panic_impl(loc, "{}: {}", msg, std::to_string(std::get<0>(*this)));
+            __panic_impl(loc, "{}: {}", msg, std::to_string(ok_ref()));
         }
 
         /// Returns the contained `Err` value.
@@ -367,14 +608,26 @@ namespace rustly
         /// auto y = Err<int, const char *>("emergency failure");
         /// assert(x.unwrap_err() == "emergency failure");
         /// ```
-        inline E unwrap_err(const std::source_location loc = std::source_location::current()) const
+        inline E unwrap_err(const std::source_location loc = std::source_location::current()) const &
             requires ToString<T>
         {
             if (is_err())
             {
-                return std::get<1>(*this);
+                return this->err_value();
             }
-            __panic_impl(loc, "called `Result::unwrap_err()` on an `Ok` value: {}", std::to_string(std::get<0>(*this)));
+            __panic_impl(loc, "called `Result::unwrap_err()` on an `Ok` value: {}", std::to_string(ok_ref()));
+        }
+
+        /// Moves the contained `Err` value out of a temporary result, rather
+        /// than copying it.
+        inline E unwrap_err(const std::source_location loc = std::source_location::current()) &&
+            requires ToString<T>
+        {
+            if (is_err())
+            {
+                return std::move(this->err_value());
+            }
+            __panic_impl(loc, "called `Result::unwrap_err()` on an `Ok` value: {}", std::to_string(ok_ref()));
         }
 
         /// Returns `res` if the result is `Ok`, otherwise returns the `Err` value of `this`.
@@ -404,7 +657,7 @@ namespace rustly
         template <class U>
         inline Result<U, E> and_b(Result<U, E> res) const
         {
-            return (is_ok() ? res : Result<U, E>(std::variant<U, E>{std::in_place_index<1>, std::get<1>(*this)}));
+            return (is_ok() ? res : Result<U, E>(std::in_place_index<1>, this->err_value()));
         }
 
         /// Calls `op` if the result is `Ok`, otherwise returns the `Err` value of `this`.
@@ -439,11 +692,11 @@ namespace rustly
         {
             if (is_ok())
             {
-                return op(std::get<0>(*this));
+                return op(ok_ref());
             }
             else
             {
-                return Result<U, E>(std::variant<U, E>{std::in_place_index<1>, std::get<1>(*this)});
+                return Result<U, E>(std::in_place_index<1>, this->err_value());
             }
         }
 
@@ -474,7 +727,7 @@ namespace rustly
         template <class F>
         inline Result<T, F> or_b(Result<T, F> res) const
         {
-            return (is_ok() ? Result<T, F>(std::variant<T, F>{std::in_place_index<0>, std::get<0>(*this)}) : res);
+            return (is_ok() ? Result<T, F>(std::in_place_index<0>, ok_ref()) : res);
         }
 
         /// Calls `op` if the result is `Err`, otherwise returns the `Ok` value of `this`.
@@ -496,11 +749,40 @@ namespace rustly
         {
             if (is_ok())
             {
-                return Result<T, F>(std::variant<T, F>{std::in_place_index<0>, std::get<0>(*this)});
+                return Result<T, F>(std::in_place_index<0>, ok_ref());
+            }
+            else
+            {
+                return op(this->err_value());
+            }
+        }
+
+    private:
+        /// The `Ok` value, as a `const T &`, or as a `T` for a reference
+        inline decltype(auto)
+        ok_ref() const
+        {
+            if constexpr (std::is_reference_v<T>)
+            {
+                return this->ok_storage().get();
             }
             else
             {
-                return op(std::get<1>(*this));
+                return this->ok_storage();
+            }
+        }
+
+        /// The `Ok` value, moved out, or as a `T` for a reference
+        inline T
+        ok_take()
+        {
+            if constexpr (std::is_reference_v<T>)
+            {
+                return this->ok_storage().get();
+            }
+            else
+            {
+                return std::move(this->ok_storage());
             }
         }
     };
@@ -512,7 +794,18 @@ namespace rustly
     /// auto x = Ok<const char *, int>("hello");
     /// ```
     template <class T, class E>
-    inline static Result<T, E> Ok(T t) { return Result<T, E>(std::variant<T, E>{std::in_place_index<0>, t}); }
+    inline static Result<T, E> Ok(T t) { return Result<T, E>(std::in_place_index<0>, std::forward<T>(t)); }
+
+    /// Construct a `Result` with an `Ok` value of `Unit`, for an operation
+    /// that has nothing to return
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto x = Ok<const char *>();
+    /// assert(x == Ok<Unit, const char *>(Unit()));
+    /// ```
+    template <class E>
+    inline static Result<Unit, E> Ok() { return Result<Unit, E>(std::in_place_index<0>); }
 
     /// Construct a `Result` with an `Err` value
     ///
@@ -522,5 +815,5 @@ namespace rustly
     /// ```
     template <class T, class E>
     [[nodiscard("this `Result` may be an `Err` variant, which should be handled")]] inline static Result<T, E>
-    Err(E e) { return Result<T, E>(std::variant<T, E>{std::in_place_index<1>, e}); }
+    Err(E e) { return Result<T, E>(std::in_place_index<1>, std::move(e)); }
 }
\ No newline at end of file
@@ -7,11 +7,39 @@ namespace rustly
 
 /** Macros */
 #include <rustly/panic.h>
+#include <rustly/print.h>
+
+/** Diagnostics */
+#include <rustly/alloc.h>
+#include <rustly/backtrace.h>
+#include <rustly/histogram.h>
+#include <rustly/log.h>
 
 /** Formatting */
 #include <rustly/display.h>
+#include <rustly/dyn.h>
+#include <rustly/errcode.h>
 #include <rustly/error.h>
 
+/** Algorithms */
+#include <rustly/memchr.h>
+#include <rustly/sort.h>
+
+/** Platform */
+#include <rustly/cpu.h>
+#include <rustly/fs.h>
+#include <rustly/sys.h>
+#include <rustly/walk.h>
+
 /** Types */
+#include <rustly/bitvec.h>
+#include <rustly/cache.h>
+#include <rustly/cmp.h>
+#include <rustly/cow.h>
+#include <rustly/function.h>
+#include <rustly/intern.h>
 #include <rustly/option.h>
-#include <rustly/result.h>
\ No newline at end of file
+#include <rustly/refcell.h>
+#include <rustly/result.h>
+#include <rustly/time.h>
+#include <rustly/validated.h>
\ No newline at end of file
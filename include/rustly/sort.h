@@ -0,0 +1,1011 @@
+#pragma once
+
+// The unstable sort and selection in this file are an altered version of pdqsort
+// (https://github.com/orlp/pdqsort), adapted to C++20, spans and Ordering
+// comparators, with every insertion sort and partition scan bounded by the
+// range. The original is distributed under the zlib license:
+//
+// Copyright (c) 2021 Orson Peters <orsonpeters@gmail.com>
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+//    original software. If you use this software in a product, an acknowledgment in the product
+//    documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//    being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <rustly/cmp.h>
+#include <rustly/panic.h>
+
+namespace rustly
+{
+    /// A contiguous, mutable sequence that can be sorted in place, such as a
+    /// `std::span<T>`, `std::vector<T>` or `std::array<T, N>`.
+    template <class R>
+    concept Slice = std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+                    !std::is_const_v<std::remove_reference_t<std::ranges::range_reference_t<R>>>;
+
+    namespace detail::sort
+    {
+        /// Below this, insertion sort is faster than partitioning
+        inline constexpr ptrdiff_t InsertionSortThreshold = 24;
+        /// Above this, the pivot is the median of three medians of three
+        inline constexpr ptrdiff_t NintherThreshold = 128;
+        /// How many elements a partial insertion sort may move before giving
+        /// up
+        inline constexpr ptrdiff_t PartialInsertionSortLimit = 8;
+        /// Elements classified at a time by the branchless partition; offsets
+        /// are stored in bytes
+        inline constexpr ptrdiff_t BlockSize = 64;
+        /// Natural runs shorter than this are extended by insertion sort
+        inline constexpr ptrdiff_t MinRun = 32;
+
+        template <class R>
+        using ElementOf = std::remove_reference_t<std::ranges::range_reference_t<R>>;
+
+        template <Slice R>
+        inline auto
+        as_span(R &&r) noexcept
+        {
+            return std::span<ElementOf<R>>(std::ranges::data(r), std::ranges::size(r));
+        }
+
+        /// `a < b`, for the default comparison
+        struct Less
+        {
+            template <class T>
+            constexpr bool
+            operator()(const T &a, const T &b) const
+            {
+                return a < b;
+            }
+        };
+
+        template <class T, class F>
+        inline void
+        insertion_sort(T *begin, T *end, F &comp)
+        {
+            if (begin == end)
+            {
+                return;
+            }
+            for (T *cur = begin + 1; cur != end; cur++)
+            {
+                T *sift = cur;
+                T *sift_1 = cur - 1;
+                if (comp(*sift, *sift_1))
+                {
+                    T tmp = std::move(*sift);
+                    do
+                    {
+                        *sift-- = std::move(*sift_1);
+                    } while (sift != begin && comp(tmp, *--sift_1));
+                    *sift = std::move(tmp);
+                }
+            }
+        }
+
+        /// Insertion sorts a range that is probably almost sorted already, or
+        /// gives up and returns `false` after moving too many elements
+        template <class T, class F>
+        inline bool
+        partial_insertion_sort(T *begin, T *end, F &comp)
+        {
+            if (begin == end)
+            {
+                return true;
+            }
+            ptrdiff_t moved = 0;
+            for (T *cur = begin + 1; cur != end; cur++)
+            {
+                T *sift = cur;
+                T *sift_1 = cur - 1;
+                if (comp(*sift, *sift_1))
+                {
+                    T tmp = std::move(*sift);
+                    do
+                    {
+                        *sift-- = std::move(*sift_1);
+                    } while (sift != begin && comp(tmp, *--sift_1));
+                    *sift = std::move(tmp);
+                    moved += cur - sift;
+                }
+                if (moved > PartialInsertionSortLimit)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <class T, class F>
+        inline void
+        sort2(T *a, T *b, F &comp)
+        {
+            if (comp(*b, *a))
+            {
+                std::iter_swap(a, b);
+            }
+        }
+
+        template <class T, class F>
+        inline void
+        sort3(T *a, T *b, T *c, F &comp)
+        {
+            sort2(a, b, comp);
+            sort2(b, c, comp);
+            sort2(a, b, comp);
+        }
+
+        /// Moves the pivot to `*begin`: the median of three, or for large
+        /// ranges the median of three medians. Either way an element no less
+        /// than the pivot is left among the last three.
+        template <class T, class F>
+        inline void
+        choose_pivot(T *begin, T *end, F &comp)
+        {
+            ptrdiff_t size = end - begin;
+            ptrdiff_t s2 = size / 2;
+            if (size > NintherThreshold)
+            {
+                sort3(begin, begin + s2, end - 1, comp);
+                sort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+                sort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+                sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comp);
+                std::iter_swap(begin, begin + s2);
+            }
+            else
+            {
+                sort3(begin + s2, begin, end - 1, comp);
+            }
+        }
+
+        /// Partitions around the pivot at `*begin`, putting elements equal to
+        /// it on the left. Returns its final position, for ranges where the
+        /// element before `begin` equals it, so that runs of equal elements
+        /// are skipped in one pass.
+        template <class T, class F>
+        inline T *
+        partition_left(T *begin, T *end, F &comp)
+        {
+            T pivot = std::move(*begin);
+            T *first = begin;
+            T *last = end;
+            while (--last > begin && comp(pivot, *last))
+            {
+            }
+            while (first < last && !comp(pivot, *++first))
+            {
+            }
+            while (first < last)
+            {
+                std::iter_swap(first, last);
+                while (--last > begin && comp(pivot, *last))
+                {
+                }
+                while (++first < end && !comp(pivot, *first))
+                {
+                }
+            }
+            *begin = std::move(*last);
+            *last = std::move(pivot);
+            return last;
+        }
+
+        /// Partitions around the pivot at `*begin`, putting elements equal to
+        /// it on the right. Returns its final position, and whether the range
+        /// was already partitioned.
+        ///
+        /// Unlike pdqsort, the scans check their bounds rather than relying on
+        /// an element that stops them, so a comparison that isn't a strict
+        /// weak order, such as `<` on a NaN, can misorder the range but never
+        /// runs off it.
+        template <class T, class F>
+        inline std::pair<T *, bool>
+        partition_right(T *begin, T *end, F &comp)
+        {
+            T pivot = std::move(*begin);
+            T *first = begin;
+            T *last = end;
+            while (++first < end && comp(*first, pivot))
+            {
+            }
+            while (first < last && !comp(*--last, pivot))
+            {
+            }
+            bool already_partitioned = first >= last;
+            while (first < last)
+            {
+                std::iter_swap(first, last);
+                while (++first < end && comp(*first, pivot))
+                {
+                }
+                while (--last > begin && !comp(*last, pivot))
+                {
+                }
+            }
+            T *pivot_pos = first - 1;
+            *begin = std::move(*pivot_pos);
+            *pivot_pos = std::move(pivot);
+            return {pivot_pos, already_partitioned};
+        }
+
+        /// Swaps the `n` misplaced elements found on each side. With unequal
+        /// counts, a cyclic permutation takes one move per element instead
+        /// of three.
+        template <class T>
+        inline void
+        swap_offsets(T *first, T *last, const uint8_t *offsets_l, const uint8_t *offsets_r, ptrdiff_t n, bool use_swaps)
+        {
+            if (use_swaps)
+            {
+                // Needed when the counts are equal, since the last element on
+                // the left may also be the first on the right
+                for (ptrdiff_t i = 0; i < n; i++)
+                {
+                    std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+                }
+            }
+            else if (n > 0)
+            {
+                T *l = first + offsets_l[0];
+                T *r = last - offsets_r[0];
+                T tmp = std::move(*l);
+                *l = std::move(*r);
+                for (ptrdiff_t i = 1; i < n; i++)
+                {
+                    l = first + offsets_l[i];
+                    *r = std::move(*l);
+                    r = last - offsets_r[i];
+                    *l = std::move(*r);
+                }
+                *r = std::move(tmp);
+            }
+        }
+
+        /// `partition_right`, without data-dependent branches while
+        /// classifying: each side records the offsets of its misplaced
+        /// elements into a block with `offsets[n] = i; n += misplaced;`, then
+        /// the two blocks are swapped pairwise (BlockQuicksort). For cheap
+        /// comparisons of random data this avoids a mispredict per element.
+        template <class T, class F>
+        inline std::pair<T *, bool>
+        partition_right_branchless(T *begin, T *end, F &comp)
+        {
+            T pivot = std::move(*begin);
+            T *first = begin;
+            T *last = end;
+            while (++first < end && comp(*first, pivot))
+            {
+            }
+            while (first < last && !comp(*--last, pivot))
+            {
+            }
+            bool already_partitioned = first >= last;
+            if (!already_partitioned)
+            {
+                std::iter_swap(first, last);
+                first++;
+
+                alignas(64) uint8_t offsets_l[BlockSize];
+                alignas(64) uint8_t offsets_r[BlockSize];
+                T *offsets_l_base = first;
+                T *offsets_r_base = last;
+                ptrdiff_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+                while (first < last)
+                {
+                    // Fill whichever blocks are empty, splitting what's left
+                    // when both are and less than two blocks remain
+                    ptrdiff_t unknown = last - first;
+                    ptrdiff_t left_split = num_l == 0 ? (num_r == 0 ? unknown / 2 : unknown) : 0;
+                    ptrdiff_t right_split = num_r == 0 ? (unknown - left_split) : 0;
+
+                    ptrdiff_t left_n = std::min(left_split, BlockSize);
+                    for (ptrdiff_t i = 0; i < left_n;)
+                    {
+                        offsets_l[num_l] = static_cast<uint8_t>(i++);
+                        num_l += !comp(*first, pivot);
+                        first++;
+                    }
+                    ptrdiff_t right_n = std::min(right_split, BlockSize);
+                    for (ptrdiff_t i = 0; i < right_n;)
+                    {
+                        offsets_r[num_r] = static_cast<uint8_t>(++i);
+                        num_r += comp(*--last, pivot);
+                    }
+
+                    ptrdiff_t n = std::min(num_l, num_r);
+                    swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, n, num_l == num_r);
+                    num_l -= n;
+                    num_r -= n;
+                    start_l += n;
+                    start_r += n;
+                    if (num_l == 0)
+                    {
+                        start_l = 0;
+                        offsets_l_base = first;
+                    }
+                    if (num_r == 0)
+                    {
+                        start_r = 0;
+                        offsets_r_base = last;
+                    }
+                }
+
+                // One side may have misplaced elements left over
+                if (num_l != 0)
+                {
+                    while (num_l-- > 0)
+                    {
+                        std::iter_swap(offsets_l_base + offsets_l[start_l + num_l], --last);
+                    }
+                    first = last;
+                }
+                if (num_r != 0)
+                {
+                    while (num_r-- > 0)
+                    {
+                        std::iter_swap(offsets_r_base - offsets_r[start_r + num_r], first);
+                        first++;
+                    }
+                    last = first;
+                }
+            }
+            T *pivot_pos = first - 1;
+            *begin = std::move(*pivot_pos);
+            *pivot_pos = std::move(pivot);
+            return {pivot_pos, already_partitioned};
+        }
+
+        template <class T, class F>
+        inline void
+        heap_sort(T *begin, T *end, F &comp)
+        {
+            std::make_heap(begin, end, std::ref(comp));
+            std::sort_heap(begin, end, std::ref(comp));
+        }
+
+        inline int
+        log2(size_t n) noexcept
+        {
+            return std::bit_width(n) - 1;
+        }
+
+        /// Pattern-defeating quicksort (Orson Peters): introsort whose
+        /// partitions detect already-sorted ranges, skip runs of equal
+        /// elements, and shuffle a few elements after an unbalanced partition
+        /// so that adversarial patterns don't stay quadratic. After
+        /// `bad_allowed` unbalanced partitions it falls back to heapsort.
+        template <bool Branchless, class T, class F>
+        inline void
+        pdqsort_loop(T *begin, T *end, F &comp, int bad_allowed, bool leftmost)
+        {
+            while (true)
+            {
+                ptrdiff_t size = end - begin;
+                if (size < InsertionSortThreshold)
+                {
+                    insertion_sort(begin, end, comp);
+                    return;
+                }
+
+                choose_pivot(begin, end, comp);
+
+                // If the element before the range equals the pivot, then so does
+                // everything not greater than it: put those on the left and skip
+                // them
+                if (!leftmost && !comp(*(begin - 1), *begin))
+                {
+                    begin = partition_left(begin, end, comp) + 1;
+                    continue;
+                }
+
+                auto [pivot_pos, already_partitioned] =
+                    Branchless ? partition_right_branchless(begin, end, comp) : partition_right(begin, end, comp);
+
+                ptrdiff_t l_size = pivot_pos - begin;
+                ptrdiff_t r_size = end - (pivot_pos + 1);
+                if (l_size < size / 8 || r_size < size / 8)
+                {
+                    if (--bad_allowed == 0)
+                    {
+                        heap_sort(begin, end, comp);
+                        return;
+                    }
+                    if (l_size >= InsertionSortThreshold)
+                    {
+                        std::iter_swap(begin, begin + l_size / 4);
+                        std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+                        if (l_size > NintherThreshold)
+                        {
+                            std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                            std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                            std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                            std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                        }
+                    }
+                    if (r_size >= InsertionSortThreshold)
+                    {
+                        std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                        std::iter_swap(end - 1, end - r_size / 4);
+                        if (r_size > NintherThreshold)
+                        {
+                            std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                            std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                            std::iter_swap(end - 2, end - (1 + r_size / 4));
+                            std::iter_swap(end - 3, end - (2 + r_size / 4));
+                        }
+                    }
+                }
+                else if (already_partitioned && partial_insertion_sort(begin, pivot_pos, comp) &&
+                         partial_insertion_sort(pivot_pos + 1, end, comp))
+                {
+                    // Probably sorted already
+                    return;
+                }
+
+                // Recurses into the left, and loops on the right
+                pdqsort_loop<Branchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+                begin = pivot_pos + 1;
+                leftmost = false;
+            }
+        }
+
+        template <bool Branchless, class T, class F>
+        inline void
+        unstable_sort(std::span<T> v, F &comp)
+        {
+            if (v.size() > 1)
+            {
+                pdqsort_loop<Branchless>(v.data(), v.data() + v.size(), comp, log2(v.size()), true);
+            }
+        }
+
+        /// Rearranges `[begin, end)` so that `*nth` is the element that would
+        /// be there if sorted, with no greater elements before it and no
+        /// lesser ones after it. The same partitions as `pdqsort_loop`, but
+        /// only into the side holding `nth`.
+        template <class T, class F>
+        inline void
+        select_nth(T *begin, T *end, T *nth, F &comp)
+        {
+            int bad_allowed = log2(static_cast<size_t>(end - begin));
+            bool leftmost = true;
+            while (end - begin >= InsertionSortThreshold)
+            {
+                ptrdiff_t size = end - begin;
+                choose_pivot(begin, end, comp);
+                if (!leftmost && !comp(*(begin - 1), *begin))
+                {
+                    // Everything up to the pivot's position equals it
+                    T *pivot_pos = partition_left(begin, end, comp);
+                    if (nth <= pivot_pos)
+                    {
+                        return;
+                    }
+                    begin = pivot_pos + 1;
+                    continue;
+                }
+                T *pivot_pos = partition_right(begin, end, comp).first;
+                if (pivot_pos == nth)
+                {
+                    return;
+                }
+                ptrdiff_t l_size = pivot_pos - begin;
+                ptrdiff_t r_size = end - (pivot_pos + 1);
+                if ((l_size < size / 8 || r_size < size / 8) && --bad_allowed == 0)
+                {
+                    heap_sort(begin, end, comp);
+                    return;
+                }
+                if (nth < pivot_pos)
+                {
+                    end = pivot_pos;
+                }
+                else
+                {
+                    begin = pivot_pos + 1;
+                    leftmost = false;
+                }
+            }
+            insertion_sort(begin, end, comp);
+        }
+
+        /// Returns the length of the run starting at `begin`: non-descending,
+        /// or strictly descending and then reversed, which keeps it stable
+        template <class T, class F>
+        inline ptrdiff_t
+        find_run(T *begin, T *end, F &comp)
+        {
+            ptrdiff_t n = end - begin;
+            if (n < 2)
+            {
+                return n;
+            }
+            ptrdiff_t i = 2;
+            if (comp(begin[1], begin[0]))
+            {
+                while (i < n && comp(begin[i], begin[i - 1]))
+                {
+                    i++;
+                }
+                std::reverse(begin, begin + i);
+            }
+            else
+            {
+                while (i < n && !comp(begin[i], begin[i - 1]))
+                {
+                    i++;
+                }
+            }
+            return i;
+        }
+
+        /// Powersort's merge policy (Munro and Wild): the depth in a balanced
+        /// merge tree over `[0, n)` of the boundary between the adjacent runs
+        /// `[s1, s1 + n1)` and `[s1 + n1, s1 + n1 + n2)`
+        inline int
+        node_power(size_t s1, size_t n1, size_t n2, size_t n) noexcept
+        {
+            // Twice the midpoints of the runs, as fractions of `n`, compared bit
+            // by bit until they differ
+            size_t a = 2 * s1 + n1;
+            size_t b = a + n1 + n2;
+            int power = 0;
+            while (true)
+            {
+                power++;
+                if (a >= n)
+                {
+                    a -= n;
+                    b -= n;
+                }
+                else if (b >= n)
+                {
+                    return power;
+                }
+                a <<= 1;
+                b <<= 1;
+            }
+        }
+
+        /// Uninitialized storage for merging, which moves back whatever it
+        /// still holds into the gap in the slice when done, even if a
+        /// comparison throws
+        template <class T>
+        class MergeBuffer
+        {
+        public:
+            explicit MergeBuffer(size_t capacity) : mData(std::allocator<T>().allocate(capacity)), mCapacity(capacity) {}
+
+            MergeBuffer(const MergeBuffer &) = delete;
+            MergeBuffer &operator=(const MergeBuffer &) = delete;
+
+            ~MergeBuffer()
+            {
+                std::allocator<T>().deallocate(mData, mCapacity);
+            }
+
+            /// Merges the sorted runs `[begin, mid)` and `[mid, end)`, moving
+            /// the shorter into the buffer
+            template <class F>
+            void
+            merge(T *begin, T *mid, T *end, F &comp)
+            {
+                if (mid - begin <= end - mid)
+                {
+                    merge_lo(begin, mid, end, comp);
+                }
+                else
+                {
+                    merge_hi(begin, mid, end, comp);
+                }
+            }
+
+        private:
+            /// The elements of the buffer not merged yet, `[first, last)`, and
+            /// the gap in the slice they fill: from `dest` forwards, or up to
+            /// `dest` backwards
+            template <bool Backwards>
+            struct Hole
+            {
+                ~Hole()
+                {
+                    if constexpr (Backwards)
+                    {
+                        std::move_backward(first, last, dest);
+                    }
+                    else
+                    {
+                        std::move(first, last, dest);
+                    }
+                    std::destroy(first, last);
+                }
+
+                T *first;
+                T *last;
+                T *dest;
+            };
+
+            template <class F>
+            void
+            merge_lo(T *begin, T *mid, T *end, F &comp)
+            {
+                Hole<false> hole{mData, std::uninitialized_move(begin, mid, mData), begin};
+                T *right = mid;
+                while (hole.first != hole.last && right != end)
+                {
+                    // Takes from the left on ties, for stability
+                    if (comp(*right, *hole.first))
+                    {
+                        *hole.dest++ = std::move(*right++);
+                    }
+                    else
+                    {
+                        *hole.dest++ = std::move(*hole.first);
+                        std::destroy_at(hole.first++);
+                    }
+                }
+            }
+
+            template <class F>
+            void
+            merge_hi(T *begin, T *mid, T *end, F &comp)
+            {
+                Hole<true> hole{mData, std::uninitialized_move(mid, end, mData), end};
+                T *left = mid;
+                while (hole.first != hole.last && left != begin)
+                {
+                    // Takes from the right on ties, for stability
+                    if (comp(*(hole.last - 1), *(left - 1)))
+                    {
+                        *--hole.dest = std::move(*--left);
+                    }
+                    else
+                    {
+                        *--hole.dest = std::move(*--hole.last);
+                        std::destroy_at(hole.last);
+                    }
+                }
+            }
+
+            T *mData;
+            size_t mCapacity;
+        };
+
+        /// A stable natural merge sort with powersort's merge policy: it finds
+        /// the existing ascending and descending runs, extends short ones to
+        /// `MinRun` by insertion sort, and merges them in a nearly optimal
+        /// order, so presorted input and concatenations of sorted inputs sort
+        /// in linear time. Allocates a buffer of half the length.
+        template <class T, class F>
+        inline void
+        stable_sort(std::span<T> v, F &comp)
+        {
+            T *base = v.data();
+            size_t n = v.size();
+            if (n <= static_cast<size_t>(InsertionSortThreshold))
+            {
+                insertion_sort(base, base + n, comp);
+                return;
+            }
+
+            struct Run
+            {
+                size_t start;
+                size_t len;
+                /// Of the boundary with the next run
+                int power;
+            };
+            // Powers strictly increase up the stack, and are at most 64
+            Run stack[66];
+            size_t height = 0;
+            std::unique_ptr<MergeBuffer<T>> buffer;
+            auto merge_top = [&]()
+            {
+                if (buffer == nullptr)
+                {
+                    buffer = std::make_unique<MergeBuffer<T>>(n / 2);
+                }
+                Run &lhs = stack[height - 2];
+                const Run &rhs = stack[height - 1];
+                buffer->merge(base + lhs.start, base + rhs.start, base + rhs.start + rhs.len, comp);
+                lhs.len += rhs.len;
+                height--;
+            };
+
+            for (size_t start = 0; start < n;)
+            {
+                size_t len = static_cast<size_t>(find_run(base + start, base + n, comp));
+                if (len < static_cast<size_t>(MinRun))
+                {
+                    size_t extended = std::min(n - start, static_cast<size_t>(MinRun));
+                    insertion_sort(base + start, base + start + extended, comp);
+                    len = extended;
+                }
+                if (height > 0)
+                {
+                    const Run &top = stack[height - 1];
+                    int power = node_power(top.start, top.len, len, n);
+                    while (height > 1 && stack[height - 2].power > power)
+                    {
+                        merge_top();
+                    }
+                    stack[height - 1].power = power;
+                }
+                stack[height++] = Run{start, len, 0};
+                start += len;
+            }
+            while (height > 1)
+            {
+                merge_top();
+            }
+        }
+
+        template <class F>
+        inline auto
+        ordering_less(F &compare)
+        {
+            return [&compare](const auto &a, const auto &b) { return Ordering(compare(a, b)).is_lt(); };
+        }
+
+        template <class F>
+        inline auto
+        key_less(F &key)
+        {
+            return [&key](const auto &a, const auto &b) { return std::invoke(key, a) < std::invoke(key, b); };
+        }
+
+        /// Whether block partitioning pays off: cheap, branch-free
+        /// comparisons of values that are cheap to move
+        template <class T>
+        inline constexpr bool Branchless = std::is_arithmetic_v<T> || std::is_pointer_v<T>;
+
+        template <class F, class T>
+        using KeyOf = std::remove_cvref_t<std::invoke_result_t<F &, const T &>>;
+
+        /// Sorts by keys computed once each, then applies the permutation
+        /// in place by following its cycles (as in Rust). Indices are
+        /// 32-bit where possible, so that the pairs are smaller.
+        template <class I, class T, class F>
+        inline void
+        sort_by_cached_key(std::span<T> v, F &key)
+        {
+            using K = KeyOf<F, T>;
+            std::vector<std::pair<K, I>> indices;
+            indices.reserve(v.size());
+            for (size_t i = 0; i < v.size(); i++)
+            {
+                indices.emplace_back(std::invoke(key, std::as_const(v[i])), static_cast<I>(i));
+            }
+            // Unique indices make the unstable sort stable
+            auto comp = [](const std::pair<K, I> &a, const std::pair<K, I> &b)
+            { return a.first < b.first || (!(b.first < a.first) && a.second < b.second); };
+            unstable_sort<false>(std::span<std::pair<K, I>>(indices), comp);
+            for (size_t i = 0; i < v.size(); i++)
+            {
+                I index = indices[i].second;
+                while (static_cast<size_t>(index) < i)
+                {
+                    index = indices[static_cast<size_t>(index)].second;
+                }
+                indices[i].second = index;
+                std::swap(v[i], v[static_cast<size_t>(index)]);
+            }
+        }
+    }
+
+    /// Sorts `v` in place, keeping equal elements in order, like Rust's
+    /// `slice::sort`. A natural merge sort with powersort's merge policy:
+    /// linear for input that is already sorted, reversed, or a concatenation
+    /// of a few sorted runs, and O(n log n) otherwise. Allocates a buffer of
+    /// half of `v`'s length.
+    ///
+    /// If `<` isn't a total order on the elements, such as for doubles
+    /// including NaN, the order of the result is unspecified, but it's still
+    /// a permutation of `v`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::vector<int> v = {5, 4, 1, 3, 2};
+    /// sort(v);
+    /// assert(v == std::vector<int>({1, 2, 3, 4, 5}));
+    /// ```
+    template <Slice R>
+    inline void
+    sort(R &&v)
+    {
+        detail::sort::Less comp;
+        detail::sort::stable_sort(detail::sort::as_span(v), comp);
+    }
+
+    /// Sorts `v` in place, stably, with a comparator returning an `Ordering`
+    /// (or a `std::strong_ordering` or `std::weak_ordering`). `compare`
+    /// should be a total order; if it isn't, the order of the result is
+    /// unspecified, but it's still a permutation of `v`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// // Descending
+    /// sort_by(v, [](int a, int b) { return cmp(a, b).reverse(); });
+    /// ```
+    template <Slice R, class F>
+    inline void
+    sort_by(R &&v, F compare)
+    {
+        auto comp = detail::sort::ordering_less(compare);
+        detail::sort::stable_sort(detail::sort::as_span(v), comp);
+    }
+
+    /// Sorts `v` in place, stably, by the key `key` returns for each
+    /// element. `key` is called twice per comparison; see
+    /// `sort_by_cached_key` for expensive keys. As with `sort_by`, keys
+    /// that aren't totally ordered leave the order unspecified.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// sort_by_key(people, [](const Person &p) { return p.age; });
+    /// // `employer_id()` returns an `Option`, and `None` sorts first
+    /// sort_by_key(people, [](const Person &p) { return p.employer_id(); });
+    /// ```
+    template <Slice R, class F>
+    inline void
+    sort_by_key(R &&v, F key)
+    {
+        auto comp = detail::sort::key_less(key);
+        detail::sort::stable_sort(detail::sort::as_span(v), comp);
+    }
+
+    /// Sorts `v` in place, stably, by the key `key` returns for each
+    /// element, calling it only once per element. Faster than `sort_by_key`
+    /// when keys are expensive to compute, such as strings built from each
+    /// element; allocates a vector of `(key, index)` pairs.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// sort_by_cached_key(paths, [](const Path &p) { return p.lowercase(); });
+    /// ```
+    template <Slice R, class F>
+    inline void
+    sort_by_cached_key(R &&v, F key)
+    {
+        auto s = detail::sort::as_span(v);
+        if (s.size() < 2)
+        {
+            return;
+        }
+        if (s.size() <= UINT32_MAX)
+        {
+            detail::sort::sort_by_cached_key<uint32_t>(s, key);
+        }
+        else
+        {
+            detail::sort::sort_by_cached_key<size_t>(s, key);
+        }
+    }
+
+    /// Sorts `v` in place, without keeping equal elements in order, like
+    /// Rust's `slice::sort_unstable`. Pattern-defeating quicksort: O(n log n)
+    /// in the worst case, linear for sorted and reversed input and for few
+    /// distinct values, and doesn't allocate. Arithmetic elements are
+    /// partitioned without branching on comparisons.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::vector<int> v = {5, 4, 1, 3, 2};
+    /// sort_unstable(v);
+    /// assert(v == std::vector<int>({1, 2, 3, 4, 5}));
+    /// ```
+    template <Slice R>
+    inline void
+    sort_unstable(R &&v)
+    {
+        using T = detail::sort::ElementOf<R>;
+        detail::sort::Less comp;
+        detail::sort::unstable_sort<detail::sort::Branchless<T>>(detail::sort::as_span(v), comp);
+    }
+
+    /// Sorts `v` in place, without keeping equal elements in order, with a
+    /// comparator returning an `Ordering`. As with `sort_by`, a `compare`
+    /// that isn't a total order leaves the order unspecified.
+    template <Slice R, class F>
+    inline void
+    sort_unstable_by(R &&v, F compare)
+    {
+        auto comp = detail::sort::ordering_less(compare);
+        detail::sort::unstable_sort<false>(detail::sort::as_span(v), comp);
+    }
+
+    /// Sorts `v` in place, without keeping equal elements in order, by the
+    /// key `key` returns for each element.
+    template <Slice R, class F>
+    inline void
+    sort_unstable_by_key(R &&v, F key)
+    {
+        using T = detail::sort::ElementOf<R>;
+        using K = detail::sort::KeyOf<F, T>;
+        auto comp = detail::sort::key_less(key);
+        detail::sort::unstable_sort<detail::sort::Branchless<K> && std::is_trivially_copyable_v<T>>(detail::sort::as_span(v),
+                                                                                                     comp);
+    }
+
+    namespace detail::sort
+    {
+        template <class T, class F>
+        inline std::tuple<std::span<T>, T &, std::span<T>>
+        select_nth_unstable(std::span<T> v, size_t index, F &comp)
+        {
+            if (index >= v.size())
+            {
+                panic("partition_at_index index {} greater than length of slice {}", index, v.size());
+            }
+            select_nth(v.data(), v.data() + v.size(), v.data() + index, comp);
+            return {v.first(index), v[index], v.subspan(index + 1)};
+        }
+    }
+
+    /// Reorders `v` so that the element at `index` is the one that would be
+    /// there if `v` were sorted, with no greater elements before it and no
+    /// lesser ones after it, like Rust's `slice::select_nth_unstable`.
+    /// Returns the elements before it, a reference to it, and the elements
+    /// after it. Linear on average, and O(n log n) in the worst case.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::vector<int> v = {-5, 4, 2, -3, 1};
+    /// auto [lesser, median, greater] = select_nth_unstable(v, 2);
+    /// assert(median == 1);
+    /// assert(lesser.size() == 2 && greater.size() == 2);
+    /// ```
+    ///
+    /// ## Panics
+    /// Panics if `index >= v.size()`.
+    template <Slice R>
+    inline auto
+    select_nth_unstable(R &&v, size_t index)
+    {
+        detail::sort::Less comp;
+        return detail::sort::select_nth_unstable(detail::sort::as_span(v), index, comp);
+    }
+
+    /// `select_nth_unstable`, with a comparator returning an `Ordering`. A
+    /// `compare` that isn't a total order leaves which element ends up at
+    /// `index` unspecified.
+    template <Slice R, class F>
+    inline auto
+    select_nth_unstable_by(R &&v, size_t index, F compare)
+    {
+        auto comp = detail::sort::ordering_less(compare);
+        return detail::sort::select_nth_unstable(detail::sort::as_span(v), index, comp);
+    }
+
+    /// `select_nth_unstable`, by the key `key` returns for each element.
+    template <Slice R, class F>
+    inline auto
+    select_nth_unstable_by_key(R &&v, size_t index, F key)
+    {
+        auto comp = detail::sort::key_less(key);
+        return detail::sort::select_nth_unstable(detail::sort::as_span(v), index, comp);
+    }
+}
@@ -0,0 +1,457 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <rustly/errcode.h>
+#include <rustly/panic.h>
+#include <rustly/result.h>
+
+namespace rustly::sys
+{
+    /// An OS error number, from `errno`, like rustix's `io::Errno`.
+    ///
+    /// Codes are from 1 to 4095, the range Linux reserves for them, so that a
+    /// `Result<Count, Errno>` or `Result<T *, Errno>` stores an `Err` the way
+    /// the kernel returns one, as a value in `[-4095, -1]`, and is the size of
+    /// a `size_t`: it's returned in a single register.
+    class Errno
+    {
+    public:
+        /// The largest code, and the size of the niche in `T`
+        static constexpr int MaxCode = 4095;
+
+        explicit constexpr Errno(int code) noexcept : mCode(code) {}
+
+        /// The error in `errno` now.
+        static Errno
+        last() noexcept
+        {
+            return Errno(errno);
+        }
+
+        constexpr int
+        code() const noexcept
+        {
+            return mCode;
+        }
+
+        /// Returns the OS's message for this code, without allocating.
+        std::string_view
+        message() const noexcept
+        {
+            return rustly::detail::describe_errno(static_cast<uint32_t>(mCode));
+        }
+
+        ErrorCode
+        error_code() const noexcept
+        {
+            return ErrorCode::from_errno(mCode);
+        }
+
+        /// Returns the message and code, e.g. `No such file or directory (os
+        /// error 2)`.
+        std::string
+        to_string() const noexcept
+        {
+            return std::string(message()) + " (os error " + std::to_string(mCode) + ")";
+        }
+
+        constexpr bool operator==(const Errno &rhs) const noexcept = default;
+        constexpr auto operator<=>(const Errno &rhs) const noexcept = default;
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const Errno &rhs)
+        {
+            return os << rhs.to_string();
+        }
+
+    private:
+        int mCode;
+    };
+
+    /// A count of bytes or items returned by a syscall, which converts to and
+    /// from `size_t`. It's its own type so that `Result<Count, Errno>` can
+    /// keep the `Err` in the counts the kernel never returns, those above
+    /// `SSIZE_MAX`, without a `Result<Count, Errno>` elsewhere losing the
+    /// largest `size_t`s to it.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// size_t n = sys::read(fd.raw(), buf, sizeof(buf)).unwrap();
+    /// ```
+    class Count
+    {
+    public:
+        constexpr Count(size_t n) noexcept : mN(n) {}
+
+        constexpr operator size_t() const noexcept
+        {
+            return mN;
+        }
+
+        std::string
+        to_string() const noexcept
+        {
+            return std::to_string(mN);
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, Count rhs)
+        {
+            return os << rhs.mN;
+        }
+
+    private:
+        size_t mN;
+    };
+
+    namespace detail
+    {
+        /// The code of `e` negated as a `uintptr_t`, to store in a niche
+        ///
+        /// ## Panics
+        /// If the code is outside `[1, MaxCode]`, as it would read as an `Ok`
+        inline uintptr_t
+        niche_code(Errno e) noexcept
+        {
+            if (e.code() < 1 || e.code() > Errno::MaxCode) [[unlikely]]
+            {
+                panic("`Errno` {} is outside [1, {}], so would read as an `Ok`", e.code(), Errno::MaxCode);
+            }
+            return -static_cast<uintptr_t>(e.code());
+        }
+    }
+}
+
+namespace rustly
+{
+    /// Counts store an `Errno` the way the kernel returns one, as `-code`.
+    /// `Ok` counts must be below `SIZE_MAX - 4095`, which counts of bytes or
+    /// items in memory always are.
+    template <>
+    struct ResultNiche<sys::Count, sys::Errno>
+    {
+        static bool
+        is_err(sys::Count raw) noexcept
+        {
+            return raw >= static_cast<size_t>(-sys::Errno::MaxCode);
+        }
+
+        static sys::Count
+        encode(sys::Errno e) noexcept
+        {
+            return sys::Count(sys::detail::niche_code(e));
+        }
+
+        static sys::Errno
+        decode(sys::Count raw) noexcept
+        {
+            return sys::Errno(static_cast<int>(-static_cast<size_t>(raw)));
+        }
+    };
+
+    /// Pointers store an `Errno` in the last page of the address space,
+    /// which is never mapped, as Linux's `ERR_PTR` does.
+    template <class T>
+    struct ResultNiche<T *, sys::Errno>
+    {
+        static bool
+        is_err(T *raw) noexcept
+        {
+            return reinterpret_cast<uintptr_t>(raw) >= static_cast<uintptr_t>(-sys::Errno::MaxCode);
+        }
+
+        static T *
+        encode(sys::Errno e) noexcept
+        {
+            return reinterpret_cast<T *>(sys::detail::niche_code(e));
+        }
+
+        static sys::Errno
+        decode(T *raw) noexcept
+        {
+            return sys::Errno(static_cast<int>(-reinterpret_cast<uintptr_t>(raw)));
+        }
+    };
+}
+
+namespace rustly::sys
+{
+    /// An owned file descriptor, closed when destroyed, like Rust's
+    /// `OwnedFd`. Pass `raw()` to the functions in `sys`, which borrow it.
+    class Fd
+    {
+    public:
+        Fd() noexcept : mFd(-1) {}
+
+        /// Takes ownership of `fd`.
+        explicit Fd(int fd) noexcept : mFd(fd) {}
+
+        Fd(Fd &&other) noexcept : mFd(std::exchange(other.mFd, -1)) {}
+
+        Fd &
+        operator=(Fd &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                mFd = std::exchange(other.mFd, -1);
+            }
+            return *this;
+        }
+
+        Fd(const Fd &) = delete;
+        Fd &operator=(const Fd &) = delete;
+
+        ~Fd()
+        {
+            reset();
+        }
+
+        int
+        raw() const noexcept
+        {
+            return mFd;
+        }
+
+        bool
+        is_open() const noexcept
+        {
+            return mFd >= 0;
+        }
+
+        /// Gives up ownership, returning the descriptor.
+        int
+        release() noexcept
+        {
+            return std::exchange(mFd, -1);
+        }
+
+        /// Closes the descriptor, returning the error that the destructor
+        /// would ignore. On Linux the descriptor is closed even on `EINTR`,
+        /// so it isn't retried.
+        Result<Unit, Errno>
+        close() &&
+        {
+            int fd = release();
+            if (fd >= 0 && ::close(fd) != 0)
+            {
+                return Err<Unit, Errno>(Errno::last());
+            }
+            return Ok<Errno>();
+        }
+
+    private:
+        void
+        reset() noexcept
+        {
+            if (mFd >= 0)
+            {
+                ::close(mFd);
+                mFd = -1;
+            }
+        }
+
+        int mFd;
+    };
+
+    namespace detail
+    {
+        /// Calls `f` until it fails with something other than `EINTR`
+        template <class F>
+        inline auto
+        retry(F &&f)
+        {
+            while (true)
+            {
+                auto r = f();
+                if (r != -1 || errno != EINTR) [[likely]]
+                {
+                    return r;
+                }
+            }
+        }
+
+        /// Converts a libc return value, `-1` with `errno` set on failure
+        template <class T, class R>
+        inline Result<T, Errno>
+        cvt(R r)
+        {
+            if (r == -1) [[unlikely]]
+            {
+                return Err<T, Errno>(Errno::last());
+            }
+            return Ok<T, Errno>(static_cast<T>(r));
+        }
+
+        inline Result<Unit, Errno>
+        cvt_unit(int r)
+        {
+            if (r == -1) [[unlikely]]
+            {
+                return Err<Unit, Errno>(Errno::last());
+            }
+            return Ok<Errno>();
+        }
+
+        inline Result<Fd, Errno>
+        cvt_fd(int r)
+        {
+            if (r == -1) [[unlikely]]
+            {
+                return Err<Fd, Errno>(Errno::last());
+            }
+            return Ok<Fd, Errno>(Fd(r));
+        }
+    }
+
+    /// Opens `path`, always with `O_CLOEXEC`, retrying on `EINTR`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto fd = sys::open("/etc/hostname", O_RDONLY);
+    /// auto missing = sys::open("/nonexistent", O_RDONLY);
+    /// assert(missing.err() == Some(sys::Errno(ENOENT)));
+    /// ```
+    inline Result<Fd, Errno>
+    open(const char *path, int flags, mode_t mode = 0)
+    {
+        return detail::cvt_fd(detail::retry([&]() { return ::open(path, flags | O_CLOEXEC, mode); }));
+    }
+
+    /// Opens `path` relative to the directory `dirfd`, always with
+    /// `O_CLOEXEC`, retrying on `EINTR`.
+    inline Result<Fd, Errno>
+    openat(int dirfd, const char *path, int flags, mode_t mode = 0)
+    {
+        return detail::cvt_fd(detail::retry([&]() { return ::openat(dirfd, path, flags | O_CLOEXEC, mode); }));
+    }
+
+    /// Reads up to `len` bytes into `buf`, returning how many were read, and
+    /// 0 at the end of the file. Retries on `EINTR`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// char buf[4096];
+    /// size_t n = sys::read(fd.raw(), buf, sizeof(buf)).unwrap();
+    /// ```
+    inline Result<Count, Errno>
+    read(int fd, void *buf, size_t len)
+    {
+        return detail::cvt<Count>(detail::retry([&]() { return ::read(fd, buf, len); }));
+    }
+
+    /// Reads up to `len` bytes at `offset` into `buf`, without moving the
+    /// file position. Retries on `EINTR`.
+    inline Result<Count, Errno>
+    pread(int fd, void *buf, size_t len, off_t offset)
+    {
+        return detail::cvt<Count>(detail::retry([&]() { return ::pread(fd, buf, len, offset); }));
+    }
+
+    /// Writes up to `len` bytes from `buf`, returning how many were written.
+    /// Retries on `EINTR`.
+    inline Result<Count, Errno>
+    write(int fd, const void *buf, size_t len)
+    {
+        return detail::cvt<Count>(detail::retry([&]() { return ::write(fd, buf, len); }));
+    }
+
+    /// Closes `fd`. Prefer `Fd::close()` for owned descriptors.
+    inline Result<Unit, Errno>
+    close(int fd)
+    {
+        return detail::cvt_unit(::close(fd));
+    }
+
+    /// Returns the status of the open file `fd`.
+    inline Result<struct stat, Errno>
+    fstat(int fd)
+    {
+        struct stat st;
+        if (::fstat(fd, &st) != 0) [[unlikely]]
+        {
+            return Err<struct stat, Errno>(Errno::last());
+        }
+        return Ok<struct stat, Errno>(st);
+    }
+
+    /// Maps `len` bytes of `fd` at `offset`, or anonymous memory, returning
+    /// the address.
+    inline Result<void *, Errno>
+    mmap(void *addr, size_t len, int prot, int flags, int fd, off_t offset)
+    {
+        void *p = ::mmap(addr, len, prot, flags, fd, offset);
+        if (p == MAP_FAILED) [[unlikely]]
+        {
+            return Err<void *, Errno>(Errno::last());
+        }
+        return Ok<void *, Errno>(p);
+    }
+
+    inline Result<Unit, Errno>
+    munmap(void *addr, size_t len)
+    {
+        return detail::cvt_unit(::munmap(addr, len));
+    }
+
+    /// Reads directory entries from the open directory `fd` into `buf`, as
+    /// packed `linux_dirent64` records, returning how many bytes were
+    /// filled, and 0 at the end of the directory. Retries on `EINTR`.
+    inline Result<Count, Errno>
+    getdents64(int fd, void *buf, size_t len)
+    {
+        return detail::cvt<Count>(detail::retry([&]() { return ::syscall(SYS_getdents64, fd, buf, len); }));
+    }
+
+    inline Result<Fd, Errno>
+    epoll_create1(int flags = EPOLL_CLOEXEC)
+    {
+        return detail::cvt_fd(::epoll_create1(flags));
+    }
+
+    inline Result<Unit, Errno>
+    epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+    {
+        return detail::cvt_unit(::epoll_ctl(epfd, op, fd, event));
+    }
+
+    /// Waits for events on `epfd`, for up to `timeout_ms` milliseconds, or
+    /// forever if negative, returning how many of `events` were filled.
+    /// Retries on `EINTR`, restarting the timeout.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::array<epoll_event, 64> events;
+    /// for (size_t i = 0, n = sys::epoll_wait(epfd.raw(), events, -1).unwrap(); i < n; i++)
+    /// {
+    ///     handle(events[i]);
+    /// }
+    /// ```
+    inline Result<Count, Errno>
+    epoll_wait(int epfd, std::span<struct epoll_event> events, int timeout_ms)
+    {
+        return detail::cvt<Count>(
+            detail::retry([&]() { return ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), timeout_ms); }));
+    }
+
+    inline Result<Fd, Errno>
+    eventfd(unsigned int initval, int flags = EFD_CLOEXEC)
+    {
+        return detail::cvt_fd(::eventfd(initval, flags));
+    }
+}
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <rustly/option.h>
+#include <rustly/panic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace rustly
+{
+    /// A span of time, with nanosecond precision.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto five_seconds = Duration(5, 0);
+    /// auto five_seconds_and_five_nanos = five_seconds + Duration::from_nanos(5);
+    ///
+    /// assert(five_seconds_and_five_nanos.as_secs() == 5);
+    /// assert(five_seconds_and_five_nanos.subsec_nanos() == 5);
+    /// ```
+    class Duration
+    {
+    public:
+        static constexpr uint32_t NanosPerSec = 1'000'000'000;
+
+        /// Creates a zero-length `Duration`.
+        constexpr Duration() : mSecs(0), mNanos(0) {}
+
+        /// Creates a new `Duration` from whole seconds and additional
+        /// nanoseconds. Nanoseconds in excess of a second carry over.
+        ///
+        /// ## Panics
+        /// Panics if the carry from the nanoseconds overflows the seconds.
+        constexpr Duration(uint64_t secs, uint32_t nanos)
+        {
+            uint64_t carry = nanos / NanosPerSec;
+            if (secs > std::numeric_limits<uint64_t>::max() - carry)
+            {
+                panic("overflow in Duration::new");
+            }
+            mSecs = secs + carry;
+            mNanos = nanos % NanosPerSec;
+        }
+
+        static constexpr Duration
+        ZERO()
+        {
+            return Duration();
+        }
+
+        static constexpr Duration
+        MAX()
+        {
+            return Duration(std::numeric_limits<uint64_t>::max(), NanosPerSec - 1);
+        }
+
+        static constexpr Duration from_secs(uint64_t secs) { return Duration(secs, 0); }
+        static constexpr Duration from_millis(uint64_t millis) { return Duration(millis / 1'000, (millis % 1'000) * 1'000'000); }
+        static constexpr Duration from_micros(uint64_t micros) { return Duration(micros / 1'000'000, (micros % 1'000'000) * 1'000); }
+        static constexpr Duration from_nanos(uint64_t nanos) { return Duration(nanos / NanosPerSec, nanos % NanosPerSec); }
+
+        /// Creates a new `Duration` from a number of seconds, as a `double`.
+        ///
+        /// ## Panics
+        /// Panics if `secs` is negative, overflows `Duration`, or is not finite.
+        static Duration
+        from_secs_f64(double secs)
+        {
+            if (!(secs >= 0.0 && secs < 18446744073709551616.0))
+            {
+                panic("cannot convert float seconds to Duration: value is negative, overflowed or not finite");
+            }
+            auto whole = static_cast<uint64_t>(secs);
+            auto nanos = static_cast<uint32_t>((secs - static_cast<double>(whole)) * NanosPerSec);
+            return Duration(whole, nanos);
+        }
+
+        /// Returns `true` if this `Duration` spans no time.
+        constexpr bool is_zero() const { return mSecs == 0 && mNanos == 0; }
+
+        /// Returns the number of whole seconds contained by this `Duration`.
+        constexpr uint64_t as_secs() const { return mSecs; }
+
+        constexpr uint32_t subsec_millis() const { return mNanos / 1'000'000; }
+        constexpr uint32_t subsec_micros() const { return mNanos / 1'000; }
+        constexpr uint32_t subsec_nanos() const { return mNanos; }
+
+        /// Returns the total number of whole milliseconds, saturating at
+        /// `UINT64_MAX`.
+        constexpr uint64_t as_millis() const { return total(1'000, 1'000'000); }
+
+        /// Returns the total number of whole microseconds, saturating at
+        /// `UINT64_MAX`.
+        constexpr uint64_t as_micros() const { return total(1'000'000, 1'000); }
+
+        /// Returns the total number of nanoseconds, saturating at `UINT64_MAX`.
+        constexpr uint64_t as_nanos() const { return total(NanosPerSec, 1); }
+
+        /// Returns the number of seconds contained by this `Duration`, as a `double`.
+        constexpr double as_secs_f64() const { return static_cast<double>(mSecs) + static_cast<double>(mNanos) / NanosPerSec; }
+
+        /// Checked `Duration` addition. Computes `this + rhs`, returning `None`
+        /// if overflow occurred.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// assert(Duration(0, 0).checked_add(Duration(0, 1)) == Some(Duration(0, 1)));
+        /// assert(Duration(UINT64_MAX, 0).checked_add(Duration(1, 0)) == None());
+        /// ```
+        inline Option<Duration>
+        checked_add(Duration rhs) const
+        {
+            uint64_t secs;
+            if (__builtin_add_overflow(mSecs, rhs.mSecs, &secs))
+            {
+                return Option<Duration>();
+            }
+            uint32_t nanos = mNanos + rhs.mNanos;
+            if (nanos >= NanosPerSec)
+            {
+                nanos -= NanosPerSec;
+                if (__builtin_add_overflow(secs, 1, &secs))
+                {
+                    return Option<Duration>();
+                }
+            }
+            return Option<Duration>(Duration(secs, nanos));
+        }
+
+        /// Checked `Duration` subtraction. Computes `this - rhs`, returning
+        /// `None` if the result would be negative.
+        ///
+        /// ## Examples
+        /// ```cpp
+        /// assert(Duration(0, 1).checked_sub(Duration(0, 0)) == Some(Duration(0, 1)));
+        /// assert(Duration(0, 0).checked_sub(Duration(0, 1)) == None());
+        /// ```
+        inline Option<Duration>
+        checked_sub(Duration rhs) const
+        {
+            uint64_t secs;
+            if (__builtin_sub_overflow(mSecs, rhs.mSecs, &secs))
+            {
+                return Option<Duration>();
+            }
+            uint32_t nanos = mNanos;
+            if (nanos < rhs.mNanos)
+            {
+                if (secs == 0)
+                {
+                    return Option<Duration>();
+                }
+                secs--;
+                nanos += NanosPerSec;
+            }
+            return Option<Duration>(Duration(secs, nanos - rhs.mNanos));
+        }
+
+        /// Checked `Duration` multiplication. Computes `this * rhs`, returning
+        /// `None` if overflow occurred.
+        inline Option<Duration>
+        checked_mul(uint32_t rhs) const
+        {
+            uint64_t nanos = static_cast<uint64_t>(mNanos) * rhs;
+            uint64_t secs;
+            if (__builtin_mul_overflow(mSecs, static_cast<uint64_t>(rhs), &secs) ||
+                __builtin_add_overflow(secs, nanos / NanosPerSec, &secs))
+            {
+                return Option<Duration>();
+            }
+            return Option<Duration>(Duration(secs, static_cast<uint32_t>(nanos % NanosPerSec)));
+        }
+
+        /// Checked `Duration` division. Computes `this / rhs`, returning `None`
+        /// if `rhs == 0`.
+        inline Option<Duration>
+        checked_div(uint32_t rhs) const
+        {
+            if (rhs == 0)
+            {
+                return Option<Duration>();
+            }
+            uint64_t secs = mSecs / rhs;
+            uint64_t carry = mSecs - secs * rhs;
+            uint64_t nanos = (mNanos + carry * NanosPerSec) / rhs;
+            return Option<Duration>(Duration(secs, static_cast<uint32_t>(nanos)));
+        }
+
+        /// Saturating `Duration` addition. Computes `this + rhs`, returning
+        /// `Duration::MAX()` if overflow occurred.
+        inline Duration saturating_add(Duration rhs) const { return checked_add(rhs).unwrap_or(MAX()); }
+
+        /// Saturating `Duration` subtraction. Computes `this - rhs`, returning
+        /// `Duration::ZERO()` if the result would be negative.
+        inline Duration saturating_sub(Duration rhs) const { return checked_sub(rhs).unwrap_or(ZERO()); }
+
+        Duration operator+(Duration rhs) const { return checked_add(rhs).expect("overflow when adding durations"); }
+        Duration operator-(Duration rhs) const { return checked_sub(rhs).expect("overflow when subtracting durations"); }
+        Duration operator*(uint32_t rhs) const { return checked_mul(rhs).expect("overflow when multiplying duration by scalar"); }
+        Duration operator/(uint32_t rhs) const { return checked_div(rhs).expect("divide by zero error when dividing duration by scalar"); }
+        Duration &operator+=(Duration rhs) { return *this = *this + rhs; }
+        Duration &operator-=(Duration rhs) { return *this = *this - rhs; }
+
+        constexpr bool operator==(const Duration &rhs) const = default;
+        constexpr auto operator<=>(const Duration &rhs) const = default;
+
+        /// Renders the duration in its largest whole unit, e.g. `1.5s`, `10ms`,
+        /// `100µs` or `5ns`.
+        const std::string
+        to_string() const noexcept
+        {
+            std::ostringstream oss;
+            oss << *this;
+            return oss.str();
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &out, const Duration &rhs)
+        {
+            auto write = [&](uint64_t whole, uint32_t frac, uint32_t divisor, const char *unit)
+            {
+                out << whole;
+                if (frac > 0)
+                {
+                    out << '.';
+                    for (divisor /= 10; frac > 0; divisor /= 10)
+                    {
+                        out << static_cast<char>('0' + frac / divisor);
+                        frac %= divisor;
+                    }
+                }
+                out << unit;
+            };
+
+            if (rhs.mSecs > 0)
+            {
+                write(rhs.mSecs, rhs.mNanos, NanosPerSec, "s");
+            }
+            else if (rhs.mNanos >= 1'000'000)
+            {
+                write(rhs.mNanos / 1'000'000, rhs.mNanos % 1'000'000, 1'000'000, "ms");
+            }
+            else if (rhs.mNanos >= 1'000)
+            {
+                write(rhs.mNanos / 1'000, rhs.mNanos % 1'000, 1'000, "µs");
+            }
+            else
+            {
+                write(rhs.mNanos, 0, 1, "ns");
+            }
+            return out;
+        }
+
+    private:
+        constexpr uint64_t
+        total(uint64_t per_sec, uint32_t nanos_per_unit) const
+        {
+            uint64_t total;
+            if (__builtin_mul_overflow(mSecs, per_sec, &total) ||
+                __builtin_add_overflow(total, mNanos / nanos_per_unit, &total))
+            {
+                return std::numeric_limits<uint64_t>::max();
+            }
+            return total;
+        }
+
+        uint64_t mSecs;
+        uint32_t mNanos;
+    };
+
+    /// The clock backing `Instant`
+    enum class ClockSource
+    {
+        /// `CLOCK_MONOTONIC`
+        Monotonic,
+        /// The invariant time-stamp counter, calibrated against `CLOCK_MONOTONIC`
+        Tsc,
+    };
+
+    namespace detail
+    {
+        inline uint64_t
+        monotonic_nanos()
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * Duration::NanosPerSec + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        /// Converts time-stamp counter ticks to `CLOCK_MONOTONIC` nanoseconds,
+        /// using a fixed-point scale measured once at startup.
+        class TscClock
+        {
+        public:
+            static constexpr int Shift = 32;
+
+            /// Returns `true` if the CPU has an invariant TSC, which ticks at a
+            /// constant rate across frequency changes and sleep states.
+            static bool
+            is_invariant()
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                unsigned int eax, ebx, ecx, edx;
+                return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+#else
+                return false;
+#endif
+            }
+
+            static inline uint64_t
+            ticks()
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                return __rdtsc();
+#else
+                return 0;
+#endif
+            }
+
+            /// Calibrates against `CLOCK_MONOTONIC` by spinning for `window`.
+            explicit TscClock(Duration window = Duration::from_millis(10))
+            {
+                uint64_t ns0 = monotonic_nanos(), tsc0 = ticks();
+                uint64_t ns1, tsc1;
+                do
+                {
+                    ns1 = monotonic_nanos();
+                    tsc1 = ticks();
+                } while (ns1 - ns0 < window.as_nanos());
+
+                mHz = static_cast<double>(tsc1 - tsc0) * 1e9 / static_cast<double>(ns1 - ns0);
+                mScale = static_cast<uint64_t>((static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0)) *
+                                               static_cast<double>(1ull << Shift));
+                mBaseTicks = tsc1;
+                mBaseNanos = ns1;
+            }
+
+            inline uint64_t
+            nanos() const
+            {
+                // Another core's TSC may read slightly behind the calibrating
+                // core's base, which would otherwise wrap to ~584 years ahead
+                uint64_t now = ticks();
+                uint64_t delta = now > mBaseTicks ? now - mBaseTicks : 0;
+                return mBaseNanos + static_cast<uint64_t>((static_cast<unsigned __int128>(delta) * mScale) >> Shift);
+            }
+
+            /// The measured TSC frequency
+            double
+            hz() const
+            {
+                return mHz;
+            }
+
+        private:
+            uint64_t mBaseTicks;
+            uint64_t mBaseNanos;
+            uint64_t mScale;
+            double mHz;
+        };
+
+        inline ClockSource
+        clock_source()
+        {
+            static const ClockSource source = []()
+            {
+                const char *var = std::getenv("RUSTLY_CLOCK");
+                if (var != nullptr && std::strcmp(var, "monotonic") == 0)
+                {
+                    return ClockSource::Monotonic;
+                }
+                return TscClock::is_invariant() ? ClockSource::Tsc : ClockSource::Monotonic;
+            }();
+            return source;
+        }
+
+        inline const TscClock &
+        tsc_clock()
+        {
+            static const TscClock clock;
+            return clock;
+        }
+
+        inline uint64_t
+        now_nanos()
+        {
+            return clock_source() == ClockSource::Tsc ? tsc_clock().nanos() : monotonic_nanos();
+        }
+    }
+
+    /// A measurement of a monotonically nondecreasing clock, useful for
+    /// measuring the time taken by an operation.
+    ///
+    /// Reads the invariant TSC when the CPU has one (calibrated once, on first
+    /// use), and `CLOCK_MONOTONIC` otherwise. Set `RUSTLY_CLOCK=monotonic` to
+    /// always use `CLOCK_MONOTONIC`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto now = Instant::now();
+    /// expensive_function();
+    /// std::cout << now.elapsed() << std::endl;
+    /// ```
+    class Instant
+    {
+    public:
+        /// Returns an instant corresponding to "now".
+        static inline Instant
+        now()
+        {
+            return Instant(detail::now_nanos());
+        }
+
+        /// Returns the clock backing `Instant::now()`.
+        static ClockSource
+        clock_source()
+        {
+            return detail::clock_source();
+        }
+
+        /// Returns the amount of time elapsed from another instant to this one,
+        /// or `None` if that instant is later than this one.
+        inline Option<Duration>
+        checked_duration_since(Instant earlier) const
+        {
+            return mNanos >= earlier.mNanos ? Option<Duration>(Duration::from_nanos(mNanos - earlier.mNanos))
+                                            : Option<Duration>();
+        }
+
+        /// Returns the amount of time elapsed from another instant to this one,
+        /// or zero duration if that instant is later than this one.
+        inline Duration
+        duration_since(Instant earlier) const
+        {
+            return checked_duration_since(earlier).unwrap_or(Duration::ZERO());
+        }
+
+        inline Duration
+        saturating_duration_since(Instant earlier) const
+        {
+            return duration_since(earlier);
+        }
+
+        /// Returns the amount of time elapsed since this instant.
+        inline Duration
+        elapsed() const
+        {
+            return now().duration_since(*this);
+        }
+
+        /// Returns `Some(t)` where `t` is the time `this + duration` if `t` can be
+        /// represented, `None` otherwise.
+        inline Option<Instant>
+        checked_add(Duration duration) const
+        {
+            uint64_t nanos;
+            if (duration.as_nanos() == std::numeric_limits<uint64_t>::max() ||
+                __builtin_add_overflow(mNanos, duration.as_nanos(), &nanos))
+            {
+                return Option<Instant>();
+            }
+            return Option<Instant>(Instant(nanos));
+        }
+
+        /// Returns `Some(t)` where `t` is the time `this - duration` if `t` can be
+        /// represented, `None` otherwise.
+        inline Option<Instant>
+        checked_sub(Duration duration) const
+        {
+            uint64_t nanos;
+            if (duration.as_nanos() == std::numeric_limits<uint64_t>::max() ||
+                __builtin_sub_overflow(mNanos, duration.as_nanos(), &nanos))
+            {
+                return Option<Instant>();
+            }
+            return Option<Instant>(Instant(nanos));
+        }
+
+        Instant operator+(Duration rhs) const { return checked_add(rhs).expect("overflow when adding duration to instant"); }
+        Instant operator-(Duration rhs) const { return checked_sub(rhs).expect("overflow when subtracting duration from instant"); }
+        Duration operator-(Instant rhs) const { return duration_since(rhs); }
+
+        constexpr bool operator==(const Instant &rhs) const = default;
+        constexpr auto operator<=>(const Instant &rhs) const = default;
+
+    private:
+        explicit Instant(uint64_t nanos) : mNanos(nanos) {}
+
+        uint64_t mNanos;
+    };
+
+    /// Anything that can record a measurement, such as a `Histogram`
+    template <class R>
+    concept Recorder = requires(R &r, uint64_t v) { r.record(v); };
+
+    /// Records the time between its construction and destruction, in
+    /// nanoseconds, into a `Recorder`.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// {
+    ///     ScopedTimer timer(parse_latency);
+    ///     parse(request);
+    /// } // Elapsed time recorded here
+    /// ```
+    template <Recorder R>
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(R &recorder) : mRecorder(recorder), mStart(Instant::now()) {}
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        ~ScopedTimer()
+        {
+            mRecorder.record(mStart.elapsed().as_nanos());
+        }
+
+    private:
+        R &mRecorder;
+        Instant mStart;
+    };
+}
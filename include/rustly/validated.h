@@ -0,0 +1,554 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <rustly/display.h>
+#include <rustly/panic.h>
+#include <rustly/result.h>
+
+namespace rustly
+{
+    /// The errors of a `Validated`, in the order they were found.
+    ///
+    /// Up to `N` errors are stored inline; beyond that they spill to a
+    /// `std::pmr::memory_resource`, e.g. an arena shared by a batch of
+    /// validations. As with `std::pmr` containers, a moved list keeps its
+    /// resource, a copied one uses the default resource, and a list that is
+    /// assigned or appended to keeps its own, moving the errors one by one
+    /// when the other list's resource differs.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::pmr::monotonic_buffer_resource arena;
+    /// ErrorList<std::string> errors("missing name", &arena);
+    /// errors.push("bad email");
+    /// assert(errors.size() == 2);
+    /// assert(errors.to_string() == "missing name; bad email");
+    /// ```
+    template <class E, size_t N = 2>
+    class ErrorList
+    {
+        static_assert(N > 0, "at least one error must be stored inline");
+        static_assert(std::is_nothrow_move_constructible_v<E>, "errors must be nothrow move constructible");
+
+    public:
+        explicit ErrorList(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) noexcept
+            : mData(inline_data()), mSize(0), mCapacity(N), mResource(resource)
+        {
+        }
+
+        explicit ErrorList(E error, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : ErrorList(resource)
+        {
+            push(std::move(error));
+        }
+
+        ErrorList(const ErrorList &other) : ErrorList()
+        {
+            reserve(other.mSize);
+            for (const auto &e : other)
+            {
+                push(e);
+            }
+        }
+
+        ErrorList(ErrorList &&other) noexcept : ErrorList(other.mResource)
+        {
+            take(other);
+        }
+
+        ErrorList &
+        operator=(const ErrorList &other)
+        {
+            if (this != &other)
+            {
+                ErrorList copy(mResource);
+                copy.reserve(other.mSize);
+                for (const auto &e : other)
+                {
+                    copy.push(e);
+                }
+                clear();
+                take(copy);
+            }
+            return *this;
+        }
+
+        /// Only allocates if `other`'s resource differs, and its errors have
+        /// spilled.
+        ErrorList &
+        operator=(ErrorList &&other)
+        {
+            if (this != &other)
+            {
+                clear();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~ErrorList()
+        {
+            clear();
+        }
+
+        void
+        push(E error)
+        {
+            if (mSize == mCapacity)
+            {
+                reserve(mCapacity * 2);
+            }
+            ::new (static_cast<void *>(mData + mSize)) E(std::move(error));
+            mSize++;
+        }
+
+        /// Moves all of `other`'s errors onto the end of this list.
+        void
+        append(ErrorList &&other)
+        {
+            if (mSize == 0)
+            {
+                *this = std::move(other);
+                return;
+            }
+            reserve(mSize + other.mSize);
+            for (auto &e : other)
+            {
+                push(std::move(e));
+            }
+            other.clear();
+        }
+
+        void
+        reserve(size_t capacity)
+        {
+            if (capacity <= mCapacity)
+            {
+                return;
+            }
+            auto *data = static_cast<E *>(mResource->allocate(capacity * sizeof(E), alignof(E)));
+            relocate(data, mData, mSize);
+            release();
+            mData = data;
+            mCapacity = static_cast<uint32_t>(capacity);
+        }
+
+        size_t
+        size() const noexcept
+        {
+            return mSize;
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return mSize == 0;
+        }
+
+        /// Returns `true` if the errors have spilled out of the inline storage.
+        bool
+        spilled() const noexcept
+        {
+            return mData != inline_data();
+        }
+
+        std::pmr::memory_resource *
+        resource() const noexcept
+        {
+            return mResource;
+        }
+
+        const E &
+        operator[](size_t i) const
+        {
+            return mData[i];
+        }
+
+        E *begin() noexcept { return mData; }
+        E *end() noexcept { return mData + mSize; }
+        const E *begin() const noexcept { return mData; }
+        const E *end() const noexcept { return mData + mSize; }
+
+        bool
+        operator==(const ErrorList &rhs) const
+        {
+            if (mSize != rhs.mSize)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < mSize; i++)
+            {
+                if (!(mData[i] == rhs.mData[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Joins the errors with `"; "`.
+        std::string
+        to_string() const noexcept
+            requires ToString<E>
+        {
+            std::string s;
+            for (size_t i = 0; i < mSize; i++)
+            {
+                s += (i == 0 ? "" : "; ") + std::to_string(mData[i]);
+            }
+            return s;
+        }
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const ErrorList &rhs)
+            requires ToString<E>
+        {
+            return os << rhs.to_string();
+        }
+
+    private:
+        E *
+        inline_data() const noexcept
+        {
+            return std::launder(reinterpret_cast<E *>(const_cast<std::byte *>(mInline)));
+        }
+
+        static void
+        relocate(E *dst, E *src, size_t n) noexcept
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                ::new (static_cast<void *>(dst + i)) E(std::move(src[i]));
+                src[i].~E();
+            }
+        }
+
+        /// Frees spilled storage, whose errors must already be destroyed
+        void
+        release() noexcept
+        {
+            if (spilled())
+            {
+                mResource->deallocate(mData, mCapacity * sizeof(E), alignof(E));
+            }
+            mData = inline_data();
+            mCapacity = N;
+        }
+
+        void
+        clear() noexcept
+        {
+            for (size_t i = 0; i < mSize; i++)
+            {
+                mData[i].~E();
+            }
+            mSize = 0;
+            release();
+        }
+
+        /// Takes `other`'s errors, into an empty list. Spilled storage is
+        /// only taken over if it came from an equal resource; otherwise the
+        /// errors are moved into this list's own.
+        void
+        take(ErrorList &other)
+        {
+            if (other.spilled() && (mResource == other.mResource || mResource->is_equal(*other.mResource)))
+            {
+                mData = other.mData;
+                mCapacity = other.mCapacity;
+                other.mData = other.inline_data();
+                other.mCapacity = N;
+            }
+            else
+            {
+                reserve(other.mSize);
+                relocate(mData, other.mData, other.mSize);
+                other.release();
+            }
+            mSize = std::exchange(other.mSize, 0);
+        }
+
+        E *mData;
+        uint32_t mSize;
+        uint32_t mCapacity;
+        std::pmr::memory_resource *mResource;
+        alignas(E) std::byte mInline[N * sizeof(E)];
+    };
+
+    /// A value of type `T`, or every error found while validating it. Unlike
+    /// `Result`, independent validations are combined with `zip` or `combine`
+    /// without stopping at the first error, so that all of them are reported
+    /// at once.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// Validated<std::string, std::string> name(const std::string &s)
+    /// {
+    ///     return s.empty() ? Invalid<std::string, std::string>("missing name") : Valid<std::string, std::string>(s);
+    /// }
+    /// Validated<int, std::string> age(int a)
+    /// {
+    ///     return a < 0 ? Invalid<int, std::string>("negative age") : Valid<int, std::string>(a);
+    /// }
+    ///
+    /// auto person = combine([](std::string n, int a) { return Person{n, a}; }, name(""), age(-1));
+    /// assert(person.errors().size() == 2);
+    /// assert(person.into_result().unwrap_err().to_string() == "missing name; negative age");
+    /// ```
+    template <class T, class E>
+    class Validated : private std::variant<T, ErrorList<E>>
+    {
+        using Base = std::variant<T, ErrorList<E>>;
+
+    public:
+        template <class... Args>
+        explicit Validated(std::in_place_index_t<0> tag, Args &&...args) : Base(tag, std::forward<Args>(args)...)
+        {
+        }
+
+        explicit Validated(std::in_place_index_t<1> tag, ErrorList<E> errors) : Base(tag, std::move(errors))
+        {
+            if (std::get<1>(*this).empty())
+            {
+                panic("an `Invalid` value must have at least one error");
+            }
+        }
+
+        /// Converts a `Result`, with its error as the only one.
+        Validated(const Result<T, E> &r)
+            : Base(r.is_ok() ? Base(std::in_place_index<0>, r.ok().unwrap())
+                             : Base(std::in_place_index<1>, ErrorList<E>(r.err().unwrap())))
+        {
+        }
+
+        bool
+        operator==(const Validated &rhs) const
+        {
+            return static_cast<const Base &>(*this) == static_cast<const Base &>(rhs);
+        }
+
+        [[nodiscard]] inline bool
+        is_valid() const
+        {
+            return this->index() == 0;
+        }
+
+        [[nodiscard]] inline bool
+        is_invalid() const
+        {
+            return this->index() == 1;
+        }
+
+        /// Returns the valid value.
+        ///
+        /// ## Panics
+        /// Panics if invalid, with the errors.
+        inline const T &
+        unwrap(const std::source_location _loc = std::source_location::current()) const &
+        {
+            check_valid(_loc);
+            return std::get<0>(*this);
+        }
+
+        inline T
+        unwrap(const std::source_location _loc = std::source_location::current()) &&
+        {
+            check_valid(_loc);
+            return std::move(std::get<0>(*this));
+        }
+
+        /// Returns the errors.
+        ///
+        /// ## Panics
+        /// Panics if valid.
+        inline const ErrorList<E> &
+        errors(const std::source_location _loc = std::source_location::current()) const &
+        {
+            check_invalid(_loc);
+            return std::get<1>(*this);
+        }
+
+        inline ErrorList<E>
+        errors(const std::source_location _loc = std::source_location::current()) &&
+        {
+            check_invalid(_loc);
+            return std::move(std::get<1>(*this));
+        }
+
+        /// Converts to a `Result` with every error, once all validations are
+        /// combined.
+        inline Result<T, ErrorList<E>>
+        into_result() &&
+        {
+            if (is_valid())
+            {
+                return Result<T, ErrorList<E>>(std::in_place_index<0>, std::move(std::get<0>(*this)));
+            }
+            return Result<T, ErrorList<E>>(std::in_place_index<1>, std::move(std::get<1>(*this)));
+        }
+
+        inline Result<T, ErrorList<E>>
+        into_result() const &
+        {
+            return Validated(*this).into_result();
+        }
+
+        /// Maps a valid value with `f`, leaving the errors untouched.
+        template <class F, class U = std::invoke_result_t<F, T &&>>
+        inline Validated<U, E>
+        map(F &&f) &&
+        {
+            if (is_valid())
+            {
+                return Validated<U, E>(std::in_place_index<0>, f(std::move(std::get<0>(*this))));
+            }
+            return Validated<U, E>(std::in_place_index<1>, std::move(std::get<1>(*this)));
+        }
+
+        /// Continues with a validation that depends on the valid value. Unlike
+        /// `zip`, this can't report the errors of both.
+        template <class F, class V = std::invoke_result_t<F, T &&>>
+        inline V
+        and_then(F &&f) &&
+        {
+            if (is_valid())
+            {
+                return f(std::move(std::get<0>(*this)));
+            }
+            return V(std::in_place_index<1>, std::move(std::get<1>(*this)));
+        }
+
+    private:
+        void
+        check_valid(const std::source_location &loc) const
+        {
+            if (is_invalid()) [[unlikely]]
+            {
+                if constexpr (ToString<E>)
+                {
+                    __panic_impl(loc, "called `Validated::unwrap()` on an `Invalid` value: {}", std::get<1>(*this).to_string());
+                }
+                else
+                {
+                    __panic_impl(loc, "called `Validated::unwrap()` on an `Invalid` value");
+                }
+            }
+        }
+
+        void
+        check_invalid(const std::source_location &loc) const
+        {
+            if (is_valid()) [[unlikely]]
+            {
+                __panic_impl(loc, "called `Validated::errors()` on a `Valid` value");
+            }
+        }
+    };
+
+    /// Construct a valid `Validated`
+    template <class T, class E>
+    inline Validated<T, E>
+    Valid(T t)
+    {
+        return Validated<T, E>(std::in_place_index<0>, std::move(t));
+    }
+
+    /// Construct an invalid `Validated`, with one error
+    template <class T, class E>
+    inline Validated<T, E>
+    Invalid(E e)
+    {
+        return Validated<T, E>(std::in_place_index<1>, ErrorList<E>(std::move(e)));
+    }
+
+    /// Construct an invalid `Validated`, with a list of errors
+    ///
+    /// ## Panics
+    /// Panics if `errors` is empty.
+    template <class T, class E>
+    inline Validated<T, E>
+    Invalid(ErrorList<E> errors)
+    {
+        return Validated<T, E>(std::in_place_index<1>, std::move(errors));
+    }
+
+    namespace detail
+    {
+        /// Moves the errors of every invalid one of `vs` into one list, in
+        /// order. The list is moved from the first, so it keeps its resource.
+        template <class E, class... Ts>
+        inline ErrorList<E>
+        collect_errors(Validated<Ts, E> &...vs)
+        {
+            std::optional<ErrorList<E>> errors;
+            auto collect = [&](auto &v)
+            {
+                if (v.is_invalid())
+                {
+                    if (errors.has_value())
+                    {
+                        errors->append(std::move(v).errors());
+                    }
+                    else
+                    {
+                        errors.emplace(std::move(v).errors());
+                    }
+                }
+            };
+            (collect(vs), ...);
+            return errors.has_value() ? std::move(*errors) : ErrorList<E>();
+        }
+    }
+
+    /// Combines independent validations into a tuple of their values, or
+    /// every error of those that are invalid, in order. The validations are
+    /// consumed.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto both = zip(Valid<int, std::string>(1), Invalid<int, std::string>("bad"));
+    /// assert(both.errors()[0] == "bad");
+    /// ```
+    template <class E, class... Ts>
+    inline Validated<std::tuple<Ts...>, E>
+    zip(Validated<Ts, E> &&...vs)
+    {
+        if ((vs.is_valid() && ...))
+        {
+            return Validated<std::tuple<Ts...>, E>(std::in_place_index<0>, std::move(vs).unwrap()...);
+        }
+        return Validated<std::tuple<Ts...>, E>(std::in_place_index<1>, detail::collect_errors(vs...));
+    }
+
+    /// Combines independent validations with `f`, if they are all valid, or
+    /// returns every error of those that are invalid, in order. The
+    /// validations are consumed.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// auto sum = combine([](int a, int b) { return a + b; }, Valid<int, std::string>(1), Valid<int, std::string>(2));
+    /// assert(sum.unwrap() == 3);
+    /// ```
+    template <class F, class E, class... Ts>
+    inline auto
+    combine(F &&f, Validated<Ts, E> &&...vs) -> Validated<std::invoke_result_t<F, Ts &&...>, E>
+    {
+        using U = std::invoke_result_t<F, Ts &&...>;
+        if ((vs.is_valid() && ...))
+        {
+            return Validated<U, E>(std::in_place_index<0>, f(std::move(vs).unwrap()...));
+        }
+        return Validated<U, E>(std::in_place_index<1>, detail::collect_errors(vs...));
+    }
+}
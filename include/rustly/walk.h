@@ -0,0 +1,584 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <rustly/option.h>
+#include <rustly/result.h>
+#include <rustly/sys.h>
+
+namespace rustly::fs
+{
+    enum class FileType : uint8_t
+    {
+        File,
+        Dir,
+        Symlink,
+        /// Devices, FIFOs and sockets
+        Other,
+    };
+
+    /// An entry found by `WalkDir`, which owns its path.
+    class DirEntry
+    {
+    public:
+        DirEntry(std::string path, size_t name_offset, FileType type, uint64_t ino, size_t depth)
+            : mPath(std::move(path)), mNameOffset(name_offset), mType(type), mIno(ino), mDepth(depth)
+        {
+        }
+
+        /// The root joined with the path to the entry.
+        std::string_view
+        path() const noexcept
+        {
+            return mPath;
+        }
+
+        /// The last component of `path()`.
+        std::string_view
+        file_name() const noexcept
+        {
+            return std::string_view(mPath).substr(mNameOffset);
+        }
+
+        /// The type of the entry itself; symbolic links aren't followed.
+        FileType
+        file_type() const noexcept
+        {
+            return mType;
+        }
+
+        bool
+        is_dir() const noexcept
+        {
+            return mType == FileType::Dir;
+        }
+
+        bool
+        is_file() const noexcept
+        {
+            return mType == FileType::File;
+        }
+
+        bool
+        is_symlink() const noexcept
+        {
+            return mType == FileType::Symlink;
+        }
+
+        uint64_t
+        ino() const noexcept
+        {
+            return mIno;
+        }
+
+        /// How many directories down from the root the entry is; the root's
+        /// children are at depth 1.
+        size_t
+        depth() const noexcept
+        {
+            return mDepth;
+        }
+
+        std::string
+        to_string() const noexcept
+        {
+            return mPath;
+        }
+
+    private:
+        std::string mPath;
+        size_t mNameOffset;
+        FileType mType;
+        uint64_t mIno;
+        size_t mDepth;
+    };
+
+    /// An error reading a directory, or finding the type of an entry in one,
+    /// which only stops the walk of that directory.
+    class WalkError
+    {
+    public:
+        WalkError(sys::Errno errno_, std::string path, size_t depth)
+            : mErrno(errno_), mPath(std::move(path)), mDepth(depth)
+        {
+        }
+
+        /// The OS error.
+        sys::Errno
+        kind() const noexcept
+        {
+            return mErrno;
+        }
+
+        /// The path of the directory or entry that the error is for.
+        std::string_view
+        path() const noexcept
+        {
+            return mPath;
+        }
+
+        size_t
+        depth() const noexcept
+        {
+            return mDepth;
+        }
+
+        /// Returns the path and the OS error, e.g. `data/private: Permission
+        /// denied (os error 13)`.
+        std::string
+        to_string() const noexcept
+        {
+            return mPath + ": " + mErrno.to_string();
+        }
+
+        bool operator==(const WalkError &rhs) const noexcept = default;
+
+        friend std::ostream &
+        operator<<(std::ostream &os, const WalkError &rhs)
+        {
+            return os << rhs.to_string();
+        }
+
+    private:
+        sys::Errno mErrno;
+        std::string mPath;
+        size_t mDepth;
+    };
+
+    /// What a `WalkDir::for_each` callback wants done next.
+    enum class WalkState
+    {
+        Continue,
+        /// Don't descend into this entry, if it's a directory
+        Skip,
+        /// Stop the walk on every thread, once each has finished the buffer
+        /// of entries it's visiting
+        Quit,
+    };
+
+    namespace detail
+    {
+        /// A directory to read, at `depth` from the root
+        struct WalkTask
+        {
+            std::string path;
+            size_t depth;
+        };
+
+        /// The directories waiting to be read, in a deque per worker. A
+        /// worker takes from the back of its own, depth first, so that it
+        /// stays short, and steals from the front of the others', taking
+        /// the shallowest, and so likely the largest, subtrees.
+        class WalkQueues
+        {
+        public:
+            explicit WalkQueues(size_t workers) : mQueues(workers) {}
+
+            void
+            push(size_t worker, WalkTask task)
+            {
+                // Counted first, so that it's never 0 while a task is queued
+                mPending.fetch_add(1, std::memory_order_relaxed);
+                {
+                    std::lock_guard lock(mQueues[worker].mutex);
+                    mQueues[worker].tasks.push_back(std::move(task));
+                }
+                // One task needs one worker
+                wake_one();
+            }
+
+            Option<WalkTask>
+            pop(size_t worker)
+            {
+                for (size_t i = 0; i < mQueues.size(); i++)
+                {
+                    auto &queue = mQueues[(worker + i) % mQueues.size()];
+                    std::lock_guard lock(queue.mutex);
+                    if (!queue.tasks.empty())
+                    {
+                        auto &taken = i == 0 ? queue.tasks.back() : queue.tasks.front();
+                        WalkTask task = std::move(taken);
+                        i == 0 ? queue.tasks.pop_back() : queue.tasks.pop_front();
+                        return Option<WalkTask>(std::move(task));
+                    }
+                }
+                return Option<WalkTask>();
+            }
+
+            /// Marks a popped task as done
+            void
+            done()
+            {
+                if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    wake();
+                }
+            }
+
+            /// Stops every worker
+            void
+            quit()
+            {
+                mQuit.store(true, std::memory_order_relaxed);
+                wake();
+            }
+
+            bool
+            quitting() const
+            {
+                return mQuit.load(std::memory_order_relaxed);
+            }
+
+            /// Returns `true` once every task is done
+            bool
+            finished() const
+            {
+                return mPending.load(std::memory_order_acquire) == 0;
+            }
+
+            /// Read before looking for a task, and passed to `wait()` if there
+            /// was none, so that a task pushed in between isn't missed
+            uint32_t
+            signal() const
+            {
+                return mSignal.load(std::memory_order_acquire);
+            }
+
+            void
+            wait(uint32_t signal) const
+            {
+                mSignal.wait(signal, std::memory_order_acquire);
+            }
+
+        private:
+            void
+            wake_one()
+            {
+                mSignal.fetch_add(1, std::memory_order_release);
+                mSignal.notify_one();
+            }
+
+            void
+            wake()
+            {
+                mSignal.fetch_add(1, std::memory_order_release);
+                mSignal.notify_all();
+            }
+
+            struct alignas(64) Queue
+            {
+                std::mutex mutex;
+                std::deque<WalkTask> tasks;
+            };
+
+            std::vector<Queue> mQueues;
+            alignas(64) std::atomic<size_t> mPending{0};
+            std::atomic<uint32_t> mSignal{0};
+            std::atomic<bool> mQuit{false};
+        };
+
+        /// Offsets in a `linux_dirent64` record
+        inline constexpr size_t DirentIno = 0;
+        inline constexpr size_t DirentReclen = 16;
+        inline constexpr size_t DirentType = 18;
+        inline constexpr size_t DirentName = 19;
+
+        inline FileType
+        file_type_of_mode(mode_t mode)
+        {
+            return S_ISDIR(mode) ? FileType::Dir : S_ISREG(mode) ? FileType::File : S_ISLNK(mode) ? FileType::Symlink : FileType::Other;
+        }
+
+        /// The type from `d_type`, or `None` if the filesystem doesn't
+        /// report it
+        inline Option<FileType>
+        file_type_of_dirent(uint8_t type)
+        {
+            switch (type)
+            {
+            case DT_REG:
+                return Option<FileType>(FileType::File);
+            case DT_DIR:
+                return Option<FileType>(FileType::Dir);
+            case DT_LNK:
+                return Option<FileType>(FileType::Symlink);
+            case DT_UNKNOWN:
+                return Option<FileType>();
+            default:
+                return Option<FileType>(FileType::Other);
+            }
+        }
+    }
+
+    /// Walks a directory tree on several threads, reading each directory
+    /// with `getdents64` into a large buffer, and taking each entry's type
+    /// from `d_type`, so that no entry is `stat`ed unless its filesystem
+    /// doesn't report types. Directories are spread over the threads by
+    /// work stealing.
+    ///
+    /// Each entry under the root is passed to the callback as a
+    /// `Result<DirEntry, WalkError>`, so that a directory that can't be read
+    /// is reported without stopping the walk of the others. Symbolic links
+    /// aren't followed. Entries come in no particular order.
+    ///
+    /// ## Examples
+    /// ```cpp
+    /// std::atomic<size_t> files = 0;
+    /// fs::WalkDir("/data").threads(8).for_each(
+    ///     [&](Result<fs::DirEntry, fs::WalkError> entry)
+    ///     {
+    ///         if (entry.is_err())
+    ///         {
+    ///             std::cerr << entry.unwrap_err() << "\n";
+    ///             return fs::WalkState::Continue;
+    ///         }
+    ///         auto e = std::move(entry).unwrap();
+    ///         files += e.is_file();
+    ///         return e.file_name() == ".git" ? fs::WalkState::Skip : fs::WalkState::Continue;
+    ///     });
+    /// ```
+    class WalkDir
+    {
+    public:
+        /// The default size of each thread's `getdents64` buffer
+        static constexpr size_t DefaultBufferSize = 256 * 1024;
+
+        explicit WalkDir(std::string root) : mRoot(std::move(root)) {}
+
+        /// Sets the number of threads, or 0, the default, for one per CPU.
+        WalkDir &
+        threads(size_t n)
+        {
+            mThreads = n;
+            return *this;
+        }
+
+        /// Reports only entries at most `depth` below the root, so 0 reports
+        /// nothing and 1 reports the root's children.
+        WalkDir &
+        max_depth(size_t depth)
+        {
+            mMaxDepth = depth;
+            return *this;
+        }
+
+        /// Sets the size of each thread's `getdents64` buffer.
+        WalkDir &
+        buffer_size(size_t bytes)
+        {
+            mBufferSize = std::max<size_t>(bytes, 4096);
+            return *this;
+        }
+
+        /// Calls `f` with each entry, or error, from every thread at once, so
+        /// `f` must be thread-safe. `f` can return a `WalkState` to skip a
+        /// directory or quit, or `void` to always continue.
+        template <class F>
+        void
+        for_each(F &&f) const
+        {
+            run([&](size_t, Result<DirEntry, WalkError> entry) { return call(f, std::move(entry)); });
+        }
+
+        /// Collects every entry, and error, in no particular order.
+        std::vector<Result<DirEntry, WalkError>>
+        collect() const
+        {
+            // Each thread appends to its own, so they're only merged at the end
+            std::vector<std::vector<Result<DirEntry, WalkError>>> found(thread_count());
+            run(
+                [&](size_t worker, Result<DirEntry, WalkError> entry)
+                {
+                    found[worker].push_back(std::move(entry));
+                    return WalkState::Continue;
+                });
+            std::vector<Result<DirEntry, WalkError>> all;
+            for (auto &entries : found)
+            {
+                std::move(entries.begin(), entries.end(), std::back_inserter(all));
+            }
+            return all;
+        }
+
+    private:
+        size_t
+        thread_count() const
+        {
+            return mThreads > 0 ? mThreads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        template <class F>
+        static WalkState
+        call(F &f, Result<DirEntry, WalkError> entry)
+        {
+            if constexpr (std::is_void_v<std::invoke_result_t<F &, Result<DirEntry, WalkError>>>)
+            {
+                f(std::move(entry));
+                return WalkState::Continue;
+            }
+            else
+            {
+                return f(std::move(entry));
+            }
+        }
+
+        /// Walks with `visit(worker, entry)` on each of the threads
+        template <class Visit>
+        void
+        run(Visit visit) const
+        {
+            if (mMaxDepth == 0)
+            {
+                return;
+            }
+            size_t workers = thread_count();
+            detail::WalkQueues queues(workers);
+            queues.push(0, detail::WalkTask{mRoot, 0});
+
+            auto work = [&](size_t worker)
+            {
+                auto buf = std::make_unique<char[]>(mBufferSize);
+                while (!queues.quitting())
+                {
+                    uint32_t signal = queues.signal();
+                    auto task = queues.pop(worker);
+                    if (task.is_none())
+                    {
+                        if (queues.finished())
+                        {
+                            return;
+                        }
+                        queues.wait(signal);
+                        continue;
+                    }
+                    if (!read_dir(std::move(task).unwrap(), buf.get(), worker, queues, visit))
+                    {
+                        queues.quit();
+                    }
+                    queues.done();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (size_t i = 1; i < workers; i++)
+            {
+                threads.emplace_back(work, i);
+            }
+            work(0);
+            for (auto &t : threads)
+            {
+                t.join();
+            }
+        }
+
+        /// Reads one directory, visiting its entries and queueing its
+        /// subdirectories. Returns `false` if the walk should quit.
+        template <class Visit>
+        bool
+        read_dir(detail::WalkTask task, char *buf, size_t worker, detail::WalkQueues &queues, Visit &visit) const
+        {
+            size_t depth = task.depth + 1;
+            // Below the root, a directory replaced by a symlink since it was
+            // read isn't followed
+            int flags = O_RDONLY | O_DIRECTORY | (task.depth > 0 ? O_NOFOLLOW : 0);
+            auto opened = sys::open(task.path.c_str(), flags);
+            if (opened.is_err())
+            {
+                return visit(worker, Err<DirEntry, WalkError>(WalkError(opened.err().unwrap(), std::move(task.path), task.depth))) !=
+                       WalkState::Quit;
+            }
+            sys::Fd dir = std::move(opened).unwrap();
+
+            std::string prefix = std::move(task.path);
+            size_t dir_len = prefix.size();
+            if (prefix.empty() || prefix.back() != '/')
+            {
+                prefix.push_back('/');
+            }
+
+            while (!queues.quitting())
+            {
+                auto filled = sys::getdents64(dir.raw(), buf, mBufferSize);
+                if (filled.is_err())
+                {
+                    return visit(worker, Err<DirEntry, WalkError>(WalkError(filled.err().unwrap(), prefix.substr(0, dir_len), task.depth))) !=
+                           WalkState::Quit;
+                }
+                size_t n = filled.unwrap();
+                if (n == 0)
+                {
+                    return true;
+                }
+                for (size_t off = 0; off < n;)
+                {
+                    uint64_t ino;
+                    uint16_t reclen;
+                    std::memcpy(&ino, buf + off + detail::DirentIno, sizeof(ino));
+                    std::memcpy(&reclen, buf + off + detail::DirentReclen, sizeof(reclen));
+                    uint8_t type = static_cast<uint8_t>(buf[off + detail::DirentType]);
+                    const char *name = buf + off + detail::DirentName;
+                    off += reclen;
+
+                    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                    {
+                        continue;
+                    }
+                    std::string path = prefix + name;
+
+                    auto file_type = detail::file_type_of_dirent(type);
+                    if (file_type.is_none())
+                    {
+                        struct stat st;
+                        if (::fstatat(dir.raw(), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                        {
+                            if (visit(worker, Err<DirEntry, WalkError>(WalkError(sys::Errno::last(), std::move(path), depth))) ==
+                                WalkState::Quit)
+                            {
+                                return false;
+                            }
+                            continue;
+                        }
+                        file_type = Option<FileType>(detail::file_type_of_mode(st.st_mode));
+                    }
+
+                    FileType kind = file_type.unwrap();
+                    bool descend = kind == FileType::Dir && depth < mMaxDepth;
+                    // Copied before visiting, since the entry takes the path,
+                    // and queued after, unless skipped
+                    std::string subdir = descend ? path : std::string();
+                    auto state = visit(worker, Ok<DirEntry, WalkError>(DirEntry(std::move(path), prefix.size(), kind, ino, depth)));
+                    if (state == WalkState::Quit)
+                    {
+                        return false;
+                    }
+                    if (descend && state != WalkState::Skip)
+                    {
+                        queues.push(worker, detail::WalkTask{std::move(subdir), depth});
+                    }
+                }
+            }
+            return true;
+        }
+
+        std::string mRoot;
+        size_t mThreads = 0;
+        size_t mMaxDepth = SIZE_MAX;
+        size_t mBufferSize = DefaultBufferSize;
+    };
+}
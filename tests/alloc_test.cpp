@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <rustly/alloc.h>
+#include <thread>
+#include <vector>
+
+using namespace rustly;
+
+// Counts every allocation in this test binary, which is built on its own
+RUSTLY_ALLOC_SHIM()
+RUSTLY_ALLOC_SHIM_MALLOC()
+
+namespace
+{
+    alloc::ScopeStats
+    stats(std::string_view name)
+    {
+        return alloc::snapshot().scope(name).unwrap();
+    }
+
+    template <class T>
+    void
+    escape(T *p)
+    {
+        asm volatile("" : : "g"(p) : "memory"); // Keep allocations from being elided
+    }
+}
+
+TEST(Alloc, Installed)
+{
+    EXPECT_TRUE(alloc::is_installed());
+    EXPECT_TRUE(alloc::snapshot().scope("(unscoped)").is_some());
+    EXPECT_TRUE(alloc::snapshot().scope("never registered").is_none());
+}
+
+TEST(Alloc, New)
+{
+    static const alloc::Scope scope("alloc_test.new");
+    auto before = stats("alloc_test.new");
+    {
+        AllocScope guard(scope);
+        auto *p = new uint64_t[8];
+        escape(p);
+        auto mid = stats("alloc_test.new");
+        EXPECT_EQ(mid.allocations - before.allocations, 1);
+        EXPECT_EQ(mid.allocated_bytes - before.allocated_bytes, 64);
+        EXPECT_EQ(mid.live_bytes() - before.live_bytes(), 64);
+        delete[] p;
+    }
+    auto after = stats("alloc_test.new");
+    EXPECT_EQ(after.deallocations - before.deallocations, 1);
+    EXPECT_EQ(after.live_bytes(), before.live_bytes());
+
+    // Outside the scope, allocations aren't attributed to it
+    auto p = std::make_unique<uint64_t>(1);
+    escape(p.get());
+    EXPECT_EQ(stats("alloc_test.new").allocations, after.allocations);
+}
+
+TEST(Alloc, Nested)
+{
+    AllocScope outer("alloc_test.outer");
+    auto *a = new uint32_t(1);
+    escape(a);
+    {
+        AllocScope inner("alloc_test.inner");
+        auto *b = new uint32_t(2);
+        escape(b);
+        EXPECT_EQ(stats("alloc_test.inner").live_bytes(), 4);
+        delete b;
+    }
+    auto *c = new uint32_t(3);
+    escape(c);
+    EXPECT_EQ(stats("alloc_test.inner").live_bytes(), 0);
+    EXPECT_EQ(stats("alloc_test.outer").live_bytes(), 8);
+    delete a;
+    delete c;
+    EXPECT_EQ(stats("alloc_test.outer").live_bytes(), 0);
+}
+
+TEST(Alloc, Aligned)
+{
+    struct alignas(256) Page
+    {
+        uint8_t data[256];
+    };
+    AllocScope guard("alloc_test.aligned");
+    auto page = std::make_unique<Page>();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(page.get()) % 256, 0);
+    EXPECT_EQ(stats("alloc_test.aligned").live_bytes(), 256);
+    page.reset();
+    EXPECT_EQ(stats("alloc_test.aligned").live_bytes(), 0);
+}
+
+TEST(Alloc, Malloc)
+{
+    AllocScope guard("alloc_test.malloc");
+    void *p = std::malloc(100);
+    escape(p);
+    EXPECT_EQ(stats("alloc_test.malloc").live_bytes(), 100);
+
+    std::memset(p, 0xab, 100);
+    p = std::realloc(p, 1000);
+    EXPECT_EQ(static_cast<uint8_t *>(p)[99], 0xab);
+    EXPECT_EQ(stats("alloc_test.malloc").live_bytes(), 1000);
+    EXPECT_EQ(malloc_usable_size(p), 1000);
+
+    auto *zeroed = static_cast<uint8_t *>(std::calloc(10, 10));
+    EXPECT_EQ(zeroed[42], 0);
+    EXPECT_EQ(stats("alloc_test.malloc").live_bytes(), 1100);
+
+    void *aligned = nullptr;
+    EXPECT_EQ(posix_memalign(&aligned, 4096, 10), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 4096, 0);
+    aligned = std::realloc(aligned, 20); // Over-aligned memory is moved, keeping its alignment
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 4096, 0);
+    EXPECT_EQ(posix_memalign(&aligned, 3, 10), EINVAL);
+
+    std::free(p);
+    std::free(zeroed);
+    std::free(aligned);
+    EXPECT_EQ(stats("alloc_test.malloc").live_bytes(), 0);
+    EXPECT_EQ(stats("alloc_test.malloc").allocations, 5); // Reallocations count as a free and an allocation
+}
+
+TEST(Alloc, Threads)
+{
+    static const alloc::Scope scope("alloc_test.threads");
+    std::vector<uint64_t *> ptrs;
+    std::thread producer([&]()
+                         {
+                             AllocScope guard(scope);
+                             for (int i = 0; i < 100; i++)
+                             {
+                                 ptrs.push_back(new uint64_t(i));
+                             } });
+    producer.join();
+
+    // Counts outlive the thread, and frees on another thread are credited to
+    // the scope that allocated
+    auto s = stats("alloc_test.threads");
+    EXPECT_GE(s.allocations, 100); // And the vector's growth
+    EXPECT_GE(s.live_bytes(), 800);
+    for (auto *p : ptrs)
+    {
+        delete p;
+    }
+    ptrs.clear();
+    ptrs.shrink_to_fit();
+    EXPECT_EQ(stats("alloc_test.threads").live_bytes(), 0);
+}
+
+TEST(Alloc, Snapshot)
+{
+    auto snap = alloc::snapshot();
+    EXPECT_EQ(snap.scopes().front().name, "(unscoped)");
+    auto total = snap.total();
+    EXPECT_GE(total.allocations, total.deallocations);
+    EXPECT_GT(total.allocations, 0);
+}
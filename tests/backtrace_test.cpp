@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <rustly/backtrace.h>
+#include <rustly/display.h>
+#include <rustly/panic.h>
+
+using namespace rustly;
+
+TEST(Backtrace, Capture)
+{
+    auto bt = Backtrace::capture();
+    if (Backtrace::enabled())
+    {
+        EXPECT_EQ(bt.status(), BacktraceStatus::Captured);
+        EXPECT_FALSE(bt.frames().empty());
+    }
+    else
+    {
+        EXPECT_EQ(bt.status(), BacktraceStatus::Disabled);
+        EXPECT_TRUE(bt.frames().empty());
+        EXPECT_EQ(bt.to_string(), "disabled backtrace\n");
+    }
+}
+
+TEST(Backtrace, ForceCapture)
+{
+    auto bt = Backtrace::force_capture();
+    EXPECT_EQ(bt.status(), BacktraceStatus::Captured);
+    EXPECT_FALSE(bt.frames().empty());
+    EXPECT_LE(bt.frames().size(), Backtrace::MaxFrames);
+
+    // Innermost frame is the caller, and symbolization is stable across renders
+    auto rendered = bt.to_string();
+    EXPECT_EQ(rendered.find("   0: Backtrace_ForceCapture_Test::TestBody()"), 0);
+    EXPECT_EQ(rendered, bt.to_string());
+    EXPECT_TRUE(ToString<Backtrace>);
+}
+
+TEST(Backtrace, Panic)
+{
+    if (Backtrace::enabled())
+    {
+        EXPECT_EXIT(panic("a message"), ::testing::KilledBySignal(SIGABRT), "a message\nstack backtrace:\n   0: ");
+    }
+    else
+    {
+        EXPECT_EXIT(panic("a message"), ::testing::KilledBySignal(SIGABRT), "a message\nnote: run with `RUST_BACKTRACE=1`");
+    }
+}
@@ -0,0 +1,132 @@
+#include <csignal>
+#include <gtest/gtest.h>
+#include <random>
+#include <rustly/bitvec.h>
+#include <vector>
+
+using namespace rustly;
+
+namespace
+{
+    constexpr cpu::Tier AllTiers[] = {cpu::Tier::Scalar, cpu::Tier::Sse42, cpu::Tier::Avx2, cpu::Tier::Avx512};
+
+    BitVec
+    random_bits(size_t len, double density, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::bernoulli_distribution bit(density);
+        BitVec v(len);
+        for (size_t i = 0; i < len; i++)
+        {
+            v.set(i, bit(rng));
+        }
+        return v;
+    }
+}
+
+TEST(BitVec, GetAndSet)
+{
+    BitVec v(100);
+    EXPECT_EQ(v.len(), 100);
+    EXPECT_EQ(v.get(3), Some(false));
+    v.set(3, true);
+    v.set(99, true);
+    EXPECT_EQ(v.get(3), Some(true));
+    EXPECT_EQ(v.get(99), Some(true));
+    EXPECT_EQ(v.get(100), None());
+    v.set(3, false);
+    EXPECT_EQ(v.get(3), Some(false));
+    EXPECT_EQ(v.count_ones(), 1);
+    EXPECT_EQ(v.count_zeros(), 99);
+
+    BitVec ones(70, true);
+    EXPECT_EQ(ones.count_ones(), 70);
+    // Bits past the end stay clear
+    EXPECT_EQ(ones.words()[1], (uint64_t(1) << 6) - 1);
+    ones.fill(false);
+    EXPECT_EQ(ones.count_ones(), 0);
+
+    BitVec pushed;
+    for (bool b : {true, false, true, true})
+    {
+        pushed.push(b);
+    }
+    std::ostringstream oss;
+    oss << pushed;
+    EXPECT_EQ(oss.str(), "1011");
+}
+
+TEST(BitVec, FindSet)
+{
+    BitVec v(300);
+    EXPECT_EQ(v.find_first_set(), None());
+    v.set(5, true);
+    v.set(64, true);
+    v.set(299, true);
+    EXPECT_EQ(v.find_first_set(), Some<size_t>(5));
+    EXPECT_EQ(v.find_next_set(5), Some<size_t>(5));
+    EXPECT_EQ(v.find_next_set(6), Some<size_t>(64));
+    EXPECT_EQ(v.find_next_set(65), Some<size_t>(299));
+    EXPECT_EQ(v.find_next_set(300), None());
+
+    std::vector<size_t> ones(v.ones().begin(), v.ones().end());
+    EXPECT_EQ(ones, (std::vector<size_t>{5, 64, 299}));
+    EXPECT_EQ(BitVec(0).ones().begin(), BitVec(0).ones().end());
+
+    auto random = random_bits(10'000, 0.01, 1);
+    std::vector<size_t> expected, found, iterated;
+    for (size_t i = 0; i < random.len(); i++)
+    {
+        if (random.test(i))
+        {
+            expected.push_back(i);
+        }
+    }
+    for (auto i = random.find_first_set(); i.is_some(); i = random.find_next_set(i.unwrap() + 1))
+    {
+        found.push_back(i.unwrap());
+    }
+    for (size_t i : random.ones())
+    {
+        iterated.push_back(i);
+    }
+    EXPECT_EQ(found, expected);
+    EXPECT_EQ(iterated, expected);
+}
+
+TEST(BitVec, BulkOpsAgreeAcrossTiers)
+{
+    // Lengths that leave a remainder after each kernel's vector width
+    for (size_t len : {1, 63, 64, 65, 255, 256, 257, 1'000, 4'099})
+    {
+        auto a = random_bits(len, 0.5, len);
+        auto b = random_bits(len, 0.3, len + 1);
+        BitVec expected_and(len), expected_or(len), expected_xor(len), expected_and_not(len);
+        uint64_t expected_count = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            expected_and.set(i, a.test(i) && b.test(i));
+            expected_or.set(i, a.test(i) || b.test(i));
+            expected_xor.set(i, a.test(i) != b.test(i));
+            expected_and_not.set(i, a.test(i) && !b.test(i));
+            expected_count += a.test(i);
+        }
+        for (auto t : AllTiers)
+        {
+            auto effective = cpu::force_tier(t);
+            EXPECT_EQ(a & b, expected_and) << len << " at " << effective;
+            EXPECT_EQ(a | b, expected_or) << len << " at " << effective;
+            EXPECT_EQ(a ^ b, expected_xor) << len << " at " << effective;
+            EXPECT_EQ(BitVec(a).and_not(b), expected_and_not) << len << " at " << effective;
+            EXPECT_EQ(a.count_ones(), expected_count) << len << " at " << effective;
+        }
+        cpu::force_tier(None());
+    }
+}
+
+TEST(BitVecDeathTest, Panics)
+{
+    BitVec a(10), b(11);
+    EXPECT_EXIT(a &= b, ::testing::KilledBySignal(SIGABRT), "panicked at .*\nbit vectors of different lengths: 10 and 11");
+    EXPECT_EXIT(a.set(10, true), ::testing::KilledBySignal(SIGABRT), "panicked at .*\nbit index 10 out of range for length 10");
+}
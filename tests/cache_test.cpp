@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <rustly/cache.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rustly;
+
+TEST(Cache, InsertAndGet)
+{
+    Cache<int, std::string> cache(2, 1);
+    EXPECT_EQ(cache.capacity(), 2);
+    EXPECT_TRUE(cache.get(1).is_none());
+    EXPECT_TRUE(cache.insert(1, "a").is_none());
+    EXPECT_TRUE(cache.insert(2, "b").is_none());
+    EXPECT_EQ(cache.get(1), Some(std::string("a")));
+    EXPECT_TRUE(cache.contains(2));
+    EXPECT_EQ(cache.size(), 2);
+
+    // Replacing returns the old value
+    EXPECT_EQ(cache.insert(2, "c"), Some(std::pair<int, std::string>(2, "b")));
+    EXPECT_EQ(cache.get(2), Some(std::string("c")));
+
+    // Full, so evicts one of the entries; both were visited, so the hand
+    // clears them and then evicts the oldest
+    auto evicted = cache.insert(3, "d");
+    EXPECT_EQ(evicted, Some(std::pair<int, std::string>(1, "a")));
+    EXPECT_EQ(cache.size(), 2);
+
+    EXPECT_EQ(cache.remove(2), Some(std::string("c")));
+    EXPECT_TRUE(cache.remove(2).is_none());
+    EXPECT_TRUE(cache.insert(4, "e").is_none());
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_TRUE(cache.get(3).is_none());
+}
+
+TEST(Cache, Sieve)
+{
+    Cache<int, int> cache(2, 1);
+    cache.insert(1, 1);
+    cache.insert(2, 2);
+    cache.get(1);
+    // The hand clears 1's visited bit, and evicts the newest entry
+    EXPECT_EQ(cache.insert(3, 3), Some(std::pair<int, int>(2, 2)));
+    // Then 1 is unvisited, and evicted next, ahead of 3
+    EXPECT_EQ(cache.insert(4, 4), Some(std::pair<int, int>(1, 1)));
+    EXPECT_EQ(cache.insert(5, 5), Some(std::pair<int, int>(3, 3)));
+    EXPECT_TRUE(cache.contains(4));
+    EXPECT_TRUE(cache.contains(5));
+}
+
+TEST(Cache, ScanResistant)
+{
+    Cache<int, int> cache(4, 1);
+    cache.insert(1, 1);
+    cache.insert(2, 2);
+    EXPECT_TRUE(cache.get(1).is_some());
+    EXPECT_TRUE(cache.get(2).is_some());
+
+    // A scan of keys that are never hit again only evicts itself
+    for (int i = 100; i < 200; i++)
+    {
+        cache.insert(i, i);
+        EXPECT_TRUE(cache.get(1).is_some());
+        EXPECT_TRUE(cache.get(2).is_some());
+    }
+    EXPECT_EQ(cache.size(), 4);
+    EXPECT_TRUE(cache.contains(199));
+    EXPECT_FALSE(cache.contains(100));
+}
+
+TEST(Cache, GetOrTryInsertWith)
+{
+    Cache<std::string, int, std::string> cache(16);
+    int calls = 0;
+    auto parse = [&](const std::string &s)
+    {
+        return cache.get_or_try_insert_with(s, [&]() -> Result<int, std::string>
+                                            {
+                                                calls++;
+                                                if (s.empty())
+                                                {
+                                                    return Err<int, std::string>("empty");
+                                                }
+                                                return Ok<int, std::string>(static_cast<int>(s.size())); });
+    };
+
+    EXPECT_EQ(parse("abc"), (Ok<int, std::string>(3)));
+    EXPECT_EQ(parse("abc"), (Ok<int, std::string>(3)));
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(cache.get("abc"), Some(3));
+
+    // Errors aren't cached without a TTL
+    EXPECT_TRUE(parse("").is_err());
+    EXPECT_TRUE(parse("").is_err());
+    EXPECT_EQ(calls, 3);
+    EXPECT_FALSE(cache.contains(""));
+}
+
+TEST(Cache, NegativeCaching)
+{
+    Cache<int, int, std::string> cache(16, Some(Duration::from_millis(50)));
+    int calls = 0;
+    auto lookup = [&]()
+    {
+        return cache.get_or_try_insert_with(7, [&]()
+                                            {
+                                                calls++;
+                                                return Err<int, std::string>("unavailable"); });
+    };
+
+    EXPECT_EQ(lookup().err(), Some(std::string("unavailable")));
+    EXPECT_EQ(lookup().err(), Some(std::string("unavailable")));
+    EXPECT_EQ(calls, 1);
+    // A cached error isn't a value
+    EXPECT_TRUE(cache.get(7).is_none());
+    EXPECT_EQ(cache.size(), 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_TRUE(lookup().is_err());
+    EXPECT_EQ(calls, 2);
+
+    // A value replaces the cached error
+    EXPECT_TRUE(cache.insert(7, 1).is_none());
+    EXPECT_EQ(lookup(), (Ok<int, std::string>(1)));
+}
+
+/// A cached error that keeps being hit is as hot as a value, and isn't
+/// evicted ahead of a scan
+TEST(Cache, NegativeCachingSurvivesEviction)
+{
+    Cache<int, int, std::string> cache(4, Some(Duration::from_secs(60)), 1);
+    int calls = 0;
+    auto lookup = [&]()
+    {
+        return cache.get_or_try_insert_with(7, [&]()
+                                            {
+                                                calls++;
+                                                return Err<int, std::string>("unavailable"); });
+    };
+
+    EXPECT_TRUE(lookup().is_err());
+    for (int i = 100; i < 200; i++)
+    {
+        cache.insert(i, i);
+        EXPECT_TRUE(lookup().is_err());
+    }
+    // Still cached, so never looked up again
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(cache.size(), 4);
+    EXPECT_TRUE(cache.contains(199));
+}
+
+TEST(Cache, Concurrent)
+{
+    Cache<int, int> cache(256, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, t]()
+                             {
+                                 for (int i = 0; i < 10'000; i++)
+                                 {
+                                     int key = (i * 7 + t) % 1'000;
+                                     auto v = cache.get_or_try_insert_with(key, [&]() { return Ok<int, Unit>(key * 2); });
+                                     ASSERT_EQ(v.ok(), Some(key * 2));
+                                     if (i % 10 == 0)
+                                     {
+                                         cache.remove(key);
+                                     }
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_LE(cache.size(), cache.capacity());
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <rustly/cmp.h>
+#include <rustly/option.h>
+#include <rustly/result.h>
+#include <sstream>
+#include <string>
+
+using namespace rustly;
+
+TEST(Ordering, Cmp)
+{
+    EXPECT_EQ(cmp(1, 2), Ordering::Less);
+    EXPECT_EQ(cmp(2, 2), Ordering::Equal);
+    EXPECT_EQ(cmp(3, 2), Ordering::Greater);
+    EXPECT_EQ(cmp(std::string("b"), std::string("a")), Ordering::Greater);
+    EXPECT_EQ(cmp(1.0, 2.0), Ordering::Less);
+}
+
+TEST(Ordering, Predicates)
+{
+    EXPECT_TRUE(Ordering::Less.is_lt());
+    EXPECT_TRUE(Ordering::Less.is_le());
+    EXPECT_TRUE(Ordering::Less.is_ne());
+    EXPECT_FALSE(Ordering::Less.is_ge());
+    EXPECT_TRUE(Ordering::Equal.is_eq());
+    EXPECT_TRUE(Ordering::Equal.is_le());
+    EXPECT_TRUE(Ordering::Equal.is_ge());
+    EXPECT_TRUE(Ordering::Greater.is_gt());
+    EXPECT_FALSE(Ordering::Greater.is_le());
+}
+
+TEST(Ordering, ReverseAndThen)
+{
+    EXPECT_EQ(Ordering::Less.reverse(), Ordering::Greater);
+    EXPECT_EQ(Ordering::Equal.reverse(), Ordering::Equal);
+    EXPECT_EQ(Ordering::Equal.then(Ordering::Less), Ordering::Less);
+    EXPECT_EQ(Ordering::Greater.then(Ordering::Less), Ordering::Greater);
+
+    int calls = 0;
+    auto less = [&]()
+    {
+        calls++;
+        return Ordering::Less;
+    };
+    EXPECT_EQ(Ordering::Greater.then_with(less), Ordering::Greater);
+    EXPECT_EQ(calls, 0);
+    EXPECT_EQ(Ordering::Equal.then_with(less), Ordering::Less);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Ordering, Conversions)
+{
+    EXPECT_EQ(Ordering(1 <=> 2), Ordering::Less);
+    EXPECT_EQ(Ordering(std::weak_ordering::equivalent), Ordering::Equal);
+    EXPECT_EQ(std::strong_ordering(Ordering::Greater), std::strong_ordering::greater);
+
+    std::ostringstream os;
+    os << Ordering::Less << " " << Ordering::Equal << " " << Ordering::Greater;
+    EXPECT_EQ(os.str(), "Less Equal Greater");
+}
+
+TEST(Ordering, Option)
+{
+    EXPECT_LT(Option<int>(), Some(-1));
+    EXPECT_LT(Some(1), Some(2));
+    EXPECT_GT(Some(2), Some(1));
+    EXPECT_LE(Option<int>(), Option<int>());
+    EXPECT_EQ(cmp(Option<int>(), Option<int>()), Ordering::Equal);
+    EXPECT_EQ(cmp(Some(std::string("a")), Option<std::string>()), Ordering::Greater);
+    EXPECT_LT(Some(std::string("a")), Some(std::string("b")));
+    // Only `Option`'s own operators, not `std::optional`'s, are candidates
+    static_assert(std::three_way_comparable<Option<int>> && std::three_way_comparable<Option<std::string>>);
+}
+
+TEST(Ordering, Result)
+{
+    using R = Result<int, std::string>;
+    EXPECT_LT(R(Ok<int, std::string>(100)), R(Err<int, std::string>("a")));
+    EXPECT_LT(R(Ok<int, std::string>(1)), R(Ok<int, std::string>(2)));
+    EXPECT_LT(R(Err<int, std::string>("a")), R(Err<int, std::string>("b")));
+    EXPECT_EQ(cmp(R(Ok<int, std::string>(1)), R(Ok<int, std::string>(1))), Ordering::Equal);
+    EXPECT_LT(Ok<std::string>(), (Err<Unit, std::string>("a")));
+}
@@ -0,0 +1,82 @@
+# Checks the disassembly of one corpus function against its rules
+#
+# Usage:
+#   cmake -DOBJDUMP=<objdump> -DMODULE=<corpus module> -DCORPUS=<corpus.cpp> -DFUNCTION=<name> -P check_codegen.cmake
+
+cmake_minimum_required(VERSION 3.20)
+
+foreach(VAR OBJDUMP MODULE CORPUS FUNCTION)
+    if(NOT DEFINED ${VAR})
+        message(FATAL_ERROR "${VAR} is not set")
+    endif()
+endforeach()
+
+# Rules
+file(READ ${CORPUS} SOURCE)
+string(REGEX MATCH "// codegen: ([^\n]*)\nextern \"C\" [^\n]*[ *&]${FUNCTION}\\(" MATCHED "${SOURCE}")
+if(NOT MATCHED)
+    message(FATAL_ERROR "no `// codegen:` rules for ${FUNCTION} in ${CORPUS}")
+endif()
+set(RULES "${CMAKE_MATCH_1}")
+if(NOT RULES MATCHES "branches=([0-9]+)")
+    message(FATAL_ERROR "${FUNCTION}: rules must set `branches=N`")
+endif()
+set(MAX_BRANCHES ${CMAKE_MATCH_1})
+set(ALLOWED "")
+if(RULES MATCHES "allow=([a-z,]+)")
+    string(REPLACE "," ";" ALLOWED "${CMAKE_MATCH_1}")
+endif()
+
+# Disassembly of the function, and of any part split out into `.text.unlikely`
+execute_process(
+    COMMAND ${OBJDUMP} -d --no-show-raw-insn ${MODULE}
+    OUTPUT_VARIABLE ASM
+    RESULT_VARIABLE RESULT
+)
+if(NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "${OBJDUMP} failed on ${MODULE}")
+endif()
+
+function(extract_symbol ASM SYMBOL OUT)
+    string(FIND "${ASM}" "<${SYMBOL}>:\n" START)
+    set(BODY "")
+    if(START GREATER_EQUAL 0)
+        string(SUBSTRING "${ASM}" ${START} -1 BODY)
+        string(FIND "${BODY}" "\n\n" END)
+        string(SUBSTRING "${BODY}" 0 ${END} BODY)
+    endif()
+    set(${OUT} "${BODY}" PARENT_SCOPE)
+endfunction()
+
+extract_symbol("${ASM}" "${FUNCTION}" HOT)
+extract_symbol("${ASM}" "${FUNCTION}.cold" COLD)
+if(HOT STREQUAL "")
+    message(FATAL_ERROR "${FUNCTION} not found in ${MODULE}")
+endif()
+set(ALL "${HOT}\n${COLD}")
+
+set(FAILURES "")
+
+# Conditional branches on the hot path: x86 `jcc`s, which is why the tests
+# are only added for x86-64
+string(REGEX MATCHALL "\tj[a-z]+ " JUMPS "${HOT}")
+list(FILTER JUMPS EXCLUDE REGEX "jmp")
+list(LENGTH JUMPS BRANCHES)
+if(BRANCHES GREATER MAX_BRANCHES)
+    list(APPEND FAILURES "${BRANCHES} conditional branches, expected at most ${MAX_BRANCHES}")
+endif()
+
+set(BANNED_function "_Function_handler|_Function_base|St8function")
+set(BANNED_new "<_Zn[wa]m|<malloc@")
+set(BANNED_panic "__panic_impl")
+foreach(KIND function new panic)
+    if(NOT KIND IN_LIST ALLOWED AND ALL MATCHES "${BANNED_${KIND}}")
+        list(APPEND FAILURES "references `${CMAKE_MATCH_0}` (allow=${KIND} not set)")
+    endif()
+endforeach()
+
+if(FAILURES)
+    string(REPLACE ";" "\n  " FAILURES "${FAILURES}")
+    message(FATAL_ERROR "${FUNCTION}:\n  ${FAILURES}\n\n${ALL}")
+endif()
+message(STATUS "${FUNCTION}: ${BRANCHES}/${MAX_BRANCHES} branches, allowed: ${ALLOWED}")
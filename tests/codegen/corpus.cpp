@@ -0,0 +1,141 @@
+// Small functions over hot combinators, compiled with optimizations and
+// checked by `check_codegen.cmake`. Each function is preceded by its rules:
+//
+//  - `branches=N`: at most `N` conditional branches
+//  - `allow=...`: lifts the default ban on references to `std::function`
+//    machinery (`function`), `operator new` (`new`), or `__panic_impl` (`panic`)
+//
+// Functions suffixed `_ok`/`_some` are given a known `Ok`/`Some` input, so
+// any remaining `__panic_impl` means the success path can panic.
+
+#include <cstdint>
+#include <rustly/option.h>
+#include <rustly/result.h>
+
+using namespace rustly;
+
+using R = Result<int32_t, uint32_t>;
+
+// codegen: branches=1
+extern "C" int32_t option_unwrap_or(const Option<int32_t> &o)
+{
+    return o.unwrap_or(7);
+}
+
+// codegen: branches=1
+extern "C" int32_t option_unwrap_or_default(const Option<int32_t> &o)
+{
+    return o.unwrap_or_default();
+}
+
+// codegen: branches=0
+extern "C" bool option_is_some(const Option<int32_t> &o)
+{
+    return o.is_some();
+}
+
+// codegen: branches=1 allow=panic
+extern "C" int32_t option_unwrap(const Option<int32_t> &o)
+{
+    return o.unwrap();
+}
+
+// codegen: branches=0
+extern "C" int32_t option_unwrap_some(int32_t x)
+{
+    return Some(x).unwrap();
+}
+
+// codegen: branches=1
+extern "C" int32_t option_map(const Option<int32_t> &o)
+{
+    return o.map<int32_t>([](int32_t x)
+                          { return x * 2; })
+        .unwrap_or(0);
+}
+
+// codegen: branches=2
+extern "C" int32_t option_and_then(const Option<int32_t> &o)
+{
+    return o.and_then<int32_t>([](int32_t x)
+                               { return x > 0 ? Some(x - 1) : Option<int32_t>(); })
+        .unwrap_or(0);
+}
+
+// codegen: branches=0
+extern "C" int32_t option_map_some(int32_t x)
+{
+    return Some(x).map<int32_t>([](int32_t x)
+                                { return x * 2; })
+        .unwrap();
+}
+
+// codegen: branches=0
+extern "C" bool option_ok_or(Option<int32_t> &o)
+{
+    return o.ok_or(1u).is_ok();
+}
+
+// codegen: branches=1
+extern "C" int32_t result_unwrap_or(const R &r)
+{
+    return r.unwrap_or(7);
+}
+
+// codegen: branches=0
+extern "C" bool result_is_ok(const R &r)
+{
+    return r.is_ok();
+}
+
+// codegen: branches=2 allow=panic
+extern "C" int32_t result_unwrap(const R &r)
+{
+    return r.unwrap();
+}
+
+// codegen: branches=0
+extern "C" int32_t result_unwrap_ok(int32_t x)
+{
+    return Ok<int32_t, uint32_t>(x).unwrap();
+}
+
+// codegen: branches=0
+extern "C" bool result_ok(const R &r)
+{
+    return r.ok().is_some();
+}
+
+// `Result`'s combinators still materialize their `std::function` argument
+
+// codegen: branches=2 allow=function
+extern "C" int32_t result_map(const R &r)
+{
+    return r.map<int32_t>([](int32_t x)
+                          { return x * 2; })
+        .unwrap_or(0);
+}
+
+// codegen: branches=2 allow=function
+extern "C" int32_t result_map_err(const R &r)
+{
+    return r.map_err<uint32_t>([](uint32_t e)
+                               { return e + 1; })
+        .unwrap_or(0);
+}
+
+// codegen: branches=3 allow=function
+extern "C" int32_t result_and_then(const R &r)
+{
+    std::function<R(int32_t)> f = [](int32_t x)
+    { return x > 0 ? Ok<int32_t, uint32_t>(x - 1) : Err<int32_t, uint32_t>(1); };
+    return r.and_then(f).unwrap_or(0);
+}
+
+// codegen: branches=0
+extern "C" int32_t result_and_then_ok(int32_t x)
+{
+    std::function<R(int32_t)> f = [](int32_t x)
+    { return Ok<int32_t, uint32_t>(x + 1); };
+    return Ok<int32_t, uint32_t>(x).and_then(f).unwrap();
+}
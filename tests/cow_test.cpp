@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <rustly/alloc.h>
+#include <rustly/cow.h>
+#include <rustly/option.h>
+#include <rustly/result.h>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+namespace
+{
+    Cow<std::string_view>
+    escape(std::string_view s)
+    {
+        if (s.find('"') == std::string_view::npos)
+        {
+            return s;
+        }
+        std::string out;
+        for (char c : s)
+        {
+            if (c == '"')
+            {
+                out.push_back('\\');
+            }
+            out.push_back(c);
+        }
+        return out;
+    }
+}
+
+TEST(Cow, BorrowedOrOwned)
+{
+    auto plain = escape("plain");
+    EXPECT_TRUE(plain.is_borrowed());
+    EXPECT_EQ(plain, "plain");
+    EXPECT_EQ(plain.to_string(), "plain");
+
+    auto quoted = escape("say \"hi\"");
+    EXPECT_TRUE(quoted.is_owned());
+    EXPECT_EQ(quoted, "say \\\"hi\\\"");
+    EXPECT_EQ(quoted.size(), 10);
+
+    // An lvalue of the owned type is borrowed, an rvalue is moved in
+    std::string s = "text";
+    Cow<std::string_view> borrowed = s;
+    EXPECT_TRUE(borrowed.is_borrowed());
+    EXPECT_EQ(borrowed.as_ref().data(), s.data());
+    Cow<std::string_view> owned = std::string("text");
+    EXPECT_TRUE(owned.is_owned());
+    EXPECT_EQ(borrowed, owned);
+
+    // A const rvalue can't be moved from, so is copied rather than borrowed
+    const std::string c = "const";
+    Cow<std::string_view> copied = std::move(c);
+    EXPECT_TRUE(copied.is_owned());
+    EXPECT_NE(copied.as_ref().data(), c.data());
+    auto make = []() -> const std::string { return "temporary"; };
+    Cow<std::string_view> from_temporary = make();
+    EXPECT_TRUE(from_temporary.is_owned());
+    EXPECT_EQ(from_temporary, "temporary");
+
+    std::ostringstream oss;
+    oss << quoted;
+    EXPECT_EQ(oss.str(), "say \\\"hi\\\"");
+}
+
+TEST(Cow, ToMut)
+{
+    std::string_view source = "abc";
+    Cow<std::string_view> c = source;
+    c.to_mut().push_back('d');
+    EXPECT_TRUE(c.is_owned());
+    const char *data = c.as_ref().data();
+    c.to_mut().push_back('e');
+    EXPECT_EQ(c, "abcde");
+    EXPECT_EQ(source, "abc");
+    // Short strings stay inline, so the second write didn't reallocate
+    EXPECT_EQ(c.as_ref().data(), data);
+}
+
+TEST(Cow, IntoOwned)
+{
+    std::string long_string(100, 'x');
+    Cow<std::string_view> owned = std::string(long_string);
+    const char *data = owned.as_ref().data();
+
+    auto before = alloc::snapshot().total().allocations;
+    std::string s = std::move(owned).into_owned();
+    EXPECT_EQ(alloc::snapshot().total().allocations, before);
+    EXPECT_EQ(s.data(), data);
+
+    Cow<std::string_view> borrowed = long_string;
+    std::string copy = borrowed.into_owned();
+    EXPECT_EQ(copy, long_string);
+    EXPECT_NE(copy.data(), long_string.data());
+    EXPECT_TRUE(borrowed.is_borrowed());
+}
+
+TEST(Cow, Span)
+{
+    std::vector<int> v = {3, 1, 2};
+    Cow<std::span<const int>> c = std::span<const int>(v);
+    EXPECT_TRUE(c.is_borrowed());
+    EXPECT_EQ(c, std::span<const int>(v));
+
+    c.to_mut().push_back(4);
+    EXPECT_TRUE(c.is_owned());
+    EXPECT_EQ(c.size(), 4);
+    EXPECT_EQ(v.size(), 3);
+    EXPECT_EQ(std::move(c).into_owned(), (std::vector<int>{3, 1, 2, 4}));
+
+    Cow<std::span<const int>> owned = std::vector<int>{1, 2};
+    EXPECT_TRUE(owned.is_owned());
+}
+
+TEST(Cow, OptionAndResult)
+{
+    std::string long_string(100, 'x');
+    Option<Cow<std::string_view>> o = Some(Cow<std::string_view>(std::string(long_string)));
+    Result<Cow<std::string_view>, int> r = Ok<Cow<std::string_view>, int>(std::string(long_string));
+
+    // Unwrapping a temporary moves the value out, rather than copying it
+    auto before = alloc::snapshot().total().allocations;
+    std::string a = std::move(o).unwrap().into_owned();
+    std::string b = std::move(r).expect("owned").into_owned();
+    EXPECT_EQ(alloc::snapshot().total().allocations, before);
+    EXPECT_EQ(a, long_string);
+    EXPECT_EQ(b, long_string);
+
+    auto none = Option<Cow<std::string_view>>();
+    EXPECT_EQ(none.map_or<size_t>(0, [](const auto &c) { return c.size(); }), 0);
+}
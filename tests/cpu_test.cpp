@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <numeric>
+#include <rustly/cpu.h>
+#include <vector>
+
+using namespace rustly;
+
+namespace
+{
+    cpu::Tier which_scalar() { return cpu::Tier::Scalar; }
+    RUSTLY_TARGET_SSE42 cpu::Tier which_sse42() { return cpu::Tier::Sse42; }
+    RUSTLY_TARGET_AVX512 cpu::Tier which_avx512() { return cpu::Tier::Avx512; }
+
+    cpu::Dispatch<cpu::Tier()> which{which_scalar, which_sse42, nullptr, which_avx512};
+
+    uint64_t
+    count_ones_scalar(const uint64_t *p, size_t n)
+    {
+        uint64_t count = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (uint64_t w = p[i]; w != 0; w &= w - 1)
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    RUSTLY_TARGET_SSE42 uint64_t
+    count_ones_sse42(const uint64_t *p, size_t n)
+    {
+        uint64_t count = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            count += static_cast<uint64_t>(__builtin_popcountll(p[i]));
+        }
+        return count;
+    }
+
+    RUSTLY_TARGET_AVX2 uint64_t
+    count_ones_avx2(const uint64_t *p, size_t n)
+    {
+        return count_ones_sse42(p, n);
+    }
+
+    cpu::Dispatch<uint64_t(const uint64_t *, size_t)> count_ones{count_ones_scalar, count_ones_sse42, count_ones_avx2};
+
+    constexpr cpu::Tier AllTiers[] = {cpu::Tier::Scalar, cpu::Tier::Sse42, cpu::Tier::Avx2, cpu::Tier::Avx512};
+}
+
+TEST(Cpu, Tier)
+{
+    EXPECT_EQ(cpu::name(cpu::Tier::Sse42), "sse4.2");
+    EXPECT_EQ(cpu::parse_tier("avx512"), Some(cpu::Tier::Avx512));
+    EXPECT_EQ(cpu::parse_tier("scalar"), Some(cpu::Tier::Scalar));
+    EXPECT_EQ(cpu::parse_tier("neon"), None());
+
+    EXPECT_LE(cpu::supported(), cpu::detect());
+    EXPECT_EQ(cpu::tier(), cpu::supported());
+    EXPECT_TRUE(cpu::has(cpu::Tier::Scalar));
+    EXPECT_TRUE(cpu::has(cpu::supported()));
+}
+
+TEST(Cpu, ForceTier)
+{
+    for (auto t : AllTiers)
+    {
+        auto effective = cpu::force_tier(t);
+        EXPECT_EQ(effective, std::min(t, cpu::supported()));
+        EXPECT_EQ(cpu::tier(), effective);
+        EXPECT_EQ(cpu::has(cpu::Tier::Avx512), effective == cpu::Tier::Avx512);
+    }
+    EXPECT_EQ(cpu::force_tier(None()), cpu::supported());
+}
+
+TEST(Cpu, Dispatch)
+{
+    for (auto t : AllTiers)
+    {
+        auto effective = cpu::force_tier(t);
+        // Missing implementations fall back to the next tier down
+        auto expected = effective == cpu::Tier::Avx2 ? cpu::Tier::Sse42 : effective;
+        EXPECT_EQ(which(), expected) << "forced " << t;
+        EXPECT_EQ(which.selected(), expected);
+        EXPECT_EQ(which.get(cpu::Tier::Avx2), which_sse42);
+    }
+    cpu::force_tier(None());
+    EXPECT_EQ(which.selected(), cpu::supported() == cpu::Tier::Avx2 ? cpu::Tier::Sse42 : cpu::supported());
+}
+
+TEST(Cpu, DispatchAgrees)
+{
+    std::vector<uint64_t> data(1000);
+    std::iota(data.begin(), data.end(), 0x0123456789abcdefull);
+    auto expected = count_ones_scalar(data.data(), data.size());
+
+    // Every tier this machine can run must compute the same result
+    for (auto t : AllTiers)
+    {
+        if (cpu::force_tier(t) == t)
+        {
+            EXPECT_EQ(count_ones(data.data(), data.size()), expected) << "forced " << t;
+        }
+    }
+    cpu::force_tier(None());
+}
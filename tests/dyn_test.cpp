@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <rustly/alloc.h>
+#include <rustly/dyn.h>
+#include <rustly/print.h>
+#include <rustly/result.h>
+#include <vector>
+
+using namespace rustly;
+
+namespace
+{
+    /// `Error` through `to_string()`
+    struct ParseError
+    {
+        int line;
+        std::string to_string() const noexcept { return "parse error on line " + std::to_string(line); }
+    };
+
+    /// `Display` through `operator<<` only
+    struct Point
+    {
+        int x, y;
+        friend std::ostream &operator<<(std::ostream &os, const Point &p) { return os << "(" << p.x << ", " << p.y << ")"; }
+    };
+
+    /// Too large to be stored inline, and counts its live instances
+    struct LargeError
+    {
+        static inline int live = 0;
+        char context[64] = "large";
+        LargeError() { live++; }
+        LargeError(const LargeError &) { live++; }
+        ~LargeError() { live--; }
+        std::string to_string() const noexcept { return context; }
+    };
+
+    std::string
+    describe(DynRef<traits::Display> d)
+    {
+        std::ostringstream oss;
+        oss << d;
+        return oss.str();
+    }
+
+    uint64_t
+    allocations()
+    {
+        return alloc::snapshot().total().allocations;
+    }
+}
+
+static_assert(sizeof(Dyn<traits::Error>) == 5 * sizeof(void *));
+static_assert(sizeof(DynRef<traits::Error>) == 2 * sizeof(void *));
+static_assert(std::is_constructible_v<Dyn<traits::Display>, Point>);
+static_assert(std::is_convertible_v<DynRef<traits::Error>, DynRef<traits::Display>>);
+static_assert(!std::is_convertible_v<DynRef<traits::Display>, DynRef<traits::Error>>);
+static_assert(Error<Dyn<traits::Error>>);
+
+TEST(Dyn, Display)
+{
+    std::vector<Dyn<traits::Display>> values;
+    values.push_back(17);
+    values.push_back(Point{1, 2});
+    values.push_back(std::string("text"));
+    values.push_back(ParseError{3});
+
+    std::ostringstream oss;
+    for (const auto &v : values)
+    {
+        oss << v << ";";
+    }
+    EXPECT_EQ(oss.str(), "17;(1, 2);text;parse error on line 3;");
+    EXPECT_EQ(values[1].to_string(), "(1, 2)");
+    EXPECT_EQ(values[3].to_string(), "parse error on line 3");
+    EXPECT_EQ(rustly::format("{}", values[1]), "(1, 2)");
+}
+
+TEST(Dyn, Error)
+{
+    auto r = Err<int, Dyn<traits::Error>>(ParseError{9});
+    EXPECT_TRUE(r.is_err());
+    EXPECT_EQ(r.unwrap_err().to_string(), "parse error on line 9");
+    EXPECT_EXIT(r.unwrap(), ::testing::KilledBySignal(SIGABRT), "parse error on line 9");
+}
+
+TEST(Dyn, Storage)
+{
+    // Small values are stored inline, including a `std::string` without a heap buffer
+    auto before = allocations();
+    {
+        Dyn<traits::Error> e = ParseError{1};
+        Dyn<traits::Error> s = std::string("short");
+        auto moved = std::move(e);
+        auto copied = s;
+        EXPECT_EQ(allocations(), before);
+        EXPECT_EQ(moved.to_string(), "parse error on line 1");
+        EXPECT_EQ(copied.to_string(), "short");
+    }
+
+    // Larger ones are boxed, and destroyed exactly once
+    {
+        Dyn<traits::Error> e = LargeError();
+        EXPECT_EQ(LargeError::live, 1);
+        auto moved = std::move(e);
+        EXPECT_EQ(LargeError::live, 1); // Moves the pointer
+        auto copied = moved;
+        EXPECT_EQ(LargeError::live, 2);
+        copied = Dyn<traits::Error>(ParseError{2});
+        EXPECT_EQ(LargeError::live, 1);
+        EXPECT_EQ(moved.to_string(), "large");
+        EXPECT_EXIT(e.to_string(), ::testing::KilledBySignal(SIGABRT), "used a moved-from `Dyn`");
+    }
+    EXPECT_EQ(LargeError::live, 0);
+}
+
+TEST(Dyn, Ref)
+{
+    auto before = allocations();
+    ParseError e{4};
+    DynRef<traits::Error> ref = e;
+    Point p{3, 4};
+    EXPECT_EQ(allocations(), before);
+
+    EXPECT_EQ(ref.to_string(), "parse error on line 4");
+    EXPECT_EQ(describe(ref), "parse error on line 4");
+    EXPECT_EQ(describe(p), "(3, 4)");
+    EXPECT_EQ(describe(5), "5");
+
+    // Borrows a `Dyn`'s value directly
+    Dyn<traits::Error> owned = LargeError();
+    DynRef<traits::Error> borrowed = owned;
+    EXPECT_EQ(describe(borrowed), "large");
+    EXPECT_EQ(describe(owned.as_ref()), "large");
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <rustly/errcode.h>
+#include <rustly/result.h>
+#include <sstream>
+
+using namespace rustly;
+
+namespace test
+{
+    enum class ParseErrc : uint32_t
+    {
+        Eof,
+        BadDigit,
+        Overflow,
+    };
+
+    enum class ApiErrc : uint32_t
+    {
+        BadRequest,
+        Internal,
+    };
+
+    /// Has its own `std::error_category`
+    enum class DbErrc : int
+    {
+        Locked = 1,
+    };
+
+    class DbCategory : public std::error_category
+    {
+    public:
+        const char *name() const noexcept override { return "db"; }
+        std::string message(int) const override { return "locked"; }
+    };
+
+    inline const std::error_category &
+    db_category() noexcept
+    {
+        static DbCategory category;
+        return category;
+    }
+}
+
+RUSTLY_ERROR_DOMAIN(test::ParseErrc, 2, "parse", "unexpected end of input", "invalid digit")
+RUSTLY_ERROR_DOMAIN(test::ApiErrc, 3, "api", "bad request", "internal error")
+
+RUSTLY_ERROR_DOMAIN_WITH_CATEGORY(test::DbErrc, 4, "db", &test::db_category, "", "database is locked")
+
+using test::ApiErrc;
+using test::DbErrc;
+using test::ParseErrc;
+
+static_assert(sizeof(ErrorCode) == 4);
+static_assert(sizeof(Result<int, ErrorCode>) == 8);
+static_assert(Error<ErrorCode>);
+
+TEST(ErrorCode, Domain)
+{
+    ErrorCode e = ParseErrc::BadDigit;
+    EXPECT_EQ(e.domain_id(), 2);
+    EXPECT_EQ(e.code(), 1u);
+    EXPECT_EQ(e.domain()->name, "parse");
+    EXPECT_EQ(e.message(), "invalid digit");
+    EXPECT_EQ(e.to_string(), "invalid digit (parse error 1)");
+    EXPECT_EQ(ErrorCode::from_raw(e.raw()), e);
+
+    EXPECT_TRUE(e.is<ParseErrc>());
+    EXPECT_FALSE(e.is<ApiErrc>());
+    EXPECT_EQ(e.as<ParseErrc>(), Some(ParseErrc::BadDigit));
+    EXPECT_EQ(e.as<ApiErrc>(), None());
+
+    EXPECT_EQ(e, ParseErrc::BadDigit);
+    EXPECT_NE(e, ParseErrc::Eof);
+    EXPECT_NE(ErrorCode(ParseErrc::Eof), ErrorCode(ApiErrc::BadRequest)); // Same code, different domains
+
+    // Codes past the end of the table
+    EXPECT_EQ(ErrorCode(ParseErrc::Overflow).message(), "unknown error");
+
+    std::ostringstream oss;
+    oss << e;
+    EXPECT_EQ(oss.str(), "invalid digit (parse error 1)");
+}
+
+TEST(ErrorCode, Os)
+{
+    auto e = ErrorCode::from_errno(ENOENT);
+    EXPECT_EQ(e.domain_id(), 0);
+    EXPECT_EQ(e.raw_os_error(), Some(ENOENT));
+    EXPECT_EQ(ErrorCode(ParseErrc::Eof).raw_os_error(), None());
+    EXPECT_EQ(e.message(), "No such file or directory");
+
+    std::ostringstream oss;
+    oss << e;
+    EXPECT_EQ(oss.str(), "No such file or directory (os error 2)");
+
+    errno = EACCES;
+    EXPECT_EQ(ErrorCode::last_os_error(), ErrorCode::from_errno(EACCES));
+}
+
+TEST(ErrorCode, ErrorCodeConversion)
+{
+    EXPECT_EQ(ErrorCode::from(std::make_error_code(std::errc::permission_denied)), Some(ErrorCode::from_errno(EACCES)));
+    EXPECT_EQ(ErrorCode::from(std::error_code(EINTR, std::system_category())), Some(ErrorCode::from_errno(EINTR)));
+
+    // A registered domain's own category
+    (void)ErrorCode(DbErrc::Locked);
+    auto db = ErrorCode::from(std::error_code(1, test::db_category()));
+    EXPECT_EQ(db, Some(ErrorCode(DbErrc::Locked)));
+    EXPECT_EQ(db.unwrap().message(), "database is locked");
+
+    EXPECT_EQ(ErrorCode::from(std::make_error_code(std::io_errc::stream)), None());
+
+    // Codes that don't fit aren't masked into others
+    EXPECT_EQ(ErrorCode::from(std::error_code((1 << 24) | 1, test::db_category())), None());
+    EXPECT_EQ(ErrorCode::from(std::error_code(-1, std::system_category())), None());
+}
+
+TEST(ErrorCode, Map)
+{
+    auto to_api = [](ParseErrc e)
+    { return e == ParseErrc::Eof ? ApiErrc::BadRequest : ApiErrc::Internal; };
+
+    ErrorCode parse = ParseErrc::Eof;
+    EXPECT_EQ(parse.map<ParseErrc>(to_api), ApiErrc::BadRequest);
+
+    ErrorCode os = ErrorCode::from_errno(EIO);
+    EXPECT_EQ(os.map<ParseErrc>(to_api), os); // Other domains pass through
+}
+
+TEST(ErrorCode, Result)
+{
+    auto parse = [](char c) -> Result<int, ErrorCode>
+    {
+        if (c < '0' || c > '9')
+        {
+            return Err<int, ErrorCode>(ParseErrc::BadDigit);
+        }
+        return Ok<int, ErrorCode>(c - '0');
+    };
+    EXPECT_EQ(parse('7'), (Ok<int, ErrorCode>(7)));
+    EXPECT_EQ(parse('x').unwrap_err(), ParseErrc::BadDigit);
+    EXPECT_EXIT(parse('x').unwrap(), ::testing::KilledBySignal(SIGABRT), "on an `Err` value: invalid digit \\(parse error 1\\)");
+}
+
+TEST(ErrorCode, OversizedCodes)
+{
+    EXPECT_EXIT(ErrorCode(static_cast<ParseErrc>(1u << 24)), ::testing::KilledBySignal(SIGABRT),
+                "error code 16777216 of domain `parse` doesn't fit in 24 bits");
+    EXPECT_EXIT(ErrorCode(static_cast<DbErrc>(-1)), ::testing::KilledBySignal(SIGABRT),
+                "error code -1 of domain `db` doesn't fit in 24 bits");
+    EXPECT_EXIT(ErrorCode::from_errno(-1), ::testing::KilledBySignal(SIGABRT), "errno -1 doesn't fit in 24 bits");
+}
+
+TEST(ErrorCode, Registration)
+{
+    static constexpr ErrorDomain clash{2, "clash", {}};
+    EXPECT_EXIT(detail::register_domain(clash), ::testing::KilledBySignal(SIGABRT),
+                "error domain 2 registered twice, for `parse` and `clash`");
+    EXPECT_EXIT(detail::register_domain(ErrorDomain{0, "zero", {}}), ::testing::KilledBySignal(SIGABRT),
+                "error domain 0 is reserved for the OS");
+}
@@ -0,0 +1,132 @@
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <rustly/fs.h>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace rustly;
+using sys::Errno;
+
+namespace
+{
+    /// A fresh path in a temporary directory, removed with it
+    class TempDir
+    {
+    public:
+        TempDir()
+        {
+            char dir[] = "/tmp/rustly_fs_XXXXXX";
+            EXPECT_NE(::mkdtemp(dir), nullptr);
+            mDir = dir;
+        }
+
+        ~TempDir()
+        {
+            std::filesystem::remove_all(mDir);
+        }
+
+        std::string
+        path(std::string_view name) const
+        {
+            return mDir + "/" + std::string(name);
+        }
+
+    private:
+        std::string mDir;
+    };
+}
+
+TEST(Fs, WriteThenRead)
+{
+    TempDir dir;
+    auto path = dir.path("a.txt");
+    EXPECT_TRUE(fs::write(path, "hello, world").is_ok());
+    EXPECT_EQ(fs::read_to_string(path), (Ok<std::string, fs::IoError>("hello, world")));
+
+    std::vector<uint8_t> bytes{0, 1, 2, 255};
+    EXPECT_TRUE(fs::write(path, bytes).is_ok());
+    EXPECT_EQ(fs::read(path).unwrap(), bytes);
+
+    // Truncates what was there
+    EXPECT_TRUE(fs::write(path, "").is_ok());
+    EXPECT_EQ(fs::read_to_string(path).unwrap(), "");
+    EXPECT_EQ(fs::read(std::filesystem::path(path)).unwrap().size(), 0);
+}
+
+TEST(Fs, LargeFile)
+{
+    TempDir dir;
+    auto path = dir.path("large");
+    std::string contents(1 << 20, '\0');
+    for (size_t i = 0; i < contents.size(); i++)
+    {
+        contents[i] = static_cast<char>(i * 31);
+    }
+    EXPECT_TRUE(fs::write(path.c_str(), contents).is_ok());
+    auto read = fs::read_to_string(path).unwrap();
+    EXPECT_EQ(read.size(), contents.size());
+    EXPECT_TRUE(read == contents);
+}
+
+/// Files in procfs report a size of 0, so are read until a read returns 0
+TEST(Fs, UnsizedFiles)
+{
+    auto status = fs::read_to_string("/proc/self/status").unwrap();
+    EXPECT_NE(status.find("Name:"), std::string::npos);
+    EXPECT_EQ(status.back(), '\n');
+
+    // Larger than the first buffer
+    auto maps = fs::read("/proc/self/maps").unwrap();
+    EXPECT_FALSE(maps.empty());
+}
+
+/// A read can return less than was asked for before the end, so reading
+/// goes on until one returns 0: here from a FIFO written in pieces
+TEST(Fs, ShortReads)
+{
+    TempDir dir;
+    auto path = dir.path("fifo");
+    ASSERT_EQ(::mkfifo(path.c_str(), 0600), 0);
+    std::thread writer([&]()
+                       {
+                           int fd = ::open(path.c_str(), O_WRONLY);
+                           for (std::string_view piece : {"first ", "second ", "third"})
+                           {
+                               EXPECT_EQ(::write(fd, piece.data(), piece.size()), ssize_t(piece.size()));
+                               std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                           }
+                           ::close(fd); });
+    EXPECT_EQ(fs::read_to_string(path).unwrap(), "first second third");
+    writer.join();
+}
+
+/// Files in sysfs can report their size, but return at most a page per read
+TEST(Fs, ShortReadsOfSizedFiles)
+{
+    const char *path = "/sys/kernel/btf/vmlinux";
+    struct stat st;
+    if (::stat(path, &st) != 0 || st.st_size <= 4096)
+    {
+        GTEST_SKIP() << path << " isn't available";
+    }
+    EXPECT_EQ(fs::read(path).unwrap().size(), size_t(st.st_size));
+}
+
+TEST(Fs, Errors)
+{
+    auto missing = fs::read_to_string("/nonexistent/file");
+    EXPECT_EQ(missing.unwrap_err().kind(), Errno(ENOENT));
+    EXPECT_EQ(missing.unwrap_err().path(), "/nonexistent/file");
+    EXPECT_EQ(missing.unwrap_err().to_string(), "/nonexistent/file: No such file or directory (os error 2)");
+
+    std::ostringstream os;
+    os << missing.unwrap_err();
+    EXPECT_EQ(os.str(), "/nonexistent/file: No such file or directory (os error 2)");
+
+    TempDir dir;
+    EXPECT_EQ(fs::read(dir.path("")).err().unwrap().kind(), Errno(EISDIR));
+    EXPECT_EQ(fs::write("/nonexistent/file", "x").unwrap_err().kind(), Errno(ENOENT));
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <rustly/alloc.h>
+#include <rustly/function.h>
+#include <string>
+
+using namespace rustly;
+
+namespace
+{
+    /// Counts live instances, to check each target is destroyed exactly once
+    struct Tracked
+    {
+        static inline int live = 0;
+        Tracked() { live++; }
+        Tracked(const Tracked &) { live++; }
+        Tracked(Tracked &&) noexcept { live++; }
+        ~Tracked() { live--; }
+    };
+
+    int
+    twice(int x)
+    {
+        return 2 * x;
+    }
+
+    uint64_t
+    allocations()
+    {
+        return alloc::snapshot().total().allocations;
+    }
+}
+
+static_assert(sizeof(FnMut<void()>) == 4 * sizeof(void *));
+static_assert(sizeof(Fn<void(), 56>) == 8 * sizeof(void *));
+static_assert(!std::is_copy_constructible_v<FnOnce<void()>>);
+static_assert(std::is_nothrow_move_constructible_v<Fn<int(int)>>);
+static_assert(std::is_constructible_v<Fn<int(int)>, int (*)(int)>);
+static_assert(!std::is_constructible_v<Fn<int(int)>, std::string>);
+
+TEST(Function, FnOnce)
+{
+    auto data = std::make_unique<std::string>("moved");
+    FnOnce<std::string()> f = [data = std::move(data)]() mutable
+    { return std::move(*data); };
+    EXPECT_TRUE(f);
+    EXPECT_EQ(std::move(f)(), "moved");
+    EXPECT_FALSE(f); // Consumed
+
+    FnOnce<void(int &)> set = [](int &x)
+    { x = 3; };
+    int x = 0;
+    std::move(set)(x);
+    EXPECT_EQ(x, 3);
+
+    EXPECT_EXIT(std::move(f)(), ::testing::KilledBySignal(SIGABRT), "panicked at .*\ncalled an empty `FnOnce`");
+}
+
+TEST(Function, FnMut)
+{
+    FnMut<int()> counter = [n = 0]() mutable
+    { return ++n; };
+    EXPECT_EQ(counter(), 1);
+    EXPECT_EQ(counter(), 2);
+
+    auto moved = std::move(counter);
+    EXPECT_FALSE(counter);
+    EXPECT_EQ(moved(), 3); // State moves with it
+
+    FnMut<int()> empty;
+    EXPECT_FALSE(empty);
+    EXPECT_EXIT(empty(), ::testing::KilledBySignal(SIGABRT), "panicked at .*\ncalled an empty `FnMut`");
+}
+
+TEST(Function, Fn)
+{
+    const Fn<int(int)> add = [k = 2](int x)
+    { return x + k; };
+    EXPECT_EQ(add(3), 5);
+
+    Fn<int(int)> f = twice;
+    EXPECT_EQ(f(4), 8);
+    f = nullptr;
+    EXPECT_FALSE(f);
+
+    // Return values convert, and are discarded for `void`
+    Fn<long(int)> widened = twice;
+    EXPECT_EQ(widened(1), 2L);
+    Fn<void(int)> discarded = twice;
+    discarded(1);
+}
+
+TEST(Function, Inline)
+{
+    struct Small
+    {
+        void *a, *b, *c;
+    };
+    struct Large
+    {
+        void *a, *b, *c, *d;
+    };
+    Small small{};
+    Large large{};
+
+    // Fits inline: no allocation, even when moved
+    auto before = allocations();
+    {
+        FnMut<void *()> f = [small]()
+        { return small.a; };
+        auto g = std::move(f);
+        EXPECT_EQ(g(), nullptr);
+    }
+    EXPECT_EQ(allocations(), before);
+
+    // Doesn't fit the default size, but does a larger one
+    {
+        FnMut<void *()> f = [large]()
+        { return large.a; };
+        EXPECT_EQ(allocations(), before + 1);
+        auto g = std::move(f); // Moves the pointer
+        EXPECT_EQ(allocations(), before + 1);
+    }
+    before = allocations();
+    {
+        FnMut<void *(), 32> f = [large]()
+        { return large.a; };
+    }
+    EXPECT_EQ(allocations(), before);
+}
+
+TEST(Function, Destruction)
+{
+    {
+        Fn<void()> inline_target = [t = Tracked()]() {};
+        FnMut<void(), 8> heap_target = [t = Tracked(), pad = std::string("large")]() {};
+        EXPECT_EQ(Tracked::live, 2);
+
+        auto moved = std::move(inline_target);
+        auto moved_heap = std::move(heap_target);
+        EXPECT_EQ(Tracked::live, 2);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+
+    // Calling an `FnOnce` destroys it, even if it throws
+    FnOnce<void()> f = [t = Tracked()]()
+    { throw std::runtime_error("oops"); };
+    EXPECT_EQ(Tracked::live, 1);
+    EXPECT_THROW(std::move(f)(), std::runtime_error);
+    EXPECT_EQ(Tracked::live, 0);
+    EXPECT_FALSE(f);
+
+    FnMut<void()> g = [t = Tracked()]() {};
+    g = [t = Tracked()]() {};
+    EXPECT_EQ(Tracked::live, 1);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <rustly/histogram.h>
+#include <thread>
+
+using namespace rustly;
+
+TEST(Histogram, Empty)
+{
+    Histogram h;
+    auto snap = h.snapshot();
+    EXPECT_TRUE(snap.is_empty());
+    EXPECT_EQ(snap.count(), 0);
+    EXPECT_EQ(snap.percentile(50.0), None());
+    EXPECT_EQ(snap.min(), None());
+    EXPECT_EQ(snap.max(), None());
+    EXPECT_TRUE(snap.mean().is_none());
+}
+
+TEST(Histogram, Percentile)
+{
+    Histogram h;
+    for (uint64_t v = 1; v <= 100; v++)
+    {
+        h.record(v);
+    }
+    auto snap = h.snapshot();
+    EXPECT_EQ(snap.count(), 100);
+    EXPECT_EQ(snap.percentile(0.0), Some<uint64_t>(1));
+    EXPECT_EQ(snap.percentile(50.0), Some<uint64_t>(50));
+    EXPECT_EQ(snap.percentile(99.0), Some<uint64_t>(99));
+    EXPECT_EQ(snap.percentile(100.0), Some<uint64_t>(100));
+    EXPECT_EQ(snap.min(), Some<uint64_t>(1));
+    EXPECT_EQ(snap.max(), Some<uint64_t>(100));
+    EXPECT_DOUBLE_EQ(snap.mean().unwrap(), 50.5);
+}
+
+TEST(Histogram, Precision)
+{
+    // Large values are bucketed, but stay within 1/128 of the true value
+    for (uint64_t v : std::initializer_list<uint64_t>{1'000, 123'456, 987'654'321, 1ull << 40, UINT64_MAX})
+    {
+        Histogram h(1);
+        h.record(v);
+        auto p = h.snapshot().percentile(100.0).unwrap();
+        EXPECT_GE(p, v);
+        EXPECT_LE((double)(p - v), (double)v / 128.0) << v;
+    }
+
+    Histogram h(1);
+    h.record(Duration::from_micros(3));
+    h.record_n(7, 3);
+    EXPECT_EQ(h.snapshot().count(), 4);
+    EXPECT_EQ(h.snapshot().percentile(75.0), Some<uint64_t>(7));
+    EXPECT_EQ(h.snapshot().max(), Some<uint64_t>(3'007)); // Bucket of [3000, 3008)
+
+    h.reset();
+    EXPECT_TRUE(h.snapshot().is_empty());
+}
+
+TEST(Histogram, Merge)
+{
+    Histogram a, b;
+    a.record(10);
+    b.record(20);
+    b.record(30);
+
+    auto snap = a.snapshot();
+    snap.merge(b.snapshot());
+    EXPECT_EQ(snap.count(), 3);
+    EXPECT_EQ(snap.min(), Some<uint64_t>(10));
+    EXPECT_EQ(snap.max(), Some<uint64_t>(30));
+}
+
+TEST(Histogram, Threads)
+{
+    Histogram h(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&h]()
+                             {
+            for (uint64_t i = 0; i < 10'000; i++)
+            {
+                h.record(i);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(h.snapshot().count(), 80'000);
+}
+
+TEST(Histogram, ScopedTimer)
+{
+    Histogram h;
+    {
+        ScopedTimer timer(h);
+    }
+    EXPECT_EQ(h.snapshot().count(), 1);
+}
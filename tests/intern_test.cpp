@@ -0,0 +1,127 @@
+#include <csignal>
+#include <gtest/gtest.h>
+#include <rustly/intern.h>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace rustly;
+
+TEST(Interner, Intern)
+{
+    Interner names;
+    EXPECT_TRUE(names.empty());
+    Symbol a = names.intern("user_id");
+    Symbol b = names.intern("order_id");
+    EXPECT_EQ(a, Symbol(0));
+    EXPECT_EQ(b, Symbol(1));
+    EXPECT_EQ(names.intern(std::string("user_") + "id"), a);
+    EXPECT_EQ(names.resolve(a), "user_id");
+    EXPECT_EQ(names.resolve(b), "order_id");
+    EXPECT_EQ(names.size(), 2);
+
+    EXPECT_EQ(names.lookup("order_id"), Some(b));
+    EXPECT_EQ(names.lookup("missing"), None());
+    EXPECT_EQ(names.size(), 2);
+
+    Symbol empty = names.intern("");
+    EXPECT_EQ(names.resolve(empty), "");
+    EXPECT_EQ(names.intern(""), empty);
+
+    std::ostringstream oss;
+    oss << a;
+    EXPECT_EQ(oss.str(), "Symbol(0)");
+    EXPECT_EQ(std::hash<Symbol>{}(a), std::hash<uint32_t>{}(0));
+}
+
+TEST(Interner, Move)
+{
+    // The empty string first, before the arena has a block
+    Interner names;
+    Symbol empty = names.intern("");
+    Symbol a = names.intern("a");
+
+    Interner moved = std::move(names);
+    EXPECT_EQ(moved.resolve(empty), "");
+    EXPECT_EQ(moved.lookup("a"), Some(a));
+
+    // The moved-from interner is empty, and still usable
+    EXPECT_TRUE(names.empty());
+    EXPECT_EQ(names.lookup("a"), None());
+    EXPECT_EQ(names.intern("b"), Symbol(0));
+    EXPECT_EQ(names.resolve(Symbol(0)), "b");
+    EXPECT_EQ(moved.resolve(a), "a");
+}
+
+TEST(Interner, Grow)
+{
+    Interner names;
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 100'000; i++)
+    {
+        Symbol sym = names.intern("ident" + std::to_string(i));
+        ASSERT_EQ(sym, Symbol(i));
+        views.push_back(names.resolve(sym));
+    }
+    // A large string gets its own arena block
+    std::string large(100'000, 'x');
+    Symbol big = names.intern(large);
+    for (int i = 0; i < 100'000; i++)
+    {
+        auto s = "ident" + std::to_string(i);
+        ASSERT_EQ(names.lookup(s), Some(Symbol(i)));
+        // Strings never move
+        ASSERT_EQ(names.resolve(Symbol(i)).data(), views[i].data());
+    }
+    EXPECT_EQ(names.resolve(big), large);
+    EXPECT_EQ(names.lookup("ident100000"), None());
+}
+
+TEST(Interner, SyncInterner)
+{
+    SyncInterner names;
+    Symbol a = names.intern("user_id");
+    EXPECT_EQ(names.intern("user_id"), a);
+    EXPECT_EQ(names.resolve(a), "user_id");
+    EXPECT_EQ(names.lookup("missing"), None());
+
+    // Threads interning overlapping strings agree on their symbols
+    constexpr int Threads = 4;
+    constexpr int Strings = 20'000;
+    std::vector<std::vector<Symbol>> symbols(Threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Threads; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 for (int i = 0; i < Strings; i++)
+                                 {
+                                     int n = (i * (t + 1)) % Strings;
+                                     Symbol sym = names.intern("s" + std::to_string(n));
+                                     ASSERT_EQ(names.resolve(sym), "s" + std::to_string(n));
+                                     symbols[t].push_back(sym);
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(names.size(), Strings + 1);
+    std::unordered_set<Symbol> distinct;
+    for (int i = 0; i < Strings; i++)
+    {
+        Symbol sym = names.lookup("s" + std::to_string(i)).unwrap();
+        distinct.insert(sym);
+        EXPECT_EQ(symbols[0][i], sym);
+    }
+    EXPECT_EQ(distinct.size(), Strings);
+}
+
+TEST(InternerDeathTest, ForeignSymbol)
+{
+    Interner names;
+    names.intern("a");
+    EXPECT_EXIT(names.resolve(Symbol(7)), ::testing::KilledBySignal(SIGABRT),
+                "panicked at .*\n7 is not from this interner, of 1 symbols");
+}
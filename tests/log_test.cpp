@@ -0,0 +1,130 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <rustly/log.h>
+#include <rustly/panic.h>
+#include <thread>
+
+using namespace rustly;
+
+class Point
+{
+public:
+    Point(int x, int y) : mX(x), mY(y) {}
+    friend std::ostream &operator<<(std::ostream &out, const Point &rhs) // Display implementation
+    {
+        out << "(" << rhs.mX << ", " << rhs.mY << ")";
+        return out;
+    }
+
+private:
+    int mX;
+    int mY;
+};
+
+class Log : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mFile = std::tmpfile();
+        logging::set_output(mFile);
+        logging::set_max_level(logging::Level::Info);
+    }
+
+    void TearDown() override
+    {
+        logging::flush();
+        logging::set_output(stderr);
+        std::fclose(mFile);
+    }
+
+    std::string output()
+    {
+        logging::flush();
+        std::string out;
+        char buf[256];
+        std::rewind(mFile);
+        while (size_t n = std::fread(buf, 1, sizeof(buf), mFile))
+        {
+            out.append(buf, n);
+        }
+        return out;
+    }
+
+    FILE *mFile;
+};
+
+TEST_F(Log, Levels)
+{
+    EXPECT_TRUE(logging::enabled(logging::Level::Error));
+    EXPECT_TRUE(logging::enabled(logging::Level::Info));
+    EXPECT_FALSE(logging::enabled(logging::Level::Debug));
+    EXPECT_FALSE(logging::enabled(logging::Level::Off));
+
+    int evaluated = 0;
+    log_debug("not evaluated {}", ++evaluated);
+    log_info("evaluated {}", ++evaluated);
+    const auto line = __LINE__ - 1;
+    EXPECT_EQ(evaluated, 1);
+
+    auto out = output();
+    EXPECT_EQ(out.find("not evaluated"), std::string::npos);
+    EXPECT_NE(out.find(" INFO  "), std::string::npos);
+    EXPECT_NE(out.find("log_test.cpp:" + std::to_string(line) + "] evaluated 1\n"), std::string::npos);
+}
+
+TEST_F(Log, Arguments)
+{
+    std::string owned("owned");
+    log_warn("{} {:>4} {:.2f} {} {} {}", "literal", 17, 1.5, owned, std::string_view("view"), true);
+    log_error("{} {}", Some(3), None<int>());
+    log_error("{} {}", Ok<int, const char *>(4), Err<int, std::string>(std::string("bad")));
+    log_error("display {}", Point(1, 2));
+    log_error("no arguments");
+
+    auto out = output();
+    EXPECT_NE(out.find("WARN  "), std::string::npos);
+    EXPECT_NE(out.find("] literal   17 1.50 owned view true\n"), std::string::npos);
+    EXPECT_NE(out.find("] Some(3) None\n"), std::string::npos);
+    EXPECT_NE(out.find("] Ok(4) Err(bad)\n"), std::string::npos);
+    EXPECT_NE(out.find("] display (1, 2)\n"), std::string::npos);
+    EXPECT_NE(out.find("] no arguments\n"), std::string::npos);
+}
+
+TEST_F(Log, Threads)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([t]()
+                             {
+            for (int i = 0; i < 1000; i++)
+            {
+                log_info("thread {} message {}", t, i);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto out = output();
+    EXPECT_EQ(std::count(out.begin(), out.end(), '\n'), 4000);
+    EXPECT_NE(out.find("thread 3 message 999\n"), std::string::npos);
+}
+
+/// The last messages before a crash are the ones most worth reading, so a
+/// panic writes them out before it aborts
+TEST(LogDeathTest, FlushedOnPanic)
+{
+    // Re-run in a fresh process, since a forked child wouldn't have the
+    // background thread, and could inherit its drain lock held
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_DEATH(
+        {
+            logging::set_output(stderr);
+            log_error("before panic {}", 1);
+            panic("boom");
+        },
+        "ERROR.*log_test\\.cpp:[0-9]+\\] before panic 1\n.*panicked at .*boom");
+}
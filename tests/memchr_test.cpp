@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <rustly/memchr.h>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+namespace
+{
+    constexpr cpu::Tier AllTiers[] = {cpu::Tier::Scalar, cpu::Tier::Sse42, cpu::Tier::Avx2, cpu::Tier::Avx512};
+
+    Option<size_t>
+    expected(size_t pos)
+    {
+        return pos == std::string_view::npos ? Option<size_t>() : Option<size_t>(pos);
+    }
+
+    std::string
+    random_string(size_t len, char alphabet, std::mt19937_64 &rng)
+    {
+        std::uniform_int_distribution<int> letter(0, alphabet - 'a');
+        std::string s(len, 'a');
+        for (char &c : s)
+        {
+            c = static_cast<char>('a' + letter(rng));
+        }
+        return s;
+    }
+}
+
+TEST(Memchr, Memchr)
+{
+    EXPECT_EQ(memchr(',', "a,b,c"), Some<size_t>(1));
+    EXPECT_EQ(memchr(';', "a,b,c"), None());
+    EXPECT_EQ(memchr('a', ""), None());
+    EXPECT_EQ(memchr('\0', std::string_view("ab\0c", 4)), Some<size_t>(2));
+    EXPECT_EQ(memchr('\xff', "abc\xff"), Some<size_t>(3));
+}
+
+TEST(Memchr, Memchr2And3)
+{
+    EXPECT_EQ(memchr2('c', 'b', "abc"), Some<size_t>(1));
+    EXPECT_EQ(memchr2('x', 'y', "abc"), None());
+    EXPECT_EQ(memchr3(',', '"', '\n', "abc\"d"), Some<size_t>(3));
+    EXPECT_EQ(memchr3('x', 'y', 'z', "abc"), None());
+}
+
+TEST(Memchr, Memrchr)
+{
+    EXPECT_EQ(memrchr(',', "a,b,c"), Some<size_t>(3));
+    EXPECT_EQ(memrchr(';', "a,b,c"), None());
+    EXPECT_EQ(memrchr('a', ""), None());
+    EXPECT_EQ(memrchr('a', "a"), Some<size_t>(0));
+}
+
+/// Every tier agrees with `std::string_view`, at every length and position,
+/// including across vector boundaries
+TEST(Memchr, AllTiersAgree)
+{
+    for (auto t : AllTiers)
+    {
+        if (cpu::force_tier(t) != t)
+        {
+            continue;
+        }
+        for (size_t n = 0; n < 200; n++)
+        {
+            std::string s(n, '.');
+            for (size_t i = 0; i < n; i++)
+            {
+                s[i] = 'x';
+                EXPECT_EQ(memchr('x', s), Some(i)) << cpu::name(t) << " " << n;
+                EXPECT_EQ(memrchr('x', s), Some(i)) << cpu::name(t) << " " << n;
+                EXPECT_EQ(memchr2('y', 'x', s), Some(i)) << cpu::name(t) << " " << n;
+                EXPECT_EQ(memchr3('y', 'z', 'x', s), Some(i)) << cpu::name(t) << " " << n;
+                s[i] = '.';
+            }
+            EXPECT_EQ(memchr('x', s), None());
+            EXPECT_EQ(memrchr('x', s), None());
+        }
+    }
+    cpu::force_tier(None());
+}
+
+TEST(Memchr, Iter)
+{
+    std::string_view s = "a\nbc\n\nd";
+    std::vector<size_t> lines(memchr_iter('\n', s).begin(), memchr_iter('\n', s).end());
+    EXPECT_EQ(lines, std::vector<size_t>({1, 4, 5}));
+
+    std::vector<size_t> v;
+    for (size_t i : memchr3_iter('a', 'c', 'd', s))
+    {
+        v.push_back(i);
+    }
+    EXPECT_EQ(v, std::vector<size_t>({0, 3, 6}));
+    EXPECT_EQ(memchr2_iter('x', 'y', s).begin(), memchr2_iter('x', 'y', s).end());
+}
+
+TEST(Memmem, Find)
+{
+    EXPECT_EQ(memmem("GET /index.html HTTP/1.1", "HTTP/"), Some<size_t>(16));
+    EXPECT_EQ(memmem("abc", ""), Some<size_t>(0));
+    EXPECT_EQ(memmem("", ""), Some<size_t>(0));
+    EXPECT_EQ(memmem("", "a"), None());
+    EXPECT_EQ(memmem("ab", "abc"), None());
+    EXPECT_EQ(memmem("abc", "c"), Some<size_t>(2));
+    EXPECT_EQ(memmem("abc", "abc"), Some<size_t>(0));
+    EXPECT_EQ(memmem("aab", "ab"), Some<size_t>(1));
+}
+
+TEST(Memmem, FinderIsReusable)
+{
+    Finder finder("ERROR");
+    EXPECT_EQ(finder.needle(), "ERROR");
+    EXPECT_EQ(finder.find("ok"), None());
+    EXPECT_EQ(finder.find("an ERROR here"), Some<size_t>(3));
+    EXPECT_EQ(finder.find("ERRORS"), Some<size_t>(0));
+}
+
+TEST(Memmem, Iter)
+{
+    std::vector<size_t> v(memmem_iter("abcabc", "bc").begin(), memmem_iter("abcabc", "bc").end());
+    EXPECT_EQ(v, std::vector<size_t>({1, 4}));
+
+    // Non-overlapping
+    v.assign(memmem_iter("aaaaa", "aa").begin(), memmem_iter("aaaaa", "aa").end());
+    EXPECT_EQ(v, std::vector<size_t>({0, 2}));
+
+    // An empty needle matches at every position, including the end
+    v.assign(memmem_iter("ab", "").begin(), memmem_iter("ab", "").end());
+    EXPECT_EQ(v, std::vector<size_t>({0, 1, 2}));
+}
+
+/// Iterators hold their search, so they outlive the range they came from
+TEST(Memmem, IterOutlivesRange)
+{
+    auto it = memmem_iter("a needle, a needle", "needle").begin();
+    EXPECT_EQ(*it, 2);
+    ++it;
+    EXPECT_EQ(*it, 12);
+
+    auto bytes = memchr_iter(',', "a,b,c").begin();
+    EXPECT_EQ(*++bytes, 3);
+}
+
+/// Small alphabets make for periodic needles, and prefilter candidates that
+/// fail, which exercises the switch to Two-Way
+TEST(Memmem, RandomAgreesWithStringView)
+{
+    std::mt19937_64 rng(7);
+    for (auto t : AllTiers)
+    {
+        if (cpu::force_tier(t) != t)
+        {
+            continue;
+        }
+        for (int round = 0; round < 3000; round++)
+        {
+            char alphabet = "abd"[round % 3];
+            std::string haystack = random_string(rng() % 300, alphabet, rng);
+            std::string needle = random_string(1 + rng() % 12, alphabet, rng);
+            EXPECT_EQ(memmem(haystack, needle), expected(std::string_view(haystack).find(needle)))
+                << cpu::name(t) << " " << haystack << " " << needle;
+        }
+    }
+    cpu::force_tier(None());
+}
+
+TEST(Memmem, PeriodicNeedles)
+{
+    for (auto t : AllTiers)
+    {
+        if (cpu::force_tier(t) != t)
+        {
+            continue;
+        }
+        for (std::string_view needle : {"abab", "aaab", "abaabaab", "aabaabaa", "abcabcabd", "zzzzzzzzzz"})
+        {
+            for (size_t n = 0; n < 100; n++)
+            {
+                std::string haystack;
+                while (haystack.size() < n)
+                {
+                    haystack += needle.substr(0, needle.size() - 1);
+                }
+                std::string found = haystack + std::string(needle);
+                EXPECT_EQ(memmem(haystack, needle), expected(std::string_view(haystack).find(needle)))
+                    << cpu::name(t) << " " << needle << " " << n;
+                EXPECT_EQ(memmem(found, needle), expected(std::string_view(found).find(needle)))
+                    << cpu::name(t) << " " << needle << " " << n;
+            }
+        }
+    }
+    cpu::force_tier(None());
+}
+
+/// The classic quadratic case for naive search: it stays linear, so it
+/// finishes quickly even on a large haystack
+TEST(Memmem, WorstCase)
+{
+    std::string haystack(1 << 20, 'a');
+    std::string needle(1000, 'a');
+    needle[500] = 'b';
+    EXPECT_EQ(memmem(haystack, needle), None());
+    haystack.replace(haystack.size() - needle.size(), needle.size(), needle);
+    EXPECT_EQ(memmem(haystack, needle), Some(haystack.size() - needle.size()));
+}
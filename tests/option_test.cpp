@@ -1,6 +1,8 @@
 #include <cmath>
 #include <gtest/gtest.h>
 #include <rustly/option.h>
+#include <string>
+#include <vector>
 #include <rustly/result.h>
 
 using namespace rustly;
@@ -182,4 +184,90 @@ TEST(Option, Result)
 // {
 //     std::vector<std::string> x = {};
 //     Some(x).begin();
-// }
\ No newline at end of file
+// }
+namespace
+{
+    /// Counts copies and moves, to check that values are updated in place
+    struct Counted
+    {
+        static inline int copies = 0;
+        static inline int moves = 0;
+        std::vector<double> data;
+        Counted(size_t n, double v) : data(n, v) {}
+        Counted(const Counted &other) : data(other.data) { copies++; }
+        Counted(Counted &&other) noexcept : data(std::move(other.data)) { moves++; }
+        Counted &operator=(const Counted &) = default;
+        bool operator==(const Counted &) const = default;
+    };
+}
+
+TEST(Option, Insert)
+{
+    auto x = None<uint32_t>();
+    auto &v = x.insert(1);
+    v = 3;
+    EXPECT_EQ(x, Some(3u));
+    x.insert(4);
+    EXPECT_EQ(x, Some(4u));
+
+    EXPECT_EQ(x.get_or_insert(7), 4u);
+    x.take();
+    x.get_or_insert(7) += 1;
+    EXPECT_EQ(x, Some(8u));
+
+    Option<std::string> s;
+    int n = 0;
+    s.get_or_insert_with([&]() { n++; return std::string("computed"); }).append("!");
+    s.get_or_insert_with([&]() { n++; return std::string("again"); });
+    EXPECT_EQ(s, Some(std::string("computed!")));
+    EXPECT_EQ(n, 1); // Only called when `None`
+
+    Option<std::vector<int>> d;
+    d.get_or_insert_default().push_back(1);
+    d.get_or_insert_default().push_back(2);
+    EXPECT_EQ(d.unwrap().size(), 2u);
+}
+
+TEST(Option, Emplace)
+{
+    Counted::copies = Counted::moves = 0;
+    Option<Counted> x;
+    x.emplace(1024, 1.0);
+    x.emplace(16, 2.0); // Replaces
+    EXPECT_EQ(Counted::copies, 0);
+    EXPECT_EQ(Counted::moves, 0);
+
+    // Updating in place, rather than `x = Some(f(x.unwrap()))`
+    x.get_or_insert_with([]() { return Counted(1, 0.0); }).data.push_back(3.0);
+    EXPECT_EQ(Counted::copies, 0);
+    EXPECT_EQ(Counted::moves, 0);
+
+    auto taken = x.take();
+    EXPECT_EQ(Counted::copies, 0);
+    EXPECT_TRUE(x.is_none());
+    EXPECT_EQ(taken.unwrap().data.size(), 17u);
+}
+
+TEST(Option, Take)
+{
+    auto x = Some(2);
+    auto y = x.take();
+    EXPECT_EQ(x, None());
+    EXPECT_EQ(y, Some(2));
+    EXPECT_EQ(x.take(), None());
+
+    auto even = Some(42);
+    EXPECT_EQ(even.take_if([](int &v) { return v % 2 == 0; }), Some(42));
+    EXPECT_EQ(even, None());
+
+    auto odd = Some(43);
+    EXPECT_EQ(odd.take_if([](int &v) { v++; return false; }), None());
+    EXPECT_EQ(odd, Some(44)); // Modified, but kept
+
+    auto r = Some(2);
+    EXPECT_EQ(r.replace(5), Some(2));
+    EXPECT_EQ(r, Some(5));
+    auto n = None<int>();
+    EXPECT_EQ(n.replace(1), None());
+    EXPECT_EQ(n, Some(1));
+}
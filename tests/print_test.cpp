@@ -0,0 +1,115 @@
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <rustly/panic.h>
+#include <rustly/print.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace rustly;
+
+class Name
+{
+public:
+    Name(const std::string &data) : mData(data) {}
+    const std::string to_string() noexcept { return mData; } // ToString<Name>
+
+private:
+    std::string mData;
+};
+
+class Coord
+{
+public:
+    Coord(int x, int y) : mX(x), mY(y) {}
+    friend std::ostream &operator<<(std::ostream &out, const Coord &rhs) // Display implementation
+    {
+        out << "(" << rhs.mX << ", " << rhs.mY << ")";
+        return out;
+    }
+
+private:
+    int mX;
+    int mY;
+};
+
+/// `print` is a function, so it doesn't collide with members of that name
+struct Report
+{
+    std::string
+    print() const
+    {
+        return "report";
+    }
+};
+
+TEST(Print, Format)
+{
+    EXPECT_EQ(rustly::format("test"), "test");
+    EXPECT_EQ(rustly::format("hello {}", "world!"), "hello world!");
+    EXPECT_EQ(rustly::format("x = {}, y = {:>3}", 10, 30), "x = 10, y =  30");
+    EXPECT_EQ(rustly::format("{} {}", std::string("owned"), std::string_view("view")), "owned view");
+
+    // Display types without a `std::formatter`
+    EXPECT_EQ(rustly::format("{}", Coord(1, 2)), "(1, 2)");
+    EXPECT_EQ(rustly::format("[{:>8}]", Name("foo")), "[     foo]");
+}
+
+TEST(Print, Write)
+{
+    std::string out;
+    rustly::write(out, "test");
+    rustly::write(out, " {}", 17);
+    EXPECT_EQ(out, "test 17");
+
+    out.clear();
+    rustly::writeln(out, "test");
+    rustly::writeln(out, "{} {}", "formatted", Coord(3, 4));
+    EXPECT_EQ(out, "test\nformatted (3, 4)\n");
+
+    std::vector<char> bytes;
+    rustly::write(bytes, "{}", 42);
+    EXPECT_EQ(std::string(bytes.begin(), bytes.end()), "42");
+}
+
+TEST(Print, Println)
+{
+    testing::internal::CaptureStdout();
+    print("a");
+    print("{} ", 1);
+    println("{}", Coord(5, 6));
+    println();
+    io::flush();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "a1 (5, 6)\n\n");
+
+    testing::internal::CaptureStderr();
+    eprint("error: ");
+    eprintln("{}", Name("unbuffered"));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "error: unbuffered\n");
+}
+
+TEST(Print, NotAMacro)
+{
+    EXPECT_EQ(Report().print(), "report");
+}
+
+/// Output still in the buffer when panicking is written out first
+TEST(PrintDeathTest, FlushedOnPanic)
+{
+    char path[] = "/tmp/rustly_print_XXXXXX";
+    int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+    EXPECT_EXIT(
+        {
+            ::dup2(fd, STDOUT_FILENO);
+            println("before panic {}", 1);
+            panic("boom");
+        },
+        ::testing::KilledBySignal(SIGABRT), "boom");
+    char buf[64] = {};
+    EXPECT_EQ(::pread(fd, buf, sizeof(buf) - 1, 0), 15);
+    EXPECT_STREQ(buf, "before panic 1\n");
+    ::close(fd);
+    ::unlink(path);
+}
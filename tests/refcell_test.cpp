@@ -0,0 +1,85 @@
+#include <csignal>
+#include <gtest/gtest.h>
+#include <rustly/refcell.h>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+TEST(RefCell, Borrow)
+{
+    const RefCell<std::vector<int>> cell(std::vector<int>{1, 2});
+    cell.borrow_mut()->push_back(3);
+    {
+        auto a = cell.borrow();
+        auto b = cell.borrow();
+        auto c = b;
+        EXPECT_EQ(a->size(), 3);
+        EXPECT_EQ(&*a, &c.get());
+        EXPECT_TRUE(cell.try_borrow().is_ok());
+        EXPECT_EQ(cell.try_borrow_mut().err().unwrap(), BorrowMutError{});
+    }
+    {
+        auto m = cell.borrow_mut();
+        m->push_back(4);
+        EXPECT_EQ(cell.try_borrow().err().unwrap(), BorrowError{});
+        EXPECT_TRUE(cell.try_borrow_mut().is_err());
+    }
+    // Every borrow was released
+    auto m = cell.try_borrow_mut().unwrap();
+    EXPECT_EQ(*m, (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST(RefCell, MovedGuards)
+{
+    RefCell<int> cell(1);
+    {
+        auto r = cell.try_borrow().unwrap();
+        auto moved = std::move(r);
+        EXPECT_EQ(*moved, 1);
+        EXPECT_TRUE(cell.try_borrow_mut().is_err());
+    }
+    {
+        auto m = cell.try_borrow_mut().unwrap();
+        auto moved = std::move(m);
+        *moved = 2;
+    }
+    EXPECT_EQ(*cell.borrow(), 2);
+    cell.get_mut() = 3;
+    EXPECT_EQ(cell.replace(4), 3);
+    EXPECT_EQ(cell.take(), 4);
+    EXPECT_EQ(std::move(cell).into_inner(), 0);
+
+    EXPECT_EQ(BorrowError{}.to_string(), "already mutably borrowed");
+    EXPECT_EQ(BorrowMutError{}.to_string(), "already borrowed");
+}
+
+TEST(RefCell, Size)
+{
+    // The borrow flag is a single word
+    static_assert(sizeof(RefCell<intptr_t>) == 2 * sizeof(intptr_t));
+    static_assert(sizeof(Ref<int>) == 2 * sizeof(void *));
+}
+
+TEST(RefCellDeathTest, Conflicts)
+{
+    RefCell<std::string> cell("text");
+    EXPECT_EXIT(
+        {
+            auto r = cell.borrow();
+            auto m = cell.borrow_mut();
+        },
+        ::testing::KilledBySignal(SIGABRT), "panicked at .*\nalready borrowed: BorrowMutError");
+    EXPECT_EXIT(
+        {
+            auto m = cell.borrow_mut();
+            auto r = cell.borrow();
+        },
+        ::testing::KilledBySignal(SIGABRT), "panicked at .*\nalready mutably borrowed: BorrowError");
+    EXPECT_EXIT(
+        {
+            auto r = cell.borrow();
+            cell.replace("other");
+        },
+        ::testing::KilledBySignal(SIGABRT), "panicked at .*\nalready borrowed: BorrowMutError");
+}
@@ -1,6 +1,7 @@
 #include <cmath>
 #include <gtest/gtest.h>
 #include <rustly/result.h>
+#include <vector>
 
 using namespace rustly;
 
@@ -242,4 +243,102 @@ TEST(Result, Unwrap)
     EXPECT_EQ(x.unwrap_err(), 17);
     EXPECT_EQ(y.unwrap_err(), FooBar{});
     EXPECT_EXIT(z.unwrap_err(), ::testing::KilledBySignal(SIGABRT), "panicked at .*\ncalled `Result::unwrap_err\\(\\)` on an `Ok` value: 1");
-}
\ No newline at end of file
+}
+namespace
+{
+    /// Counts copies, to check that results don't make any
+    struct Counted
+    {
+        static inline int copies = 0;
+        int value;
+        explicit Counted(int v) : value(v) {}
+        Counted(const Counted &other) : value(other.value) { copies++; }
+        Counted(Counted &&other) noexcept : value(other.value) {}
+        Counted &operator=(const Counted &) = default;
+        bool operator==(const Counted &rhs) const { return value == rhs.value; }
+        std::string to_string() const noexcept { return std::to_string(value); }
+    };
+
+    Result<Counted &, int>
+    lookup(std::vector<Counted> &rows, size_t i)
+    {
+        if (i >= rows.size())
+        {
+            return Err<Counted &, int>(-1);
+        }
+        return Ok<Counted &, int>(rows[i]);
+    }
+
+    template <class R>
+    concept HasOk = requires(const R &r) { r.ok(); };
+
+    template <class R>
+    concept HasUnwrapOrDefault = requires(const R &r) { r.unwrap_or_default(); };
+}
+
+static_assert(sizeof(Result<Counted &, int>) == 2 * sizeof(void *));
+static_assert(sizeof(Result<Unit, int>) == 2 * sizeof(int));
+static_assert(sizeof(Result<Unit, uint8_t>) == 2);
+
+TEST(Result, Reference)
+{
+    std::vector<Counted> rows;
+    rows.emplace_back(1);
+    rows.emplace_back(2);
+    Counted::copies = 0;
+
+    auto r = lookup(rows, 1);
+    EXPECT_TRUE(r.is_ok());
+    EXPECT_EQ(&r.unwrap(), &rows[1]); // The element itself
+    EXPECT_EQ(r.expect("present").value, 2);
+    r.unwrap().value = 20;
+    EXPECT_EQ(rows[1].value, 20);
+
+    auto copy = r;
+    EXPECT_EQ(copy, r);
+    EXPECT_EQ(copy.map<int>([](Counted &c) { return c.value; }), (Ok<int, int>(20)));
+    EXPECT_EQ(lookup(rows, 5).unwrap_err(), -1);
+    EXPECT_EQ(&lookup(rows, 5).unwrap_or(rows[0]), &rows[0]);
+    EXPECT_EQ(Counted::copies, 0);
+
+    // An `Option` can't hold the reference, and there's no default to refer to
+    static_assert(!HasOk<Result<Counted &, int>> && !HasUnwrapOrDefault<Result<Counted &, int>>);
+    static_assert(HasOk<Result<int, int>> && HasUnwrapOrDefault<Result<int, int>>);
+}
+
+TEST(Result, NoCopies)
+{
+    Counted::copies = 0;
+    auto x = Ok<Counted, int>(Counted(1));
+    auto y = Err<int, Counted>(Counted(2));
+    EXPECT_EQ(Counted::copies, 0); // Moved in
+
+    auto z = Result<Counted, int>(std::in_place_index<0>, 3);
+    EXPECT_EQ(z.unwrap().value, 3);
+    EXPECT_EQ(Counted::copies, 1); // `unwrap()` returns a copy
+    EXPECT_TRUE(x.is_ok() && y.is_err());
+}
+
+TEST(Result, Unit)
+{
+    auto ok = Ok<std::string>();
+    EXPECT_TRUE(ok.is_ok());
+    EXPECT_EQ(ok, (Ok<Unit, std::string>(Unit())));
+    EXPECT_EQ(ok.unwrap(), Unit());
+
+    auto err = Err<Unit, std::string>("failed");
+    EXPECT_NE(ok, err);
+    EXPECT_EQ(err.unwrap_err(), "failed");
+    EXPECT_EXIT(ok.unwrap_err(), ::testing::KilledBySignal(SIGABRT), "on an `Ok` value: \\(\\)");
+}
+
+TEST(Result, SameTypes)
+{
+    // `Ok` and `Err` of the same type are told apart
+    auto x = Ok<int, int>(2);
+    auto y = Err<int, int>(2);
+    EXPECT_NE(x, y);
+    EXPECT_EQ(x.map<int>([](int v) { return v * 2; }), (Ok<int, int>(4)));
+    EXPECT_EQ(y.map<int>([](int v) { return v * 2; }), (Err<int, int>(2)));
+    EXPECT_EQ(y.map_err<int>([](int v) { return v + 1; }), (Err<int, int>(3)));
+}
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <csignal>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <rustly/option.h>
+#include <rustly/result.h>
+#include <rustly/sort.h>
+#include <string>
+#include <vector>
+
+using namespace rustly;
+
+namespace
+{
+    /// Random values in `[0, max]`, sorted, reversed, or organ-pipe shaped
+    enum class Pattern
+    {
+        Random,
+        Sorted,
+        Reversed,
+        OrganPipe,
+        SortedRuns,
+    };
+
+    std::vector<int>
+    generate(size_t n, int max, Pattern pattern, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<int> value(0, max);
+        std::vector<int> v(n);
+        for (int &x : v)
+        {
+            x = value(rng);
+        }
+        switch (pattern)
+        {
+        case Pattern::Random:
+            break;
+        case Pattern::Sorted:
+            std::sort(v.begin(), v.end());
+            break;
+        case Pattern::Reversed:
+            std::sort(v.begin(), v.end(), std::greater<int>());
+            break;
+        case Pattern::OrganPipe:
+            std::sort(v.begin(), v.begin() + n / 2);
+            std::sort(v.begin() + n / 2, v.end(), std::greater<int>());
+            break;
+        case Pattern::SortedRuns:
+            for (size_t i = 0; i < n; i += 100)
+            {
+                std::sort(v.begin() + i, v.begin() + std::min(n, i + 100));
+            }
+            break;
+        }
+        return v;
+    }
+
+    constexpr Pattern AllPatterns[] = {Pattern::Random, Pattern::Sorted, Pattern::Reversed, Pattern::OrganPipe,
+                                       Pattern::SortedRuns};
+    constexpr size_t Sizes[] = {0, 1, 2, 3, 10, 23, 24, 25, 33, 100, 129, 1000, 10'007};
+
+    /// An element whose `id` records its original position, to check
+    /// stability
+    struct Tagged
+    {
+        int key;
+        size_t id;
+    };
+
+    std::vector<Tagged>
+    tag(const std::vector<int> &v)
+    {
+        std::vector<Tagged> tagged;
+        for (size_t i = 0; i < v.size(); i++)
+        {
+            tagged.push_back({v[i], i});
+        }
+        return tagged;
+    }
+
+    void
+    expect_stably_sorted(const std::vector<Tagged> &v)
+    {
+        for (size_t i = 1; i < v.size(); i++)
+        {
+            ASSERT_TRUE(v[i - 1].key < v[i].key || (v[i - 1].key == v[i].key && v[i - 1].id < v[i].id)) << "at " << i;
+        }
+    }
+}
+
+TEST(Sort, Sort)
+{
+    std::vector<int> v = {5, 4, 1, 3, 2};
+    sort(v);
+    EXPECT_EQ(v, std::vector<int>({1, 2, 3, 4, 5}));
+
+    std::array<std::string, 3> a = {"b", "c", "a"};
+    sort(a);
+    EXPECT_EQ(a, (std::array<std::string, 3>{"a", "b", "c"}));
+
+    std::vector<int> empty;
+    sort(empty);
+    sort_unstable(empty);
+    EXPECT_TRUE(empty.empty());
+}
+
+TEST(Sort, SortIsStable)
+{
+    for (auto pattern : AllPatterns)
+    {
+        for (size_t n : Sizes)
+        {
+            for (int max : {3, 1'000'000})
+            {
+                auto v = tag(generate(n, max, pattern, n));
+                sort_by_key(v, [](const Tagged &t) { return t.key; });
+                expect_stably_sorted(v);
+
+                v = tag(generate(n, max, pattern, n + 1));
+                sort_by(v, [](const Tagged &a, const Tagged &b) { return cmp(a.key, b.key); });
+                expect_stably_sorted(v);
+
+                v = tag(generate(n, max, pattern, n + 2));
+                sort_by_cached_key(v, [](const Tagged &t) { return std::to_string(t.key + 1'000'000'000); });
+                expect_stably_sorted(v);
+            }
+        }
+    }
+}
+
+TEST(Sort, SortUnstableAgreesWithStdSort)
+{
+    for (auto pattern : AllPatterns)
+    {
+        for (size_t n : Sizes)
+        {
+            for (int max : {0, 3, 1'000'000})
+            {
+                auto v = generate(n, max, pattern, n);
+                auto expected = v;
+                std::sort(expected.begin(), expected.end());
+
+                auto a = v;
+                sort_unstable(a);
+                EXPECT_EQ(a, expected);
+
+                // Not arithmetic, so not the branchless partition
+                std::vector<std::string> s;
+                std::vector<std::string> s_expected;
+                for (int x : v)
+                {
+                    s.push_back(std::to_string(x));
+                }
+                s_expected = s;
+                std::sort(s_expected.begin(), s_expected.end());
+                sort_unstable(s);
+                EXPECT_EQ(s, s_expected);
+
+                auto b = v;
+                sort_unstable_by(b, [](int x, int y) { return cmp(x, y).reverse(); });
+                EXPECT_TRUE(std::is_sorted(b.begin(), b.end(), std::greater<int>()));
+
+                auto c = v;
+                sort_unstable_by_key(c, [](int x) { return -x; });
+                EXPECT_TRUE(std::is_sorted(c.begin(), c.end(), std::greater<int>()));
+            }
+        }
+    }
+}
+
+/// A pattern that drives naive median-of-three quicksort quadratic; with
+/// the heapsort fallback this finishes quickly
+TEST(Sort, SortUnstableKiller)
+{
+    constexpr size_t N = 1 << 16;
+    std::vector<int> v(N);
+    for (size_t i = 0; i < N / 2; i++)
+    {
+        v[2 * i] = static_cast<int>(i + 1);
+        v[2 * i + 1] = static_cast<int>(N / 2 + i + 1);
+    }
+    std::rotate(v.begin(), v.begin() + N / 4, v.end());
+    sort_unstable(v);
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
+
+/// Comparisons that aren't a strict weak order may misorder, but must keep
+/// every element and stay within the slice
+TEST(Sort, InconsistentComparisons)
+{
+    for (size_t n : Sizes)
+    {
+        std::vector<double> v;
+        for (int x : generate(n, 100, Pattern::Random, n))
+        {
+            v.push_back(x % 7 == 0 ? std::nan("") : x);
+        }
+        // NaNs don't compare equal, so elements are compared by their bits
+        auto bits = [](double x) { return std::bit_cast<uint64_t>(x); };
+        auto by_bits = [&](double a, double b) { return bits(a) < bits(b); };
+        auto expected = v;
+        std::sort(expected.begin(), expected.end(), by_bits);
+
+        auto a = v;
+        sort_unstable(a);
+        std::sort(a.begin(), a.end(), by_bits);
+        EXPECT_TRUE(std::ranges::equal(a, expected, {}, bits, bits));
+
+        auto b = v;
+        sort(b);
+        std::sort(b.begin(), b.end(), by_bits);
+        EXPECT_TRUE(std::ranges::equal(b, expected, {}, bits, bits));
+
+        std::mt19937_64 rng(n);
+        auto coin = [&](int, int) { return rng() & 1 ? std::strong_ordering::less : std::strong_ordering::greater; };
+        auto ints = generate(n, 100, Pattern::Random, n);
+        auto ints_expected = ints;
+        std::sort(ints_expected.begin(), ints_expected.end());
+        sort_unstable_by(ints, coin);
+        std::sort(ints.begin(), ints.end());
+        EXPECT_EQ(ints, ints_expected);
+        if (n > 0)
+        {
+            select_nth_unstable_by(ints, n / 2, coin);
+            std::sort(ints.begin(), ints.end());
+            EXPECT_EQ(ints, ints_expected);
+        }
+    }
+}
+
+TEST(Sort, MoveOnly)
+{
+    std::vector<std::unique_ptr<int>> v;
+    for (int x : generate(1000, 50, Pattern::Random, 1))
+    {
+        v.push_back(std::make_unique<int>(x));
+    }
+    auto by_value = [](const std::unique_ptr<int> &p) { return *p; };
+    sort_by_key(v, by_value);
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), [](auto &a, auto &b) { return *a < *b; }));
+    sort_unstable_by(v, [](const auto &a, const auto &b) { return *b <=> *a; });
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), [](auto &a, auto &b) { return *a > *b; }));
+}
+
+TEST(Sort, Span)
+{
+    std::vector<int> v = {3, 2, 1, 9, 8, 7};
+    // Sorts only the first half
+    sort_unstable(std::span<int>(v).first(3));
+    EXPECT_EQ(v, std::vector<int>({1, 2, 3, 9, 8, 7}));
+}
+
+TEST(Sort, OptionAndResultKeys)
+{
+    std::vector<Option<int>> v = {Some(3), Option<int>(), Some(1)};
+    sort(v);
+    EXPECT_EQ(v, std::vector<Option<int>>({Option<int>(), Some(1), Some(3)}));
+
+    std::vector<std::pair<std::string, Option<int>>> people = {{"a", Some(30)}, {"b", Option<int>()}, {"c", Some(20)}};
+    sort_by_key(people, [](const auto &p) { return p.second; });
+    EXPECT_EQ(people[0].first, "b");
+    EXPECT_EQ(people[1].first, "c");
+
+    std::vector<Result<int, std::string>> r = {Err<int, std::string>("b"), Ok<int, std::string>(2),
+                                               Err<int, std::string>("a"), Ok<int, std::string>(1)};
+    sort_unstable(r);
+    EXPECT_EQ(r, (std::vector<Result<int, std::string>>{Ok<int, std::string>(1), Ok<int, std::string>(2),
+                                                        Err<int, std::string>("a"), Err<int, std::string>("b")}));
+}
+
+TEST(Sort, SelectNthUnstable)
+{
+    std::vector<int> v = {-5, 4, 2, -3, 1};
+    auto [lesser, median, greater] = select_nth_unstable(v, 2);
+    EXPECT_EQ(median, 1);
+    EXPECT_EQ(lesser.size(), 2);
+    EXPECT_EQ(greater.size(), 2);
+    median = 10;
+    EXPECT_EQ(v[2], 10);
+
+    for (auto pattern : AllPatterns)
+    {
+        for (size_t n : Sizes)
+        {
+            if (n == 0)
+            {
+                continue;
+            }
+            for (int max : {0, 3, 1'000'000})
+            {
+                auto expected = generate(n, max, pattern, n);
+                auto v = expected;
+                std::sort(expected.begin(), expected.end());
+                for (size_t index : {size_t(0), n / 3, n / 2, n - 1})
+                {
+                    auto [l, nth, r] = select_nth_unstable(v, index);
+                    ASSERT_EQ(nth, expected[index]);
+                    ASSERT_TRUE(std::all_of(l.begin(), l.end(), [&](int x) { return x <= nth; }));
+                    ASSERT_TRUE(std::all_of(r.begin(), r.end(), [&](int x) { return x >= nth; }));
+                }
+                auto [l, nth, r] = select_nth_unstable_by(v, 0, [](int a, int b) { return cmp(b, a); });
+                EXPECT_EQ(nth, expected.back());
+                auto [l2, nth2, r2] = select_nth_unstable_by_key(v, n - 1, [](int a) { return -a; });
+                EXPECT_EQ(nth2, expected.front());
+            }
+        }
+    }
+}
+
+TEST(SortDeathTest, SelectNthOutOfRange)
+{
+    std::vector<int> v = {1, 2, 3};
+    EXPECT_EXIT(select_nth_unstable(v, 3), ::testing::KilledBySignal(SIGABRT),
+                "panicked at .*\npartition_at_index index 3 greater than length of slice 3");
+}
@@ -0,0 +1,232 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <rustly/print.h>
+#include <rustly/sys.h>
+#include <string>
+#include <thread>
+
+using namespace rustly;
+using sys::Errno;
+
+namespace
+{
+    /// A pipe, as `{read end, write end}`
+    std::pair<sys::Fd, sys::Fd>
+    make_pipe()
+    {
+        int fds[2];
+        if (::pipe2(fds, O_CLOEXEC) != 0)
+        {
+            std::abort();
+        }
+        return {sys::Fd(fds[0]), sys::Fd(fds[1])};
+    }
+
+    std::string
+    temp_file(std::string_view contents)
+    {
+        char path[] = "/tmp/rustly_sys_XXXXXX";
+        int fd = ::mkstemp(path);
+        EXPECT_EQ(::write(fd, contents.data(), contents.size()), ssize_t(contents.size()));
+        ::close(fd);
+        return path;
+    }
+
+    std::atomic<int> signals{0};
+}
+
+TEST(Sys, NichePacking)
+{
+    static_assert(sizeof(Result<sys::Count, Errno>) == sizeof(size_t));
+    static_assert(sizeof(Result<void *, Errno>) == sizeof(void *));
+
+    auto ok = Ok<sys::Count, Errno>(42);
+    EXPECT_TRUE(ok.is_ok());
+    EXPECT_EQ(ok.unwrap(), 42);
+    EXPECT_EQ((Ok<sys::Count, Errno>(SIZE_MAX - 4095).unwrap()), SIZE_MAX - 4095);
+
+    for (int code : {1, EINTR, ENOENT, Errno::MaxCode})
+    {
+        auto err = Err<sys::Count, Errno>(Errno(code));
+        EXPECT_TRUE(err.is_err());
+        EXPECT_EQ(err.err(), Some(Errno(code)));
+
+        auto ptr_err = Err<void *, Errno>(Errno(code));
+        EXPECT_TRUE(ptr_err.is_err());
+        EXPECT_EQ(ptr_err.err(), Some(Errno(code)));
+    }
+    EXPECT_EQ((Ok<sys::Count, Errno>(7)), (Ok<sys::Count, Errno>(7)));
+    EXPECT_NE((Ok<sys::Count, Errno>(7)), (Err<sys::Count, Errno>(Errno(7))));
+}
+
+/// Other integers keep every value, as they aren't packed
+TEST(Sys, IntegersAreNotPacked)
+{
+    EXPECT_EQ((Ok<uint64_t, Errno>(UINT64_MAX).unwrap()), UINT64_MAX);
+    EXPECT_EQ((Ok<size_t, Errno>(SIZE_MAX).unwrap()), SIZE_MAX);
+    EXPECT_EQ((Ok<int, Errno>(-1).unwrap()), -1);
+    EXPECT_EQ((Err<int, Errno>(Errno(0)).err()), Some(Errno(0)));
+}
+
+TEST(SysDeathTest, OkInNiche)
+{
+    EXPECT_EXIT((Ok<sys::Count, Errno>(SIZE_MAX)), ::testing::KilledBySignal(SIGABRT),
+                "panicked at .*\n`Ok` value is in the niche of its `Err` type, so would read as an `Err`");
+}
+
+TEST(SysDeathTest, ErrnoOutsideNiche)
+{
+    EXPECT_EXIT(static_cast<void>(Err<sys::Count, Errno>(Errno(0))), ::testing::KilledBySignal(SIGABRT),
+                "panicked at .*\n`Errno` 0 is outside \\[1, 4095\\], so would read as an `Ok`");
+    EXPECT_EXIT(static_cast<void>(Err<sys::Count, Errno>(Errno(5000))), ::testing::KilledBySignal(SIGABRT),
+                "`Errno` 5000 is outside");
+    EXPECT_EXIT(static_cast<void>(Err<void *, Errno>(Errno(-1))), ::testing::KilledBySignal(SIGABRT),
+                "`Errno` -1 is outside");
+}
+
+TEST(Sys, Errno)
+{
+    Errno e(ENOENT);
+    EXPECT_EQ(e.code(), ENOENT);
+    EXPECT_EQ(e.message(), "No such file or directory");
+    EXPECT_EQ(e.to_string(), "No such file or directory (os error 2)");
+    EXPECT_EQ(e.error_code(), ErrorCode::from_errno(ENOENT));
+
+    std::ostringstream os;
+    os << e;
+    EXPECT_EQ(os.str(), e.to_string());
+    EXPECT_EQ(rustly::format("{}", e), e.to_string());
+}
+
+TEST(Sys, OpenReadWrite)
+{
+    EXPECT_EQ(sys::open("/nonexistent/file", O_RDONLY).err(), Some(Errno(ENOENT)));
+
+    auto path = temp_file("hello, world");
+    auto fd = sys::open(path.c_str(), O_RDWR).unwrap();
+    EXPECT_TRUE(fd.is_open());
+    EXPECT_EQ(::fcntl(fd.raw(), F_GETFD) & FD_CLOEXEC, FD_CLOEXEC);
+
+    char buf[64];
+    EXPECT_EQ(sys::read(fd.raw(), buf, sizeof(buf)), (Ok<sys::Count, Errno>(12)));
+    EXPECT_EQ(std::string_view(buf, 12), "hello, world");
+    EXPECT_EQ(sys::read(fd.raw(), buf, sizeof(buf)), (Ok<sys::Count, Errno>(0)));
+
+    EXPECT_EQ(sys::pread(fd.raw(), buf, 5, 7), (Ok<sys::Count, Errno>(5)));
+    EXPECT_EQ(std::string_view(buf, 5), "world");
+
+    EXPECT_EQ(sys::write(fd.raw(), "!", 1), (Ok<sys::Count, Errno>(1)));
+    EXPECT_EQ(sys::fstat(fd.raw()).unwrap().st_size, 13);
+
+    EXPECT_TRUE(std::move(fd).close().is_ok());
+    EXPECT_FALSE(fd.is_open());
+    EXPECT_EQ(sys::read(-1, buf, 1).err(), Some(Errno(EBADF)));
+    EXPECT_EQ(sys::close(-1).err(), Some(Errno(EBADF)));
+    ::unlink(path.c_str());
+}
+
+TEST(Sys, FdOwnership)
+{
+    auto [r, w] = make_pipe();
+    int raw = w.raw();
+    sys::Fd moved = std::move(w);
+    EXPECT_FALSE(w.is_open());
+    EXPECT_EQ(moved.raw(), raw);
+    {
+        sys::Fd dropped = std::move(moved);
+    }
+    // The write end is closed, so reading hits the end of the pipe
+    char c;
+    EXPECT_EQ(sys::read(r.raw(), &c, 1), (Ok<sys::Count, Errno>(0)));
+}
+
+TEST(Sys, Mmap)
+{
+    auto path = temp_file("mapped");
+    auto fd = sys::open(path.c_str(), O_RDONLY).unwrap();
+    void *p = sys::mmap(nullptr, 6, PROT_READ, MAP_PRIVATE, fd.raw(), 0).unwrap();
+    EXPECT_EQ(std::string_view(static_cast<const char *>(p), 6), "mapped");
+    EXPECT_TRUE(sys::munmap(p, 6).is_ok());
+    EXPECT_EQ(sys::mmap(nullptr, 6, PROT_READ, MAP_PRIVATE, -1, 0).err(), Some(Errno(EBADF)));
+    ::unlink(path.c_str());
+}
+
+TEST(Sys, Getdents64)
+{
+    char dir[] = "/tmp/rustly_sys_dir_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir), nullptr);
+    std::string file = std::string(dir) + "/entry";
+    ::close(::open(file.c_str(), O_CREAT | O_WRONLY, 0600));
+
+    auto fd = sys::open(dir, O_RDONLY | O_DIRECTORY).unwrap();
+    alignas(8) char buf[4096];
+    size_t n = sys::getdents64(fd.raw(), buf, sizeof(buf)).unwrap();
+    bool found = false;
+    for (size_t off = 0; off < n;)
+    {
+        // Layout of `struct linux_dirent64`
+        uint16_t reclen;
+        std::memcpy(&reclen, buf + off + 16, sizeof(reclen));
+        found |= std::string_view(buf + off + 19) == "entry";
+        off += reclen;
+    }
+    EXPECT_TRUE(found);
+    EXPECT_EQ(sys::getdents64(fd.raw(), buf, sizeof(buf)), (Ok<sys::Count, Errno>(0)));
+    EXPECT_EQ(sys::getdents64(-1, buf, sizeof(buf)).err(), Some(Errno(EBADF)));
+    ::unlink(file.c_str());
+    ::rmdir(dir);
+}
+
+TEST(Sys, EpollAndEventfd)
+{
+    auto epfd = sys::epoll_create1().unwrap();
+    auto efd = sys::eventfd(0).unwrap();
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = efd.raw();
+    EXPECT_TRUE(sys::epoll_ctl(epfd.raw(), EPOLL_CTL_ADD, efd.raw(), &ev).is_ok());
+    EXPECT_EQ(sys::epoll_ctl(epfd.raw(), EPOLL_CTL_ADD, efd.raw(), &ev).err(), Some(Errno(EEXIST)));
+
+    std::array<epoll_event, 4> events;
+    EXPECT_EQ(sys::epoll_wait(epfd.raw(), events, 0), (Ok<sys::Count, Errno>(0)));
+
+    uint64_t one = 1;
+    EXPECT_EQ(sys::write(efd.raw(), &one, sizeof(one)), (Ok<sys::Count, Errno>(8)));
+    EXPECT_EQ(sys::epoll_wait(epfd.raw(), events, -1), (Ok<sys::Count, Errno>(1)));
+    EXPECT_EQ(events[0].data.fd, efd.raw());
+}
+
+/// A signal handler installed without `SA_RESTART` interrupts a blocking
+/// read, which is retried rather than returning `EINTR`
+TEST(Sys, RetriesOnEintr)
+{
+    struct sigaction sa{};
+    sa.sa_handler = [](int) { signals++; };
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    struct sigaction old;
+    ASSERT_EQ(::sigaction(SIGUSR1, &sa, &old), 0);
+
+    auto [r, w] = make_pipe();
+    pthread_t reader = ::pthread_self();
+    std::thread writer(
+        [&, wfd = w.raw()]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            ::pthread_kill(reader, SIGUSR1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT_EQ(::write(wfd, "x", 1), 1);
+        });
+    char c = 0;
+    EXPECT_EQ(sys::read(r.raw(), &c, 1), (Ok<sys::Count, Errno>(1)));
+    EXPECT_EQ(c, 'x');
+    writer.join();
+    EXPECT_EQ(signals.load(), 1);
+    ::sigaction(SIGUSR1, &old, nullptr);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <rustly/time.h>
+#include <thread>
+
+using namespace rustly;
+
+TEST(Duration, Constructor)
+{
+    EXPECT_TRUE(Duration().is_zero());
+    EXPECT_EQ(Duration(5, 1'500'000'000), Duration(6, 500'000'000)); // Nanos carry over
+    EXPECT_EQ(Duration::from_secs(3), Duration(3, 0));
+    EXPECT_EQ(Duration::from_millis(2'500), Duration(2, 500'000'000));
+    EXPECT_EQ(Duration::from_micros(1'000'001), Duration(1, 1'000));
+    EXPECT_EQ(Duration::from_nanos(1'000'000'123), Duration(1, 123));
+    EXPECT_EQ(Duration::from_secs_f64(2.5), Duration(2, 500'000'000));
+    EXPECT_EXIT(Duration::from_secs_f64(-1.0), ::testing::KilledBySignal(SIGABRT), "panicked at .*\ncannot convert float seconds");
+
+    auto d = Duration(5, 730'023'852);
+    EXPECT_EQ(d.as_secs(), 5);
+    EXPECT_EQ(d.subsec_millis(), 730);
+    EXPECT_EQ(d.subsec_micros(), 730'023);
+    EXPECT_EQ(d.subsec_nanos(), 730'023'852);
+    EXPECT_EQ(d.as_millis(), 5'730);
+    EXPECT_EQ(d.as_micros(), 5'730'023);
+    EXPECT_EQ(d.as_nanos(), 5'730'023'852);
+    EXPECT_DOUBLE_EQ(Duration(2, 700'000'000).as_secs_f64(), 2.7);
+    EXPECT_EQ(Duration::MAX().as_nanos(), UINT64_MAX); // Saturates
+}
+
+TEST(Duration, Arithmetic)
+{
+    EXPECT_EQ(Duration(0, 0).checked_add(Duration(0, 1)), Some(Duration(0, 1)));
+    EXPECT_EQ(Duration(1, 600'000'000).checked_add(Duration(0, 600'000'000)), Some(Duration(2, 200'000'000)));
+    EXPECT_EQ(Duration(UINT64_MAX, 0).checked_add(Duration(1, 0)), None());
+    EXPECT_EQ(Duration(0, 1).checked_sub(Duration(0, 0)), Some(Duration(0, 1)));
+    EXPECT_EQ(Duration(1, 0).checked_sub(Duration(0, 1)), Some(Duration(0, 999'999'999)));
+    EXPECT_EQ(Duration(0, 0).checked_sub(Duration(0, 1)), None());
+    EXPECT_EQ(Duration(0, 500'000'001).checked_mul(2), Some(Duration(1, 2)));
+    EXPECT_EQ(Duration(UINT64_MAX - 1, 0).checked_mul(2), None());
+    EXPECT_EQ(Duration(2, 0).checked_div(2), Some(Duration(1, 0)));
+    EXPECT_EQ(Duration(1, 0).checked_div(2), Some(Duration(0, 500'000'000)));
+    EXPECT_EQ(Duration(2, 0).checked_div(0), None());
+
+    EXPECT_EQ(Duration(1, 0).saturating_add(Duration::MAX()), Duration::MAX());
+    EXPECT_EQ(Duration(0, 0).saturating_sub(Duration(0, 1)), Duration::ZERO());
+
+    EXPECT_EQ(Duration(1, 0) + Duration(0, 5), Duration(1, 5));
+    EXPECT_EQ(Duration(1, 0) - Duration(0, 5), Duration(0, 999'999'995));
+    EXPECT_EQ(Duration(1, 1) * 3, Duration(3, 3));
+    EXPECT_EQ(Duration(3, 3) / 3, Duration(1, 1));
+    EXPECT_LT(Duration(0, 999), Duration(1, 0));
+    EXPECT_EXIT(Duration(0, 0) - Duration(0, 1), ::testing::KilledBySignal(SIGABRT), "panicked at .*\noverflow when subtracting durations");
+}
+
+TEST(Duration, Display)
+{
+    EXPECT_TRUE(Display<Duration>);
+    EXPECT_EQ(Duration(1, 500'000'000).to_string(), "1.5s");
+    EXPECT_EQ(Duration(2, 0).to_string(), "2s");
+    EXPECT_EQ(Duration::from_millis(10).to_string(), "10ms");
+    EXPECT_EQ(Duration::from_micros(100).to_string(), "100µs");
+    EXPECT_EQ(Duration::from_nanos(1'050).to_string(), "1.05µs");
+    EXPECT_EQ(Duration::from_nanos(5).to_string(), "5ns");
+}
+
+TEST(Instant, Elapsed)
+{
+    auto start = Instant::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto end = Instant::now();
+
+    EXPECT_GE(end, start);
+    EXPECT_GE(end.duration_since(start), Duration::from_millis(5));
+    EXPECT_GE(start.elapsed(), Duration::from_millis(5));
+    EXPECT_EQ(end - start, end.duration_since(start));
+    EXPECT_EQ(start.duration_since(end), Duration::ZERO()); // Saturates
+    EXPECT_TRUE(end.checked_duration_since(start).is_some());
+    EXPECT_TRUE(start.checked_duration_since(end).is_none());
+}
+
+TEST(Instant, Arithmetic)
+{
+    auto now = Instant::now();
+    EXPECT_EQ(now.checked_add(Duration(1, 0)), Some(now + Duration(1, 0)));
+    EXPECT_EQ((now + Duration(1, 0)) - now, Duration(1, 0));
+    EXPECT_EQ(now.checked_add(Duration::MAX()), None());
+    EXPECT_EQ(now.checked_sub(Duration::MAX()), None());
+    EXPECT_EQ(now.checked_sub(Duration(0, 1)).unwrap() + Duration(0, 1), now);
+}
+
+TEST(Instant, ClockSource)
+{
+    if (!detail::TscClock::is_invariant())
+    {
+        EXPECT_EQ(Instant::clock_source(), ClockSource::Monotonic);
+        GTEST_SKIP() << "no invariant TSC";
+    }
+
+    // The calibrated TSC should agree closely with CLOCK_MONOTONIC
+    detail::TscClock tsc;
+    EXPECT_GT(tsc.hz(), 1e8);
+    uint64_t mono0 = detail::monotonic_nanos(), tsc0 = tsc.nanos();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t mono1 = detail::monotonic_nanos(), tsc1 = tsc.nanos();
+    double drift = std::abs((double)(tsc1 - tsc0) - (double)(mono1 - mono0)) / (double)(mono1 - mono0);
+    EXPECT_LT(drift, 0.01);
+}
+
+struct Samples
+{
+    void record(uint64_t v) { values.push_back(v); }
+    std::vector<uint64_t> values;
+};
+
+TEST(Instant, ScopedTimer)
+{
+    Samples samples;
+    {
+        ScopedTimer timer(samples);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(samples.values.size(), 1);
+    EXPECT_GE(samples.values[0], 1'000'000);
+}
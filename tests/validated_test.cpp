@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <rustly/validated.h>
+#include <string>
+
+using namespace rustly;
+
+namespace
+{
+    struct Person
+    {
+        std::string name;
+        int age;
+        bool operator==(const Person &) const = default;
+    };
+
+    Validated<std::string, std::string>
+    name(const std::string &s)
+    {
+        return s.empty() ? Invalid<std::string, std::string>("missing name") : Valid<std::string, std::string>(s);
+    }
+
+    Validated<int, std::string>
+    age(int a)
+    {
+        if (a < 0)
+        {
+            return Invalid<int, std::string>("negative age");
+        }
+        return Valid<int, std::string>(a);
+    }
+
+    Person
+    make_person(std::string n, int a)
+    {
+        return Person{std::move(n), a};
+    }
+}
+
+TEST(Validated, ErrorList)
+{
+    ErrorList<std::string> errors;
+    EXPECT_TRUE(errors.empty());
+    errors.push("a");
+    errors.push("b");
+    EXPECT_FALSE(errors.spilled());
+    errors.push("c"); // Past the two inline errors
+    EXPECT_TRUE(errors.spilled());
+    EXPECT_EQ(errors.size(), 3u);
+    EXPECT_EQ(errors.to_string(), "a; b; c");
+
+    auto copy = errors;
+    EXPECT_EQ(copy, errors);
+    auto moved = std::move(errors);
+    EXPECT_EQ(moved, copy);
+    EXPECT_TRUE(errors.empty());
+
+    ErrorList<std::string> other("d");
+    other.append(std::move(moved));
+    EXPECT_EQ(other.to_string(), "d; a; b; c");
+    EXPECT_TRUE(moved.empty());
+}
+
+TEST(Validated, Arena)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    ErrorList<std::string> errors("a", &arena);
+    for (int i = 0; i < 10; i++)
+    {
+        errors.push(std::to_string(i));
+    }
+    EXPECT_TRUE(errors.spilled());
+    EXPECT_EQ(errors.resource(), &arena);
+
+    // Moves keep the arena; copies don't
+    auto moved = std::move(errors);
+    EXPECT_EQ(moved.resource(), &arena);
+    EXPECT_EQ(moved.size(), 11u);
+    auto copy = moved;
+    EXPECT_EQ(copy.resource(), std::pmr::get_default_resource());
+
+    // A combined list keeps the first one's arena
+    auto v = zip(Invalid<int, std::string>(std::move(moved)), Invalid<int, std::string>("b"));
+    EXPECT_EQ(v.errors().resource(), &arena);
+    EXPECT_EQ(v.errors().size(), 12u);
+
+    // Assigning or appending keeps the list's own resource, and moves the
+    // errors across
+    std::pmr::monotonic_buffer_resource other_arena;
+    ErrorList<std::string> assigned(&other_arena);
+    assigned = copy;
+    EXPECT_EQ(assigned.resource(), &other_arena);
+    EXPECT_TRUE(assigned == copy);
+    assigned = std::move(copy);
+    EXPECT_EQ(assigned.resource(), &other_arena);
+    EXPECT_EQ(assigned.size(), 11u);
+    EXPECT_TRUE(copy.empty());
+    ErrorList<std::string> appended;
+    appended.append(std::move(assigned));
+    EXPECT_EQ(appended.resource(), std::pmr::get_default_resource());
+    EXPECT_EQ(appended.size(), 11u);
+    EXPECT_EQ(appended[10], "9");
+}
+
+TEST(Validated, Valid)
+{
+    auto v = Valid<int, std::string>(3);
+    EXPECT_TRUE(v.is_valid());
+    EXPECT_FALSE(v.is_invalid());
+    EXPECT_EQ(v.unwrap(), 3);
+    auto doubled = std::move(v).map([](int x)
+                                    { return x * 2; });
+    EXPECT_EQ(doubled.unwrap(), 6);
+    EXPECT_EQ((Valid<int, std::string>(3).into_result()), (Ok<int, ErrorList<std::string>>(3)));
+    EXPECT_EXIT(v.errors(), ::testing::KilledBySignal(SIGABRT), "called `Validated::errors\\(\\)` on a `Valid` value");
+}
+
+TEST(Validated, Invalid)
+{
+    auto v = Invalid<int, std::string>("bad");
+    EXPECT_TRUE(v.is_invalid());
+    EXPECT_EQ(v.errors().size(), 1u);
+    EXPECT_EQ(v.errors()[0], "bad");
+    auto mapped = Invalid<int, std::string>("bad").map([](int x)
+                                                      { return x * 2; });
+    EXPECT_TRUE(mapped.is_invalid());
+    EXPECT_EXIT(v.unwrap(), ::testing::KilledBySignal(SIGABRT), "on an `Invalid` value: bad");
+    EXPECT_EXIT((Invalid<int, std::string>(ErrorList<std::string>())), ::testing::KilledBySignal(SIGABRT),
+                "must have at least one error");
+
+    // From a `Result`
+    Validated<int, std::string> r = Err<int, std::string>("from result");
+    EXPECT_EQ(r.errors()[0], "from result");
+    Validated<int, std::string> ok = Ok<int, std::string>(1);
+    EXPECT_EQ(ok.unwrap(), 1);
+}
+
+TEST(Validated, Combine)
+{
+    auto person = combine(make_person, name("ann"), age(30));
+    EXPECT_EQ(person.unwrap(), (Person{"ann", 30}));
+
+    // Every error, in order, rather than stopping at the first
+    auto invalid = combine(make_person, name(""), age(-1));
+    ASSERT_TRUE(invalid.is_invalid());
+    auto result = std::move(invalid).into_result();
+    EXPECT_EQ(result.err().unwrap().to_string(), "missing name; negative age");
+
+    auto one = combine(make_person, name("bob"), age(-1));
+    EXPECT_EQ(one.errors().to_string(), "negative age");
+
+    auto tuple = zip(name("cat"), age(4), Valid<double, std::string>(1.5));
+    EXPECT_EQ(tuple.unwrap(), std::make_tuple(std::string("cat"), 4, 1.5));
+}
+
+TEST(Validated, AndThen)
+{
+    auto adult = [](int a)
+    { return a >= 18 ? Valid<int, std::string>(a) : Invalid<int, std::string>("not an adult"); };
+    EXPECT_EQ(age(20).and_then(adult).unwrap(), 20);
+    EXPECT_EQ(age(10).and_then(adult).errors().to_string(), "not an adult");
+    EXPECT_EQ(age(-1).and_then(adult).errors().to_string(), "negative age"); // Stops at the first
+}
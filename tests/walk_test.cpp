@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <rustly/fs.h>
+#include <rustly/walk.h>
+#include <set>
+#include <string>
+#include <unistd.h>
+
+using namespace rustly;
+
+namespace
+{
+    /// A temporary tree of `depth` levels of `width` directories, each with
+    /// `files` files in it
+    class TempTree
+    {
+    public:
+        TempTree(size_t depth, size_t width, size_t files)
+        {
+            char dir[] = "/tmp/rustly_walk_XXXXXX";
+            EXPECT_NE(::mkdtemp(dir), nullptr);
+            mRoot = dir;
+            populate(mRoot, depth, width, files);
+        }
+
+        ~TempTree()
+        {
+            std::filesystem::permissions(mRoot, std::filesystem::perms::owner_all);
+            std::filesystem::remove_all(mRoot);
+        }
+
+        const std::string &
+        root() const
+        {
+            return mRoot;
+        }
+
+        /// Every path under the root, found with `std::filesystem`
+        std::set<std::string>
+        expected() const
+        {
+            std::set<std::string> paths;
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(mRoot))
+            {
+                paths.insert(entry.path().string());
+            }
+            return paths;
+        }
+
+    private:
+        void
+        populate(const std::string &dir, size_t depth, size_t width, size_t files)
+        {
+            for (size_t i = 0; i < files; i++)
+            {
+                fs::write(dir + "/file" + std::to_string(i), "x").unwrap();
+            }
+            if (depth == 0)
+            {
+                return;
+            }
+            for (size_t i = 0; i < width; i++)
+            {
+                auto sub = dir + "/dir" + std::to_string(i);
+                std::filesystem::create_directory(sub);
+                populate(sub, depth - 1, width, files);
+            }
+        }
+
+        std::string mRoot;
+    };
+}
+
+TEST(WalkDir, FindsEveryEntry)
+{
+    TempTree tree(3, 3, 4);
+    std::filesystem::create_symlink("dir0", tree.root() + "/link");
+    for (size_t threads : {1, 4})
+    {
+        std::set<std::string> found;
+        for (auto &entry : fs::WalkDir(tree.root()).threads(threads).collect())
+        {
+            auto e = std::move(entry).unwrap();
+            EXPECT_TRUE(found.insert(std::string(e.path())).second);
+            EXPECT_EQ(e.path().substr(0, tree.root().size()), tree.root());
+            EXPECT_EQ(e.file_name(), std::filesystem::path(e.path()).filename().string());
+            EXPECT_EQ(e.depth(), static_cast<size_t>(std::count(e.path().begin() + tree.root().size(), e.path().end(), '/')));
+            if (e.file_name() == "link")
+            {
+                EXPECT_TRUE(e.is_symlink());
+            }
+            else
+            {
+                EXPECT_EQ(e.is_dir(), e.file_name().starts_with("dir"));
+                EXPECT_EQ(e.is_file(), e.file_name().starts_with("file"));
+            }
+        }
+        EXPECT_EQ(found, tree.expected());
+    }
+}
+
+TEST(WalkDir, MaxDepthAndSkip)
+{
+    TempTree tree(3, 2, 1);
+    auto shallow = fs::WalkDir(tree.root() + "/").max_depth(1).collect();
+    EXPECT_EQ(shallow.size(), 3);
+    for (auto &entry : shallow)
+    {
+        EXPECT_EQ(entry.unwrap().depth(), 1);
+        EXPECT_EQ(entry.unwrap().path().find("//"), std::string_view::npos);
+    }
+    EXPECT_TRUE(fs::WalkDir(tree.root()).max_depth(0).collect().empty());
+    auto two = fs::WalkDir(tree.root()).max_depth(2).collect();
+    // The root's 3 entries, and the 3 in each of its 2 directories
+    EXPECT_EQ(two.size(), 3 + 2 * 3);
+    for (auto &entry : two)
+    {
+        EXPECT_LE(entry.unwrap().depth(), 2);
+    }
+
+    std::atomic<size_t> visited = 0;
+    fs::WalkDir(tree.root()).threads(2).for_each(
+        [&](Result<fs::DirEntry, fs::WalkError> entry)
+        {
+            visited++;
+            auto e = entry.unwrap();
+            return e.depth() == 1 && e.file_name() == "dir0" ? fs::WalkState::Skip : fs::WalkState::Continue;
+        });
+    // Everything but the 13 entries under the root's `dir0`
+    EXPECT_EQ(visited.load(), tree.expected().size() - 13);
+}
+
+TEST(WalkDir, Quit)
+{
+    TempTree tree(2, 4, 8);
+    std::atomic<size_t> visited = 0;
+    fs::WalkDir(tree.root()).threads(4).for_each(
+        [&](Result<fs::DirEntry, fs::WalkError>)
+        {
+            visited++;
+            return fs::WalkState::Quit;
+        });
+    EXPECT_GE(visited.load(), 1);
+    EXPECT_LT(visited.load(), tree.expected().size());
+}
+
+/// An unreadable directory is reported, and the rest of the tree is still
+/// walked
+TEST(WalkDir, ErrorsDontStopTheWalk)
+{
+    if (::geteuid() == 0)
+    {
+        GTEST_SKIP() << "root can read any directory";
+    }
+    TempTree tree(2, 2, 2);
+    auto locked = tree.root() + "/dir0";
+    std::filesystem::permissions(locked, std::filesystem::perms::none);
+
+    size_t entries = 0;
+    std::vector<fs::WalkError> errors;
+    std::mutex mutex;
+    fs::WalkDir(tree.root()).threads(2).for_each(
+        [&](Result<fs::DirEntry, fs::WalkError> entry)
+        {
+            std::lock_guard lock(mutex);
+            entry.is_ok() ? entries++ : (errors.push_back(entry.unwrap_err()), 0);
+        });
+    std::filesystem::permissions(locked, std::filesystem::perms::owner_all);
+
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0].kind(), sys::Errno(EACCES));
+    EXPECT_EQ(errors[0].path(), locked);
+    EXPECT_EQ(errors[0].depth(), 1);
+    // The root's 4 entries, and the 5 under `dir1`
+    EXPECT_EQ(entries, 9);
+}
+
+TEST(WalkDir, MissingRoot)
+{
+    auto found = fs::WalkDir("/nonexistent/dir").collect();
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(found[0].unwrap_err(), fs::WalkError(sys::Errno(ENOENT), "/nonexistent/dir", 0));
+    EXPECT_EQ(found[0].unwrap_err().to_string(), "/nonexistent/dir: No such file or directory (os error 2)");
+}